@@ -0,0 +1,497 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+/* gpu_culling_benchmark: checks and times GPUCulling against its CPU
+* reference GPUCulling::cull_on_cpu(), on a headless context (see
+* context/gl_context.h), e.g. EGL surfaceless with Mesa llvmpipe.
+*
+* Usage:
+*   gpu_culling_benchmark [--instances <count>] [--iterations <count>]
+*     --instances  : the count of culled instances. Defaults to 100000.
+*     --iterations : the count of iterations over all the views.
+*                    Defaults to 20.  The fastest one gets reported.
+*
+* Instances get frustum-culled from several views, both with compacted
+* draw commands (when glMultiDrawElementsIndirectCount() is available)
+* and with the fallback of one draw command per instance.  The visible
+* instances and the count of draws found on the GPU must be the very
+* ones found on the CPU.  The visible instances get then drawn, as many
+* points as their mesh has indices, culling and drawing alternately as
+* in frames: the count of drawn points must be the one expected from
+* the CPU reference.  For each path, the GPU time of the culling
+* dispatches and the wall time from their submission to their
+* completion are reported, per view, with the CPU time of the
+* reference culling.
+*
+* The HiZ pyramid of a depth buffer with odd sizes gets checked level by
+* level against a CPU reduction.  Instances get then culled behind a wall
+* that covers the left half of the screen: the ones clearly in front of
+* it or beside it must be visible,  the ones clearly behind it must be
+* occluded.
+*
+* The exit code is 0 when all checks passed, 1 when some failed, and
+* 77 when no OpenGL context supporting GPU culling could be created.
+*/
+
+
+//===========================================================================
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "GL/glew.h"
+#include "Eigen/Core"
+
+#include "buffers/index_buffer.h"
+#include "context/gl_context.h"
+#include "context/memory_barriers.h"
+#include "culling/gpu_culling.h"
+#include "pipeline/pipeline_state.h"
+#include "shaders/fragment_shader.h"
+#include "shaders/shaders_program.h"
+#include "shaders/vertex_shader.h"
+#include "vertex_arrays/vertex_array.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+static const GLuint     MESHES_COUNT = 4;
+static const GLuint     INDICES_COUNT = 4096;       // enough for all meshes.
+static const int        VIEWS_COUNT = 8;
+static const int        SKIPPED_EXIT_CODE = 77;     // as expected by CTest SKIP_RETURN_CODE.
+static const GLsizei    NPOT_DEPTH_WIDTH = 250;     // odd HiZ levels sizes get folded.
+static const GLsizei    NPOT_DEPTH_HEIGHT = 130;
+static const GLsizei    WALL_DEPTH_WIDTH = 256;     // power of two sizes: HiZ texels cover whole depth texels.
+static const GLsizei    WALL_DEPTH_HEIGHT = 128;
+static const float      WALL_DEPTH = 0.995f;        // the depth of the wall over the left half of the wall depth buffer.
+static const float      DEPTH_EPSILON = 1e-4f;
+static const float      UV_EPSILON = 1e-3f;
+
+
+//---------------------------------------------------------------------------
+// Returns the view-projection matrix of a camera orbiting the center of the scene.
+static Eigen::Matrix4f get_view_projection(const int view)
+{
+    const float near = 0.5f;
+    const float far = 150.0f;
+    const float focal = 1.0f / tanf(0.5f);     // vertical field of view of 1 radian
+    Eigen::Matrix4f projection = Eigen::Matrix4f::Zero();
+    projection(0, 0) = focal / 1.5f;
+    projection(1, 1) = focal;
+    projection(2, 2) = (far + near) / (near - far);
+    projection(2, 3) = 2.0f * far * near / (near - far);
+    projection(3, 2) = -1.0f;
+
+    // looks at the center from a point of a circle of radius 40, around axis y
+    const float angle = 6.2831853f * float(view) / float(VIEWS_COUNT);
+    const Eigen::Vector3f eye(40.0f * sinf(angle), 10.0f, 40.0f * cosf(angle));
+    // cross products written out, the Geometry module of Eigen being not vendored
+    const Eigen::Vector3f forward = (-eye).normalized();
+    const Eigen::Vector3f right = Eigen::Vector3f(-forward.z(), 0.0f, forward.x()).normalized();
+    const Eigen::Vector3f up(right.y() * forward.z() - right.z() * forward.y(),
+                             right.z() * forward.x() - right.x() * forward.z(),
+                             right.x() * forward.y() - right.y() * forward.x());
+    Eigen::Matrix4f view_matrix = Eigen::Matrix4f::Identity();
+    view_matrix.block<1, 3>(0, 0) = right.transpose();
+    view_matrix.block<1, 3>(1, 0) = up.transpose();
+    view_matrix.block<1, 3>(2, 0) = -forward.transpose();
+    view_matrix(0, 3) = -right.dot(eye);
+    view_matrix(1, 3) = -up.dot(eye);
+    view_matrix(2, 3) = forward.dot(eye);
+
+    return projection * view_matrix;
+}
+
+
+//---------------------------------------------------------------------------
+// Returns the elapsed time in ms since some start time point.
+static double get_elapsed_ms(const chrono::steady_clock::time_point& start)
+{
+    return double(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()) * 1e-6;
+}
+
+
+//---------------------------------------------------------------------------
+// Draws the visible instances of each view after culling them, then
+// checks the counts of drawn points.
+static bool check_draws(const char* title, GPUCulling& culling, PipelineStateCache& pipeline_states,
+                        const PipelineState* state, const GLuint64 expected[VIEWS_COUNT])
+{
+    bool ok = true;
+    GLuint query;
+    glGenQueries(1, &query);
+    while (glGetError() != GL_NO_ERROR)
+        ;
+
+    // the culling program gets used between the draws of the same pipeline state
+    for (int view = 0; view < VIEWS_COUNT; ++view) {
+        culling.cull(get_view_projection(view), false);
+        glBeginQuery(GL_PRIMITIVES_GENERATED, query);
+        culling.draw(pipeline_states, state, GL_POINTS);
+        glEndQuery(GL_PRIMITIVES_GENERATED);
+
+        // some implementations draw with no error while a compute program is used
+        GLint program = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        GLuint64 points = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &points);
+        const GLenum error = glGetError();
+        if (points != expected[view] || error != GL_NO_ERROR || GLuint(program) != state->get_desc().program->name) {
+            fprintf(stderr, "!!! %s: view %d: %llu points drawn, %llu expected, with program %d, OpenGL error 0x%x\n",
+                    title, view, (unsigned long long)points, (unsigned long long)expected[view], program, error);
+            ok = false;
+        }
+    }
+
+    glDeleteQueries(1, &query);
+    return ok;
+}
+
+
+//---------------------------------------------------------------------------
+// Creates a depth texture with some content.
+static GLuint create_depth_texture(const GLsizei width, const GLsizei height, const vector<float>& depth)
+{
+    GLuint texture;
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, 1, GL_DEPTH_COMPONENT32F, width, height);
+    glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_DEPTH_COMPONENT, GL_FLOAT, depth.data());
+    return texture;
+}
+
+
+//---------------------------------------------------------------------------
+// Reduces a level of a HiZ pyramid into the next one, as the reduction shader does.
+static void reduce_on_cpu(const vector<float>& source, const GLsizei source_width, const GLsizei source_height,
+                          vector<float>& destination, const GLsizei width, const GLsizei height)
+{
+    destination.assign(size_t(width) * height, 0.0f);
+    for (GLsizei y = 0; y < height; ++y) {
+        for (GLsizei x = 0; x < width; ++x) {
+            // odd sizes get their last row and column folded into the last texels
+            const GLsizei last_x = min(2 * x + 1 + (x == width - 1 ? source_width & 1 : 0), source_width - 1);
+            const GLsizei last_y = min(2 * y + 1 + (y == height - 1 ? source_height & 1 : 0), source_height - 1);
+            float& depth = destination[size_t(y) * width + x];
+            for (GLsizei source_y = 2 * y; source_y <= last_y; ++source_y)
+                for (GLsizei source_x = 2 * x; source_x <= last_x; ++source_x)
+                    depth = max(depth, source[size_t(source_y) * source_width + source_x]);
+        }
+    }
+}
+
+
+//---------------------------------------------------------------------------
+// Checks the HiZ pyramid of a depth buffer with odd sizes, then the
+// occlusion culling of view 0 behind a wall covering the left half
+// of the screen.
+static bool check_occlusion(const char* title, GPUCulling& culling, const vector<CullingInstance>& instances,
+                            const vector<GLuint>& frustum_visible)
+{
+    bool ok = true;
+    MemoryBarriers& barriers = MemoryBarriers::get_current();
+
+    // each level gets checked against the CPU reduction, maxima being exact
+    vector<float> depth(size_t(NPOT_DEPTH_WIDTH) * NPOT_DEPTH_HEIGHT);
+    for (GLsizei y = 0; y < NPOT_DEPTH_HEIGHT; ++y)
+        for (GLsizei x = 0; x < NPOT_DEPTH_WIDTH; ++x)
+            depth[size_t(y) * NPOT_DEPTH_WIDTH + x] = float((x * 7919 + y * 104729) % 1000) / 1000.0f;
+    GLuint depth_texture = create_depth_texture(NPOT_DEPTH_WIDTH, NPOT_DEPTH_HEIGHT, depth);
+    culling.build_hiz(depth_texture, NPOT_DEPTH_WIDTH, NPOT_DEPTH_HEIGHT);
+    barriers.require_texture(culling.get_hiz_texture(), GL_TEXTURE_UPDATE_BARRIER_BIT);
+    barriers.flush();
+
+    vector<float> expected = depth;
+    vector<float> level_depth;
+    GLsizei source_width = NPOT_DEPTH_WIDTH;
+    GLsizei source_height = NPOT_DEPTH_HEIGHT;
+    for (GLint level = 0; level < culling.get_hiz_levels(); ++level) {
+        const GLsizei width = max(NPOT_DEPTH_WIDTH / 2 >> level, 1);
+        const GLsizei height = max(NPOT_DEPTH_HEIGHT / 2 >> level, 1);
+        reduce_on_cpu(vector<float>(expected), source_width, source_height, expected, width, height);
+        level_depth.assign(expected.size(), -1.0f);
+        glGetTextureImage(culling.get_hiz_texture(), level, GL_RED, GL_FLOAT, GLsizei(level_depth.size() * sizeof(float)), level_depth.data());
+        if (level_depth != expected) {
+            fprintf(stderr, "!!! %s: HiZ level %d (%dx%d) differs from the CPU reduction\n", title, level, width, height);
+            ok = false;
+        }
+        source_width = width;
+        source_height = height;
+    }
+    if (culling.get_hiz_levels() != 7) {
+        fprintf(stderr, "!!! %s: %d HiZ levels, 7 expected\n", title, culling.get_hiz_levels());
+        ok = false;
+    }
+    glDeleteTextures(1, &depth_texture);
+
+    // a wall over the left half of the screen, nothing over the right one
+    depth.resize(size_t(WALL_DEPTH_WIDTH) * WALL_DEPTH_HEIGHT);
+    for (GLsizei y = 0; y < WALL_DEPTH_HEIGHT; ++y)
+        for (GLsizei x = 0; x < WALL_DEPTH_WIDTH; ++x)
+            depth[size_t(y) * WALL_DEPTH_WIDTH + x] = x < WALL_DEPTH_WIDTH / 2 ? WALL_DEPTH : 1.0f;
+    depth_texture = create_depth_texture(WALL_DEPTH_WIDTH, WALL_DEPTH_HEIGHT, depth);
+    culling.build_hiz(depth_texture, WALL_DEPTH_WIDTH, WALL_DEPTH_HEIGHT);
+    const Eigen::Matrix4f view_projection = get_view_projection(0);
+    culling.cull(view_projection, true);
+    vector<GLuint> visible;
+    culling.get_visible_instances(visible);
+    glDeleteTextures(1, &depth_texture);
+
+    // instances clearly in front of the wall, or reaching the right half, must be visible;
+    // instances clearly behind the wall, far enough from the right half, must be occluded
+    const float hiz_width = float(WALL_DEPTH_WIDTH / 2);
+    const float hiz_height = float(WALL_DEPTH_HEIGHT / 2);
+    size_t must_be_visible = 0;
+    size_t must_be_occluded = 0;
+    size_t errors = 0;
+    for (const GLuint index : frustum_visible) {
+        const CullingInstance& instance = instances[index];
+        const bool is_box = instance.extents[0] > 0.0f || instance.extents[1] > 0.0f || instance.extents[2] > 0.0f;
+        const Eigen::Vector3f center(instance.center[0], instance.center[1], instance.center[2]);
+        const Eigen::Vector3f extents = is_box ? Eigen::Vector3f(instance.extents[0], instance.extents[1], instance.extents[2])
+                                               : Eigen::Vector3f::Constant(instance.radius);
+        bool crosses_near = false;
+        Eigen::Vector3f ndc_min = Eigen::Vector3f::Ones();
+        Eigen::Vector3f ndc_max = -Eigen::Vector3f::Ones();
+        for (int i = 0; i < 8; ++i) {
+            const Eigen::Vector3f corner = center + extents.cwiseProduct(Eigen::Vector3f((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f));
+            const Eigen::Vector4f clip = view_projection * Eigen::Vector4f(corner.x(), corner.y(), corner.z(), 1.0f);
+            crosses_near = crosses_near || clip.w() <= 1e-5f;
+            const Eigen::Vector3f ndc = clip.head<3>() / clip.w();
+            ndc_min = ndc_min.cwiseMin(ndc);
+            ndc_max = ndc_max.cwiseMax(ndc);
+        }
+        const float u_min = min(max(ndc_min.x() * 0.5f + 0.5f, 0.0f), 1.0f);
+        const float u_max = min(max(ndc_max.x() * 0.5f + 0.5f, 0.0f), 1.0f);
+        const float v_min = min(max(ndc_min.y() * 0.5f + 0.5f, 0.0f), 1.0f);
+        const float v_max = min(max(ndc_max.y() * 0.5f + 0.5f, 0.0f), 1.0f);
+        const float depth_min = ndc_min.z() * 0.5f + 0.5f;
+
+        // the texels tested by the shader are at most one level above the one of the extent
+        const float extent = max((u_max - u_min) * hiz_width, (v_max - v_min) * hiz_height);
+        const int level = int(ceil(log2(max(extent, 1.0f))));
+        const float texel_width = float(1 << (level + 1)) / hiz_width;
+
+        const bool is_visible = binary_search(visible.begin(), visible.end(), index);
+        if (crosses_near || depth_min < WALL_DEPTH - DEPTH_EPSILON || u_max > 0.5f + UV_EPSILON) {
+            ++must_be_visible;
+            errors += is_visible ? 0 : 1;
+        }
+        else if (depth_min > WALL_DEPTH + DEPTH_EPSILON && u_max + texel_width < 0.5f - UV_EPSILON) {
+            ++must_be_occluded;
+            errors += is_visible ? 1 : 0;
+        }
+    }
+
+    // occlusion tests never make instances visible
+    const bool is_subset = includes(frustum_visible.begin(), frustum_visible.end(), visible.begin(), visible.end());
+    if (errors > 0 || !is_subset || must_be_visible == 0 || must_be_occluded == 0) {
+        fprintf(stderr, "!!! %s: %zu occlusion errors over %zu instances that must be visible and %zu that must be occluded%s\n",
+                title, errors, must_be_visible, must_be_occluded, is_subset ? "" : ", frustum culled instances found visible");
+        ok = false;
+    }
+    printf("%-32s %zu of %zu visible, %zu checked visible and %zu checked occluded  %s\n", "  with HiZ occlusion",
+           visible.size(), frustum_visible.size(), must_be_visible, must_be_occluded, ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+
+//---------------------------------------------------------------------------
+// Checks the visible instances found by some culling against the CPU
+// reference for all views, then their draws and occlusion culling, then
+// reports the fastest iteration.
+static bool run(const char* title, GPUCulling& culling, const vector<CullingInstance>& instances,
+                const vector<GLuint> expected[VIEWS_COUNT], PipelineStateCache& pipeline_states,
+                const PipelineState* state, const GLuint64 points[VIEWS_COUNT], const int iterations)
+{
+    bool ok = culling.is_ok() && culling.set_instances(instances.data(), GLuint(instances.size()));
+    if (!ok) {
+        fprintf(stderr, "!!! %s: culling is not ok\n", title);
+        return false;
+    }
+
+    vector<GLuint> visible;
+    for (int view = 0; view < VIEWS_COUNT; ++view) {
+        culling.cull(get_view_projection(view), false);
+        const GLuint draws_count = culling.get_visible_count();
+        culling.get_visible_instances(visible);
+        if (visible != expected[view] || draws_count != GLuint(expected[view].size())) {
+            fprintf(stderr, "!!! %s: view %d: %zu visible instances and %u draws on GPU, %zu visible instances on CPU\n",
+                    title, view, visible.size(), draws_count, expected[view].size());
+            ok = false;
+        }
+    }
+    ok = check_draws(title, culling, pipeline_states, state, points) && ok;
+
+    GLuint queries[VIEWS_COUNT];
+    glGenQueries(VIEWS_COUNT, queries);
+    double best_gpu_ms = 0.0;
+    double best_cpu_ms = 0.0;
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int view = 0; view < VIEWS_COUNT; ++view) {
+            glBeginQuery(GL_TIME_ELAPSED, queries[view]);
+            culling.cull(get_view_projection(view), false);
+            glEndQuery(GL_TIME_ELAPSED);
+        }
+        glFinish();
+        const double cpu_ms = get_elapsed_ms(start);
+
+        double gpu_ms = 0.0;
+        for (int view = 0; view < VIEWS_COUNT; ++view) {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(queries[view], GL_QUERY_RESULT, &ns);
+            gpu_ms += double(ns) * 1e-6;
+        }
+        if (iteration == 0 || gpu_ms < best_gpu_ms)
+            best_gpu_ms = gpu_ms;
+        if (iteration == 0 || cpu_ms < best_cpu_ms)
+            best_cpu_ms = cpu_ms;
+    }
+    glDeleteQueries(VIEWS_COUNT, queries);
+
+    printf("%-32s %10.3f ms GPU %10.3f ms wall time  %s\n",
+           title, best_gpu_ms / VIEWS_COUNT, best_cpu_ms / VIEWS_COUNT, ok ? "ok" : "MISMATCH");
+    return check_occlusion(title, culling, instances, expected[0]) && ok;
+}
+
+
+//===========================================================================
+int main(int argc, char* argv[])
+{
+    size_t instances_count = 100000;
+    int iterations = 20;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc)
+            instances_count = size_t(strtoul(argv[++i], NULL, 10));
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: gpu_culling_benchmark [--instances <count>] [--iterations <count>]\n");
+            return 2;
+        }
+    }
+    if (instances_count == 0)
+        instances_count = 1;
+    if (iterations <= 0)
+        iterations = 1;
+
+    // draws need a framebuffer, even with no fragments
+    GLContext::Config config;
+    config.width = config.height = 16;
+    GLContext context(config);
+    if (!context.is_ok() || !GPUCulling::is_supported()) {
+        fprintf(stderr, "gpu_culling_benchmark: no OpenGL context supporting GPU culling, skipped\n");
+        return SKIPPED_EXIT_CODE;
+    }
+    printf("%s, %s, %zu instances, %d views\n\n",
+           GLContext::get_platform_name(context.get_platform()), (const char*)glGetString(GL_RENDERER), instances_count, VIEWS_COUNT);
+
+    // spheres and boxes, spread over a cube of side 200 centered on the origin
+    mt19937 random(1);
+    uniform_real_distribution<float> position(-100.0f, 100.0f);
+    uniform_real_distribution<float> size(0.2f, 2.0f);
+    vector<CullingInstance> instances(instances_count);
+    for (size_t i = 0; i < instances_count; ++i) {
+        CullingInstance& instance = instances[i];
+        for (int axis = 0; axis < 3; ++axis)
+            instance.center[axis] = position(random);
+        instance.radius = size(random);
+        for (int axis = 0; axis < 3; ++axis)
+            instance.extents[axis] = (i & 1) ? instance.radius * 0.5f : 0.0f;
+        instance.mesh = GLuint(i % MESHES_COUNT);
+    }
+    CullingMesh meshes[MESHES_COUNT];
+    for (GLuint i = 0; i < MESHES_COUNT; ++i)
+        meshes[i] = CullingMesh{ 36 * (i + 1), 1000 * i, GLint(i), 0 };
+
+    // the CPU reference
+    vector<GLuint> expected[VIEWS_COUNT];
+    double best_cpu_ms = 0.0;
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int view = 0; view < VIEWS_COUNT; ++view) {
+            expected[view].clear();
+            GPUCulling::cull_on_cpu(get_view_projection(view), instances.data(), instances.size(), expected[view]);
+        }
+        const double cpu_ms = get_elapsed_ms(start);
+        if (iteration == 0 || cpu_ms < best_cpu_ms)
+            best_cpu_ms = cpu_ms;
+    }
+    size_t visible_count = 0;
+    for (int view = 0; view < VIEWS_COUNT; ++view)
+        visible_count += expected[view].size();
+    printf("%-32s %10.3f ms CPU, %zu visible instances per view\n", "cull_on_cpu()", best_cpu_ms / VIEWS_COUNT, visible_count / VIEWS_COUNT);
+
+    // each visible instance draws as many points as its mesh has indices
+    GLuint64 points[VIEWS_COUNT];
+    for (int view = 0; view < VIEWS_COUNT; ++view) {
+        points[view] = 0;
+        for (const GLuint index : expected[view])
+            points[view] += meshes[instances[index].mesh].count;
+    }
+
+    // the OpenGL objects are released before the context
+    bool ok = true;
+    {
+        VertexShader vertex_shader;
+        vertex_shader.set_source_code("#version 450 core\nvoid main() { gl_Position = vec4(0.0, 0.0, 0.0, 1.0); }\n");
+        FragmentShader fragment_shader;
+        fragment_shader.set_source_code("#version 450 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n");
+        ShadersList shaders{ &vertex_shader, &fragment_shader };
+        ShadersProgram program(shaders);
+
+        const vector<GLuint> indices(INDICES_COUNT, 0);
+        IndexBuffer index_buffer(GLsizeiptr(indices.size() * sizeof(GLuint)), indices.data());
+        VertexArray vertex_array;
+        vertex_array.set_index_buffer(index_buffer);
+
+        PipelineStateCache pipeline_states;
+        PipelineDesc desc;
+        desc.program = &program;
+        desc.vertex_array = &vertex_array;
+        desc.rasterizer.rasterizer_discard = true;
+        const PipelineState* state = pipeline_states.acquire(desc);
+
+        if (GPUCulling::is_draw_count_supported()) {
+            GPUCulling culling(GLuint(instances_count), MESHES_COUNT);
+            ok = culling.set_meshes(meshes, MESHES_COUNT) && culling.is_compacted() &&
+                 run("cull(), compacted draws", culling, instances, expected, pipeline_states, state, points, iterations);
+        }
+        else
+            printf("%-32s not supported by this context\n", "cull(), compacted draws");
+
+        GPUCulling culling(GLuint(instances_count), MESHES_COUNT, false, false);
+        ok = culling.set_meshes(meshes, MESHES_COUNT) && !culling.is_compacted() &&
+             run("cull(), one draw per instance", culling, instances, expected, pipeline_states, state, points, iterations) && ok;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+/* shaders_program_benchmark: measures the CPU overhead of ShadersProgram
+* itself, with the OpenGL calls dispatched to the MOCK backend of
+* GLBackend: no context, no driver, so that only the cost of ObjectGL
+* gets measured.
+*
+* Usage:
+*   shaders_program_benchmark [--iterations <count>] [--calls]
+*     --iterations : the count of iterations of each batch. Defaults to
+*                    100000.  Each benchmark runs 5 batches and reports
+*                    the fastest one.
+*     --calls      : reports also the count of calls of each OpenGL
+*                    function over the whole run.
+*
+* For each benchmark,  the CPU time per iteration is reported with the
+* count of OpenGL calls per iteration that ObjectGL issued.
+*/
+
+
+//===========================================================================
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "context/gl_backend.h"
+#include "shaders/fragment_shader.h"
+#include "shaders/shaders_program.h"
+#include "shaders/vertex_shader.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+static const int        BATCHES_COUNT = 5;
+static const GLint      SUBROUTINE_UNIFORMS_COUNT = 4;
+static const GLint      SUBROUTINE_FUNCTIONS_COUNT = 8;
+
+
+//---------------------------------------------------------------------------
+// Runs batches of 'iterations' calls to 'iterate(i)', then reports the fastest batch.
+template<typename F>
+static void run(const char* title, const size_t iterations, F iterate)
+{
+    double best_ns = 0.0;
+    const uint64_t calls_start = GLBackend::get_calls_count();
+    for (int batch = 0; batch < BATCHES_COUNT; ++batch) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+            iterate(i);
+        const double ns = double(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count()) / double(iterations);
+        if (batch == 0 || ns < best_ns)
+            best_ns = ns;
+    }
+    const double calls = double(GLBackend::get_calls_count() - calls_start) / double(iterations * BATCHES_COUNT);
+    printf("%-40s %10.1f ns/iteration %8.2f GL calls/iteration\n", title, best_ns, calls);
+}
+
+
+//===========================================================================
+int main(int argc, char* argv[])
+{
+    size_t iterations = 100000;
+    bool calls = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = size_t(strtoul(argv[++i], NULL, 10));
+        else if (strcmp(argv[i], "--calls") == 0)
+            calls = true;
+        else {
+            fprintf(stderr, "usage: shaders_program_benchmark [--iterations <count>] [--calls]\n");
+            return 2;
+        }
+    }
+    if (iterations == 0)
+        iterations = 1;
+
+    GLBackend::set(GLBackend::MOCK);
+    GLBackend::set_mock_subroutines(GL_FRAGMENT_SHADER, SUBROUTINE_UNIFORMS_COUNT, SUBROUTINE_FUNCTIONS_COUNT);
+
+    bool ok = true;
+
+    // ObjectGL objects are released before getting back to the real backend
+    {
+        VertexShader vertex_shader;
+        vertex_shader.set_source_code("#version 450 core\nvoid main() { gl_Position = vec4(0.0); }\n");
+        FragmentShader fragment_shader;
+        fragment_shader.set_source_code("#version 450 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n");
+        ShadersList shaders{ &vertex_shader, &fragment_shader };
+
+        run("ShadersProgram construction", iterations, [&](size_t) {
+            ShadersProgram program(shaders);
+        });
+
+        ShadersProgram program(shaders);
+        ShadersProgram other_program(shaders);
+        VertexShader extra_shader;
+
+        run("attach_shader() + detach_shader()", iterations, [&](size_t) {
+            program.attach_shader(extra_shader);
+            program.detach_shader(extra_shader);
+        });
+
+        run("use(), same program", iterations, [&](size_t) {
+            program.use();
+        });
+
+        run("use(), alternating programs", iterations, [&](size_t i) {
+            if (i & 1)
+                other_program.use();
+            else
+                program.use();
+        });
+
+        SubroutinesStageState* stage = program.get_subroutines().get_stage(GL_FRAGMENT_SHADER);
+        if (stage == NULL) {
+            fprintf(stderr, "!!! no subroutines reflected from the mock backend\n");
+            ok = false;
+        }
+        else {
+            program.use();
+
+            run("subroutine select(), same function", iterations, [&](size_t) {
+                stage->select(0, 0);
+                program.use();
+            });
+
+            run("subroutine select() + use()", iterations, [&](size_t i) {
+                stage->select(GLint(i % SUBROUTINE_UNIFORMS_COUNT), GLuint(i % SUBROUTINE_FUNCTIONS_COUNT));
+                program.use();
+            });
+        }
+    }
+
+    if (calls) {
+        vector<pair<string, uint64_t>> counts;
+        GLBackend::get_calls_counts(counts);
+        printf("\n");
+        for (const pair<string, uint64_t>& count : counts)
+            printf("%-40s %12llu\n", count.first.c_str(), (unsigned long long)count.second);
+    }
+
+    GLBackend::set(GLBackend::REAL);
+    return ok ? 0 : 1;
+}
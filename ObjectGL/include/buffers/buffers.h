@@ -0,0 +1,259 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+
+#include "GL/glew.h"
+
+#include "context/gl_state.h"
+#include "objects/object.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The base class for all OpenGL Buffer Objects.
+*
+* Buffers get immutable storage, allocated once with 'allocate()'.
+* All operations on them are done with the Direct State Access calls
+* of OpenGL 4.5 (e.g. glNamedBufferSubData(), glMapNamedBufferRange())
+* so that no binding is ever needed to edit their content.
+*
+* When  extension  ARB_direct_state_access  is  not  available,  edits
+* fall back on binding the buffer to the GL_COPY_WRITE_BUFFER target,
+* which has no effect on the rendering state (e.g. on the element array
+* buffer of the currently bound vertex array).
+*
+* Buffers can be moved but cannot be copied.
+*
+* Notice: an OpenGL context must be current when calling  methods
+*   of this class.  OpenGL 4.4 or extension ARB_buffer_storage is
+*   needed for allocating storage.
+*/
+class Buffer : public SharableObject {
+public:
+
+    /** \brief Constructor.
+    *
+    * Creates an OpenGL Buffer object with no storage yet.
+    *
+    * \param target : the default binding target of this buffer,
+    *       e.g. GL_ARRAY_BUFFER or GL_UNIFORM_BUFFER.
+    */
+    Buffer(const GLenum target);
+
+
+    /** \brief Constructor with storage allocation.
+    *
+    * \param target : the default binding target of this buffer.
+    * \param size : the size in bytes of the storage.
+    * \param data : a pointer to the initial content of the storage,
+    *       or NULL if not initialized. Defaults to NULL.
+    * \param flags : the glBufferStorage() flags of the storage.
+    *       Defaults to GL_DYNAMIC_STORAGE_BIT.
+    */
+    Buffer(const GLenum target, const GLsizeiptr size, const void* data = NULL, const GLbitfield flags = GL_DYNAMIC_STORAGE_BIT);
+
+
+    /** \brief Move constructor.
+    */
+    Buffer(Buffer&& other);
+
+
+    /** \brief Destructor.
+    *
+    * Unmaps this buffer if mapped, then deletes it.
+    */
+    ~Buffer();
+
+
+    /** \brief Move assignment.
+    */
+    Buffer& operator= (Buffer&& other);
+
+
+    /** \brief Allocates the immutable storage of this buffer.
+    *
+    * May be called only once per buffer.
+    *
+    * \param size : the size in bytes of the storage.
+    * \param data : a pointer to the initial content of the storage,
+    *       or NULL if not initialized. Defaults to NULL.
+    * \param flags : the glBufferStorage() flags of the storage, e.g.
+    *       GL_DYNAMIC_STORAGE_BIT or GL_MAP_WRITE_BIT |
+    *       GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT. Defaults to
+    *       GL_DYNAMIC_STORAGE_BIT.
+    *
+    * \return true if storage has been allocated, or false else.
+    */
+    bool allocate(const GLsizeiptr size, const void* data = NULL, const GLbitfield flags = GL_DYNAMIC_STORAGE_BIT);
+
+
+    /** \brief Binds this buffer to its default target.
+    *
+    * Bindings go through the state cache of the current context.
+    */
+    inline void bind() const {
+        GLStateCache::get_current().bind_buffer(prvt_target, name);
+    }
+
+
+    /** \brief Binds this buffer to a target.
+    */
+    inline void bind(const GLenum target) const {
+        GLStateCache::get_current().bind_buffer(target, name);
+    }
+
+
+    /** \brief Binds this whole buffer to an indexed binding point of its default target.
+    *
+    * The default target must be an indexed one, e.g. GL_UNIFORM_BUFFER
+    * or GL_SHADER_STORAGE_BUFFER.
+    */
+    inline void bind_base(const GLuint binding_index) const {
+        GLStateCache::get_current().bind_buffer_base(prvt_target, binding_index, name);
+    }
+
+
+    /** \brief Binds a range of this buffer to an indexed binding point of its default target.
+    */
+    inline void bind_range(const GLuint binding_index, const GLintptr offset, const GLsizeiptr size) const {
+        GLStateCache::get_current().bind_buffer_range(prvt_target, binding_index, name, offset, size);
+    }
+
+
+    /** \brief Copies a part of the content of this buffer into another buffer.
+    *
+    * The copy is done by the GPU, with no CPU round trip.
+    */
+    void copy_to(Buffer& destination, const GLintptr read_offset, const GLintptr write_offset, const GLsizeiptr size) const;
+
+
+    /** \brief Makes the content of a range of a mapped buffer visible to the GPU.
+    *
+    * To be used with ranges that have been mapped with GL_MAP_FLUSH_EXPLICIT_BIT.
+    */
+    void flush_mapped_range(const GLintptr offset, const GLsizeiptr size);
+
+
+    /** \brief Reads back a part of the content of this buffer.
+    */
+    void get_data(const GLintptr offset, const GLsizeiptr size, void* data) const;
+
+
+    /** \brief Returns a pointer to the mapped memory of this buffer, or NULL if not mapped.
+    *
+    * The pointer relates to the first mapped byte.
+    */
+    inline void* get_mapped_data() const {
+        return prvt_mapped;
+    }
+
+
+    /** \brief Returns the size in bytes of the storage of this buffer, 0 if not allocated yet.
+    */
+    inline const GLsizeiptr get_size() const {
+        return prvt_size;
+    }
+
+
+    /** \brief Returns the glBufferStorage() flags of this buffer.
+    */
+    inline const GLbitfield get_storage_flags() const {
+        return prvt_flags;
+    }
+
+
+    /** \brief Returns the default binding target of this buffer.
+    */
+    inline const GLenum get_target() const {
+        return prvt_target;
+    }
+
+
+    /** \brief Returns true if this buffer is currently mapped.
+    */
+    inline const bool is_mapped() const {
+        return prvt_mapped != NULL;
+    }
+
+
+    /** \brief Maps a range of this buffer into the client memory.
+    *
+    * \param offset : the offset of the first byte to be mapped.
+    * \param size : the count of bytes to be mapped.
+    * \param access : the glMapBufferRange() access flags. They must be
+    *       compatible with the storage flags of this buffer.
+    *
+    * \return a pointer to the mapped memory, or NULL on error.
+    */
+    void* map(const GLintptr offset, const GLsizeiptr size, const GLbitfield access);
+
+
+    /** \brief Maps this whole buffer into the client memory.
+    */
+    inline void* map(const GLbitfield access) {
+        return map(0, prvt_size, access);
+    }
+
+
+    /** \brief Modifies a part of the content of this buffer.
+    *
+    * Storage must have been allocated with GL_DYNAMIC_STORAGE_BIT.
+    */
+    void set_data(const GLintptr offset, const GLsizeiptr size, const void* data);
+
+
+    /** \brief Unmaps this buffer.
+    *
+    * \return false if the content of the buffer has been corrupted
+    *       while it was mapped, or true else.
+    */
+    bool unmap();
+
+
+    /** Class method. Returns true if a name is the one of an OpenGL Buffer object.
+    */
+    static inline const bool is_buffer(const GLuint name) {
+        return glIsBuffer(name) == GL_TRUE;
+    }
+
+
+    /** Class method. Returns true if Direct State Access is supported by the current OpenGL context.
+    */
+    static inline const bool is_dsa_supported() {
+        return GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access;
+    }
+
+
+private:
+    GLenum      prvt_target;    // the default binding target of this buffer.
+    GLsizeiptr  prvt_size;      // the size of the storage of this buffer.
+    GLbitfield  prvt_flags;     // the storage flags of this buffer.
+    void*       prvt_mapped;    // the mapped memory of this buffer, NULL if not mapped.
+
+    void prvt_release();
+};
@@ -0,0 +1,107 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <utility>
+
+#include "GL/glew.h"
+
+#include "buffers.h"
+
+
+//===========================================================================
+/** \brief The class of OpenGL Index Buffers, i.e. buffers of vertex indices.
+*
+* Default binding target is GL_ELEMENT_ARRAY_BUFFER.
+*/
+class IndexBuffer : public Buffer {
+public:
+
+    /** \brief Empty constructor.
+    *
+    * Creates an OpenGL buffer object with no storage yet.
+    */
+    IndexBuffer(const GLenum index_type = GL_UNSIGNED_INT)
+        : Buffer(GL_ELEMENT_ARRAY_BUFFER), prvt_index_type(index_type)
+    {}
+
+
+    /** \brief Constructor with storage allocation.
+    *
+    * \param size : the size in bytes of the storage.
+    * \param data : a pointer to the initial content of the storage,
+    *       or NULL if not initialized. Defaults to NULL.
+    * \param flags : the glBufferStorage() flags of the storage.
+    *       Defaults to GL_DYNAMIC_STORAGE_BIT.
+    * \param index_type : the type of the indices, i.e. one of
+    *       GL_UNSIGNED_BYTE,  GL_UNSIGNED_SHORT  and GL_UNSIGNED_INT.
+    *       Defaults to GL_UNSIGNED_INT.
+    */
+    IndexBuffer(const GLsizeiptr size, const void* data = NULL, const GLbitfield flags = GL_DYNAMIC_STORAGE_BIT, const GLenum index_type = GL_UNSIGNED_INT)
+        : Buffer(GL_ELEMENT_ARRAY_BUFFER, size, data, flags), prvt_index_type(index_type)
+    {}
+
+
+    /** \brief Move constructor.
+    */
+    IndexBuffer(IndexBuffer&& other)
+        : Buffer(std::move(other)), prvt_index_type(other.prvt_index_type)
+    {}
+
+
+    /** \brief Move assignment.
+    */
+    IndexBuffer& operator= (IndexBuffer&& other) {
+        Buffer::operator=(std::move(other));
+        prvt_index_type = other.prvt_index_type;
+        return *this;
+    }
+
+
+    /** \brief Returns the count of indices this buffer can contain.
+    */
+    inline const GLsizeiptr get_indices_count() const {
+        return get_size() / get_index_size();
+    }
+
+
+    /** \brief Returns the size in bytes of one index.
+    */
+    inline const GLsizeiptr get_index_size() const {
+        return prvt_index_type == GL_UNSIGNED_BYTE ? 1 : prvt_index_type == GL_UNSIGNED_SHORT ? 2 : 4;
+    }
+
+
+    /** \brief Returns the type of the indices.
+    */
+    inline const GLenum get_index_type() const {
+        return prvt_index_type;
+    }
+
+
+private:
+    GLenum prvt_index_type; // the type of the indices.
+};
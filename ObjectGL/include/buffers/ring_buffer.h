@@ -0,0 +1,226 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "buffers.h"
+#include "trace/gl_trace.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of persistently mapped ring buffers of per-draw constants.
+*
+* One single immutable buffer is allocated with glBufferStorage() and
+* gets mapped once and for all, persistently and coherently.  Its memory
+* is split into as many regions as there are frames in flight.  Per-draw
+* constants are written with plain memcpy() into aligned sub-allocations
+* of the region of the current frame, and sub-allocations get bound with
+* glBindBufferRange(): no glBufferSubData() call is involved at all.
+*
+* At end of each frame, a fence is inserted into the OpenGL commands
+* stream for the region of the frame.  Before a region gets reused,
+* its fence is waited for, so that the CPU never overwrites data the
+* GPU has not consumed yet.
+*
+* Sub-allocations offsets respect the alignment the OpenGL implementation
+* requires for the target (e.g. GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT).
+*
+* Notice: an OpenGL context must be current when calling methods of
+*   this class.  OpenGL 4.4 or extension ARB_buffer_storage is needed.
+*
+* Usage:
+*   RingBuffer ring(64 * 1024);
+*   ...
+*   ring.begin_frame();
+*   for (...) {
+*       RingBuffer::Allocation constants = ring.push(per_draw_constants);
+*       ring.bind(constants, 1);
+*       ... draw ...
+*   }
+*   ring.end_frame();
+*/
+class RingBuffer : public Buffer {
+public:
+
+    /** \brief The description of a sub-allocation in a ring buffer.
+    */
+    struct Allocation {
+        GLintptr    offset; //!< the offset of the sub-allocation in the buffer.
+        GLsizeiptr  size;   //!< the size in bytes of the sub-allocation.
+        void*       data;   //!< a pointer to the mapped memory of the sub-allocation, NULL if allocation failed.
+
+        /** \brief Returns true if the allocation succeeded.
+        */
+        inline const bool is_ok() const {
+            return data != NULL;
+        }
+    };
+
+
+    /** \brief The statistics of use of a ring buffer.
+    */
+    struct Stats {
+        size_t allocations; //!< the count of successful sub-allocations.
+        size_t bytes;       //!< the count of allocated bytes, alignment padding included.
+        size_t overflows;   //!< the count of sub-allocations that did not fit in the region of their frame.
+        size_t waits;       //!< the count of frames that had to wait for the GPU before reusing their region.
+    };
+
+
+    /** \brief Constructor.
+    *
+    * \param frame_size : the size in bytes available for sub-allocations
+    *       in each frame. It is rounded up to the required alignment.
+    * \param frames_count : the count of frames in flight. Defaults to 3.
+    * \param target : the buffer binding target sub-allocations are
+    *       meant to be bound to.  Defaults to GL_UNIFORM_BUFFER. May
+    *       also be GL_SHADER_STORAGE_BUFFER for instance.
+    */
+    RingBuffer(const GLsizeiptr frame_size, const GLuint frames_count = 3, const GLenum target = GL_UNIFORM_BUFFER);
+
+
+    /** \brief Destructor.
+    *
+    * Waits for all frames in flight to be completed by the GPU.
+    */
+    ~RingBuffer();
+
+
+    /** \brief Sub-allocates aligned memory in the region of the current frame.
+    *
+    * \param size : the size in bytes to be allocated.
+    *
+    * \return the description of the sub-allocation, whose 'data'
+    *       is NULL if the region of the current frame is full.
+    */
+    Allocation allocate(const GLsizeiptr size);
+
+
+    /** \brief Starts a new frame.
+    *
+    * Waits for the GPU to have completed the commands that were using
+    * the region of this frame, if any.
+    */
+    void begin_frame();
+
+
+    using Buffer::bind;
+
+
+    /** \brief Binds a sub-allocation to an indexed binding point of the target of this ring buffer.
+    *
+    * While capturing an OpenGL trace, the content of the sub-allocation
+    * gets recorded: it must have been written already.
+    */
+    inline void bind(const Allocation& allocation, const GLuint binding_index) const {
+        if (GLTrace::is_capturing())
+            GLTrace::on_mapped_write(name, allocation.offset, allocation.size, allocation.data);
+        bind_range(binding_index, allocation.offset, allocation.size);
+    }
+
+
+    /** \brief Ends the current frame.
+    *
+    * Inserts a fence into the OpenGL commands stream, protecting the
+    * region of this frame until the GPU has consumed it.
+    */
+    void end_frame();
+
+
+    /** \brief Returns the required alignment of sub-allocations offsets.
+    */
+    inline const GLint get_alignment() const {
+        return prvt_alignment;
+    }
+
+
+    /** \brief Returns the size in bytes of the region of each frame.
+    */
+    inline const GLsizeiptr get_frame_size() const {
+        return prvt_frame_size;
+    }
+
+
+    /** \brief Returns the count of frames in flight.
+    */
+    inline const GLuint get_frames_count() const {
+        return prvt_frames_count;
+    }
+
+
+    /** \brief Returns the statistics of use of this ring buffer.
+    */
+    inline const Stats& get_stats() const {
+        return prvt_stats;
+    }
+
+
+    /** \brief Sub-allocates memory for and copies a value into the region of the current frame.
+    *
+    * \return the description of the sub-allocation, whose 'data'
+    *       is NULL if the region of the current frame is full.
+    */
+    template<typename T>
+    inline Allocation push(const T& value) {
+        return push(&value, sizeof(T));
+    }
+
+
+    /** \brief Sub-allocates memory for and copies data into the region of the current frame.
+    */
+    inline Allocation push(const void* data, const GLsizeiptr size) {
+        Allocation allocation = allocate(size);
+        if (allocation.is_ok())
+            memcpy(allocation.data, data, size);
+        return allocation;
+    }
+
+
+    /** Class method. Returns true if ring buffers are supported by the current OpenGL context.
+    */
+    static inline const bool is_supported() {
+        return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    }
+
+
+private:
+    GLint           prvt_alignment;     // the alignment of sub-allocations offsets.
+    GLsizeiptr      prvt_frame_size;    // the size of the region of each frame.
+    GLuint          prvt_frames_count;  // the count of frames in flight.
+    GLuint          prvt_frame;         // the index of the current frame.
+    GLsizeiptr      prvt_head;          // the offset of the next sub-allocation in the region of the current frame.
+    unsigned char*  prvt_mapped;        // the persistently mapped memory of the whole buffer.
+    vector<GLsync>  prvt_fences;        // the fence of each frame, NULL if none.
+    Stats           prvt_stats;
+
+    void prvt_wait(const GLuint frame);
+};
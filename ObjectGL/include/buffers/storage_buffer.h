@@ -0,0 +1,78 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <utility>
+
+#include "GL/glew.h"
+
+#include "buffers.h"
+
+
+//===========================================================================
+/** \brief The class of OpenGL Shader Storage Buffers.
+*
+* Default binding target is GL_SHADER_STORAGE_BUFFER.
+*/
+class StorageBuffer : public Buffer {
+public:
+
+    /** \brief Empty constructor.
+    *
+    * Creates an OpenGL buffer object with no storage yet.
+    */
+    StorageBuffer()
+        : Buffer(GL_SHADER_STORAGE_BUFFER)
+    {}
+
+
+    /** \brief Constructor with storage allocation.
+    *
+    * \param size : the size in bytes of the storage.
+    * \param data : a pointer to the initial content of the storage,
+    *       or NULL if not initialized. Defaults to NULL.
+    * \param flags : the glBufferStorage() flags of the storage.
+    *       Defaults to GL_DYNAMIC_STORAGE_BIT.
+    */
+    StorageBuffer(const GLsizeiptr size, const void* data = NULL, const GLbitfield flags = GL_DYNAMIC_STORAGE_BIT)
+        : Buffer(GL_SHADER_STORAGE_BUFFER, size, data, flags)
+    {}
+
+
+    /** \brief Move constructor.
+    */
+    StorageBuffer(StorageBuffer&& other)
+        : Buffer(std::move(other))
+    {}
+
+
+    /** \brief Move assignment.
+    */
+    StorageBuffer& operator= (StorageBuffer&& other) {
+        Buffer::operator=(std::move(other));
+        return *this;
+    }
+};
@@ -0,0 +1,297 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "GL/glew.h"
+
+#include "buffers/buffers.h"
+#include "mpsc_queue.h"
+#include "pipeline/pipeline_state.h"
+#include "shaders/shaders_program.h"
+#include "vertex_arrays/vertex_array.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of per-thread memory arenas of command buffers.
+*
+* Commands are recorded into fixed-size chunks of memory. Each thread
+* gets its own arena, from which the command buffers it records take
+* their chunks with no synchronization at all. Once replayed, command
+* buffers give their chunks back to the arena they come from,  from
+* whatever thread, through a lock-free stack.
+*/
+class CommandArena {
+public:
+
+    /** \brief The header of the chunks of memory of arenas.
+    *
+    * The chunk data follows its header in memory.
+    */
+    struct Chunk {
+        Chunk*  next;       //!< the next chunk in the list this chunk belongs to.
+        size_t  capacity;   //!< the count of bytes of data of this chunk.
+        size_t  used;       //!< the count of used bytes of data.
+
+        inline unsigned char* data() {
+            return reinterpret_cast<unsigned char*>(this + 1);
+        }
+    };
+
+
+    /** \brief The capacity of chunks. Bigger chunks are allocated for bigger commands, and are never recycled.
+    */
+    static const size_t CHUNK_CAPACITY = 64 * 1024;
+
+
+    /** \brief Empty constructor.
+    */
+    CommandArena();
+
+
+    /** \brief Destructor. Frees all the chunks that have been given back.
+    */
+    ~CommandArena();
+
+
+    /** \brief Acquires an empty chunk of memory.
+    *
+    * Must be called from the thread that owns this arena only.
+    *
+    * \param min_capacity : the minimal capacity of the chunk.
+    * \return the chunk, or NULL if memory could not get allocated, in
+    *       which case the command being recorded gets dropped.
+    */
+    Chunk* acquire(const size_t min_capacity);
+
+
+    /** \brief Gives back a list of chunks to this arena.
+    *
+    * May be called from any thread.
+    */
+    void release(Chunk* first);
+
+
+    /** Class method. Returns the arena of the calling thread.
+    */
+    static const shared_ptr<CommandArena>& get_local();
+
+
+private:
+    Chunk*          prvt_free;      // the free chunks, accessed by the owner thread only.
+    atomic<Chunk*>  prvt_returned;  // the chunks given back by other threads.
+
+    static void prvt_free_list(Chunk* chunk);
+};
+
+
+//===========================================================================
+/** \brief The class of buffers of OpenGL commands.
+*
+* Command buffers may be recorded in any thread, with no OpenGL context
+* current:  commands get encoded into compact binary streams in memory
+* chunks taken from the arena of the recording thread.  They are then
+* replayed in the thread where the OpenGL context is current, either
+* directly with 'execute()' or by being submitted to a CommandThread.
+*
+* Recorded commands keep pointers to ObjectGL objects (programs,
+* buffers, pipeline states, ...):  these objects must live until the
+* command buffer has been replayed.  Data of uploads and uniforms are
+* copied into the command buffer at recording time.
+*
+* Before each draw or dispatch,  the modified uniforms of the program
+* in use are flushed.
+*
+* A command buffer must be recorded by the thread that created it,
+* since its memory comes from the arena of that thread.
+*
+* Usage, in worker threads:
+*   CommandBuffer* commands = new CommandBuffer();
+*   commands->use_pipeline(pipeline_states, state);
+*   commands->set_uniform(program, model_slot, model_matrix);
+*   commands->draw_elements(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0);
+*   gl_thread.submit(commands);
+*/
+class CommandBuffer : public MPSCNode {
+public:
+
+    /** \brief Empty constructor.
+    *
+    * Memory will be taken from the arena of the calling thread.
+    */
+    CommandBuffer();
+
+
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator= (const CommandBuffer&) = delete;
+
+
+    /** \brief Destructor. Gives memory back to the arena it comes from.
+    */
+    ~CommandBuffer();
+
+
+    //--- recording -----------------------------------------------------------
+
+    /** \brief Records the binding of a buffer to a non-indexed target.
+    */
+    void bind_buffer(const GLenum target, const Buffer& buffer);
+
+
+    /** \brief Records the binding of a range of a buffer to an indexed target binding point.
+    */
+    void bind_buffer_range(const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size);
+
+
+    /** \brief Records the binding of textures to consecutive texture units.
+    *
+    * The textures names are copied into the command buffer.
+    */
+    void bind_textures(const GLuint first, const GLsizei count, const GLuint* textures);
+
+
+    /** \brief Records the binding of a vertex array.
+    */
+    void bind_vertex_array(const VertexArray& vertex_array);
+
+
+    /** \brief Records a call to a function of the application.
+    *
+    * The function is called in the replaying thread, with the OpenGL
+    * context current.
+    */
+    void call(void (*function)(void*), void* user_data);
+
+
+    /** \brief Records a compute dispatch with the program in use.
+    */
+    void dispatch_compute(const GLuint groups_x, const GLuint groups_y, const GLuint groups_z);
+
+
+    /** \brief Records a non-indexed draw.
+    */
+    void draw_arrays(const GLenum mode, const GLint first, const GLsizei count, const GLsizei instance_count = 1, const GLuint base_instance = 0);
+
+
+    /** \brief Records an indexed draw.
+    *
+    * \param offset : the offset in bytes of the first index in the
+    *       index buffer of the bound vertex array.
+    */
+    void draw_elements(const GLenum mode, const GLsizei count, const GLenum index_type, const GLintptr offset,
+                       const GLint base_vertex = 0, const GLsizei instance_count = 1, const GLuint base_instance = 0);
+
+
+    /** \brief Records a memory barrier.
+    */
+    void memory_barrier(const GLbitfield barriers);
+
+
+    /** \brief Records the setting of contiguous elements of a uniform.
+    *
+    * \param program : a reference to the program the uniform belongs to.
+    * \param slot : the slot of the uniform in the uniforms shadow of
+    *       the program, see UniformsShadow::find().
+    * \param first_element : the index of the first element to set.
+    * \param count : the count of elements to set.
+    * \param values : a pointer to the values, which get copied.
+    * \param size : the size in bytes of the values.
+    *
+    * Nothing gets recorded, with an error message, if the slot does not
+    * exist or if size is not count times the size of the elements of the
+    * uniform, as reflected by the uniforms shadow.
+    */
+    void set_uniform(ShadersProgram& program, const GLint slot, const GLint first_element, const GLsizei count, const void* values, const size_t size);
+
+
+    /** \brief Records the setting of the value of a uniform.
+    */
+    template<typename T>
+    inline void set_uniform(ShadersProgram& program, const GLint slot, const T& value) {
+        set_uniform(program, slot, 0, 1, &value, sizeof(T));
+    }
+
+
+    /** \brief Records an upload of data into a buffer.
+    *
+    * Data get copied into the command buffer.
+    */
+    void upload(Buffer& buffer, const GLintptr offset, const GLsizeiptr size, const void* data);
+
+
+    /** \brief Records the application of a pipeline state.
+    */
+    void use_pipeline(PipelineStateCache& pipeline_states, const PipelineState* state);
+
+
+    /** \brief Records the use of a program.
+    */
+    void use_program(ShadersProgram& program);
+
+
+    //--- replaying -----------------------------------------------------------
+
+    /** \brief Replays all the recorded commands.
+    *
+    * Must be called in the thread where the OpenGL context is current.
+    * Commands are kept: a command buffer can be replayed many times.
+    * Draws and dispatches first issue the memory barriers that are
+    * pending in the tracker of the current context, e.g. the ones
+    * required by called functions.
+    */
+    void execute() const;
+
+
+    /** \brief Removes all the recorded commands, keeping the memory for next recordings.
+    */
+    void clear();
+
+
+    /** \brief Returns the count of recorded commands.
+    */
+    inline const size_t get_commands_count() const {
+        return prvt_commands_count;
+    }
+
+
+    /** \brief Returns the count of bytes used by the recorded commands.
+    */
+    const size_t get_size() const;
+
+
+private:
+    shared_ptr<CommandArena>    prvt_arena;         // the arena memory comes from.
+    CommandArena::Chunk*        prvt_first;         // the first chunk of recorded commands.
+    CommandArena::Chunk*        prvt_last;          // the chunk commands are currently recorded into.
+    size_t                      prvt_commands_count;
+
+    void* prvt_record(const uint32_t opcode, const size_t payload_size);
+};
@@ -0,0 +1,138 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "command_buffer.h"
+#include "mpsc_queue.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of the threads dedicated to OpenGL calls.
+*
+* The thread owns the OpenGL context:  it is made current there by the
+* start function passed to 'start()'. Command buffers recorded in any
+* thread are submitted through a lock-free MPSC queue,  and are replayed
+* in order of submission by this thread, then deleted.
+*
+* Submitting never blocks. When the queue gets empty, the thread goes
+* to sleep until next submission.
+*/
+class CommandThread {
+public:
+
+    /** \brief The statistics of a command thread.
+    */
+    struct Stats {
+        size_t submitted;   //!< the count of submitted command buffers.
+        size_t replayed;    //!< the count of replayed command buffers.
+        size_t commands;    //!< the count of replayed commands.
+    };
+
+
+    /** \brief Empty constructor. The thread is not started.
+    */
+    CommandThread();
+
+
+    CommandThread(const CommandThread&) = delete;
+    CommandThread& operator= (const CommandThread&) = delete;
+
+
+    /** \brief Destructor. Stops the thread if running.
+    */
+    ~CommandThread();
+
+
+    /** \brief Returns a snapshot of the statistics of this command thread.
+    */
+    Stats get_stats() const;
+
+
+    /** \brief Returns true if the thread is running.
+    */
+    inline const bool is_running() const {
+        return prvt_thread.joinable();
+    }
+
+
+    /** \brief Starts the thread.
+    *
+    * \param on_start : a function called first in the thread, e.g.
+    *       to make the OpenGL context current there. May be empty.
+    * \param on_stop : a function called last in the thread, e.g. to
+    *       release the OpenGL context. May be empty.
+    *
+    * \return false if the thread was already running, or true else.
+    */
+    bool start(function<void()> on_start = function<void()>(), function<void()> on_stop = function<void()>());
+
+
+    /** \brief Stops the thread, once all submitted command buffers have been replayed.
+    *
+    * Command buffers that are submitted afterwards, until the thread
+    * gets started again, are deleted with no replay.
+    */
+    void stop();
+
+
+    /** \brief Submits a command buffer for replay.
+    *
+    * May be called from any thread. The command thread takes the
+    * ownership of the command buffer, which gets deleted once
+    * replayed: it must have been allocated with 'new'.
+    */
+    void submit(CommandBuffer* commands);
+
+
+    /** \brief Waits until all the command buffers submitted so far have been replayed.
+    */
+    void wait_idle();
+
+
+private:
+    MPSCQueue<CommandBuffer>    prvt_queue;         // the submitted command buffers.
+    thread                      prvt_thread;        // the command thread.
+    mutable mutex               prvt_mutex;         // protects sleeping and waking up only.
+    condition_variable          prvt_wakeup;        // signaled on submission and on stop.
+    condition_variable          prvt_idle;          // signaled when the queue gets emptied.
+    atomic<bool>                prvt_sleeping;      // true while the command thread sleeps.
+    atomic<bool>                prvt_stopping;      // true once stop has been requested.
+    atomic<size_t>              prvt_submitting;    // the count of submissions in progress.
+    atomic<size_t>              prvt_submitted;
+    atomic<size_t>              prvt_replayed;
+    atomic<size_t>              prvt_commands;
+
+    void prvt_delete_pending();
+    void prvt_run(function<void()> on_start, function<void()> on_stop);
+};
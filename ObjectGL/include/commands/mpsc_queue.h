@@ -0,0 +1,136 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <atomic>
+#include <cstddef>
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The base of the nodes of intrusive MPSC queues.
+*/
+struct MPSCNode {
+    atomic<MPSCNode*> mpsc_next;    //!< the next node in the queue, managed by the queue.
+
+    MPSCNode()
+        : mpsc_next(NULL)
+    {}
+};
+
+
+//===========================================================================
+/** \brief The class of intrusive, lock-free, multi-producers single-consumer queues.
+*
+* This is Dmitry Vyukov's MPSC queue: pushing is wait-free,  with one
+* single atomic exchange, and popping is lock-free. Nodes are not
+* owned by the queue.
+*
+* Any thread may push. Only one thread at a time may pop.
+*
+* \param T : the type of the queued items. It must derive from MPSCNode.
+*/
+template<typename T>
+class MPSCQueue {
+public:
+
+    /** \brief Empty constructor.
+    */
+    MPSCQueue()
+        : prvt_head(&prvt_stub), prvt_tail(&prvt_stub)
+    {}
+
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator= (const MPSCQueue&) = delete;
+
+
+    /** \brief Returns true if no item has been pushed since the last popped one.
+    *
+    * Items may be pushed concurrently: the result is a snapshot.
+    */
+    inline const bool is_empty() const {
+        return prvt_head.load(memory_order_seq_cst) == prvt_tail && prvt_tail == &prvt_stub;
+    }
+
+
+    /** \brief Pops the oldest item of the queue.
+    *
+    * Must be called by the consumer thread only.
+    *
+    * \return a pointer to the popped item,  or NULL if the queue is
+    *       empty or if the pushing of the next item is still in
+    *       progress in some producer thread.
+    */
+    T* pop() {
+        MPSCNode* tail = prvt_tail;
+        MPSCNode* next = tail->mpsc_next.load(memory_order_acquire);
+
+        if (tail == &prvt_stub) {
+            if (next == NULL)
+                return NULL;
+            prvt_tail = tail = next;
+            next = next->mpsc_next.load(memory_order_acquire);
+        }
+
+        if (next != NULL) {
+            prvt_tail = next;
+            return static_cast<T*>(tail);
+        }
+
+        if (tail != prvt_head.load(memory_order_acquire))
+            return NULL;  // a producer is pushing
+
+        prvt_push(&prvt_stub);
+        next = tail->mpsc_next.load(memory_order_acquire);
+        if (next != NULL) {
+            prvt_tail = next;
+            return static_cast<T*>(tail);
+        }
+        return NULL;
+    }
+
+
+    /** \brief Pushes an item at the end of the queue.
+    *
+    * May be called from any thread.
+    */
+    inline void push(T* item) {
+        prvt_push(item);
+    }
+
+
+private:
+    atomic<MPSCNode*>   prvt_head;  // the last pushed node, exchanged by producers.
+    MPSCNode*           prvt_tail;  // the next node to be popped, accessed by the consumer only.
+    MPSCNode            prvt_stub;  // the stub node, never returned by pop().
+
+    inline void prvt_push(MPSCNode* node) {
+        node->mpsc_next.store(NULL, memory_order_relaxed);
+        MPSCNode* previous = prvt_head.exchange(node, memory_order_seq_cst);
+        previous->mpsc_next.store(node, memory_order_release);
+    }
+};
@@ -0,0 +1,170 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "GL/glew.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The backends that the OpenGL calls of ObjectGL get dispatched to.
+*
+* All the OpenGL calls issued by ObjectGL go through function pointers:
+* the ones loaded by GLEW and the ones of trace/gl_dispatch.h for the
+* OpenGL 1.1 calls.  The tables of trace/gl_calls.h list them all, and
+* are the dispatch table that this class swaps between three backends:
+*   - REAL: the OpenGL entry points, as loaded by GLEW.  This is the
+*     default one, which adds no cost to the calls;
+*   - MOCK: no OpenGL at all.  Calls are counted and get plausible
+*     answers: new names, successful compilations and linkings, all
+*     extensions supported, programs binaries, memory for mapped buf-
+*     fers, signaled fences, and configurable subroutines and uniforms
+*     (see 'set_mock_subroutines()' and 'set_mock_uniforms()').  No
+*     context is needed, so that the CPU overhead of ObjectGL itself
+*     can be measured or tested apart from any driver cost;
+*   - VALIDATING: the OpenGL entry points, each followed by a call to
+*     glGetError() which reports any error with the name of the call.
+*     Calls are counted too.  Very slow, for debugging purposes.
+*
+* Usage:
+*   // with no context, e.g. in benchmarks
+*   GLBackend::set(GLBackend::MOCK);
+*   ShadersProgram program(shaders);
+*   cout << GLBackend::get_calls_count("glLinkProgram") << endl;
+*
+*   // right after glewInit() in the current context
+*   GLBackend::set(GLBackend::VALIDATING);
+*
+* Notice: the backend must be set after glewInit(), which would load
+*   the OpenGL entry points again,  and cannot be changed while
+*   GLTrace is capturing.  Counters are not synchronized:  as for
+*   OpenGL contexts,  calls are expected to be issued from a single
+*   thread.
+*/
+class GLBackend {
+public:
+
+    /** \brief The types of backends.
+    */
+    enum Type {
+        REAL,       //!< the OpenGL entry points.
+        MOCK,       //!< counted calls, with no OpenGL at all.
+        VALIDATING  //!< the OpenGL entry points, counted and checked with glGetError().
+    };
+
+
+    /** \brief Dispatches all the OpenGL calls of ObjectGL to a backend.
+    *
+    * Switching to MOCK also sets the GLEW flags of the versions and
+    * extensions that ObjectGL checks, which get restored on switching
+    * back.  Calls counters are left unchanged.
+    *
+    * \param type : the type of the backend.
+    *
+    * \return false if GLTrace is capturing, or true else.
+    */
+    static bool set(const Type type);
+
+
+    /** \brief Returns the type of the current backend.
+    */
+    static inline const Type get() {
+        return prvt_type;
+    }
+
+
+    /** \brief Returns the count of the calls dispatched to the MOCK and VALIDATING backends since the last reset.
+    */
+    static uint64_t get_calls_count();
+
+
+    /** \brief Returns the count of calls to one OpenGL function since the last reset.
+    *
+    * \param function_name : the name of the function, e.g. "glUseProgram".
+    *
+    * \return 0 for unknown functions.
+    */
+    static uint64_t get_calls_count(const string& function_name);
+
+
+    /** \brief Gets the counts of calls per OpenGL function since the last reset.
+    *
+    * \param counts : the names of the called functions with their
+    *       counts of calls, in alphabetical order.  Functions that
+    *       have not been called are left out.
+    */
+    static void get_calls_counts(vector<pair<string, uint64_t>>& counts);
+
+
+    /** \brief Resets all the counters of calls and of errors.
+    */
+    static void reset_counts();
+
+
+    /** \brief Returns the count of the OpenGL errors reported by the VALIDATING backend since the last reset.
+    */
+    static uint64_t get_errors_count();
+
+
+    /** \brief Sets the subroutines that the MOCK backend reports for all programs.
+    *
+    * Functions are named "function0", "function1", ... and uniforms
+    * "uniform0", "uniform1", ... with locations 0, 1, ...  All the
+    * functions are compatible with all the uniforms.  Programs have
+    * no subroutines unless set.
+    *
+    * \param shader_type : the stage that contains subroutines, e.g.
+    *       GL_FRAGMENT_SHADER.
+    * \param uniforms_count : the count of subroutine uniforms, or 0
+    *       for no subroutines.
+    * \param functions_count : the count of subroutine functions.
+    */
+    static void set_mock_subroutines(const GLenum shader_type, const GLint uniforms_count, const GLint functions_count);
+
+
+    /** \brief Sets the default block uniforms that the MOCK backend reports for all programs.
+    *
+    * Uniforms are named "value0", "value1", ... and all get the same
+    * type and the same count of elements. Their locations follow
+    * each other, one per element.  Programs have no uniforms unless
+    * set.
+    *
+    * \param type : the GLSL type of the uniforms, e.g. GL_FLOAT_VEC4.
+    * \param uniforms_count : the count of uniforms, or 0 for none.
+    * \param array_size : the count of elements of each uniform.
+    *       Defaults to 1.
+    */
+    static void set_mock_uniforms(const GLenum type, const GLint uniforms_count, const GLint array_size = 1);
+
+
+private:
+    static Type prvt_type;
+};
@@ -0,0 +1,226 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "context/gl_state.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of headless OpenGL contexts, for server-side rendering.
+*
+* Contexts are created with no window system at all (no X11, no
+* Wayland), on the first available platform of:
+*   - EGL on a device (EGL_EXT_platform_device), e.g. a GPU of a
+*     headless server or the software device of Mesa;
+*   - EGL on the surfaceless platform of Mesa (EGL_MESA_platform_surfaceless),
+*     e.g. with llvmpipe: LIBGL_ALWAYS_SOFTWARE=1;
+*   - OSMesa, loaded at run time from libOSMesa when available.
+*
+* Each context may get an offscreen default framebuffer, with RGBA8
+* color and depth-stencil buffers: an EGL pbuffer surface, or the
+* OSMesa color buffer.  Framebuffer 0 then is this one, as for window
+* contexts, and can be read back with 'read_pixels()'.  Without it,
+* rendering targets application framebuffer objects only.
+*
+* Worker threads get contexts that share the objects of a main one,
+* e.g. to compile shaders or to upload buffers in parallel:
+*   GLContext main_context(config);             // current in this thread
+*   GLContext worker_context(main_context);     // to be made current in the worker thread
+*   thread worker([&] { worker_context.make_current(); ... });
+*
+* The first context made current loads the OpenGL entry points: with
+* glewInit() for EGL, or from the tables of trace/gl_calls.h for OSMesa
+* which GLEW cannot load from.  Each context has its own GLStateCache,
+* which gets current with it.
+*
+* Notice: all the contexts of a process are expected to be created on
+*   the same platform, and before GLBackend gets set.
+*/
+class GLContext {
+public:
+
+    /** \brief The platforms of contexts.
+    */
+    enum Platform {
+        PLATFORM_ANY,               //!< the first available platform, in the order of the following ones.
+        PLATFORM_EGL_DEVICE,        //!< EGL on a device, see 'Config::device'.
+        PLATFORM_EGL_SURFACELESS,   //!< EGL on the surfaceless platform of Mesa.
+        PLATFORM_OSMESA             //!< OSMesa, loaded from libOSMesa.
+    };
+
+
+    /** \brief The configuration of contexts.
+    */
+    struct Config {
+        Platform    platform;       //!< the platform of the context.
+        int         major_version;  //!< the major number of the OpenGL version.
+        int         minor_version;  //!< the minor number of the OpenGL version.
+        bool        core_profile;   //!< true for a core profile context, false for a compatibility one.
+        bool        debug;          //!< true for a debug context.
+        GLsizei     width;          //!< the width of the offscreen default framebuffer, or 0 for none.
+        GLsizei     height;         //!< the height of the offscreen default framebuffer, or 0 for none.
+        GLsizei     samples;        //!< the count of samples of the default framebuffer, 0 for no multisampling (EGL only).
+        int         device;         //!< the index of the EGL device, for PLATFORM_EGL_DEVICE.
+
+        /** \brief Default constructor: an OpenGL 4.5 core context on any platform, with no default framebuffer. */
+        Config()
+            : platform(PLATFORM_ANY), major_version(4), minor_version(5), core_profile(true), debug(false),
+              width(0), height(0), samples(0), device(0)
+        {}
+    };
+
+
+    /** \brief Creates a context and makes it current in the calling thread.
+    *
+    * \param config : the configuration of the context.
+    *
+    * Notice: check 'is_ok()' after construction.
+    */
+    GLContext(const Config& config = Config());
+
+
+    /** \brief Creates a context that shares the objects of another one.
+    *
+    * The new context is not made current: it is expected to be made
+    * current in another thread with 'make_current()'.
+    *
+    * \param shared : the context which objects get shared, with the
+    *        configuration of which the new one gets created.
+    * \param width : the width of the offscreen default framebuffer of
+    *        the new context, or 0 for none.
+    * \param height : the height of the offscreen default framebuffer
+    *        of the new context, or 0 for none.
+    *
+    * Notice: check 'is_ok()' after construction.
+    */
+    GLContext(GLContext& shared, const GLsizei width = 0, const GLsizei height = 0);
+
+
+    /** \brief Copy constructor is not allowed on contexts.
+    */
+    GLContext(const GLContext& copy) = delete;
+
+
+    /** \brief Destructor.
+    *
+    * The context must not be current in another thread.
+    */
+    ~GLContext();
+
+
+    /** \brief Returns true if the context has been created.
+    */
+    inline const bool is_ok() const {
+        return prvt_context != NULL;
+    }
+
+
+    /** \brief Makes this context current in the calling thread, with its state cache.
+    *
+    * \return false if this context is not ok or cannot be made
+    *       current, or true else.
+    */
+    bool make_current();
+
+
+    /** \brief Releases this context from the calling thread, in which it must be current.
+    */
+    void done_current();
+
+
+    /** \brief Returns the platform this context has been created on.
+    */
+    inline const Platform get_platform() const {
+        return prvt_platform;
+    }
+
+
+    /** \brief Returns the name of a platform.
+    */
+    static const char* get_platform_name(const Platform platform);
+
+
+    /** \brief Returns the width of the offscreen default framebuffer, 0 for none.
+    */
+    inline const GLsizei get_width() const {
+        return prvt_width;
+    }
+
+
+    /** \brief Returns the height of the offscreen default framebuffer, 0 for none.
+    */
+    inline const GLsizei get_height() const {
+        return prvt_height;
+    }
+
+
+    /** \brief Returns the state cache of this context.
+    */
+    inline GLStateCache& get_state_cache() {
+        return prvt_state_cache;
+    }
+
+
+    /** \brief Reads back the color buffer of the offscreen default framebuffer.
+    *
+    * Reads the current read framebuffer, which is the default one
+    * unless another framebuffer has been bound for reading.  This
+    * context must be current in the calling thread.
+    *
+    * \param rgba : the RGBA8 pixels, rows from bottom to top.
+    *
+    * \return false if this context has no default framebuffer, or
+    *       true else.
+    */
+    bool read_pixels(vector<unsigned char>& rgba);
+
+
+    /** Class method. Returns the context current in the calling thread, or NULL if none.
+    */
+    static GLContext* get_current();
+
+
+private:
+    Platform        prvt_platform;
+    Config          prvt_config;            // the configuration of this context.
+    void*           prvt_display;           // EGL: the display.
+    void*           prvt_egl_config;        // EGL: the frame buffer configuration, NULL for none.
+    void*           prvt_surface;           // EGL: the pbuffer surface, NULL for none.
+    void*           prvt_context;           // EGL or OSMesa: the context.
+    GLsizei         prvt_width;
+    GLsizei         prvt_height;
+    vector<unsigned char> prvt_color_buffer; // OSMesa: the color buffer of the default framebuffer.
+    GLStateCache    prvt_state_cache;       // the state cache of this context.
+
+    bool prvt_create_egl(const Platform platform, GLContext* shared);
+    bool prvt_create_osmesa(GLContext* shared);
+    void prvt_destroy();
+};
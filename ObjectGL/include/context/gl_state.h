@@ -0,0 +1,427 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+
+#include "GL/glew.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of caches of the OpenGL state of contexts.
+*
+* One state cache is associated with each OpenGL context. All ObjectGL
+* objects  go  through the state cache of the current context when
+* binding themselves or setting rendering states,  so  that  calls
+* that would not change the OpenGL state are skipped.
+*
+* Binding many textures, samplers or buffer ranges at once is done
+* with the ARB_multi_bind calls (e.g. glBindTextures()), restricted
+* to the range of units whose binding actually changes.
+*
+* The cache has to be resynchronized with 'invalidate()' once foreign
+* code (e.g. another library) has issued OpenGL calls: the whole state
+* is then unknown and the next call for each piece of state is issued.
+*
+* Counters of issued versus elided calls are maintained per frame.
+*
+* Notice: the state cache of a context must be used only by the
+*   thread the context is current in. A default cache is provided
+*   per thread,  which suits applications that use one context
+*   per thread. Others should associate their own caches with
+*   their contexts with 'set_current()'.
+*/
+class GLStateCache {
+public:
+
+    /** \brief The counters of calls that have been issued or elided.
+    *
+    * For batched bindings, each unit whose binding was already set
+    * counts as one elided call.
+    */
+    struct Stats {
+        size_t issued;  //!< the count of OpenGL calls that have been issued.
+        size_t elided;  //!< the count of OpenGL calls that have been skipped as redundant.
+    };
+
+
+    /** \brief The count of texture units, samplers units and indexed buffer bindings tracked per target.
+    *
+    * Units and indices beyond this count are never cached: calls
+    * are always issued for them.
+    */
+    static const GLuint MAX_TRACKED_UNITS = 32;
+
+
+    /** \brief Empty constructor.
+    *
+    * The whole state is initially unknown.
+    */
+    GLStateCache();
+
+
+    //--- programs, vertex arrays and buffers -------------------------------
+
+    /** \brief Binds a buffer to a non-indexed target.
+    *
+    * Bindings are cached for targets GL_ARRAY_BUFFER,
+    * GL_DRAW_INDIRECT_BUFFER,     GL_DISPATCH_INDIRECT_BUFFER,
+    * GL_PARAMETER_BUFFER,  GL_PIXEL_PACK_BUFFER,  GL_PIXEL_UNPACK_BUFFER
+    * and GL_QUERY_BUFFER.
+    *
+    * \return true if the call has been issued, or false if elided.
+    */
+    bool bind_buffer(const GLenum target, const GLuint buffer);
+
+
+    /** \brief Binds a whole buffer to an indexed target binding point.
+    *
+    * Indexed bindings are cached for targets GL_UNIFORM_BUFFER,
+    * GL_SHADER_STORAGE_BUFFER and GL_ATOMIC_COUNTER_BUFFER.
+    */
+    bool bind_buffer_base(const GLenum target, const GLuint index, const GLuint buffer);
+
+
+    /** \brief Binds a range of a buffer to an indexed target binding point.
+    */
+    bool bind_buffer_range(const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size);
+
+
+    /** \brief Binds ranges of buffers to consecutive indexed target binding points.
+    *
+    * Only the changing sub-range of binding points is bound, with one
+    * single call to glBindBuffersRange() when ARB_multi_bind is
+    * available.
+    *
+    * \return true if a call has been issued, or false if all the
+    *       bindings were already set.
+    */
+    bool bind_buffers_range(const GLenum target, const GLuint first, const GLsizei count, const GLuint* buffers, const GLintptr* offsets, const GLsizeiptr* sizes);
+
+
+    /** \brief Binds a vertex array.
+    */
+    bool bind_vertex_array(const GLuint vertex_array);
+
+
+    /** \brief Uses a program.
+    *
+    * \return true if glUseProgram() has been issued,  or  false if
+    *       the program was already in use.
+    */
+    bool use_program(const GLuint program);
+
+
+    //--- textures and samplers ---------------------------------------------
+
+    /** \brief Binds a sampler to a texture unit.
+    */
+    bool bind_sampler(const GLuint unit, const GLuint sampler);
+
+
+    /** \brief Binds samplers to consecutive texture units.
+    *
+    * Only the changing sub-range of units is bound, with one single
+    * call to glBindSamplers() when ARB_multi_bind is available.
+    */
+    bool bind_samplers(const GLuint first, const GLsizei count, const GLuint* samplers);
+
+
+    /** \brief Binds a texture to a texture unit.
+    *
+    * Needs ARB_multi_bind or ARB_direct_state_access, since textures
+    * are bound with no target.
+    */
+    bool bind_texture(const GLuint unit, const GLuint texture);
+
+
+    /** \brief Binds textures to consecutive texture units.
+    *
+    * Only the changing sub-range of units is bound, with one single
+    * call to glBindTextures() when ARB_multi_bind is available.
+    */
+    bool bind_textures(const GLuint first, const GLsizei count, const GLuint* textures);
+
+
+    //--- fixed functions states --------------------------------------------
+
+    /** \brief Sets the blend equations, with glBlendEquationSeparate().
+    */
+    bool blend_equation(const GLenum mode_rgb, const GLenum mode_alpha);
+
+
+    /** \brief Sets the blend functions, with glBlendFuncSeparate().
+    */
+    bool blend_func(const GLenum src_rgb, const GLenum dst_rgb, const GLenum src_alpha, const GLenum dst_alpha);
+
+
+    /** \brief Sets the color write mask.
+    */
+    bool color_mask(const bool red, const bool green, const bool blue, const bool alpha);
+
+
+    /** \brief Sets the faces that are culled.
+    */
+    bool cull_face(const GLenum mode);
+
+
+    /** \brief Sets the depth comparison function.
+    */
+    bool depth_func(const GLenum func);
+
+
+    /** \brief Enables or disables writes into the depth buffer.
+    */
+    bool depth_mask(const bool enabled);
+
+
+    /** \brief Disables a capability.
+    */
+    inline bool disable(const GLenum capability) {
+        return set_capability(capability, false);
+    }
+
+
+    /** \brief Enables a capability.
+    */
+    inline bool enable(const GLenum capability) {
+        return set_capability(capability, true);
+    }
+
+
+    /** \brief Sets the orientation of front-facing polygons.
+    */
+    bool front_face(const GLenum mode);
+
+
+    /** \brief Sets the rasterization mode of polygons, for both faces.
+    */
+    bool polygon_mode(const GLenum mode);
+
+
+    /** \brief Sets the scale and units of the depth offset of polygons.
+    */
+    bool polygon_offset(const GLfloat factor, const GLfloat units);
+
+
+    /** \brief Sets the scissor box.
+    */
+    bool scissor(const GLint x, const GLint y, const GLsizei width, const GLsizei height);
+
+
+    /** \brief Sets the stencil test function, reference value and mask, for both faces.
+    */
+    bool stencil_func(const GLenum func, const GLint reference, const GLuint mask);
+
+
+    /** \brief Sets the mask of the bits written into the stencil buffer, for both faces.
+    */
+    bool stencil_mask(const GLuint mask);
+
+
+    /** \brief Sets the stencil test actions, for both faces.
+    */
+    bool stencil_op(const GLenum stencil_fail, const GLenum depth_fail, const GLenum depth_pass);
+
+
+    /** \brief Enables or disables a capability.
+    *
+    * States are cached for capabilities GL_BLEND,  GL_CULL_FACE,
+    * GL_DEPTH_CLAMP,   GL_DEPTH_TEST,   GL_FRAMEBUFFER_SRGB,
+    * GL_MULTISAMPLE,  GL_POLYGON_OFFSET_FILL,  GL_PRIMITIVE_RESTART,
+    * GL_PRIMITIVE_RESTART_FIXED_INDEX,   GL_PROGRAM_POINT_SIZE,
+    * GL_RASTERIZER_DISCARD,    GL_SAMPLE_ALPHA_TO_COVERAGE,
+    * GL_SCISSOR_TEST,    GL_STENCIL_TEST    and
+    * GL_TEXTURE_CUBE_MAP_SEAMLESS. Other capabilities are always set.
+    */
+    bool set_capability(const GLenum capability, const bool enabled);
+
+
+    /** \brief Sets the viewport.
+    */
+    bool viewport(const GLint x, const GLint y, const GLsizei width, const GLsizei height);
+
+
+    //--- synchronization ---------------------------------------------------
+
+    /** \brief Marks the whole state as unknown.
+    *
+    * To be called once foreign code has issued OpenGL calls,  for
+    * instance after a third-party library has rendered its stuff.
+    * The next call for each piece of state will then be issued.
+    */
+    void invalidate();
+
+
+    /** \brief Forgets all the bindings of a buffer that is being deleted.
+    *
+    * OpenGL unbinds deleted buffers,  while their names may be reused
+    * right away for new buffers.
+    */
+    void on_buffer_deleted(const GLuint buffer);
+
+
+    /** \brief Forgets all the bindings of a sampler that is being deleted.
+    */
+    void on_sampler_deleted(const GLuint sampler);
+
+
+    /** \brief Forgets all the bindings of a texture that is being deleted.
+    */
+    void on_texture_deleted(const GLuint texture);
+
+
+    /** \brief Forgets the binding of a vertex array that is being deleted.
+    */
+    void on_vertex_array_deleted(const GLuint vertex_array);
+
+
+    //--- statistics ----------------------------------------------------------
+
+    /** \brief Ends the current frame.
+    *
+    * The counters of the current frame become the ones of the last
+    * frame, and get reset.
+    */
+    void end_frame();
+
+
+    /** \brief Returns the counters of the current frame.
+    */
+    inline const Stats& get_frame_stats() const {
+        return prvt_frame_stats;
+    }
+
+
+    /** \brief Returns the counters of the last ended frame.
+    */
+    inline const Stats& get_last_frame_stats() const {
+        return prvt_last_frame_stats;
+    }
+
+
+    /** \brief Returns the counters accumulated since the creation of this cache.
+    */
+    inline const Stats& get_total_stats() const {
+        return prvt_total_stats;
+    }
+
+
+    //--- current cache -------------------------------------------------------
+
+    /** Class method. Returns the state cache of the current context of the calling thread.
+    *
+    * If none has been set, this is the default cache of the thread.
+    */
+    static GLStateCache& get_current();
+
+
+    /** Class method. Sets the state cache of the context that has just been made current in the calling thread.
+    *
+    * \param cache : a pointer to the state cache, or NULL to get
+    *       back to the default cache of the thread.
+    */
+    static void set_current(GLStateCache* cache);
+
+
+private:
+    static const GLuint UNKNOWN = 0xffffffff;   // the value of unknown names.
+    static const GLuint CAPABILITIES_COUNT = 15;
+    static const GLuint BUFFER_TARGETS_COUNT = 7;
+    static const GLuint INDEXED_TARGETS_COUNT = 3;
+
+    struct BufferRange {
+        GLuint      buffer;
+        GLintptr    offset;
+        GLsizeiptr  size;   // -1 for whole buffers
+    };
+
+    // the bits of the pieces of fixed functions state that are known
+    enum KnownStates : uint32_t {
+        KNOWN_BLEND_EQUATION  = 1 << 0,
+        KNOWN_BLEND_FUNC      = 1 << 1,
+        KNOWN_COLOR_MASK      = 1 << 2,
+        KNOWN_CULL_FACE       = 1 << 3,
+        KNOWN_DEPTH_FUNC      = 1 << 4,
+        KNOWN_DEPTH_MASK      = 1 << 5,
+        KNOWN_FRONT_FACE      = 1 << 6,
+        KNOWN_POLYGON_MODE    = 1 << 7,
+        KNOWN_POLYGON_OFFSET  = 1 << 8,
+        KNOWN_SCISSOR         = 1 << 9,
+        KNOWN_VIEWPORT        = 1 << 10,
+        KNOWN_STENCIL_FUNC    = 1 << 11,
+        KNOWN_STENCIL_MASK    = 1 << 12,
+        KNOWN_STENCIL_OP      = 1 << 13
+    };
+
+    GLuint      prvt_program;
+    GLuint      prvt_vertex_array;
+    GLuint      prvt_buffers[BUFFER_TARGETS_COUNT];
+    BufferRange prvt_buffer_ranges[INDEXED_TARGETS_COUNT][MAX_TRACKED_UNITS];
+    GLuint      prvt_textures[MAX_TRACKED_UNITS];
+    GLuint      prvt_samplers[MAX_TRACKED_UNITS];
+    int8_t      prvt_capabilities[CAPABILITIES_COUNT];  // -1 when unknown
+
+    uint32_t    prvt_known;             // the KnownStates bits of the known fixed functions states.
+    GLenum      prvt_blend_equation[2];
+    GLenum      prvt_blend_func[4];
+    bool        prvt_color_mask[4];
+    GLenum      prvt_cull_face;
+    GLenum      prvt_depth_func;
+    bool        prvt_depth_mask;
+    GLenum      prvt_front_face;
+    GLenum      prvt_polygon_mode;
+    GLfloat     prvt_polygon_offset[2];
+    GLint       prvt_scissor[4];
+    GLint       prvt_viewport[4];
+    GLenum      prvt_stencil_func;
+    GLint       prvt_stencil_reference;
+    GLuint      prvt_stencil_read_mask;
+    GLuint      prvt_stencil_write_mask;
+    GLenum      prvt_stencil_op[3];
+
+    Stats       prvt_frame_stats;
+    Stats       prvt_last_frame_stats;
+    Stats       prvt_total_stats;
+
+    inline bool prvt_issue(const size_t count = 1) {
+        prvt_frame_stats.issued += count;
+        prvt_total_stats.issued += count;
+        return true;
+    }
+
+    inline bool prvt_elide(const size_t count = 1) {
+        prvt_frame_stats.elided += count;
+        prvt_total_stats.elided += count;
+        return false;
+    }
+
+    static int prvt_buffer_target_index(const GLenum target);
+    static int prvt_capability_index(const GLenum capability);
+    static int prvt_indexed_target_index(const GLenum target);
+};
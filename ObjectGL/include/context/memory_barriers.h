@@ -0,0 +1,172 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "GL/glew.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of trackers of the memory barriers needed after incoherent shader writes.
+*
+* Writes done by shaders into shader storage buffers, images or atomic
+* counters are incoherent: before reading the written resources in any
+* other way,  a  memory barrier must be issued with the barrier bit
+* related to the kind of reading.  Issuing GL_ALL_BARRIER_BITS after
+* each dispatch is correct but wastes GPU time.
+*
+* This tracker records which buffers and textures have been written by
+* shaders, and which barrier bits have been issued since then. Readers
+* declare their kind of reading with 'require_buffer()' or
+* 'require_texture()'. Only the missing bits get accumulated,  and are
+* issued at once by 'flush()', right before the reading commands.
+*
+* Usage:
+*   MemoryBarriers& barriers = MemoryBarriers::get_current();
+*   particles.dispatch_for(count);   // writes 'positions' as SSBO
+*   barriers.require_buffer(positions.name, GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+*   barriers.flush();
+*   ... draw with 'positions' as vertex buffer ...
+*
+* One tracker is associated with each OpenGL context,  as for the
+* state cache.
+*/
+class MemoryBarriers {
+public:
+
+    /** \brief The statistics of a memory barriers tracker.
+    */
+    struct Stats {
+        size_t barriers;    //!< the count of issued glMemoryBarrier() calls.
+        size_t required;    //!< the count of requirements declared on written resources.
+        size_t elided;      //!< the count of requirements already covered by previously issued barriers.
+    };
+
+
+    /** \brief Empty constructor.
+    */
+    MemoryBarriers();
+
+
+    /** \brief Issues the accumulated barrier bits, if any.
+    *
+    * \return the issued barrier bits, or 0 if none.
+    */
+    GLbitfield flush();
+
+
+    /** \brief Returns the barrier bits that are waiting for next flush.
+    */
+    inline const GLbitfield get_pending() const {
+        return prvt_pending;
+    }
+
+
+    /** \brief Returns the statistics of this tracker.
+    */
+    inline const Stats& get_stats() const {
+        return prvt_stats;
+    }
+
+
+    /** \brief Records that a buffer has been written by shaders (storage buffer, atomic counters, ...).
+    */
+    inline void on_buffer_written(const GLuint buffer) {
+        prvt_on_written(prvt_key(buffer, false));
+    }
+
+
+    /** \brief Records that a texture has been written by shaders, as an image.
+    */
+    inline void on_texture_written(const GLuint texture) {
+        prvt_on_written(prvt_key(texture, true));
+    }
+
+
+    /** \brief Declares a coming reading of a buffer.
+    *
+    * \param buffer : the OpenGL identifier of the buffer.
+    * \param barrier_bits : the barrier bits related to the kind of
+    *       reading, e.g. GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT for vertex
+    *       attributes fetch, GL_COMMAND_BARRIER_BIT for indirect commands,
+    *       GL_UNIFORM_BARRIER_BIT for uniform blocks,  or
+    *       GL_SHADER_STORAGE_BARRIER_BIT for storage blocks.
+    */
+    inline void require_buffer(const GLuint buffer, const GLbitfield barrier_bits) {
+        prvt_require(prvt_key(buffer, false), barrier_bits);
+    }
+
+
+    /** \brief Declares a coming reading of a texture.
+    *
+    * \param texture : the OpenGL identifier of the texture.
+    * \param barrier_bits : the barrier bits related to the kind of
+    *       reading,   e.g.   GL_TEXTURE_FETCH_BARRIER_BIT  for sampling,
+    *       GL_SHADER_IMAGE_ACCESS_BARRIER_BIT for image loads, or
+    *       GL_FRAMEBUFFER_BARRIER_BIT for framebuffer attachments.
+    */
+    inline void require_texture(const GLuint texture, const GLbitfield barrier_bits) {
+        prvt_require(prvt_key(texture, true), barrier_bits);
+    }
+
+
+    /** \brief Forgets all the written resources.
+    *
+    * To be called once a full barrier has been issued by foreign code,
+    * e.g. at end of frame after a GL_ALL_BARRIER_BITS barrier.
+    */
+    void reset();
+
+
+    /** Class method. Returns the memory barriers tracker of the current context of the calling thread.
+    */
+    static MemoryBarriers& get_current();
+
+
+    /** Class method. Sets the memory barriers tracker of the context that has just been made current in the calling thread.
+    *
+    * \param barriers : a pointer to the tracker, or NULL to get back
+    *       to the default tracker of the thread.
+    */
+    static void set_current(MemoryBarriers* barriers);
+
+
+private:
+    unordered_map<uint64_t, GLbitfield> prvt_written;   // the barrier bits issued since last write, per written resource.
+    GLbitfield                          prvt_pending;   // the bits waiting for next flush.
+    Stats                               prvt_stats;
+
+    static inline uint64_t prvt_key(const GLuint name, const bool is_texture) {
+        return (uint64_t(is_texture) << 32) | name;
+    }
+
+    void prvt_on_written(const uint64_t key);
+    void prvt_require(const uint64_t key, const GLbitfield barrier_bits);
+};
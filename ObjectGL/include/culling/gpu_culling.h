@@ -0,0 +1,297 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <vector>
+
+#include "GL/glew.h"
+#include "Eigen/Core"
+
+#include "buffers/buffers.h"
+#include "buffers/indirect_buffer.h"
+#include "buffers/storage_buffer.h"
+#include "pipeline/pipeline_state.h"
+#include "shaders/compute_program.h"
+#include "shaders/compute_shader.h"
+#include "shaders/uniform.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The indexed geometry of a mesh, as referenced by culled instances.
+*
+* Matches the std430 layout of the culling shader.
+*/
+struct CullingMesh {
+    GLuint count;           //!< the count of indices.
+    GLuint first_index;     //!< the index of the first index in the index buffer.
+    GLint  base_vertex;     //!< the value added to each index.
+    GLuint padding;
+};
+
+
+//===========================================================================
+/** \brief The bounds of an instance, as tested by the culling shader.
+*
+* Instances are bounded either by a sphere, when all extents are
+* zero,  or by an axis-aligned box centered on the sphere center.
+* Matches the std430 layout of the culling shader.
+*/
+struct CullingInstance {
+    GLfloat center[3];      //!< the center of the bounds, in world space.
+    GLfloat radius;         //!< the radius of the bounding sphere.
+    GLfloat extents[3];     //!< the half extents of the bounding box, or zeros.
+    GLuint  mesh;           //!< the index of the mesh of this instance.
+};
+
+
+//===========================================================================
+/** \brief The class of GPU-driven frustum and occlusion culling stages.
+*
+* The bounds of up to 'max_instances' instances live in a  shader
+* storage  buffer.  Each frame,  one compute dispatch tests all of
+* them against the view frustum and, optionally, against a
+* hierarchical-Z pyramid built from the depth buffer of the previous
+* frame.  The draw commands of visible instances are written into an
+* indirect buffer,  their base instance being set to the index of the
+* instance, so that vertex shaders fetch their per-instance data with
+* gl_BaseInstance.  No CPU round trip is involved.
+*
+* When ARB_indirect_parameters (or OpenGL 4.6) is available,  visible
+* commands are stream-compacted and drawn with
+* glMultiDrawElementsIndirectCount(), the count of draws being read
+* from a GPU buffer.  Otherwise,  one command is written per instance,
+* with an instance count of 0 for culled ones, and drawn with
+* glMultiDrawElementsIndirect().
+*
+* The HiZ pyramid is a GL_R32F texture whose level 0 has half the
+* size of the depth buffer, each texel keeping the farthest depth of
+* the texels it covers. Depth is expected to be in [0, 1] with
+* GL_LESS-like testing.
+*
+* Usage:
+*   GPUCulling culling(100000, 64);
+*   culling.set_meshes(meshes.data(), meshes.size());
+*   culling.set_instances(instances.data(), instances.size());
+*   ... each frame:
+*   culling.cull(projection * view);
+*   culling.draw(pipeline_states, state, GL_TRIANGLES);
+*   ... render the rest of the frame, then:
+*   culling.build_hiz(depth_texture, width, height);
+*/
+class GPUCulling {
+public:
+
+    /** \brief Constructor.
+    *
+    * \param max_instances : the maximal count of culled instances.
+    * \param max_meshes : the maximal count of meshes.
+    * \param verbose : set this to true to get verbose compilation
+    *       and linking of the culling shaders. Defaults to false.
+    * \param compact : set this to false to get one draw command per
+    *       instance even when the count of draws may be read from a
+    *       buffer, e.g. to check or to time the fallback path.
+    *       Defaults to true.
+    */
+    GPUCulling(const GLuint max_instances, const GLuint max_meshes, const bool verbose = false, const bool compact = true);
+
+
+    /** \brief Destructor.
+    */
+    ~GPUCulling();
+
+
+    GPUCulling(const GPUCulling& copy) = delete;
+    GPUCulling& operator= (const GPUCulling& copy) = delete;
+
+
+    /** \brief Builds the hierarchical-Z pyramid from a depth texture.
+    *
+    * To be called once the depth buffer of a frame is complete.  The
+    * pyramid is used by the occlusion tests of the next calls to
+    * 'cull()'. It gets (re)allocated when the size of the depth
+    * texture changes.
+    *
+    * \param depth_texture : the OpenGL identifier of a 2D depth texture.
+    * \param width : the width of the depth texture.
+    * \param height : the height of the depth texture.
+    */
+    void build_hiz(const GLuint depth_texture, const GLsizei width, const GLsizei height);
+
+
+    /** \brief Tests all instances and writes the draw commands of the visible ones.
+    *
+    * \param view_projection : the view-projection matrix of the frame.
+    * \param occlusion : set this to false to skip occlusion tests.
+    *       Occlusion tests are skipped anyway when no HiZ pyramid has
+    *       been built yet. Defaults to true.
+    */
+    void cull(const Eigen::Matrix4f& view_projection, const bool occlusion = true);
+
+
+    /** \brief Draws the visible instances, with the draw commands written by the last call to 'cull()'.
+    *
+    * \param pipeline_states : a reference to the cache of the
+    *       pipeline state.
+    * \param state : the pipeline state of all instances.
+    * \param mode : the primitives mode, e.g. GL_TRIANGLES.
+    * \param index_type : the type of indices. Defaults to
+    *       GL_UNSIGNED_INT.
+    */
+    void draw(PipelineStateCache& pipeline_states, const PipelineState* state, const GLenum mode, const GLenum index_type = GL_UNSIGNED_INT);
+
+
+    /** \brief Returns the OpenGL identifier of the HiZ pyramid texture, or 0 if not built yet.
+    */
+    inline const GLuint get_hiz_texture() const {
+        return prvt_hiz_texture;
+    }
+
+
+    /** \brief Returns the count of levels of the HiZ pyramid.
+    */
+    inline const GLint get_hiz_levels() const {
+        return prvt_hiz_levels;
+    }
+
+
+    /** \brief Returns the count of instances currently set.
+    */
+    inline const GLuint get_instances_count() const {
+        return prvt_instances_count;
+    }
+
+
+    /** \brief Returns the count of visible instances found by the last call to 'cull()'.
+    *
+    * Synchronizes with the GPU: meant for tests and statistics only.
+    */
+    GLuint get_visible_count();
+
+
+    /** \brief Gets the indices of the visible instances found by the last call to 'cull()', in increasing order.
+    *
+    * Synchronizes with the GPU: meant for tests and statistics only.
+    */
+    void get_visible_instances(vector<GLuint>& visible);
+
+
+    /** \brief Returns true when draws get compacted and drawn with glMultiDrawElementsIndirectCount().
+    */
+    inline const bool is_compacted() const {
+        return prvt_compacted;
+    }
+
+
+    /** \brief Returns true if both culling programs got linked.
+    */
+    inline const bool is_ok() const {
+        return prvt_cull_program.linked && prvt_reduce_program.linked;
+    }
+
+
+    /** \brief Sets the meshes referenced by instances.
+    *
+    * \return false if 'count' exceeds the maximal count of meshes.
+    */
+    bool set_meshes(const CullingMesh* meshes, const GLuint count);
+
+
+    /** \brief Sets the bounds of the culled instances.
+    *
+    * \return false if 'count' exceeds the maximal count of instances.
+    */
+    bool set_instances(const CullingInstance* instances, const GLuint count);
+
+
+    /** Class method. Evaluates the six normalized frustum planes of a view-projection matrix.
+    *
+    * Planes are ordered left, right, bottom, top, near and far. Their
+    * normals point inside the frustum.
+    */
+    static void get_frustum_planes(const Eigen::Matrix4f& view_projection, Eigen::Vector4f planes[6]);
+
+
+    /** Class method. Returns true if GPU culling is supported by the current OpenGL context.
+    */
+    static inline const bool is_supported() {
+        return (GLEW_VERSION_4_5 || (GLEW_VERSION_4_3 && GLEW_ARB_direct_state_access)) && GLEW_ARB_buffer_storage;
+    }
+
+
+    /** Class method. Returns true if the count of draws may be read from a buffer.
+    */
+    static inline const bool is_draw_count_supported() {
+        return GLEW_VERSION_4_6 || GLEW_ARB_indirect_parameters;
+    }
+
+
+    /** Class method. Frustum-culls instances on the CPU.
+    *
+    * Applies the very same frustum tests as the culling shader, with
+    * no occlusion tests.  This is the reference GPU results and GPU
+    * timings get checked against.
+    *
+    * \return the count of visible instances, whose indices are
+    *       appended to 'visible'.
+    */
+    static size_t cull_on_cpu(const Eigen::Matrix4f& view_projection, const CullingInstance* instances, const size_t count, vector<GLuint>& visible);
+
+
+private:
+    GLuint                      prvt_max_instances;
+    GLuint                      prvt_max_meshes;
+    GLuint                      prvt_instances_count;
+    bool                        prvt_compacted;         // true when draw commands get compacted.
+
+    StorageBuffer               prvt_meshes;            // the meshes, at binding 0.
+    StorageBuffer               prvt_instances;         // the instances bounds, at binding 1.
+    IndirectBuffer              prvt_commands;          // the draw commands, at binding 2.
+    Buffer                      prvt_draw_count;        // the count of visible instances, at binding 3.
+
+    ComputeShader               prvt_cull_shader;
+    ComputeShader               prvt_reduce_shader;
+    ComputeProgram              prvt_cull_program;
+    ComputeProgram              prvt_reduce_program;
+
+    Uniform<Eigen::Matrix4f>    prvt_view_projection;
+    Uniform<Eigen::Vector4f>    prvt_planes;
+    Uniform<GLuint>             prvt_instances_uniform;
+    Uniform<GLuint>             prvt_occlusion;
+    Uniform<Eigen::Vector2i>    prvt_hiz_size;
+    Uniform<GLint>              prvt_hiz_max_level;
+    Uniform<GLint>              prvt_source_level;
+
+    GLuint                      prvt_hiz_texture;       // the HiZ pyramid.
+    GLsizei                     prvt_hiz_width;         // the width of level 0 of the pyramid.
+    GLsizei                     prvt_hiz_height;        // the height of level 0 of the pyramid.
+    GLint                       prvt_hiz_levels;
+    GLuint                      prvt_depth_sampler;     // nearest sampling of single level depth textures.
+    GLuint                      prvt_hiz_sampler;       // nearest sampling of all levels of the pyramid.
+
+    void prvt_release_hiz();
+};
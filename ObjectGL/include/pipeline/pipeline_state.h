@@ -0,0 +1,281 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "shaders/shaders_program.h"
+#include "vertex_arrays/vertex_array.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The blending part of pipeline states descriptions.
+*
+* Default values are the OpenGL initial ones.
+*/
+struct BlendState {
+    bool    enabled = false;
+    GLenum  src_rgb = GL_ONE;
+    GLenum  dst_rgb = GL_ZERO;
+    GLenum  src_alpha = GL_ONE;
+    GLenum  dst_alpha = GL_ZERO;
+    GLenum  equation_rgb = GL_FUNC_ADD;
+    GLenum  equation_alpha = GL_FUNC_ADD;
+    bool    color_mask[4] = { true, true, true, true };
+
+    bool operator== (const BlendState& other) const;
+    inline bool operator!= (const BlendState& other) const { return !(*this == other); }
+    uint64_t hash(uint64_t seed) const;
+};
+
+
+/** \brief The depth and stencil part of pipeline states descriptions.
+*/
+struct DepthStencilState {
+    bool    depth_test = false;
+    bool    depth_write = true;
+    GLenum  depth_func = GL_LESS;
+    bool    stencil_test = false;
+    GLenum  stencil_func = GL_ALWAYS;
+    GLint   stencil_reference = 0;
+    GLuint  stencil_read_mask = 0xffffffff;
+    GLuint  stencil_write_mask = 0xffffffff;
+    GLenum  stencil_fail = GL_KEEP;
+    GLenum  depth_fail = GL_KEEP;
+    GLenum  depth_pass = GL_KEEP;
+
+    bool operator== (const DepthStencilState& other) const;
+    inline bool operator!= (const DepthStencilState& other) const { return !(*this == other); }
+    uint64_t hash(uint64_t seed) const;
+};
+
+
+/** \brief The rasterization part of pipeline states descriptions.
+*/
+struct RasterizerState {
+    bool    cull_enabled = false;
+    GLenum  cull_face = GL_BACK;
+    GLenum  front_face = GL_CCW;
+    GLenum  polygon_mode = GL_FILL;
+    bool    polygon_offset_enabled = false;
+    GLfloat polygon_offset_factor = 0.0f;
+    GLfloat polygon_offset_units = 0.0f;
+    bool    rasterizer_discard = false;
+
+    bool operator== (const RasterizerState& other) const;
+    inline bool operator!= (const RasterizerState& other) const { return !(*this == other); }
+    uint64_t hash(uint64_t seed) const;
+};
+
+
+/** \brief The viewport and scissor part of pipeline states descriptions.
+*
+* Null sized viewports are not applied,  leaving the current one
+* unchanged. The scissor box is applied only when the scissor test
+* is enabled.
+*/
+struct ViewportState {
+    GLint   viewport[4] = { 0, 0, 0, 0 };
+    bool    scissor_test = false;
+    GLint   scissor[4] = { 0, 0, 0, 0 };
+
+    bool operator== (const ViewportState& other) const;
+    inline bool operator!= (const ViewportState& other) const { return !(*this == other); }
+    uint64_t hash(uint64_t seed) const;
+};
+
+
+/** \brief The descriptions of pipeline states.
+*
+* The shaders program and the vertex array (i.e. the vertex layout)
+* are referenced, not owned: they must live longer than the pipeline
+* states built from this description. Either may be NULL, in which
+* case it is left unchanged when applying the pipeline state.
+*/
+struct PipelineDesc {
+    ShadersProgram*     program = NULL;
+    VertexArray*        vertex_array = NULL;
+    BlendState          blend;
+    DepthStencilState   depth_stencil;
+    RasterizerState     rasterizer;
+    ViewportState       viewport;
+
+    bool operator== (const PipelineDesc& other) const;
+
+    /** \brief Returns the 64-bits hash value of this description.
+    */
+    uint64_t hash() const;
+};
+
+
+//===========================================================================
+/** \brief The class of immutable pipeline states.
+*
+* A pipeline state bundles a shaders program,  a  vertex  layout  and
+* all  the  blending,  depth-stencil,  rasterization  and  viewport
+* states a draw needs.  Pipeline states are hash-consed: they are
+* built only by a PipelineStateCache, which returns the very same
+* instance for identical descriptions. Comparing pipeline states
+* is then a mere comparison of pointers.
+*
+* Transitions from a pipeline state to another one emit only the
+* OpenGL calls for the fixed-function parts of the description that
+* differ,  and go through the state cache of the current context.
+* The program and the vertex array are bound on each application,
+* since other code may bind its own ones in between (e.g. compute
+* dispatches): the state cache drops these calls when redundant.
+*/
+class PipelineState {
+public:
+
+    /** \brief Applies this pipeline state.
+    *
+    * \param previous : a pointer to the pipeline state that is
+    *       currently applied, or NULL if unknown. In the latter
+    *       case, all parts of this pipeline state are applied.
+    */
+    void apply(const PipelineState* previous = NULL) const;
+
+
+    /** \brief Returns the description of this pipeline state.
+    */
+    inline const PipelineDesc& get_desc() const {
+        return prvt_desc;
+    }
+
+
+    /** \brief Returns the hash value of the description of this pipeline state.
+    */
+    inline const uint64_t get_hash() const {
+        return prvt_hash;
+    }
+
+
+    /** \brief Returns the identifier of this pipeline state, unique in its cache.
+    *
+    * Identifiers are small consecutive integers, e.g. suitable for
+    * sort keys.
+    */
+    inline const GLuint get_id() const {
+        return prvt_id;
+    }
+
+
+private:
+    friend class PipelineStateCache;
+
+    PipelineDesc    prvt_desc;  // the description of this pipeline state.
+    uint64_t        prvt_hash;  // the hash value of the description.
+    GLuint          prvt_id;    // the identifier of this pipeline state in its cache.
+
+    PipelineState(const PipelineDesc& desc, const uint64_t hash, const GLuint id)
+        : prvt_desc(desc), prvt_hash(hash), prvt_id(id)
+    {}
+
+    void prvt_apply_blend() const;
+    void prvt_apply_depth_stencil() const;
+    void prvt_apply_rasterizer() const;
+    void prvt_apply_viewport() const;
+};
+
+
+//===========================================================================
+/** \brief The class of the caches that hash-cons pipeline states.
+*
+* Also keeps track of the last applied pipeline state,  so that the
+* transitions to next ones are diff-based.
+*
+* Acquiring pipeline states is thread-safe. Applying them must be done
+* in the thread where the related OpenGL context is current.
+*/
+class PipelineStateCache {
+public:
+
+    /** \brief Empty constructor.
+    */
+    PipelineStateCache();
+
+
+    /** \brief Returns the unique pipeline state of a description.
+    *
+    * The pipeline state is built at first call with a description,
+    * and is returned as is with all next identical descriptions.
+    * Returned pointers remain valid until 'clear()' is called or
+    * until this cache is destroyed.
+    */
+    const PipelineState* acquire(const PipelineDesc& desc);
+
+
+    /** \brief Applies a pipeline state, emitting only the calls for what differs from the last applied one.
+    *
+    * The program and the vertex array are checked against the state
+    * cache of the current context rather than against the last
+    * applied pipeline state.
+    */
+    void apply(const PipelineState* state);
+
+
+    /** \brief Deletes all the pipeline states of this cache.
+    */
+    void clear();
+
+
+    /** \brief Returns the last applied pipeline state, or NULL if unknown.
+    */
+    inline const PipelineState* get_last_applied() const {
+        return prvt_last_applied;
+    }
+
+
+    /** \brief Forgets the last applied pipeline state.
+    *
+    * To be called along with 'GLStateCache::invalidate()',  once
+    * foreign code has issued OpenGL calls.
+    */
+    inline void invalidate() {
+        prvt_last_applied = NULL;
+    }
+
+
+    /** \brief Returns the count of distinct pipeline states in this cache.
+    */
+    size_t size() const;
+
+
+private:
+    mutable mutex                                                   prvt_mutex;
+    unordered_map<uint64_t, vector<const PipelineState*>>           prvt_buckets;       // the pipeline states, per hash value.
+    vector<unique_ptr<PipelineState>>                               prvt_states;        // all the pipeline states, indexed by id.
+    const PipelineState*                                            prvt_last_applied;  // the last applied pipeline state, or NULL.
+};
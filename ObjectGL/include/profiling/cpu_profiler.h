@@ -0,0 +1,210 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#   ifdef _MSC_VER
+#       include <intrin.h>
+#   else
+#       include <x86intrin.h>
+#   endif
+#   define OBJECTGL_CPU_PROFILING_RDTSC
+#endif
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The process-wide CPU profiler, with per-thread lock-free rings of zones.
+*
+* CPU zones are recorded only when the library is compiled with
+* OBJECTGL_CPU_PROFILING defined: else, macro OBJECTGL_CPU_ZONE()
+* expands to nothing and release builds pay nothing.
+*
+* Each zone reads the time stamp counter (rdtsc) on x86-64, or
+* std::chrono::steady_clock elsewhere, at its beginning and at its
+* end, and then writes one event into the ring of its thread.  Rings
+* are single-producer single-consumer:  no lock is taken by zones,
+* but for the registration of the ring of each thread at its first
+* zone. Events are dropped when a ring is full.
+*
+* A background flusher thread drains all rings at regular intervals
+* and writes their events into a file, either in the Chrome trace
+* event format or in a compact binary format:
+*   - an 8 bytes header: "OGLCPU01";
+*   - then records, each starting with one byte type:
+*       - 'N': a name definition: uint32 name id, uint32 length,
+*              then the chars of the name, with no terminating NULL;
+*       - 'Z': a zone: uint32 thread id, uint32 name id, uint64
+*              begin and uint64 end, in nanoseconds since start.
+*   All integers are little-endian.
+*
+* Usage:
+*   // with OBJECTGL_CPU_PROFILING defined
+*   CPUProfiler::start("frame.json");
+*   ...
+*   void update() {
+*       OBJECTGL_CPU_ZONE("update");
+*       ...
+*   }
+*   ...
+*   CPUProfiler::stop();
+*
+* Notice: zones names must be strings with static storage duration,
+*         e.g. string literals, since only their addresses get
+*         recorded.
+*/
+class CPUProfiler {
+public:
+
+    /** \brief The formats of the output files.
+    */
+    enum Format {
+        CHROME_TRACE,   //!< Chrome trace event format (JSON).
+        BINARY          //!< compact binary format.
+    };
+
+
+    /** \brief An event recorded by a zone, in ticks.
+    */
+    struct Event {
+        const char* name;
+        uint64_t    begin;
+        uint64_t    end;
+    };
+
+
+    /** \brief Returns the current count of ticks.
+    */
+    static inline uint64_t now() {
+#ifdef OBJECTGL_CPU_PROFILING_RDTSC
+        return __rdtsc();
+#else
+        return uint64_t(chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+
+    /** \brief Returns the count of events dropped since start because rings were full.
+    */
+    static uint64_t get_dropped_events();
+
+
+    /** \brief Returns true once profiling has been started and until it gets stopped.
+    */
+    static inline const bool is_enabled() {
+        return prvt_enabled.load(memory_order_relaxed);
+    }
+
+
+    /** \brief Records an event into the ring of the calling thread.
+    */
+    static void record(const char* name, const uint64_t begin, const uint64_t end);
+
+
+    /** \brief Sets the capacity of the rings of the threads that have not recorded events yet.
+    *
+    * \param events_count : the count of events, rounded up to a
+    *       power of two. Defaults to 64K.
+    */
+    static void set_ring_capacity(const size_t events_count);
+
+
+    /** \brief Starts profiling, and the flusher thread.
+    *
+    * \param filepath : the path of the output file.
+    * \param format : the format of the output file. Defaults to
+    *       CHROME_TRACE.
+    * \param flush_interval_ms : the interval between two drainings
+    *       of the rings, in milliseconds. Defaults to 50.
+    *
+    * \return false if profiling is already started or if the output
+    *       file cannot be opened, or true else.
+    */
+    static bool start(const string& filepath, const Format format = CHROME_TRACE, const unsigned flush_interval_ms = 50);
+
+
+    /** \brief Stops profiling. Drains the rings a last time, closes the output file and joins the flusher thread.
+    */
+    static void stop();
+
+
+private:
+    static atomic<bool> prvt_enabled;
+};
+
+
+//===========================================================================
+/** \brief The class of scoped CPU profiling zones.
+*
+* Use through macro OBJECTGL_CPU_ZONE().
+*/
+class CPUZone {
+public:
+
+    /** \brief Constructor. Begins the zone.
+    *
+    * \param name : the name of the zone, with static storage duration.
+    */
+    inline CPUZone(const char* name)
+        : prvt_name(name), prvt_begin(CPUProfiler::is_enabled() ? CPUProfiler::now() : 0)
+    {}
+
+
+    /** \brief Destructor. Ends the zone and records it.
+    */
+    inline ~CPUZone()
+    {
+        if (prvt_begin != 0)
+            CPUProfiler::record(prvt_name, prvt_begin, CPUProfiler::now());
+    }
+
+
+    CPUZone(const CPUZone& copy) = delete;
+    CPUZone& operator= (const CPUZone& copy) = delete;
+
+
+private:
+    const char* prvt_name;
+    uint64_t    prvt_begin;
+};
+
+
+#define OBJECTGL_CPU_ZONE_CONCAT_(a, b) a##b
+#define OBJECTGL_CPU_ZONE_CONCAT(a, b)  OBJECTGL_CPU_ZONE_CONCAT_(a, b)
+
+/** \brief Opens a CPU zone till the end of the enclosing scope, when OBJECTGL_CPU_PROFILING is defined. */
+#ifdef OBJECTGL_CPU_PROFILING
+#   define OBJECTGL_CPU_ZONE(name) CPUZone OBJECTGL_CPU_ZONE_CONCAT(objectgl_cpu_zone_, __LINE__)(name)
+#else
+#   define OBJECTGL_CPU_ZONE(name) ((void)0)
+#endif
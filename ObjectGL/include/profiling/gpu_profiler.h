@@ -0,0 +1,331 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "GL/glew.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of GPU profilers, with non-stalling timer queries.
+*
+* Profiling zones and whole frames get timed on the GPU with pairs of
+* GL_TIMESTAMP queries, so that zones may nest  (GL_TIME_ELAPSED queries
+* cannot).  Each frame in flight owns its pool of query objects, which
+* grows as needed and is reused once the frame results have been read
+* back.
+*
+* Results are read back 'frames_latency' frames later, and only once
+* GL_QUERY_RESULT_AVAILABLE is set: the CPU never waits for the GPU.
+* Frames whose results are still not available when their pool is
+* needed again are dropped (see 'get_dropped_frames()').
+*
+* Zones also push and pop KHR_debug groups, so that they show up in
+* frame debuggers.  Results feed per-zone rolling statistics and,
+* when recording is enabled, a trace that can be exported in the
+* Chrome trace event format (chrome://tracing, Perfetto).
+*
+* Profilers are per context: the current profiler of the calling
+* thread is used by GPU zones, e.g. the ones set automatically
+* around draws and dispatches. Profiling is disabled by default, in
+* which case zones cost one test.
+*
+* Usage:
+*   GPUProfiler profiler;
+*   GPUProfiler::set_current(&profiler);
+*   profiler.set_enabled(true);
+*   ... each frame:
+*   profiler.begin_frame();
+*   {
+*       OBJECTGL_GPU_ZONE("shadows");
+*       ...
+*   }
+*   profiler.end_frame();
+*   ...
+*   GPUProfiler::ZoneStats stats;
+*   if (profiler.get_zone_stats("shadows", stats))
+*       cout << stats.avg_ms << " ms" << endl;
+*/
+class GPUProfiler {
+public:
+
+    /** \brief The rolling statistics of a zone, in milliseconds.
+    */
+    struct ZoneStats {
+        double min_ms;      //!< the minimal duration.
+        double avg_ms;      //!< the average duration.
+        double p99_ms;      //!< the 99th percentile of durations.
+        size_t samples;     //!< the count of durations the statistics are evaluated on.
+    };
+
+
+    /** \brief The name of the zone that times whole frames.
+    */
+    static const char* FRAME_ZONE_NAME;
+
+
+    /** \brief Constructor.
+    *
+    * \param frames_latency : the count of frames between the end of
+    *       a frame and the read back of its results. Defaults to 3.
+    * \param window : the count of the most recent samples the
+    *       statistics of each zone are evaluated on. Defaults to 128.
+    */
+    GPUProfiler(const GLuint frames_latency = 3, const size_t window = 128);
+
+
+    /** \brief Destructor. Deletes all the query objects.
+    */
+    ~GPUProfiler();
+
+
+    GPUProfiler(const GPUProfiler& copy) = delete;
+    GPUProfiler& operator= (const GPUProfiler& copy) = delete;
+
+
+    /** \brief Starts a new frame.
+    *
+    * Reads back the results of the previous frames that are
+    * available, with no waiting.
+    */
+    void begin_frame();
+
+
+    /** \brief Opens a zone, nested in the currently opened one if any.
+    *
+    * Zones opened out of frames are not timed, but still get their
+    * debug group.
+    */
+    void begin_zone(const char* name);
+
+
+    /** \brief Closes the last opened zone.
+    */
+    void end_zone();
+
+
+    /** \brief Ends the current frame.
+    *
+    * Zones left opened get reported and timed till the end of the
+    * frame. They remain opened though, until their owners close them
+    * as zones opened out of frames.
+    */
+    void end_frame();
+
+
+    /** \brief Returns the count of frames whose results have been dropped since they were not available in time.
+    */
+    inline const size_t get_dropped_frames() const {
+        return prvt_dropped_frames;
+    }
+
+
+    /** \brief Gets the statistics of all zones with samples, sorted by names.
+    */
+    void get_stats(vector<pair<string, ZoneStats>>& stats) const;
+
+
+    /** \brief Gets the statistics of a zone.
+    *
+    * \return false if the zone has no samples yet, or true else.
+    */
+    bool get_zone_stats(const string& name, ZoneStats& stats) const;
+
+
+    /** \brief Returns true if zones are processed.
+    */
+    inline const bool is_enabled() const {
+        return prvt_enabled;
+    }
+
+
+    /** \brief Enables or disables profiling.
+    *
+    * Disabling profiling within a frame takes effect at the next
+    * frame.
+    */
+    inline void set_enabled(const bool enabled) {
+        prvt_enabled = enabled;
+    }
+
+
+    /** \brief Starts or stops the recording of zones into the trace.
+    *
+    * \param recording : true to record zones.
+    * \param max_events : the maximal count of recorded zones. Further
+    *       zones are not recorded. Defaults to 1M.
+    */
+    void set_recording(const bool recording, const size_t max_events = size_t(1) << 20);
+
+
+    /** \brief Clears the recorded trace.
+    */
+    void clear_trace();
+
+
+    /** \brief Writes the recorded trace in the Chrome trace event format (JSON).
+    */
+    void write_chrome_trace(ostream& out) const;
+
+
+    /** \brief Writes the recorded trace into a file, in the Chrome trace event format (JSON).
+    *
+    * \return false if the file could not be written, or true else.
+    */
+    bool write_chrome_trace(const string& filepath) const;
+
+
+    /** Class method. Returns the current profiler of the calling thread.
+    *
+    * Defaults to a disabled profiler of the thread.
+    */
+    static GPUProfiler& get_current();
+
+
+    /** Class method. Returns true if timer queries are supported by the current OpenGL context.
+    */
+    static inline const bool is_supported() {
+        return GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    }
+
+
+    /** Class method. Sets the current profiler of the calling thread.
+    *
+    * \param profiler : a pointer to the profiler. NULL to get back
+    *       to the default one.
+    */
+    static void set_current(GPUProfiler* profiler);
+
+
+private:
+    struct Zone {
+        uint32_t    name_id;
+        uint32_t    depth;
+        GLuint      begin_query;
+        GLuint      end_query;  // 0 while the zone is opened.
+    };
+
+    struct Frame {
+        vector<Zone>    zones;
+        vector<GLuint>  queries;        // the pool of timestamp queries of this frame.
+        size_t          queries_used;
+        GLuint          begin_query;    // the timestamp of the beginning of this frame.
+        GLuint          end_query;      // the timestamp of the end of this frame.
+        uint64_t        index;
+        bool            pending;        // true while results have to be read back.
+    };
+
+    struct History {
+        vector<double>  samples;        // the most recent durations, as a ring.
+        size_t          next;
+    };
+
+    struct TraceEvent {
+        uint32_t    name_id;
+        uint32_t    depth;
+        uint64_t    frame;
+        GLuint64    begin_ns;
+        GLuint64    end_ns;
+    };
+
+    vector<Frame>                       prvt_frames;
+    uint64_t                            prvt_frame_index;
+    Frame*                              prvt_frame;         // the current frame, or NULL out of frames.
+    vector<size_t>                      prvt_opened;        // the indices of the opened zones of the current frame.
+    size_t                              prvt_opened_untimed;// the count of opened zones out of frames.
+    vector<string>                      prvt_names;
+    unordered_map<string, uint32_t>     prvt_names_ids;
+    vector<History>                     prvt_histories;     // per name identifier.
+    size_t                              prvt_window;
+    size_t                              prvt_dropped_frames;
+    vector<TraceEvent>                  prvt_trace;
+    size_t                              prvt_trace_capacity;
+    bool                                prvt_recording;
+    bool                                prvt_enabled;
+
+    static thread_local GPUProfiler*    prvt_current;
+
+    uint32_t prvt_get_name_id(const char* name);
+    GLuint prvt_get_query(Frame& frame);
+    void prvt_add_sample(const uint32_t name_id, const double duration_ms);
+    bool prvt_read_back(Frame& frame);
+};
+
+
+//===========================================================================
+/** \brief The class of scoped GPU profiling zones.
+*
+* Opens a zone of the current profiler at construction and closes it
+* at destruction. Does nothing when the profiler is disabled.
+*/
+class GPUZone {
+public:
+
+    /** \brief Constructor. Opens the zone.
+    *
+    * \param name : the name of the zone.
+    */
+    GPUZone(const char* name)
+        : prvt_profiler(GPUProfiler::get_current())
+    {
+        prvt_opened = prvt_profiler.is_enabled();
+        if (prvt_opened)
+            prvt_profiler.begin_zone(name);
+    }
+
+
+    /** \brief Destructor. Closes the zone.
+    */
+    ~GPUZone()
+    {
+        if (prvt_opened)
+            prvt_profiler.end_zone();
+    }
+
+
+    GPUZone(const GPUZone& copy) = delete;
+    GPUZone& operator= (const GPUZone& copy) = delete;
+
+
+private:
+    GPUProfiler&    prvt_profiler;
+    bool            prvt_opened;
+};
+
+
+#define OBJECTGL_GPU_ZONE_CONCAT_(a, b) a##b
+#define OBJECTGL_GPU_ZONE_CONCAT(a, b)  OBJECTGL_GPU_ZONE_CONCAT_(a, b)
+
+/** \brief Opens a GPU zone till the end of the enclosing scope. */
+#define OBJECTGL_GPU_ZONE(name) GPUZone OBJECTGL_GPU_ZONE_CONCAT(objectgl_gpu_zone_, __LINE__)(name)
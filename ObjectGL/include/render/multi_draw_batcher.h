@@ -0,0 +1,341 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "buffers/indirect_buffer.h"
+#include "buffers/ring_buffer.h"
+#include "context/gl_state.h"
+#include "context/memory_barriers.h"
+#include "pipeline/pipeline_state.h"
+#include "profiling/cpu_profiler.h"
+#include "profiling/gpu_profiler.h"
+#include "trace/gl_trace.h"
+#include "utils/hash.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of batchers of indexed draws into multi-draw indirect calls.
+*
+* Draws are added in any order during a frame. At submission time,
+* compatible draws,  i.e.  draws  with  the same pipeline state (and
+* then the same program and vertex array) and the same primitives mode,
+* are gathered into batches.  Each batch is drawn with one single call
+* to glMultiDrawElementsIndirect().
+*
+* The DrawElementsIndirectCommand records of all batches are written
+* into a persistently mapped ring of indirect buffers, while the
+* per-draw data (e.g. transforms and material indices) are written into
+* a ring of shader storage buffers, bound to 'storage_binding'.  No
+* glBufferSubData() call is involved.
+*
+* Shaders fetch the per-draw data of their draw either:
+*   - with gl_BaseInstance (GLSL 4.60,  or gl_BaseInstanceARB with
+*     extension ARB_shader_draw_parameters): the base instance of each
+*     draw is set to the index of its per-draw data;
+*   - or with gl_DrawID plus the index of the first draw of the batch,
+*     which is set into the uniform named with 'set_draw_offset_uniform()'
+*     when the program has such a uniform.
+*
+* Usage, with a per-draw structure matching a std430 shader block:
+*   // vertex shader:
+*   //   struct DrawData { mat4 model; uint material; };
+*   //   layout(std430, binding = 3) readonly buffer Draws { DrawData draws[]; };
+*   //   ... draws[gl_BaseInstance].model ...
+*   MultiDrawBatcher<DrawData> batcher(16384, 3);
+*   ...
+*   batcher.begin_frame();
+*   for (mesh : meshes)
+*       batcher.add(mesh.state, GL_TRIANGLES, mesh.count, mesh.first_index, mesh.base_vertex, mesh.draw_data);
+*   batcher.submit(pipeline_states);
+*   batcher.end_frame();
+*
+* \param T : the type of the per-draw data.  It gets copied with
+*       memcpy() and must match the std430 layout of the related
+*       shader structure (e.g. Eigen fixed-size matrices are fine).
+*/
+template<typename T>
+class MultiDrawBatcher {
+public:
+
+    /** \brief The statistics of the last submission.
+    */
+    struct Stats {
+        size_t draws;       //!< the count of batched draws.
+        size_t batches;     //!< the count of glMultiDrawElementsIndirect() calls.
+        size_t dropped;     //!< the count of draws that did not fit in the buffers of the frame.
+    };
+
+
+    /** \brief Constructor.
+    *
+    * \param max_draws : the maximal count of draws per frame.
+    * \param storage_binding : the shader storage buffer binding point
+    *       of the per-draw data.
+    * \param index_type : the type of the indices of all draws.
+    *       Defaults to GL_UNSIGNED_INT.
+    * \param frames_count : the count of frames in flight. Defaults to 3.
+    */
+    MultiDrawBatcher(const GLuint max_draws, const GLuint storage_binding, const GLenum index_type = GL_UNSIGNED_INT, const GLuint frames_count = 3)
+        : prvt_max_draws(max_draws),
+          prvt_storage_binding(storage_binding),
+          prvt_index_type(index_type),
+          prvt_commands(max_draws * sizeof(DrawElementsIndirectCommand), frames_count, GL_DRAW_INDIRECT_BUFFER),
+          prvt_draw_data(max_draws * sizeof(T), frames_count, GL_SHADER_STORAGE_BUFFER),
+          prvt_stats{ 0, 0, 0 }
+    {
+        prvt_draws.reserve(max_draws);
+    }
+
+
+    /** \brief Adds an indexed draw to the batches of the current frame.
+    *
+    * \param state : the pipeline state of the draw.
+    * \param mode : the primitives mode, e.g. GL_TRIANGLES.
+    * \param count : the count of indices.
+    * \param first_index : the index of the first index in the index
+    *       buffer of the vertex array of the pipeline state.
+    * \param base_vertex : the value added to each index.
+    * \param draw_data : the per-draw data, copied.
+    * \param instance_count : the count of instances. Defaults to 1.
+    *
+    * \return false if the maximal count of draws per frame is reached,
+    *       or true else.
+    */
+    bool add(const PipelineState* state, const GLenum mode, const GLuint count, const GLuint first_index, const GLint base_vertex,
+             const T& draw_data, const GLuint instance_count = 1)
+    {
+        if (prvt_draws.size() >= prvt_max_draws) {
+            ++prvt_stats.dropped;
+            return false;
+        }
+
+        const BatchKey key{ state, mode };
+        typename unordered_map<BatchKey, GLuint, BatchKeyHash>::iterator it = prvt_batches_index.find(key);
+        GLuint batch_index;
+        if (it != prvt_batches_index.end())
+            batch_index = it->second;
+        else {
+            batch_index = GLuint(prvt_batches.size());
+            prvt_batches_index.emplace(key, batch_index);
+            prvt_batches.push_back(Batch{ state, mode, 0, 0 });
+        }
+        ++prvt_batches[batch_index].count;
+
+        prvt_draws.push_back(PendingDraw{ batch_index, DrawElementsIndirectCommand{ count, instance_count, first_index, base_vertex, 0 }, draw_data });
+        return true;
+    }
+
+
+    /** \brief Starts a new frame.
+    *
+    * Waits for the GPU to be done with the buffers of this frame, if
+    * needed.
+    */
+    void begin_frame() {
+        prvt_commands.begin_frame();
+        prvt_draw_data.begin_frame();
+        prvt_draws.clear();
+        prvt_batches.clear();
+        prvt_batches_index.clear();
+        prvt_stats = Stats{ 0, 0, 0 };
+    }
+
+
+    /** \brief Ends the current frame.
+    */
+    void end_frame() {
+        prvt_commands.end_frame();
+        prvt_draw_data.end_frame();
+    }
+
+
+    /** \brief Returns the statistics of the current frame.
+    */
+    inline const Stats& get_stats() const {
+        return prvt_stats;
+    }
+
+
+    /** \brief Sets the name of the uniform that receives the index of the first draw of each batch.
+    *
+    * Needed only by shaders that index their per-draw data with
+    * gl_DrawID rather than with gl_BaseInstance.  The slot of the
+    * uniform gets searched for once per program and per linking of it,
+    * so programs must not be deleted while this batcher draws with them.
+    */
+    inline void set_draw_offset_uniform(const string& uniform_name) {
+        prvt_draw_offset_uniform = uniform_name;
+        prvt_draw_offset_slots.clear();
+    }
+
+
+    /** \brief Writes all the batches of the current frame into the buffers, and draws them.
+    *
+    * The memory barriers that are pending in the tracker of the
+    * current context get issued before the draws.
+    *
+    * \param pipeline_states : a reference to the cache the pipeline
+    *       states of the draws come from.
+    */
+    void submit(PipelineStateCache& pipeline_states) {
+        OBJECTGL_CPU_ZONE("MultiDrawBatcher::submit");
+        const GLuint draws_count = GLuint(prvt_draws.size());
+        if (draws_count == 0)
+            return;
+
+        const RingBuffer::Allocation commands = prvt_commands.allocate(draws_count * sizeof(DrawElementsIndirectCommand));
+        const RingBuffer::Allocation draw_data = prvt_draw_data.allocate(draws_count * sizeof(T));
+        if (!commands.is_ok() || !draw_data.is_ok()) {
+            cerr << "!!! multi-draw batcher buffers overflow" << endl;
+            prvt_stats.dropped += draws_count;
+            return;
+        }
+
+        // evaluates the first draw of each batch
+        GLuint first = 0;
+        for (Batch& batch : prvt_batches) {
+            batch.first = first;
+            first += batch.count;
+            batch.count = 0;
+        }
+
+        // scatters draws into their batches, directly into mapped memory
+        DrawElementsIndirectCommand* command_records = static_cast<DrawElementsIndirectCommand*>(commands.data);
+        T* draw_records = static_cast<T*>(draw_data.data);
+        for (const PendingDraw& draw : prvt_draws) {
+            Batch& batch = prvt_batches[draw.batch_index];
+            const GLuint index = batch.first + batch.count++;
+            DrawElementsIndirectCommand record = draw.command;
+            record.base_instance = index;
+            memcpy(command_records + index, &record, sizeof(record));
+            memcpy(static_cast<void*>(draw_records + index), &draw.data, sizeof(T));
+        }
+
+        prvt_draw_data.bind(draw_data, prvt_storage_binding);
+        prvt_commands.bind();
+        if (GLTrace::is_capturing())
+            GLTrace::on_mapped_write(prvt_commands.name, commands.offset, commands.size, commands.data);
+        MemoryBarriers::get_current().flush();
+
+        for (const Batch& batch : prvt_batches) {
+            ShadersProgram* program = batch.state->get_desc().program;
+            GPUZone zone(program == NULL || program->get_label().empty() ? "multi-draw" : program->get_label().c_str());
+            pipeline_states.apply(batch.state);
+
+            if (program != NULL) {
+                if (!prvt_draw_offset_uniform.empty()) {
+                    const GLint slot = prvt_get_draw_offset_slot(*program);
+                    if (slot >= 0) {
+                        const GLuint offset = batch.first;
+                        program->get_uniforms_shadow().set(slot, 0, 1, &offset);
+                    }
+                }
+                program->flush_uniforms();
+            }
+
+            const GLintptr offset = commands.offset + GLintptr(batch.first) * sizeof(DrawElementsIndirectCommand);
+            glMultiDrawElementsIndirect(batch.mode, prvt_index_type, reinterpret_cast<const void*>(offset), batch.count, 0);
+            ++prvt_stats.batches;
+        }
+        prvt_stats.draws += draws_count;
+    }
+
+
+    /** Class method. Returns true if multi-draw indirect batching is supported by the current OpenGL context.
+    */
+    static inline const bool is_supported() {
+        return RingBuffer::is_supported() &&
+               (GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_shader_storage_buffer_object));
+    }
+
+
+private:
+    struct BatchKey {
+        const PipelineState*    state;
+        GLenum                  mode;
+
+        inline const bool operator== (const BatchKey& other) const {
+            return state == other.state && mode == other.mode;
+        }
+    };
+
+    struct BatchKeyHash {
+        inline size_t operator() (const BatchKey& key) const {
+            return size_t(fnv1a::hash_value(key.mode, fnv1a::hash_value(key.state)));
+        }
+    };
+
+    struct DrawOffsetSlot {
+        GLint       slot;
+        unsigned    link_count; // the link count of the program at search time.
+    };
+
+    struct Batch {
+        const PipelineState*    state;
+        GLenum                  mode;
+        GLuint                  first;  // the index of the first draw of the batch.
+        GLuint                  count;  // the count of draws of the batch.
+    };
+
+    struct PendingDraw {
+        GLuint                      batch_index;
+        DrawElementsIndirectCommand command;
+        T                           data;
+    };
+
+    GLuint                          prvt_max_draws;
+    GLuint                          prvt_storage_binding;
+    GLenum                          prvt_index_type;
+    RingBuffer                      prvt_commands;          // the ring of indirect commands.
+    RingBuffer                      prvt_draw_data;         // the ring of per-draw data.
+    vector<PendingDraw>             prvt_draws;             // the draws of the current frame, in order of addition.
+    vector<Batch>                   prvt_batches;           // the batches of the current frame.
+    unordered_map<BatchKey, GLuint, BatchKeyHash>       prvt_batches_index;     // the index of the batch of each (state, mode) key.
+    string                                              prvt_draw_offset_uniform;
+    unordered_map<ShadersProgram*, DrawOffsetSlot>      prvt_draw_offset_slots; // the slot of the draw offset uniform, per program.
+    Stats                                               prvt_stats;
+
+    // returns the slot of the draw offset uniform in the shadow of a program, or -1 if it has none.
+    const GLint prvt_get_draw_offset_slot(ShadersProgram& program) {
+        DrawOffsetSlot& entry = prvt_draw_offset_slots.emplace(&program, DrawOffsetSlot{ -1, 0 }).first->second;
+        if (entry.link_count != program.get_link_count()) {
+            entry.slot = program.get_uniforms_shadow().find(program.get_reflection(), prvt_draw_offset_uniform.c_str());
+            entry.link_count = program.get_link_count();
+        }
+        return entry.slot;
+    }
+};
@@ -0,0 +1,193 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "pipeline/pipeline_state.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The description of one draw submitted to a render queue.
+*
+* Pointed data (pipeline state, textures) must remain valid until the
+* render queue has been submitted.
+*/
+struct DrawPacket {
+    uint64_t                key;            //!< the sort key of this draw, see RenderQueue::make_key().
+    const PipelineState*    state;          //!< the pipeline state of this draw.
+    const GLuint*           textures;       //!< the textures to be bound to units 0 and next ones, or NULL.
+    GLsizei                 textures_count; //!< the count of textures.
+    GLuint                  constants_buffer;   //!< the buffer of the per-draw constants, or 0 if none.
+    GLintptr                constants_offset;   //!< the offset of the per-draw constants in their buffer.
+    GLsizeiptr              constants_size;     //!< the size of the per-draw constants.
+    GLenum                  mode;           //!< the primitives mode, e.g. GL_TRIANGLES.
+    GLenum                  index_type;     //!< the type of indices, or 0 for non-indexed draws.
+    GLsizei                 count;          //!< the count of vertices or of indices.
+    GLintptr                first;          //!< the first vertex, or the offset in bytes of the first index.
+    GLint                   base_vertex;    //!< the value added to indices, for indexed draws.
+    GLsizei                 instance_count; //!< the count of instances.
+    GLuint                  base_instance;  //!< the first instance.
+};
+
+
+//===========================================================================
+/** \brief The class of sorted queues of draws.
+*
+* Draw packets are pushed in any order during a frame. They get then
+* sorted on their 64-bits sort keys with an LSD radix sort and are
+* submitted in that order.  Sort keys are built with 'make_key()',
+* which encodes, from most to least significant bits:
+*   - the layer of the draw (4 bits), e.g. opaque geometry, then sky,
+*     then HUD;
+*   - the translucency of the draw (1 bit):  opaque draws come first;
+*   - for opaque draws: the program id (10 bits), the pipeline state
+*     id (14 bits), the material (i.e. textures set) id (15 bits) and
+*     the depth (20 bits),  so that draws get grouped by program and
+*     then by state, and are then front-to-back;
+*   - for translucent draws: the reversed depth (20 bits) first, for
+*     correct back-to-front blending,  then the program, pipeline
+*     state and material ids.
+*
+* Grouping draws this way minimizes the count of pipeline state,
+* program and texture switches,  which all go through the state
+* cache of the current context.
+*/
+class RenderQueue {
+public:
+
+    /** \brief The statistics of the last submission.
+    */
+    struct Stats {
+        size_t draws;               //!< the count of submitted draws.
+        size_t state_changes;       //!< the count of pipeline state transitions.
+        size_t program_changes;     //!< the count of transitions involving a program change.
+        size_t textures_changes;    //!< the count of draws whose textures set differed from previous draw.
+    };
+
+
+    static const uint32_t MAX_LAYER       = (1u << 4) - 1;   //!< the greatest layer that can be encoded in sort keys.
+    static const uint32_t MAX_PROGRAM_ID  = (1u << 10) - 1;  //!< the greatest program id that can be encoded in sort keys.
+    static const uint32_t MAX_PIPELINE_ID = (1u << 14) - 1;  //!< the greatest pipeline state id that can be encoded in sort keys.
+    static const uint32_t MAX_MATERIAL_ID = (1u << 15) - 1;  //!< the greatest material id that can be encoded in sort keys.
+
+
+    /** \brief Constructor.
+    *
+    * \param constants_binding : the uniform buffer binding point the
+    *       per-draw constants get bound to. Defaults to 0.
+    * \param reserved_count : the count of draw packets to reserve
+    *       memory for. Defaults to 0.
+    */
+    RenderQueue(const GLuint constants_binding = 0, const size_t reserved_count = 0);
+
+
+    /** \brief Removes all the draw packets of this queue.
+    */
+    inline void clear() {
+        prvt_packets.clear();
+        prvt_order.clear();
+        prvt_sorted = true;
+    }
+
+
+    /** \brief Returns the statistics of the last submission.
+    */
+    inline const Stats& get_stats() const {
+        return prvt_stats;
+    }
+
+
+    /** \brief Appends a draw packet to this queue.
+    */
+    inline void push(const DrawPacket& packet) {
+        prvt_packets.push_back(packet);
+        prvt_sorted = false;
+    }
+
+
+    /** \brief Returns the count of draw packets in this queue.
+    */
+    inline const size_t size() const {
+        return prvt_packets.size();
+    }
+
+
+    /** \brief Sorts the draw packets on their keys.
+    *
+    * The sort is stable: draws with equal keys keep their order of
+    * push. It is done automatically by 'submit()' if needed.
+    */
+    void sort();
+
+
+    /** \brief Submits all the draws of this queue, in sorted order.
+    *
+    * The queue is left unchanged: call 'clear()' before pushing the
+    * draws of next frame.  The memory barriers that are pending in
+    * the tracker of the current context get issued first.
+    *
+    * \param pipeline_states : a reference to the cache the pipeline
+    *       states of the draws come from.  Transitions between
+    *       consecutive pipeline states are applied through it.
+    */
+    void submit(PipelineStateCache& pipeline_states);
+
+
+    /** Class method. Builds the sort key of a draw.
+    *
+    * \param layer : the layer of the draw, from 0 to MAX_LAYER.
+    * \param translucent : true if the draw is blended, false if opaque.
+    * \param program_id : the id of the program of the draw, e.g. the
+    *       OpenGL name of the program of its pipeline state.  Only
+    *       its low bits are kept, up to MAX_PROGRAM_ID: programs
+    *       with the same low bits are then just not grouped.
+    * \param pipeline_id : the id of the pipeline state of the draw,
+    *       e.g. PipelineState::get_id(), from 0 to MAX_PIPELINE_ID.
+    *       Pipeline states ids follow the order of creation of the
+    *       states, so that the program id groups the draws that
+    *       share a program across pipeline states.
+    * \param material_id : the id of the textures set of the draw,
+    *       from 0 to MAX_MATERIAL_ID.
+    * \param depth : the distance of the draw to the viewer. Negative
+    *       values are clamped to 0.
+    */
+    static uint64_t make_key(const uint32_t layer, const bool translucent, const uint32_t program_id, const uint32_t pipeline_id, const uint32_t material_id, const float depth);
+
+
+private:
+    GLuint              prvt_constants_binding; // the binding point of the per-draw constants.
+    vector<DrawPacket>  prvt_packets;           // the draw packets, in order of push.
+    vector<uint64_t>    prvt_keys;              // the sorted keys, used as radix sort buffers.
+    vector<uint32_t>    prvt_order;             // the indices of the packets in sorted order.
+    bool                prvt_sorted;            // true when prvt_order is up to date.
+    Stats               prvt_stats;
+};
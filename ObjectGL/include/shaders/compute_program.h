@@ -0,0 +1,211 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "buffers/buffers.h"
+#include "compute_shader.h"
+#include "context/memory_barriers.h"
+#include "shaders_program.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of OpenGL programs made of one compute shader.
+*
+* The work group size of the program is reflected, through
+* GL_COMPUTE_WORK_GROUP_SIZE,  each time the program gets linked.
+* Dispatches may then be expressed either in work groups or in
+* invocations (i.e. problem size), the count of work groups being
+* evaluated with rounding up: shaders have to discard the
+* invocations that fall beyond the problem size.
+*
+* The resources the program reads and writes may be declared.  Memory
+* barriers are then inserted automatically, and precisely, through
+* the memory barriers tracker of the current context:
+*   - before each dispatch,  for  declared inputs that have been
+*     written by previous dispatches;
+*   - after each dispatch, declared outputs are recorded as written,
+*     so that later readers get the barrier bits they need only.
+*
+* Other readers declare their readings with 'require_buffer()' or
+* 'require_texture()' of the tracker, which get issued by its method
+* 'flush()'.  The draws submitted by RenderQueue,  MultiDrawBatcher,
+* GPUCulling and CommandBuffer flush the pending barriers first; any
+* other draw has to be preceded by an explicit 'flush()'.
+*
+* Usage:
+*   ComputeProgram blur(blur_shader);
+*   blur.add_image_input(source_texture);
+*   blur.add_image_output(blurred_texture);
+*   blur.dispatch_for(width, height);
+*   MemoryBarriers& barriers = MemoryBarriers::get_current();
+*   barriers.require_texture(blurred_texture, GL_TEXTURE_FETCH_BARRIER_BIT);
+*   barriers.flush();
+*   ... draw sampling 'blurred_texture' ...
+*/
+class ComputeProgram : public ShadersProgram {
+public:
+
+    /** \brief Empty constructor.
+    */
+    ComputeProgram()
+        : ShadersProgram(), prvt_work_group_link_count(0)
+    {
+        prvt_work_group_size[0] = prvt_work_group_size[1] = prvt_work_group_size[2] = 0;
+    }
+
+
+    /** \brief Constructor with compute shader. Attaches, compiles and links the shader.
+    *
+    * \param shader : a reference to the compute shader.
+    * \param verbose : set this to true to get verbose compilation
+    *       and linking. Defaults to false.
+    */
+    ComputeProgram(ComputeShader& shader, const bool verbose = false);
+
+
+    /** \brief Constructor with programs binaries cache.
+    *
+    * Compiling and linking are skipped when the binary of the program
+    * is found in the cache.
+    */
+    ComputeProgram(ComputeShader& shader, ProgramBinaryCache& cache, const bool verbose = false);
+
+
+    /** \brief Declares a buffer as read by this program.
+    *
+    * \param buffer : a reference to the buffer.
+    * \param barrier_bits : the barrier bits related to the way the
+    *       buffer  is  read.   Defaults   to
+    *       GL_SHADER_STORAGE_BARRIER_BIT, i.e. storage blocks.
+    */
+    inline void add_buffer_input(const Buffer& buffer, const GLbitfield barrier_bits = GL_SHADER_STORAGE_BARRIER_BIT) {
+        prvt_inputs.push_back(Resource{ buffer.name, false, barrier_bits });
+    }
+
+
+    /** \brief Declares a buffer as written by this program (storage blocks or atomic counters).
+    */
+    inline void add_buffer_output(const Buffer& buffer) {
+        prvt_outputs.push_back(Resource{ buffer.name, false, 0 });
+    }
+
+
+    /** \brief Declares a texture as read by this program.
+    *
+    * \param texture : the OpenGL identifier of the texture.
+    * \param barrier_bits : the barrier bits related to the way the
+    *       texture is read. Defaults to GL_SHADER_IMAGE_ACCESS_BARRIER_BIT,
+    *       i.e. image loads. Use GL_TEXTURE_FETCH_BARRIER_BIT for
+    *       samplers.
+    */
+    inline void add_image_input(const GLuint texture, const GLbitfield barrier_bits = GL_SHADER_IMAGE_ACCESS_BARRIER_BIT) {
+        prvt_inputs.push_back(Resource{ texture, true, barrier_bits });
+    }
+
+
+    /** \brief Declares a texture as written by this program, as an image.
+    */
+    inline void add_image_output(const GLuint texture) {
+        prvt_outputs.push_back(Resource{ texture, true, 0 });
+    }
+
+
+    /** \brief Removes all the declared inputs and outputs.
+    */
+    inline void clear_resources() {
+        prvt_inputs.clear();
+        prvt_outputs.clear();
+    }
+
+
+    /** \brief Dispatches work groups.
+    *
+    * Uses this program, flushes its modified uniforms and inserts
+    * the needed memory barriers before dispatching.
+    */
+    void dispatch(const GLuint groups_x, const GLuint groups_y = 1, const GLuint groups_z = 1);
+
+
+    /** \brief Dispatches enough work groups to cover a problem size.
+    *
+    * \param size_x : the count of invocations along x.
+    * \param size_y : the count of invocations along y. Defaults to 1.
+    * \param size_z : the count of invocations along z. Defaults to 1.
+    */
+    void dispatch_for(const GLuint size_x, const GLuint size_y = 1, const GLuint size_z = 1);
+
+
+    /** \brief Dispatches work groups whose counts are read from an indirect buffer.
+    *
+    * \param buffer : a reference to the buffer containing a
+    *       DispatchIndirectCommand.
+    * \param offset : the offset of the command in the buffer.
+    *       Defaults to 0.
+    */
+    void dispatch_indirect(const Buffer& buffer, const GLintptr offset = 0);
+
+
+    /** \brief Returns the count of work groups needed for a problem size along one dimension.
+    */
+    inline const GLuint get_groups_count(const GLuint size, const int dimension) {
+        const GLuint group_size = GLuint(get_work_group_size()[dimension]);
+        return group_size == 0 ? 0 : (size + group_size - 1) / group_size;
+    }
+
+
+    /** \brief Returns the three dimensions of the work groups of this program.
+    *
+    * The dimensions are reflected again after each linking.
+    */
+    const GLint* get_work_group_size();
+
+
+    /** Class method. Returns the maximal counts of work groups per dispatch, along each dimension.
+    */
+    static void get_max_groups_count(GLint counts[3]);
+
+
+private:
+    struct Resource {
+        GLuint      name;
+        bool        is_texture;
+        GLbitfield  barrier_bits;
+    };
+
+    GLint               prvt_work_group_size[3];    // the reflected work group size.
+    unsigned            prvt_work_group_link_count; // the link count at reflection time.
+    vector<Resource>    prvt_inputs;                // the declared inputs.
+    vector<Resource>    prvt_outputs;               // the declared outputs.
+
+    void prvt_before_dispatch();
+    void prvt_after_dispatch();
+};
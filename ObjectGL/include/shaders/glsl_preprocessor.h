@@ -0,0 +1,183 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of GLSL sources preprocessors.
+*
+* Resolves the '#include "file"' and '#include <file>' directives of
+* GLSL source files,  which OpenGL does not support by itself.  Files
+* that contain '#pragma once' or that are protected by an include
+* guard ('#ifndef X / #define X ... #endif') are inserted  at  most
+* once per preprocessed source.
+*
+* Each parsed file (i.e. unit) is kept in an in-memory cache keyed
+* by its canonical path and by its last modification time.  Shared
+* headers are then parsed once per process rather than once per
+* shader.  The dependency graph between units is recorded also, so
+* that  the  shaders  that are affected by the modification of some
+* header can be precisely evaluated.
+*
+* Quoted includes are searched for first in the directory of  the
+* including file, then in the include directories.  Angled includes
+* are searched for in the include directories only.
+*
+* Notice: included files must not contain any '#version' directive.
+*
+* \sa Shader::load_source_code(const char*, GLSLPreprocessor&, const string&).
+*/
+class GLSLPreprocessor {
+public:
+
+    /** \brief The statistics of use of a preprocessor.
+    */
+    struct Stats {
+        size_t parses;      //!< the count of files that have been parsed.
+        size_t cache_hits;  //!< the count of units that were found up to date in cache.
+    };
+
+
+    /** \brief Constructor.
+    *
+    * \param include_directories : a reference to the list of the
+    *       directories to search for included files. Defaults to
+    *       no include directories.
+    */
+    GLSLPreprocessor(const vector<string>& include_directories = vector<string>());
+
+
+    /** \brief Copy constructor is not allowed on preprocessors.
+    */
+    GLSLPreprocessor(const GLSLPreprocessor& copy) = delete;
+
+
+    /** \brief Destructor.
+    */
+    ~GLSLPreprocessor()
+    {}
+
+
+    /** \brief Appends a directory to the list of include directories.
+    */
+    void add_include_directory(const string& directory_path);
+
+
+    /** \brief Empties the cache of units and the dependency graph.
+    */
+    void clear();
+
+
+    /** \brief Returns the paths of all the units that depend on some file.
+    *
+    * \param filepath : a reference to the path of the modified
+    *       file.
+    *
+    * \return the canonical paths of all the cached units which
+    *       directly or indirectly include 'filepath', not incl-
+    *       uding 'filepath' itself.
+    */
+    vector<string> get_dependents(const string& filepath) const;
+
+
+    /** \brief Returns the paths of the files directly included by some unit.
+    *
+    * \param filepath : a reference to the path of the unit.
+    *
+    * \return the canonical paths of the files that are directly
+    *       included by 'filepath',  or an empty list if this unit
+    *       has not been parsed yet.
+    */
+    vector<string> get_includes(const string& filepath) const;
+
+
+    /** \brief Returns the statistics of use of this preprocessor.
+    */
+    inline const Stats& get_stats() const {
+        return prvt_stats;
+    }
+
+
+    /** \brief Removes a unit from cache.
+    *
+    * Units are also automatically parsed again as soon as their
+    * modification time changes.
+    *
+    * \param filepath : a reference to the path of the unit.
+    */
+    void invalidate(const string& filepath);
+
+
+    /** \brief Preprocesses a GLSL source file.
+    *
+    * \param filepath : a reference to the path of the file to be
+    *       preprocessed.
+    * \param out_source_code : a reference to the string that will
+    *       finally contain the preprocessed source code.
+    * \param out_source_paths : a pointer to a vector that will
+    *       finally  contain  the  paths  of  the  files  that are
+    *       indexed  by  the  source-string-numbers  of the emitted
+    *       '#line' directives, or NULL. Defaults to NULL.
+    *
+    * \return true if preprocessing completed with no error,  or
+    *       false else.  Errors are printed on the error console.
+    */
+    bool preprocess(const string& filepath, string& out_source_code, vector<string>* out_source_paths = NULL);
+
+
+private:
+    struct Segment {
+        bool     is_include;    // true if this segment is an include directive, false if it is text.
+        string   content;       // the text of this segment, or the canonical path of the included file.
+        unsigned next_line;     // the number of the line that follows this segment in the unit.
+    };
+
+    struct Unit {
+        filesystem::file_time_type mtime;       // the modification time of the file at parsing time.
+        vector<Segment>            segments;    // the text and include segments of the file.
+        bool                       once;        // true if this unit is to be inserted at most once.
+    };
+
+    vector<string>                      prvt_include_directories;   // the directories to search for included files.
+    unordered_map<string, Unit>         prvt_units;                 // the cache of parsed units.
+    unordered_map<string, set<string>>  prvt_dependents;            // the reverse edges of the dependency graph.
+    Stats                               prvt_stats;                 // the statistics of use of this preprocessor.
+
+    static const string prvt_canonical(const filesystem::path& path);
+
+    bool prvt_expand(const string& path, set<string>& inserted, vector<string>& stack, vector<string>& sources, string& out);
+    const Unit* prvt_get_unit(const string& path);
+    bool prvt_parse(const string& path, Unit& unit);
+    const string prvt_resolve(const string& include_name, const bool quoted, const string& includer_path) const;
+};
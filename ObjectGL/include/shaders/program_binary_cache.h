@@ -0,0 +1,164 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "shaders_program.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of on-disk caches of OpenGL programs binaries.
+*
+* Once a shaders program has been successfully linked, its binary
+* representation  can  be retrieved from the OpenGL driver and be
+* stored on disk. At next run, this binary can be reloaded via
+* glProgramBinary() in place of compiling and linking again all of
+* the attached shaders.
+*
+* Each cached binary is identified by a 64-bits key evaluated from
+* the types and the source codes of all the shaders attached to the
+* program,  and  from  the  vendor,  renderer and version strings of
+* the OpenGL driver. Any change in a source code or in the driver
+* leads then to a new key.
+*
+* Drivers may reject previously stored binaries at any time.  In
+* such a case, the rejected binary file is removed from the cache
+* and the program gets compiled and linked as usual,  its new
+* binary replacing the rejected one.
+*
+* Notice: an OpenGL context must be current when calling  methods
+*   of this class.
+*
+* \sa ShadersProgram::link(ProgramBinaryCache&, const bool).
+*/
+class ProgramBinaryCache {
+public:
+
+    /** \brief The statistics of use of a program binaries cache.
+    */
+    struct Stats {
+        size_t hits;            //!< the count of binaries that were successfully loaded from cache.
+        size_t misses;          //!< the count of keys that were not found in cache.
+        size_t invalidations;   //!< the count of cached binaries that were rejected by the driver.
+        size_t stores;          //!< the count of binaries that were stored in cache.
+    };
+
+
+    /** \brief Constructor.
+    *
+    * \param directory_path : a reference to the path  of  the
+    *       directory  where  binaries  will be stored. This
+    *       directory is created when it does not yet exist.
+    */
+    ProgramBinaryCache(const string& directory_path);
+
+
+    /** \brief Copy constructor is not allowed on programs binaries caches.
+    */
+    ProgramBinaryCache(const ProgramBinaryCache& copy) = delete;
+
+
+    /** \brief Destructor.
+    */
+    ~ProgramBinaryCache()
+    {}
+
+
+    /** \brief Evaluates the cache key associated with a list of shaders.
+    *
+    * \param shaders : a reference to the list of the  shaders
+    *       that are attached to a program.
+    *
+    * \return the 64-bits key associated with these shaders for
+    *       the current OpenGL driver.
+    */
+    uint64_t evaluate_key(const ShadersList& shaders);
+
+
+    /** \brief Returns the statistics of use of this cache.
+    */
+    inline const Stats& get_stats() const {
+        return prvt_stats;
+    }
+
+
+    /** \brief Returns true if the current driver supports programs binaries.
+    */
+    bool is_supported();
+
+
+    /** \brief Loads a program binary from cache.
+    *
+    * Loads the binary associated with 'key' and sets it as the
+    * executable  of  the  program.  If  the  driver rejects the
+    * binary, the related cache file is removed.
+    *
+    * \param program_name : the OpenGL identifier of  the  prog-
+    *       ram to be set.
+    * \param key : the cache key of the program.
+    *
+    * \return true if the binary was found in cache and has been
+    *       accepted by the driver, or false else.
+    */
+    bool load(const GLuint program_name, const uint64_t key);
+
+
+    /** \brief Removes all the binaries stored in this cache.
+    */
+    void clear();
+
+
+    /** \brief Stores the binary of a successfully linked program in cache.
+    *
+    * The program should have been linked after  having  set  its
+    * GL_PROGRAM_BINARY_RETRIEVABLE_HINT parameter to GL_TRUE.
+    *
+    * \param program_name : the OpenGL identifier of  the  prog-
+    *       ram to be stored.
+    * \param key : the cache key of the program.
+    *
+    * \return true if the binary has been successfully  stored,
+    *       or false else.
+    */
+    bool store(const GLuint program_name, const uint64_t key);
+
+
+private:
+    string   prvt_directory_path;   // the path of the directory where binaries are stored.
+    uint64_t prvt_driver_hash;      // the hash value of the driver vendor, renderer and version strings.
+    Stats    prvt_stats;            // the statistics of use of this cache.
+    GLint    prvt_formats_count;    // the count of binary formats supported by the driver, -1 when not yet evaluated.
+
+    const string prvt_get_filepath(const uint64_t key) const;
+    uint64_t prvt_get_driver_hash();
+};
@@ -0,0 +1,134 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "GL/glew.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of the reflected interfaces of linked shaders programs.
+*
+* Runs once after each successful linking of a program and records,
+* through  glGetProgramInterfaceiv()  and  glGetProgramResourceiv(),
+* all the active uniforms,  vertex attributes (i.e. program inputs),
+* uniform blocks, shader storage blocks and atomic counter buffers
+* of the program.
+*
+* Resources are stored in compact arrays of plain structures, one per
+* interface,  while all names are stored in one single pool of chars.
+* Lookups by name are meant for setup time only: hot paths should keep
+* the returned locations, indices or resources pointers.
+*/
+class ProgramReflection {
+public:
+
+    /** \brief The reflected interfaces.
+    */
+    enum Interface {
+        UNIFORMS = 0,           //!< the default block uniforms and the uniforms of named blocks.
+        INPUTS,                 //!< the vertex attributes of the program.
+        UNIFORM_BLOCKS,         //!< the uniform blocks.
+        STORAGE_BLOCKS,         //!< the shader storage blocks.
+        ATOMIC_COUNTER_BUFFERS, //!< the atomic counter buffers. They have no name.
+        INTERFACES_COUNT
+    };
+
+
+    /** \brief The description of a reflected resource.
+    *
+    * Fields that are not relevant for an interface are set to -1.
+    */
+    struct Resource {
+        GLuint  name_offset;    //!< the offset of the name of this resource in the names pool.
+        GLenum  type;           //!< the GLSL type of uniforms and inputs (e.g. GL_FLOAT_VEC3), 0 for blocks and buffers.
+        GLint   location;       //!< the location of uniforms and inputs, -1 for uniforms in named blocks.
+        GLint   array_size;     //!< the count of elements of arrays, 1 for non arrays.
+        GLint   block_index;    //!< the index of the block of uniforms in named blocks, -1 else.
+        GLint   binding;        //!< the buffer binding point of blocks and buffers.
+        GLint   offset;         //!< the offset in their block of block uniforms, the data size of blocks and buffers.
+        GLint   array_stride;   //!< the stride of arrays in blocks.
+        GLint   matrix_stride;  //!< the stride of matrices columns in blocks.
+    };
+
+
+    /** \brief Looks for a resource by name.
+    *
+    * For arrays,  both "name" and "name[0]" are accepted.
+    *
+    * \return a pointer to the resource,  or NULL if no such
+    *       resource is active.
+    */
+    const Resource* find(const Interface itf, const char* name) const;
+
+
+    /** \brief Returns the location of an input (i.e. vertex attribute), or -1 if not found.
+    */
+    inline GLint get_input_location(const char* name) const {
+        const Resource* resource = find(INPUTS, name);
+        return resource == NULL ? -1 : resource->location;
+    }
+
+
+    /** \brief Returns the name of a resource.
+    */
+    inline const char* get_name(const Resource& resource) const {
+        return prvt_names.data() + resource.name_offset;
+    }
+
+
+    /** \brief Returns all the resources of an interface.
+    */
+    inline const vector<Resource>& get_resources(const Interface itf) const {
+        return prvt_resources[itf];
+    }
+
+
+    /** \brief Returns the location of a default block uniform, or -1 if not found.
+    */
+    inline GLint get_uniform_location(const char* name) const {
+        const Resource* resource = find(UNIFORMS, name);
+        return resource == NULL ? -1 : resource->location;
+    }
+
+
+    /** \brief Reflects the interfaces of a linked program.
+    *
+    * \param program_name : the OpenGL identifier of the program.
+    */
+    void reflect(const GLuint program_name);
+
+
+private:
+    vector<Resource>    prvt_resources[INTERFACES_COUNT];   // the resources of each interface.
+    vector<GLchar>      prvt_names;                         // the pool of all NULL-terminated names.
+
+    void prvt_reflect_interface(const GLuint program_name, const Interface itf);
+};
@@ -0,0 +1,228 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "shaders.h"
+#include "shaders_program.h"
+
+using namespace std;
+
+class GLSLPreprocessor;
+class ProgramBinaryCache;
+
+
+//===========================================================================
+/** \brief The class of shaders programs permutations managers.
+*
+* An uber-shader is declared once with the base source code of each
+* of its stages and with a list of keywords (up to 64).  Each
+* combination  of  keywords  is a variant of the program,  identified
+* by a bitmask key: bit i is set when keyword i is enabled. Variants
+* are compiled and linked lazily, on their first request only, with
+* a prelude made of the '#version' line and of  a  '#define  KEYWORD 1'
+* line  per  enabled  keyword.  Base  source  codes  must  then not
+* contain any '#version' directive.
+*
+* Compiling costs scale then with the count of variants actually used
+* rather than with the count of possible combinations. Built variants
+* are kept in a hash map. When a memory budget is set, the least
+* recently requested variants are evicted as soon as the estimated
+* memory footprint of the built variants exceeds it.
+*
+* Notice: an OpenGL context must be current when calling methods  of
+*   this class,  and when destructing it.
+*/
+class ShaderPermutations {
+public:
+
+    typedef uint64_t Key;   //!< the type of variants keys.
+
+    /** \brief The statistics of use of a permutations manager.
+    */
+    struct Stats {
+        size_t builds;          //!< the count of variants that have been compiled and linked.
+        size_t failures;        //!< the count of variants that failed to compile or link.
+        size_t hits;            //!< the count of requests of already built variants.
+        size_t evictions;       //!< the count of variants that have been evicted.
+        size_t memory_used;     //!< the estimated memory footprint of the currently built variants, in bytes.
+    };
+
+
+    /** \brief Constructor.
+    *
+    * \param glsl_version : a reference to the version to be set
+    *       in the '#version' directive of each variant,  e.g.
+    *       "450 core".
+    * \param keywords : a reference to the list of the keywords
+    *       of this uber-shader. At most 64 keywords.
+    */
+    ShaderPermutations(const string& glsl_version, const vector<string>& keywords);
+
+
+    /** \brief Copy constructor is not allowed on permutations managers.
+    */
+    ShaderPermutations(const ShaderPermutations& copy) = delete;
+
+
+    /** \brief Destructor. Deletes all built variants.
+    */
+    ~ShaderPermutations();
+
+
+    /** \brief Declares a stage with its base source code loaded from file.
+    *
+    * \param type : the type of the stage shader, e.g. GL_VERTEX_SHADER.
+    * \param filepath : a reference to the path of the file that
+    *       contains the base source code of this stage.
+    */
+    void add_stage_file(const GLenum type, const string& filepath);
+
+
+    /** \brief Declares a stage with its base source code.
+    *
+    * \param type : the type of the stage shader, e.g. GL_VERTEX_SHADER.
+    * \param source_code : a reference to the base source code of
+    *       this stage.
+    */
+    void add_stage_source(const GLenum type, const string& source_code);
+
+
+    /** \brief Deletes all built variants and forgets the failed ones.
+    */
+    void clear();
+
+
+    /** \brief Returns the shaders program of a variant. Builds it on first request.
+    *
+    * \param key : the key of the requested variant.
+    * \param verbose : set this to true to get compilation and
+    *       linking error logs printed on error console. Defaults
+    *       to false.
+    *
+    * \return a pointer to the linked shaders program of this
+    *       variant, or NULL if it failed to compile or to link.
+    *       Failures are remembered until 'clear()' is called,
+    *       so that broken variants are not built again. They do
+    *       not count as hits nor against the memory budget, and
+    *       are never evicted.  The pointer remains valid until
+    *       the variant gets evicted or cleared.
+    */
+    ShadersProgram* get(const Key key, const bool verbose = false);
+
+
+    /** \brief Returns the key of the variant with the specified enabled keywords.
+    *
+    * Unknown keywords are ignored. Keys should be evaluated once
+    * and kept, rather than evaluated on each request.
+    */
+    Key get_key(const vector<string>& enabled_keywords) const;
+
+
+    /** \brief Returns the statistics of use of this permutations manager.
+    */
+    inline const Stats& get_stats() const {
+        return prvt_stats;
+    }
+
+
+    /** \brief Returns true if the variant with the specified key is currently built.
+    */
+    inline const bool is_built(const Key key) const {
+        const auto found = prvt_variants.find(key);
+        return found != prvt_variants.end() && found->second.program;
+    }
+
+
+    /** \brief Sets the programs binaries cache to be used when building variants.
+    *
+    * \param cache : a pointer to the cache, or NULL to not use
+    *       any cache. It must live longer than this manager.
+    */
+    inline void set_binary_cache(ProgramBinaryCache* cache) {
+        prvt_binary_cache = cache;
+    }
+
+
+    /** \brief Sets the memory budget for the built variants.
+    *
+    * \param budget : the maximum estimated memory footprint of
+    *       the built variants,  in bytes,  or 0 for no limit at
+    *       all. The most recently requested variant is never
+    *       evicted.
+    */
+    void set_memory_budget(const size_t budget);
+
+
+    /** \brief Sets the GLSL preprocessor to be used for loading stages from files.
+    *
+    * \param preprocessor : a pointer to the preprocessor, or NULL
+    *       to not preprocess files. It must live longer than this
+    *       manager.
+    */
+    inline void set_preprocessor(GLSLPreprocessor* preprocessor) {
+        prvt_preprocessor = preprocessor;
+    }
+
+
+private:
+    struct Stage {
+        GLenum type;            // the type of the shader of this stage.
+        string filepath;        // the path of the base source file, or empty.
+        string source_code;     // the base source code, when not loaded from file.
+    };
+
+    struct Variant {
+        unique_ptr<ShadersProgram>  program;    // the shaders program, or NULL when building failed (negative entry).
+        vector<unique_ptr<Shader>>  shaders;    // the shaders of this variant.
+        size_t                      memory;     // the estimated memory footprint of this variant.
+        uint64_t                    last_use;   // the tick of the last request of this variant.
+    };
+
+    string                          prvt_version;           // the '#version' directive of all variants.
+    vector<string>                  prvt_keywords;          // the declared keywords.
+    vector<string>                  prvt_defines;           // the '#define' line of each keyword.
+    vector<Stage>                   prvt_stages;            // the declared stages.
+    unordered_map<Key, Variant>     prvt_variants;          // the built variants.
+    Stats                           prvt_stats;
+    size_t                          prvt_memory_budget;     // 0 for no limit.
+    uint64_t                        prvt_tick;              // incremented on each request.
+    optional<Key>                   prvt_last_key;          // the key of the most recently requested built variant, if any.
+    ProgramBinaryCache*             prvt_binary_cache;
+    GLSLPreprocessor*               prvt_preprocessor;
+
+    void prvt_build(const Key key, Variant& variant, const bool verbose);
+    void prvt_evict_cold_variants(const optional<Key>& protected_key);
+    void prvt_release(Variant& variant);
+};
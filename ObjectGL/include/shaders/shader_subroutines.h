@@ -89,7 +89,7 @@ public:
     /** \brief Returns the ok status of this shader subroutine.
     */
     const bool is_ok() {
-        return prvt_location >= 0 && prvt_location != GL_INVALID_OPERATION;
+        return prvt_location >= 0;
     }
 
 
@@ -129,6 +129,38 @@ public:
     }
 
 
+    /** \brief selects the final function to be used within the targetted shader, by index.
+    *
+    * This is the fastest way to select functions: no name  lookup
+    * takes place.  The selection is recorded in the  subroutines
+    * state of the program and is uploaded either immediately or
+    * with the next batched upload of this program stage.
+    *
+    * \param function_index : the index of the function, as
+    *       returned by 'get_function_index()'.
+    * \param immediate : set this to true to upload the selections
+    *       of the whole stage now, or false to only record the
+    *       selection until the next call to 'use()' or to the
+    *       'apply()' method of the program subroutines state.
+    *       Defaults to true.
+    *
+    * \return true if selection  has  successfully  completed,  or
+    *       false otherwise.
+    */
+    bool select(const GLuint function_index, const bool immediate = true);
+
+
+    /** \brief Returns the index of a function, to be later used for fast selection.
+    *
+    * \param function_name : a C-string containing the name of the
+    *       function.
+    *
+    * \return the index of the function, or GL_INVALID_INDEX if no
+    *       such function is active in the targetted shader.
+    */
+    GLuint get_function_index(const char* function_name);
+
+
     /*** /
     Parameter shadertype for the functions in this
     section may be {COMPUTE, VERTEX}_SHADER,
@@ -196,7 +228,7 @@ public:
     GLsizei uniformCount,
     const GLuint *uniformIndices,
     GLenum pname, GLint *params);
-    /***/
+    ***/
 
 private:
     ShadersProgram& prvt_program;
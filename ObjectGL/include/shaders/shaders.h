@@ -25,12 +25,48 @@ SOFTWARE.
 
 //===========================================================================
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <vector>
 #include "GL/glew.h"
 #include "../objects/object.h"
+#include "../utils/hash.h"
 
 using namespace std;
 
+class GLSLPreprocessor;
+
+
+//===========================================================================
+/** \brief The type of SPIR-V specialization constants.
+*
+* Values are 32-bits patterns.  Boolean,  integer  and  floating
+* point constants can be built with the related constructors.
+*/
+struct SpecializationConstant {
+    GLuint id;      //!< the SPIR-V specialization constant id, as set with 'layout(constant_id = ...)'.
+    GLuint value;   //!< the 32-bits pattern of the value of this constant.
+
+    SpecializationConstant(const GLuint id, const GLuint value)
+        : id(id), value(value)
+    {}
+
+    SpecializationConstant(const GLuint id, const GLint value)
+        : id(id), value(GLuint(value))
+    {}
+
+    SpecializationConstant(const GLuint id, const bool value)
+        : id(id), value(value ? 1 : 0)
+    {}
+
+    SpecializationConstant(const GLuint id, const GLfloat value)
+        : id(id), value(0)
+    {
+        memcpy(&this->value, &value, sizeof(GLuint));
+    }
+};
+
 
 //===========================================================================
 /** The base class for all OpenGL Shader Objects.
@@ -39,6 +75,7 @@ class Shader : public SharableObject {
 public:
 
     bool compiled; //!< the compilation status of this shader.
+    GLenum type;   //!< the type of this shader, as specified at construction time.
 
     /** \brief Empty constructor.
     * 
@@ -62,7 +99,7 @@ public:
     *       GL_TESS_EVALUATION_SHADER, GL_TESS_CONTROL_SHADER.
     */
     Shader(GLenum type)
-        : SharableObject(glCreateShader(type)), compiled(false)
+        : SharableObject(glCreateShader(type)), compiled(false), type(type), prvt_source_hash(0), prvt_compile_pending(false), prvt_preprocessor(NULL), prvt_spirv(false), prvt_specialized(false), prvt_binary_hash(0)
     {}
 
     /** \brief Constructor with source code setting from file.
@@ -91,7 +128,7 @@ public:
     * \sa set_source_code.
     */
     Shader(GLenum type, const string& filepath)
-        : SharableObject(glCreateShader(type)), compiled(false)
+        : SharableObject(glCreateShader(type)), compiled(false), type(type), prvt_source_hash(0), prvt_compile_pending(false), prvt_preprocessor(NULL), prvt_spirv(false), prvt_specialized(false), prvt_binary_hash(0)
     {
         load_source_code(filepath);
     }
@@ -123,7 +160,7 @@ public:
     * \sa set_source_code.
     */
     Shader(GLenum type, const char* filepath)
-        : SharableObject(glCreateShader(type)), compiled(false)
+        : SharableObject(glCreateShader(type)), compiled(false), type(type), prvt_source_hash(0), prvt_compile_pending(false), prvt_preprocessor(NULL), prvt_spirv(false), prvt_specialized(false), prvt_binary_hash(0)
     {
         load_source_code(filepath);
     }
@@ -156,6 +193,60 @@ public:
     bool compile();
 
 
+    /** \brief Compiles this shader and returns its full compilation log on failure.
+    *
+    * Same as 'compile()', the whole log being queried  with  its
+    * actual length rather than with a maximum one.
+    *
+    * \param error_log : a reference to the string which  gets
+    *       the  compilation  logs  on  error,  and which gets
+    *       cleared on success.
+    *
+    * \return true if compiling is ok, or false else.
+    */
+    bool compile(string& error_log);
+
+
+    /** \brief Submits the compilation of this shader without waiting for its completion.
+    *
+    * The compilation status is not queried, so that drivers which
+    * support  KHR_parallel_shader_compile  can  compile  shaders
+    * on their own threads.  Completion can then be polled with
+    * 'is_compile_completed()'.  Method 'compile()' may be called
+    * afterwards to get the final (blocking) compilation status.
+    *
+    * \sa compile, is_compile_completed.
+    */
+    void compile_async();
+
+
+    /** \brief Returns true if no submitted compilation of this shader is pending anymore.
+    *
+    * Never blocks when the driver supports parallel  shaders
+    * compilation (KHR_parallel_shader_compile or its ARB twin).
+    * Otherwise,  compilation  is  completed on the calling thread
+    * and true is then returned.  Once true has been returned,
+    * 'compile()' returns the final status without blocking.
+    *
+    * \sa compile_async.
+    */
+    bool is_compile_completed();
+
+
+    /** \brief Returns true if this shader has been loaded from a SPIR-V binary.
+    */
+    inline const bool is_spirv() const {
+        return prvt_spirv;
+    }
+
+
+    /** Class method. Returns true if the driver accepts SPIR-V shaders binaries.
+    */
+    static bool is_spirv_supported() {
+        return GLEW_VERSION_4_6 || GLEW_ARB_gl_spirv;
+    }
+
+
     /** \brief Provides compilation logs.
     * 
     * \param info_log : a reference to  the  string  which  will
@@ -184,10 +275,48 @@ public:
         return glIsShader(name);
     }
 
+
+    /** \brief Returns the hash value of the current source code of this shader.
+    *
+    * This hash value is evaluated each time the source code of
+    * this shader is set. It is stable from one run to another,
+    * so that it can be used as part of on-disk caches keys.
+    *
+    * \return the FNV-1a 64-bits hash of the shader type and of
+    *       its source code, or 0 if no source code has been set
+    *       yet.
+    */
+    inline const uint64_t get_source_hash() const {
+        return prvt_source_hash;
+    }
+
+
+    /** \brief Returns the paths of the files the current source code of this shader has been loaded from.
+    *
+    * \return a reference to the list of the paths of the files
+    *       passed to the last call to 'load_source_code()',  or
+    *       an empty list if the source code has been set in any
+    *       other way.
+    */
+    inline const vector<string>& get_source_filepaths() const {
+        return prvt_source_filepaths;
+    }
+
+
+    /** \brief Returns the GLSL preprocessor used at last loading of the source code of this shader.
+    *
+    * \return a pointer to the preprocessor, or NULL if no pre-
+    *       processor was used.
+    */
+    inline GLSLPreprocessor* get_preprocessor() const {
+        return prvt_preprocessor;
+    }
+
     /** \brief Loads from file the source code of this shader.
     * 
-    * Catches any I/O exceptions and provides an  error  message
-    * on the console. In case of error, returns false.
+    * The file is memory-mapped and its content is passed as is
+    * to OpenGL. Provides an error message on the console in case
+    * of error, and then returns false.
     *
     * \param file_path : a reference to the  path  of  the  file
     *        that contains the whole source code of this shader.
@@ -206,8 +335,9 @@ public:
 
     /** \brief Loads from file the source code of this shader.
     *
-    * Catches any I/O exceptions and provides an  error  message 
-    * on the console. In case of error, returns false.
+    * The file is memory-mapped and its content is passed as is
+    * to OpenGL. Provides an error message on the console in case
+    * of error, and then returns false.
     * 
     * \param file_path : a C NULL-terminated  string  describing
     *        to  the  path  of  the  file that contains the whole
@@ -218,6 +348,130 @@ public:
     bool load_source_code(const char* filepath);
 
 
+    /** \brief Loads from file the source code of this shader, preceded by a prelude.
+    *
+    * The file is memory-mapped and its content is passed with
+    * the  prelude  straight  to  OpenGL,  with  no intermediate
+    * copy.  The prelude typically contains the '#version'  line
+    * and '#define' directives, in which case the file itself
+    * must not contain any '#version' line.
+    *
+    * \param file_path : a C NULL-terminated  string  describing
+    *        the path of the file that contains the source code
+    *        of this shader.
+    * \param prelude : a reference to the text to be inserted
+    *        before the content of the file. May be empty.
+    *
+    * \return true if loading was ok, or false else.
+    */
+    bool load_source_code(const char* filepath, const string& prelude);
+
+
+    /** \brief Loads from many files the source code of this shader, preceded by a prelude.
+    *
+    * All files are memory-mapped and their contents are passed
+    * in  the  specified  order  and  with  the prelude straight
+    * to OpenGL, with no intermediate copy.
+    *
+    * \param filepaths : a reference to the vector of the paths
+    *        of the files that contain the source code of this
+    *        shader.
+    * \param prelude : a reference to the text to be inserted
+    *        before the contents of the files. Defaults to  no
+    *        prelude.
+    *
+    * \return true if loading was ok, or false else.
+    */
+    bool load_source_code(const vector<string>& filepaths, const string& prelude = string());
+
+
+    /** \brief Loads from file and preprocesses the source code of this shader.
+    *
+    * The '#include' directives of the file are resolved by the
+    * specified  preprocessor,  which  caches  the parsed units
+    * for all the shaders that use it.
+    *
+    * \param file_path : a C NULL-terminated  string  describing
+    *        the path of the file that contains the source code
+    *        of this shader.
+    * \param preprocessor : a reference to the GLSL preprocessor
+    *        to be used.
+    * \param prelude : a reference to the text to be inserted
+    *        before the preprocessed source code. Defaults to no
+    *        prelude.
+    *
+    * \return true if loading and preprocessing were ok, or false
+    *        else.
+    */
+    bool load_source_code(const char* filepath, GLSLPreprocessor& preprocessor, const string& prelude = string());
+
+
+    /** \brief Loads again the source code of this shader from its files.
+    *
+    * Uses the same files,  prelude  and  preprocessor  as  the
+    * last  call to 'load_source_code()'.  The shader has then to
+    * be compiled again.
+    *
+    * \return true if loading was ok,  or false on error or if
+    *        the source code of this shader has not been loaded
+    *        from files.
+    */
+    bool reload_source_code();
+
+
+    /** \brief Loads from file a SPIR-V binary as the code of this shader.
+    *
+    * The file content is passed as is to glShaderBinary(), so
+    * that the driver GLSL front-end parser is not run at all. The
+    * shader is then compiled by being specialized, either by cal-
+    * ling 'specialize()' or by calling 'compile()' which uses the
+    * entry point and the specialization constants set with 'set_
+    * specialization()'.  Since OpenGL specializes a shader binary
+    * once only, the binary is kept and uploaded again whenever
+    * the shader gets specialized another time.
+    *
+    * Files whose size is not a multiple of 4 bytes or which do
+    * not start with the SPIR-V magic number are rejected.
+    *
+    * \param file_path : a C NULL-terminated  string  describing
+    *        the path of the '.spv' file.
+    *
+    * \return true if loading was ok, or false else.
+    *
+    * \sa is_spirv_supported, specialize.
+    */
+    bool load_spirv(const char* filepath);
+
+
+    /** \brief Sets the entry point and the specialization constants of this SPIR-V shader.
+    *
+    * They are used at next compilation of this shader.
+    *
+    * \param constants : a reference to the list of the special-
+    *        ization constants to be set. Constants that are not
+    *        listed keep their default values.
+    * \param entry_point : a reference to the name of the entry
+    *        point function. Defaults to "main".
+    */
+    void set_specialization(const vector<SpecializationConstant>& constants, const string& entry_point = "main");
+
+
+    /** \brief Specializes (i.e. compiles) this SPIR-V shader.
+    *
+    * \param constants : a reference to the list of the special-
+    *        ization constants to be set. Defaults to none.
+    * \param entry_point : a reference to the name of the entry
+    *        point function. Defaults to "main".
+    *
+    * \return true if specialization completed with no error, or
+    *        false else.
+    */
+    bool specialize(const vector<SpecializationConstant>& constants = vector<SpecializationConstant>(), const string& entry_point = "main") {
+        set_specialization(constants, entry_point);
+        return compile();
+    }
+
+
     /** \brief Prepares the further deletion of this shader within the OpenGL context.
     *
     * Notice: this is not  the  same  action  as  deleting  this
@@ -237,11 +491,30 @@ public:
     * \sa old_source_code_to_string.
     */
     void set_source_code(const string& source_code) {
-        glShaderSource(name, 1, (const GLchar *const *)source_code.c_str(), NULL);
-        compiled = false;
+        const GLchar* chunk = source_code.c_str();
+        const GLint length = GLint(source_code.size());
+        set_source_code(1, &chunk, &length);
     }
 
 
+    /** \brief Sets the source code of this shader from many chunks of text.
+    *
+    * The chunks are passed as is to OpenGL, which concatenates
+    * them.  No copy of them is done on the application side.
+    *
+    * \param count : the count of entries in arrays 'chunks' and
+    *        'lengths'.
+    * \param chunks : an array of pointers to the chunks of text.
+    *        They may not be NULL-terminated, see next argument.
+    * \param lengths : an array of the lengths of each chunk. A
+    *        negative length means that the related chunk is a
+    *        NULL-terminated string. Must not be NULL.
+    *
+    * \sa set_source_code(const string&).
+    */
+    void set_source_code(const GLsizei count, const GLchar* const* chunks, const GLint* lengths);
+
+
     /** \brief Transforms all version of source code to a single NULL-terminated string.
     * 
     * This is a class method. It takes as input the classical
@@ -272,4 +545,23 @@ public:
         const GLint* length,
         string& out_source_code);
 
+
+protected:
+    uint64_t prvt_source_hash;      // the hash value of the current source code of this shader.
+    bool     prvt_compile_pending;  // true once compilation has been submitted and until its status has been queried.
+
+    vector<string>    prvt_source_filepaths;    // the paths of the files the source code has been loaded from.
+    string            prvt_prelude;             // the prelude used at last loading from files.
+    GLSLPreprocessor* prvt_preprocessor;        // the preprocessor used at last loading from files, or NULL.
+
+    bool                            prvt_spirv;                 // true if the code of this shader is a SPIR-V binary.
+    bool                            prvt_specialized;           // true once the current SPIR-V binary has been specialized.
+    uint64_t                        prvt_binary_hash;           // the hash value of the SPIR-V binary.
+    vector<GLuint>                  prvt_binary;                // the SPIR-V binary, uploaded again for each new specialization.
+    string                          prvt_entry_point;           // the SPIR-V entry point.
+    vector<SpecializationConstant>  prvt_specialization;        // the SPIR-V specialization constants.
+
+    void prvt_submit_compile();
+    void prvt_upload_spirv();
+
 };
\ No newline at end of file
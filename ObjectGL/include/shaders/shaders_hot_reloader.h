@@ -0,0 +1,232 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "shaders.h"
+#include "shaders_program.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of shaders hot reloaders.
+*
+* Watches the source files of the shaders attached to registered
+* programs  -  and  the files they include when they have been
+* loaded through a GLSLPreprocessor - and reloads, recompiles and
+* relinks only the shaders and programs  that  are  affected  by
+* modified files.
+*
+* On Linux, files modifications are notified by  inotify  to  a
+* background  thread,  which  watches  directories  rather  than
+* files, so that thousands of files can be watched at no cost.
+* Nothing is polled per frame: when no file has been modified,
+* methods 'process_pending()' and 'swap_reloaded()' only check an
+* atomic flag.  On other platforms, modifications can be notified
+* with method 'notify_changed()'.
+*
+* Rebuilding takes place in 'process_pending()', which may be called
+* from a background thread with an OpenGL context that  shares  its
+* objects  with  the  rendering  one.  New programs are linked into
+* new OpenGL program objects.  They are swapped  in  by  method
+* 'swap_reloaded()',  to be called from the rendering thread, only
+* once they have been successfully linked and once the driver has
+* completed  their  building.  On  any  failure,  the previous
+* programs are kept running.
+*
+* Notice: 'update()' runs both steps, for applications that want to
+*   rebuild programs on their rendering thread.
+*/
+class ShadersHotReloader {
+public:
+
+    /** \brief The statistics of use of a hot reloader.
+    */
+    struct Stats {
+        size_t notifications;   //!< the count of files modifications that have been notified.
+        size_t relinks;         //!< the count of programs that have been successfully relinked.
+        size_t failures;        //!< the count of shaders compilations and programs linkings that have failed.
+    };
+
+
+    /** \brief Empty constructor.
+    */
+    ShadersHotReloader();
+
+
+    /** \brief Copy constructor is not allowed on hot reloaders.
+    */
+    ShadersHotReloader(const ShadersHotReloader& copy) = delete;
+
+
+    /** \brief Destructor. Stops the watching thread if it is running.
+    *
+    * Notice: replacement programs that have been linked but not
+    *   yet swapped in are deleted only if an OpenGL context is
+    *   current at destruction time.
+    */
+    ~ShadersHotReloader();
+
+
+    /** \brief Returns the statistics of use of this hot reloader.
+    */
+    inline const Stats get_stats() {
+        lock_guard<mutex> lock(prvt_mutex);
+        return prvt_stats;
+    }
+
+
+    /** \brief Returns true if the watching thread is running.
+    */
+    inline const bool is_running() const {
+        return prvt_running.load();
+    }
+
+
+    /** \brief Notifies the modification of a file.
+    *
+    * Called by the watching thread. May be called also by the
+    * application, e.g. on platforms where inotify is not avail-
+    * able. Files that are not watched are ignored.
+    *
+    * \param filepath : a reference to the path of the modified
+    *       file.
+    */
+    void notify_changed(const string& filepath);
+
+
+    /** \brief Reloads, recompiles and relinks everything that is affected by modified files.
+    *
+    * Must be called from a thread with a current OpenGL context,
+    * either the rendering one or one that shares its objects with
+    * it. Relinked programs are not swapped in yet. Shaders and
+    * their preprocessors are modified by this method only, the
+    * watching thread never accessing them.
+    *
+    * \param verbose : set this to true to get compilation and
+    *       linking error logs printed on error console. Defaults
+    *       to false.
+    *
+    * \return the count of programs that have been relinked.
+    *
+    * \sa swap_reloaded, update.
+    */
+    size_t process_pending(const bool verbose = false);
+
+
+    /** \brief Starts the watching thread.
+    *
+    * \return true if the watching thread is running, or false if
+    *       inotify is not available or could not be initialized.
+    */
+    bool start();
+
+
+    /** \brief Stops the watching thread.
+    */
+    void stop();
+
+
+    /** \brief Swaps in the programs that have been relinked by 'process_pending()'.
+    *
+    * Must be called from the rendering thread. Programs whose
+    * building is not yet completed by the driver are left for a
+    * next call. Never blocks.
+    *
+    * \return the count of programs that have been swapped in.
+    */
+    size_t swap_reloaded();
+
+
+    /** \brief Unregisters a shaders program.
+    */
+    void unwatch(ShadersProgram& program);
+
+
+    /** \brief Reloads and swaps in everything that is affected by modified files.
+    *
+    * Must be called from the rendering thread.
+    *
+    * \return the count of programs that have been swapped in.
+    */
+    inline size_t update(const bool verbose = false) {
+        process_pending(verbose);
+        return swap_reloaded();
+    }
+
+
+    /** \brief Registers a shaders program.
+    *
+    * The source files of all the attached shaders that have been
+    * loaded from files, and all the files they include, get watched.
+    *
+    * \param program : a reference to the program to be watched.
+    *       It must stay alive until it gets unwatched or until
+    *       this hot reloader is destructed.
+    *
+    * \return true if at least one file is watched for this prog-
+    *       ram, or false else.
+    */
+    bool watch(ShadersProgram& program);
+
+
+private:
+    struct Replacement {
+        ShadersProgram* program;    // the program to be replaced.
+        GLuint          new_name;   // the OpenGL identifier of the replacement program.
+        GLsync          fence;      // signaled once the driver has completed the building of the replacement.
+    };
+
+    mutex                                               prvt_mutex;             // protects all the containers below.
+    unordered_map<string, set<Shader*>>                 prvt_file_shaders;      // the shaders affected by each watched file.
+    unordered_map<Shader*, set<ShadersProgram*>>        prvt_shader_programs;   // the programs each watched shader is attached to.
+    unordered_map<string, int>                          prvt_directory_watches; // the inotify watch descriptor of each watched directory.
+    unordered_map<int, string>                          prvt_watched_directories;
+    set<string>                                         prvt_changed_files;     // the modified files not yet processed.
+    vector<Replacement>                                 prvt_replacements;      // the relinked programs not yet swapped in.
+    Stats                                               prvt_stats;
+
+    atomic<bool>    prvt_has_changes;
+    atomic<bool>    prvt_has_replacements;
+    atomic<bool>    prvt_running;
+    thread          prvt_thread;
+    int             prvt_inotify_fd;
+    int             prvt_wakeup_fds[2];
+
+    void prvt_register_shader(Shader* shader);
+    void prvt_run();
+    void prvt_watch_directory(const string& directory_path);
+};
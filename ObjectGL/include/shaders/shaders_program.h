@@ -24,17 +24,24 @@ SOFTWARE.
 */
 
 //===========================================================================
+#include <string>
 #include <vector>
 
 #include "GL/glew.h"
 
+#include "context/gl_state.h"
 #include "objects/object.h"
+#include "program_reflection.h"
 #include "shaders.h"
+#include "subroutines_state.h"
+#include "uniforms_shadow.h"
 
 
 //===========================================================================
 typedef vector<Shader*> ShadersList; //< the type for lists of shaders.
 
+class ProgramBinaryCache;
+
 
 //===========================================================================
 /** The class of OpenGL Shaders Programs.
@@ -55,7 +62,7 @@ public:
     *          associated identifier is 0.
     */
     ShadersProgram()
-        : Object(glCreateProgram()), linked(false)
+        : Object(glCreateProgram()), linked(false), prvt_link_pending(false), prvt_link_count(0)
     {}
 
 
@@ -88,6 +95,28 @@ public:
     ShadersProgram(ShadersList& shaders, const bool immediate_use = false, const bool verbose = false);
 
 
+    /** \brief full constructor with programs binaries cache. May run (i.e. "use") the program if asked for.
+    *
+    * Same as the full constructor above, except that compiling
+    * and  linking  are  skipped  when  the  binary  of  this
+    * program is found in the specified cache.
+    *
+    * \param shaders : a  reference  to  a  vector  of  shaders
+    *       references.
+    * \param cache : a reference to the programs binaries cache
+    *       to be used.
+    * \param immediate_use: set this to true if  you  want  this
+    *       program  to  be run (i.e. "used") as soon as it will
+    *       have been created and linked. Defaults to false.
+    * \param verbose: set this to true to get verbose compilation
+    *       of compiled shaders,  or set it to false to get muted
+    *       compilations.
+    *
+    * \sa link(ProgramBinaryCache&, const bool).
+    */
+    ShadersProgram(ShadersList& shaders, ProgramBinaryCache& cache, const bool immediate_use = false, const bool verbose = false);
+
+
     /** \brief Copy constructor is not allowed on shaders programs.
     */
     ShadersProgram(const ShadersProgram& copy) = delete;
@@ -219,6 +248,73 @@ public:
     void get_linking_log(string& info_log, const GLsizei max_length = 1024);
 
 
+    /** \brief Returns the list of the shaders that are currently attached to this program.
+    */
+    inline const ShadersList& get_attached_shaders() const {
+        return prvt_attached_shaders;
+    }
+
+
+    /** \brief Returns the label of this program, or an empty string if not set.
+    */
+    inline const string& get_label() const {
+        return prvt_label;
+    }
+
+
+    /** \brief Returns the subroutines state of this program.
+    *
+    * This state is reflected each time this program gets linked.
+    * Selections recorded in it are uploaded either by a call to
+    * its method 'apply()' or by method 'use()'.
+    */
+    inline SubroutinesState& get_subroutines() {
+        return prvt_subroutines;
+    }
+
+
+    /** \brief Returns the count of successful linkings of this program.
+    *
+    * Locations  and  indices  may  change each time a program is
+    * linked again (e.g. when hot reloaded).  Objects that cache
+    * them compare this count to the one they  have  been  resolved
+    * with.
+    */
+    inline const unsigned get_link_count() const {
+        return prvt_link_count;
+    }
+
+
+    /** \brief Returns the reflected interfaces of this program.
+    *
+    * Interfaces are reflected each time this program gets linked.
+    */
+    inline const ProgramReflection& get_reflection() const {
+        return prvt_reflection;
+    }
+
+
+    /** \brief Returns the shadow copy of the default block uniforms of this program.
+    *
+    * The shadow is built again each time this program gets linked.
+    */
+    inline UniformsShadow& get_uniforms_shadow() {
+        return prvt_uniforms_shadow;
+    }
+
+
+    /** \brief Uploads the uniforms values that have been modified since last flush.
+    *
+    * To be called right before drawing or dispatching with this
+    * program.  Uploads are done with the DSA glProgramUniform*()
+    * calls: this program does not need to be in use.
+    */
+    inline void flush_uniforms() {
+        if (prvt_uniforms_shadow.is_dirty())
+            prvt_uniforms_shadow.flush(name);
+    }
+
+
     /** Class method. Tests for the Program-ness of a name.
     *
     * \param name : the OpenGL identifier of an object to test
@@ -246,6 +342,142 @@ public:
     bool link();
 
 
+    /** Links all shaders that are attached to this program, with programs binaries cache.
+    *
+    * Looks first for the binary of this program in 'cache'. On
+    * cache hit, the binary is loaded and compiling and linking
+    * are both skipped.  On cache miss, or when the driver rejects
+    * the cached binary, attached shaders are compiled when needed
+    * and linked, and the resulting binary is stored in cache.
+    *
+    * \param cache : a reference to the programs binaries cache
+    *       to be used.
+    * \param verbose : set this to true to get compilation error
+    *       logs printed on error console, or set it to false to
+    *       get muted compilation. Defaults to false.
+    *
+    * \return true if linking succesfully completed, or false
+    *       else.
+    */
+    bool link(ProgramBinaryCache& cache, const bool verbose = false);
+
+
+    /** \brief Submits compilation and linking of all attached shaders without waiting for their completion.
+    *
+    * Every attached shader that has not yet been compiled  gets
+    * its compilation submitted,  then  the  linking  of  this
+    * program is submitted also.  No status is queried,  so that
+    * drivers that support KHR_parallel_shader_compile can process
+    * all of them on their own threads.  Many programs should be
+    * submitted this way before polling any of them.
+    *
+    * Call 'ready()' afterwards to poll for completion.  Method
+    * 'use()' is a no-op until this program is ready and linked.
+    *
+    * \sa ready, set_max_compiler_threads.
+    */
+    void link_async();
+
+
+    /** \brief Returns true if this program is linked and ready to be used.
+    *
+    * Never blocks when the driver supports parallel  shaders
+    * compilation.  While a submitted linking is still pending,
+    * returns false.  Once completed,  the link status of this
+    * program and the compilation status of its shaders are
+    * evaluated, and 'linked' gets updated accordingly.
+    * Renderers should skip draws with programs that are not
+    * ready yet.
+    *
+    * \return true if this program is linked, or false if its
+    *       linking is still pending or has failed.
+    *
+    * \sa is_link_pending, link_async.
+    */
+    bool ready();
+
+
+    /** \brief Returns true if a linking has been submitted and is not yet completed.
+    */
+    inline const bool is_link_pending() const {
+        return prvt_link_pending;
+    }
+
+
+    /** Class method. Sets the count of threads the driver may use for compiling and linking.
+    *
+    * \param threads_count : the maximum count of threads to be
+    *       used by the driver for parallel compiling and linking.
+    *       0 disables parallel compilation, while 0xFFFFFFFF lets
+    *       the driver choose.
+    *
+    * \return true if the driver supports parallel shaders
+    *       compilation, or false else.
+    */
+    static bool set_max_compiler_threads(const GLuint threads_count);
+
+
+    /** \brief Links the attached shaders into a new program object, leaving this one untouched.
+    *
+    * The attached shaders are compiled when needed,  then they
+    * are attached to a newly created OpenGL program which gets
+    * linked.  This program keeps on running with its  current
+    * executable in the meantime.
+    *
+    * \param verbose : set this to true to get compilation and
+    *       linking error logs printed on error console, or set
+    *       it to false to get muted operations. Defaults to false.
+    *
+    * \return the OpenGL identifier of the newly linked program,
+    *       or 0 if compiling or linking failed, in which case no
+    *       new program object remains.
+    *
+    * \sa replace, relink.
+    */
+    GLuint link_replacement(const bool verbose = false);
+
+
+    /** \brief Compiles and links again the attached shaders, replacing this program only on success.
+    *
+    * \param verbose : set this to true to get compilation and
+    *       linking error logs printed on error console. Defaults
+    *       to false.
+    *
+    * \return true if the new program has been successfully
+    *       linked and has replaced the previous one, or false
+    *       if the previous program has been kept.
+    *
+    * \sa link_replacement, replace.
+    */
+    bool relink(const bool verbose = false) {
+        const GLuint new_name = link_replacement(verbose);
+        if (new_name != 0)
+            replace(new_name);
+        return new_name != 0;
+    }
+
+
+    /** \brief Replaces the OpenGL program object of this shaders program.
+    *
+    * The previous OpenGL program object gets deleted.
+    *
+    * \param new_name : the OpenGL identifier of the successfully
+    *       linked program that replaces this one.
+    *
+    * \sa link_replacement.
+    */
+    void replace(const GLuint new_name);
+
+
+    /** \brief Sets the label of this program.
+    *
+    * The label names the GPU profiling zones of the draws and of the
+    * dispatches done with this program. It is also attached to the
+    * OpenGL object, for debuggers, when KHR_debug is available.
+    */
+    void set_label(const string& label);
+
+
     /** \brief Prepares the further deletion of this program within the OpenGL context.
     *
     * Notice: this is not  the  same  action  as  deleting  this
@@ -264,14 +496,29 @@ public:
     * No  error  will  be returned if any of the mandatory steps
     * before using thisprogram will have failed.  Meanwhile,  no
     * operation will take place in such a failure situation.
+    *
+    * The program is used through the state cache of the current
+    * context: glUseProgram() is not issued if this program is
+    * already in use.  Since OpenGL drops subroutines selections
+    * on each program change, the recorded selections of this
+    * program are uploaded again when glUseProgram() is issued.
+    * Otherwise, only modified selections are uploaded.
     */
     void use() {
         if (linked)
-            glUseProgram(name);
+            prvt_subroutines.apply(GLStateCache::get_current().use_program(name));
     }
 
 
 private:
     ShadersList prvt_attached_shaders;  // the list of shaders that are currently attached to this program.
+    bool        prvt_link_pending;      // true once linking has been submitted and until its status has been queried.
+    SubroutinesState prvt_subroutines;  // the subroutines state of all the stages of this program.
+    ProgramReflection prvt_reflection;  // the reflected interfaces of this program.
+    UniformsShadow prvt_uniforms_shadow; // the shadow copy of the default block uniforms of this program.
+    unsigned    prvt_link_count;        // the count of successful linkings of this program.
+    string      prvt_label;             // the label of this program.
+
+    void prvt_on_linked();
 
 };
\ No newline at end of file
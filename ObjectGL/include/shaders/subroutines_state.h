@@ -0,0 +1,190 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "GL/glew.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of the subroutines state of one stage of a shaders program.
+*
+* Reflects once, at link time, all the active subroutine uniforms of
+* a  stage  and their compatible functions into flat index tables.
+* Selections are then recorded by index, with no OpenGL query,  and
+* are uploaded with exactly one glUniformSubroutinesuiv() call per
+* dirty stage.
+*
+* Notice: OpenGL drops the subroutines state of all stages on each
+*   call to glUseProgram(). Recorded selections are then applied
+*   again by ShadersProgram::use().
+*/
+class SubroutinesStageState {
+public:
+
+    /** \brief Constructor.
+    *
+    * \param shader_type : the type of the shader of this stage.
+    */
+    SubroutinesStageState(const GLenum shader_type = GL_VERTEX_SHADER);
+
+
+    /** \brief Uploads the selected functions of this stage.
+    *
+    * \param force : set this to true to upload the selections
+    *       even if they have not been modified since last upload.
+    *       Defaults to false.
+    */
+    void apply(const bool force = false);
+
+
+    /** \brief Returns the index of a subroutine function of this stage.
+    *
+    * \return the index of the function, or GL_INVALID_INDEX if
+    *       no such active function exists in this stage.
+    */
+    GLuint get_function_index(const char* function_name) const;
+
+
+    /** \brief Returns the location of a subroutine uniform of this stage.
+    *
+    * \return the location of the subroutine uniform, or -1 if no
+    *       such active uniform exists in this stage.
+    */
+    GLint get_uniform_location(const char* uniform_name) const;
+
+
+    /** \brief Returns the count of subroutine uniform locations of this stage.
+    */
+    inline const GLsizei get_locations_count() const {
+        return GLsizei(prvt_selected.size());
+    }
+
+
+    /** \brief Returns the type of the shader of this stage.
+    */
+    inline const GLenum get_shader_type() const {
+        return prvt_shader_type;
+    }
+
+
+    /** \brief Returns true if some selection has been modified since last upload.
+    */
+    inline const bool is_dirty() const {
+        return prvt_dirty;
+    }
+
+
+    /** \brief Reflects the subroutine uniforms and functions of this stage.
+    *
+    * \param program_name : the OpenGL identifier of the linked
+    *       program.
+    */
+    void reflect(const GLuint program_name);
+
+
+    /** \brief Records the selection of a function for a subroutine uniform.
+    *
+    * \param location : the location of the subroutine uniform.
+    * \param function_index : the index of the selected function.
+    *
+    * \return true if the function is compatible with the uniform,
+    *       or false else, in which case nothing is recorded.
+    */
+    bool select(const GLint location, const GLuint function_index);
+
+
+private:
+    struct UniformEntry {
+        GLint   location;           // the first location of this uniform.
+        GLint   size;               // the count of locations of this uniform (arrays).
+        GLuint  compatibles_start;  // the start of the compatible functions in 'prvt_compatibles'.
+        GLuint  compatibles_count;  // the count of compatible functions.
+    };
+
+    GLenum                  prvt_shader_type;       // the type of the shader of this stage.
+    vector<UniformEntry>    prvt_uniforms;          // the active subroutine uniforms.
+    vector<string>          prvt_uniform_names;     // the names of the active subroutine uniforms, same order.
+    vector<GLuint>          prvt_compatibles;       // the flat table of compatible functions indices.
+    vector<string>          prvt_function_names;    // the names of the active functions, indexed by function index.
+    vector<GLint>           prvt_location_uniforms; // the entry in 'prvt_uniforms' of each location.
+    vector<GLuint>          prvt_selected;          // the selected function index of each location.
+    bool                    prvt_dirty;             // true when selections have been modified since last upload.
+};
+
+
+//===========================================================================
+/** \brief The class of the subroutines state of all the stages of a shaders program.
+*
+* Only stages that contain active subroutine uniforms are recorded.
+*/
+class SubroutinesState {
+public:
+
+    /** \brief Uploads the selected functions of all the stages.
+    *
+    * \param force : set this to true to upload the selections of
+    *       all stages, or false to upload the dirty stages only.
+    *       Defaults to false.
+    */
+    void apply(const bool force = false) {
+        for (SubroutinesStageState& stage : prvt_stages)
+            stage.apply(force);
+    }
+
+
+    /** \brief Returns the subroutines state of one stage.
+    *
+    * \return a pointer to the state of the stage, or NULL if this
+    *       stage contains no active subroutine uniform.
+    */
+    SubroutinesStageState* get_stage(const GLenum shader_type) {
+        for (SubroutinesStageState& stage : prvt_stages)
+            if (stage.get_shader_type() == shader_type)
+                return &stage;
+        return NULL;
+    }
+
+
+    /** \brief Returns true if no stage contains any active subroutine uniform.
+    */
+    inline const bool is_empty() const {
+        return prvt_stages.empty();
+    }
+
+
+    /** \brief Reflects the subroutines of all the stages of a linked program.
+    */
+    void reflect(const GLuint program_name);
+
+
+private:
+    vector<SubroutinesStageState> prvt_stages;  // the stages that contain active subroutine uniforms.
+};
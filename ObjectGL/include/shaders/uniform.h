@@ -0,0 +1,248 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include "GL/glew.h"
+#include "Eigen/Core"
+
+#include "shaders_program.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief Returns true if a GLSL type is an opaque type (i.e. sampler, image or atomic counter).
+*/
+inline const bool is_opaque_uniform_type(const GLenum type) {
+    return (type >= GL_SAMPLER_1D && type <= GL_SAMPLER_2D_RECT_SHADOW) ||
+           (type >= GL_SAMPLER_1D_ARRAY && type <= GL_UNSIGNED_INT_SAMPLER_BUFFER && (type < GL_UNSIGNED_INT_VEC2 || type > GL_UNSIGNED_INT_VEC4)) ||
+           (type >= GL_SAMPLER_CUBE_MAP_ARRAY && type <= GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY) ||
+           (type >= GL_SAMPLER_2D_MULTISAMPLE && type <= GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY) ||
+           (type >= GL_IMAGE_1D && type <= GL_UNSIGNED_INT_IMAGE_2D_MULTISAMPLE_ARRAY) ||
+           type == GL_UNSIGNED_INT_ATOMIC_COUNTER;
+}
+
+
+//===========================================================================
+/** \brief The traits of the C++ types that can be uploaded into uniforms.
+*
+* Each specialization provides:
+*   - 'accepts(type)', which returns true if values of the C++ type
+*     can be uploaded into uniforms of the GLSL 'type';
+*   - 'upload(program, location, count, values)',  which  uploads
+*     'count'  contiguous  values  with  the  related  DSA  call
+*     glProgramUniform*(), so that the program does not need to be
+*     in use.
+*
+* Eigen vectors and matrices are supported. Eigen matrices being
+* column-major by default, they are uploaded with no transposition.
+*/
+template<typename T>
+struct UniformTraits;
+
+
+#define OBJECTGL_UNIFORM_TRAITS(T, CHECK, UPLOAD)                                                   \
+    template<>                                                                                      \
+    struct UniformTraits<T> {                                                                       \
+        static inline const bool accepts(const GLenum type) {                                       \
+            return CHECK;                                                                           \
+        }                                                                                           \
+        static inline void upload(const GLuint program, const GLint location, const GLsizei count, const T* values) { \
+            UPLOAD;                                                                                 \
+        }                                                                                           \
+    };
+
+OBJECTGL_UNIFORM_TRAITS(GLfloat,          type == GL_FLOAT,       glProgramUniform1fv(program, location, count, values))
+OBJECTGL_UNIFORM_TRAITS(GLdouble,         type == GL_DOUBLE,      glProgramUniform1dv(program, location, count, values))
+OBJECTGL_UNIFORM_TRAITS(GLint,            type == GL_INT || type == GL_BOOL || is_opaque_uniform_type(type),
+                                                                  glProgramUniform1iv(program, location, count, values))
+OBJECTGL_UNIFORM_TRAITS(GLuint,           type == GL_UNSIGNED_INT || type == GL_BOOL,
+                                                                  glProgramUniform1uiv(program, location, count, values))
+
+OBJECTGL_UNIFORM_TRAITS(Eigen::Vector2f,  type == GL_FLOAT_VEC2,  glProgramUniform2fv(program, location, count, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Vector3f,  type == GL_FLOAT_VEC3,  glProgramUniform3fv(program, location, count, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Vector4f,  type == GL_FLOAT_VEC4,  glProgramUniform4fv(program, location, count, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Vector2d,  type == GL_DOUBLE_VEC2, glProgramUniform2dv(program, location, count, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Vector3d,  type == GL_DOUBLE_VEC3, glProgramUniform3dv(program, location, count, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Vector4d,  type == GL_DOUBLE_VEC4, glProgramUniform4dv(program, location, count, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Vector2i,  type == GL_INT_VEC2 || type == GL_BOOL_VEC2,
+                                                                  glProgramUniform2iv(program, location, count, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Vector3i,  type == GL_INT_VEC3 || type == GL_BOOL_VEC3,
+                                                                  glProgramUniform3iv(program, location, count, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Vector4i,  type == GL_INT_VEC4 || type == GL_BOOL_VEC4,
+                                                                  glProgramUniform4iv(program, location, count, values->data()))
+
+OBJECTGL_UNIFORM_TRAITS(Eigen::Matrix2f,  type == GL_FLOAT_MAT2,  glProgramUniformMatrix2fv(program, location, count, GL_FALSE, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Matrix3f,  type == GL_FLOAT_MAT3,  glProgramUniformMatrix3fv(program, location, count, GL_FALSE, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Matrix4f,  type == GL_FLOAT_MAT4,  glProgramUniformMatrix4fv(program, location, count, GL_FALSE, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Matrix2d,  type == GL_DOUBLE_MAT2, glProgramUniformMatrix2dv(program, location, count, GL_FALSE, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Matrix3d,  type == GL_DOUBLE_MAT3, glProgramUniformMatrix3dv(program, location, count, GL_FALSE, values->data()))
+OBJECTGL_UNIFORM_TRAITS(Eigen::Matrix4d,  type == GL_DOUBLE_MAT4, glProgramUniformMatrix4dv(program, location, count, GL_FALSE, values->data()))
+
+#undef OBJECTGL_UNIFORM_TRAITS
+
+
+//===========================================================================
+/** \brief The class of typed handles on shaders programs uniforms.
+*
+* The location of the uniform is resolved once, from the reflected
+* interface  of  the  program,  and  the  GLSL  type  of the uniform
+* is checked against the C++ type T at that time.  Setting values
+* involves then no string at all.
+*
+* Values are set into the uniforms shadow of the program: values
+* that are already resident are skipped,  while modified ones get
+* uploaded at next call to 'ShadersProgram::flush_uniforms()'.
+* Use 'set_immediate()' to upload right away.
+*
+* Locations are resolved again only when the program gets linked
+* again, e.g. when it is hot reloaded.
+*
+* \sa UniformTraits for the supported C++ types.
+*/
+template<typename T>
+class Uniform {
+public:
+
+    /** \brief Constructor with 'const char*' signature.
+    *
+    * \param program : a reference to the linked shaders program
+    *       this uniform belongs to.  It must live longer than
+    *       this handle.
+    * \param uniform_name : the name of the uniform.
+    */
+    Uniform(ShadersProgram& program, const char* uniform_name)
+        : prvt_program(program), prvt_name(uniform_name), prvt_location(-1), prvt_slot(-1), prvt_link_count(0)
+    {
+        prvt_resolve();
+    }
+
+
+    /** \brief Constructor with 'const string&' signature.
+    */
+    Uniform(ShadersProgram& program, const string& uniform_name)
+        : Uniform(program, uniform_name.c_str())
+    {}
+
+
+    /** \brief Destructor.
+    */
+    ~Uniform()
+    {}
+
+
+    /** \brief Returns the location of this uniform, or -1 if it is not active or if its type does not match.
+    */
+    inline const GLint get_location() {
+        if (prvt_link_count != prvt_program.get_link_count())
+            prvt_resolve();
+        return prvt_location;
+    }
+
+
+    /** \brief Returns the ok status of this uniform handle.
+    */
+    inline const bool is_ok() {
+        return get_location() >= 0;
+    }
+
+
+    /** \brief Sets the value of this uniform.
+    */
+    inline void set(const T& value) {
+        set(&value, 1);
+    }
+
+
+    /** \brief Sets the values of many contiguous elements of this array uniform.
+    *
+    * Modified values are uploaded at next flush of the uniforms
+    * of the program.
+    *
+    * \param values : a pointer to the first value to be set.
+    * \param count : the count of contiguous elements to be set.
+    * \param first_element : the index of the first element to be
+    *       set. Defaults to 0.
+    */
+    inline void set(const T* values, const GLsizei count, const GLint first_element = 0) {
+        if (get_location() >= 0)
+            prvt_program.get_uniforms_shadow().set(prvt_slot, first_element, count, values);
+    }
+
+
+    /** \brief Sets the value of this uniform and uploads it right away if modified.
+    */
+    inline void set_immediate(const T& value) {
+        set_immediate(&value, 1);
+    }
+
+
+    /** \brief Sets the values of many contiguous elements of this array uniform and uploads them right away if modified.
+    */
+    inline void set_immediate(const T* values, const GLsizei count, const GLint first_element = 0) {
+        const GLint location = get_location();
+        if (location >= 0 && prvt_program.get_uniforms_shadow().set(prvt_slot, first_element, count, values, false))
+            UniformTraits<T>::upload(prvt_program.name, location + first_element, count, values);
+    }
+
+
+    /** \brief Assignment operator. Sets the value of this uniform.
+    */
+    inline Uniform& operator= (const T& value) {
+        set(value);
+        return *this;
+    }
+
+
+private:
+    ShadersProgram& prvt_program;       // the program this uniform belongs to.
+    string          prvt_name;          // the name of this uniform, used at resolution time only.
+    GLint           prvt_location;      // the resolved location of this uniform.
+    GLint           prvt_slot;          // the slot of this uniform in the uniforms shadow of the program.
+    unsigned        prvt_link_count;    // the link count of the program at resolution time.
+
+    void prvt_resolve() {
+        prvt_link_count = prvt_program.get_link_count();
+        prvt_location = -1;
+        prvt_slot = -1;
+
+        const ProgramReflection& reflection = prvt_program.get_reflection();
+        const ProgramReflection::Resource* resource = reflection.find(ProgramReflection::UNIFORMS, prvt_name.c_str());
+        if (resource != NULL && resource->location >= 0) {
+            UniformsShadow& shadow = prvt_program.get_uniforms_shadow();
+            const GLint slot = shadow.find(reflection, prvt_name.c_str());
+            if (slot >= 0 && UniformTraits<T>::accepts(resource->type) && shadow.get_element_size(slot) == sizeof(T)) {
+                prvt_location = resource->location;
+                prvt_slot = slot;
+            }
+            else
+                cerr << "!!! type mismatch for uniform '" << prvt_name << "'" << endl;
+        }
+    }
+};
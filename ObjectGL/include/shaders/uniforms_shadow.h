@@ -0,0 +1,180 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "program_reflection.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of CPU-side shadow copies of the default block uniforms of programs.
+*
+* Built from the reflected interface of a program each time it gets
+* linked,  it keeps a copy of the last value set for each element of
+* each uniform.  Setting a value that equals the shadow copy is  then
+* skipped.  Modified elements are marked as dirty and are uploaded
+* lazily,  right  before  drawing,  by 'flush()', with the DSA calls
+* glProgramUniform*() so that the program does not need to be in use.
+* Consecutive dirty elements of array uniforms are coalesced into
+* one single upload.
+*
+* Values of elements that have never been set are unknown: setting
+* them is never skipped.
+*/
+class UniformsShadow {
+public:
+
+    /** \brief The statistics of use of a uniforms shadow.
+    */
+    struct Stats {
+        size_t skipped;     //!< the count of set elements whose value was already resident.
+        size_t modified;    //!< the count of set elements whose value has changed.
+        size_t uploads;     //!< the count of glProgramUniform*() calls.
+    };
+
+
+    /** \brief Empty constructor.
+    */
+    UniformsShadow();
+
+
+    /** \brief Builds the shadow copy from the reflected interface of a linked program.
+    *
+    * All values are unknown after building.
+    */
+    void build(const ProgramReflection& reflection);
+
+
+    /** \brief Returns the index of the slot of a default block uniform, or -1 if not found.
+    *
+    * Meant for setup time only: slots should be kept for later use.
+    *
+    * \param reflection : the reflection this shadow has been built from.
+    * \param uniform_name : the name of the uniform.
+    */
+    GLint find(const ProgramReflection& reflection, const char* uniform_name) const;
+
+
+    /** \brief Uploads all dirty elements.
+    *
+    * \param program_name : the OpenGL identifier of the program.
+    */
+    void flush(const GLuint program_name);
+
+
+    /** \brief Returns the count of slots, i.e. of default block uniforms.
+    */
+    inline const GLint get_slots_count() const {
+        return GLint(prvt_slots.size());
+    }
+
+
+    /** \brief Returns the size in bytes of one element of the uniform of a slot.
+    */
+    inline const GLuint get_element_size(const GLint slot) const {
+        return prvt_slots[slot].element_size;
+    }
+
+
+    /** \brief Returns the statistics of use of this shadow.
+    */
+    inline const Stats& get_stats() const {
+        return prvt_stats;
+    }
+
+
+    /** \brief Returns the GLSL type of the uniform of a slot.
+    */
+    inline const GLenum get_type(const GLint slot) const {
+        return prvt_slots[slot].type;
+    }
+
+
+    /** \brief Returns true if some elements have still to be uploaded.
+    */
+    inline const bool is_dirty() const {
+        return !prvt_dirty_slots.empty();
+    }
+
+
+    /** \brief Resets the statistics of use of this shadow.
+    */
+    inline void reset_stats() {
+        prvt_stats = Stats{ 0, 0, 0 };
+    }
+
+
+    /** \brief Sets the values of contiguous elements of a uniform.
+    *
+    * \param slot : the slot of the uniform, as returned by 'find()'.
+    * \param first_element : the index of the first element to set.
+    * \param count : the count of elements to set. Elements past the
+    *       end of the uniform are ignored.
+    * \param values : a pointer to the contiguous values to be set,
+    *       whose layout is the one of the elements of the uniform.
+    * \param deferred : set this to true to mark modified elements
+    *       as dirty,  or  to  false if the caller uploads them by
+    *       itself right after this call. Defaults to true.
+    *
+    * \return true if at least one element has been modified, or
+    *       false if all values were already resident.
+    */
+    bool set(const GLint slot, const GLint first_element, const GLsizei count, const void* values, const bool deferred = true);
+
+
+    /** Class method. Returns the size in bytes of one element of a GLSL type, or 0 if not supported.
+    */
+    static GLuint get_type_size(const GLenum type);
+
+
+private:
+    enum ElementState : uint8_t { UNKNOWN = 0, CLEAN, DIRTY };
+
+    struct Slot {
+        GLint   location;       // the location of the first element of the uniform.
+        GLenum  type;           // the GLSL type of the uniform.
+        GLint   array_size;     // the count of elements of the uniform.
+        GLuint  element_size;   // the size in bytes of one element.
+        GLuint  data_offset;    // the offset of the first element in the values buffer.
+        GLuint  state_offset;   // the index of the state of the first element in the states buffer.
+        bool    listed;         // true when this slot is in the list of dirty slots.
+    };
+
+    vector<Slot>            prvt_slots;         // one slot per default block uniform.
+    vector<GLint>           prvt_resource_slots; // the slot of each reflected uniform, -1 for uniforms in named blocks.
+    vector<unsigned char>   prvt_values;        // the shadow values of all elements of all slots.
+    vector<ElementState>    prvt_states;        // the state of each element of each slot.
+    vector<GLint>           prvt_dirty_slots;   // the slots that contain dirty elements.
+    Stats                   prvt_stats;
+
+    static void prvt_upload(const GLuint program_name, const GLenum type, const GLint location, const GLsizei count, const void* values);
+};
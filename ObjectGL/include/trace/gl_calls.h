@@ -0,0 +1,281 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+/* The tables of the OpenGL calls issued by ObjectGL.
+*
+* They are the dispatch table of ObjectGL: GLTrace swaps the calls of
+* the traced tables for recording wrappers, and GLBackend swaps all of
+* them for the ones of its mock and validating backends.
+*
+* Each traced table is an X-macro: it expands its argument macro once per
+* call, with the name of the call without its 'gl' prefix and a string
+* giving the kind of each argument of the call:
+*   'v' : a value, replayed as is;
+*   'o' : a pointer used as an offset into a bound buffer;
+*   'B' : a buffer name;
+*   'T' : a texture name;
+*   'P' : a program name;
+*   'S' : a shader name;
+*   'A' : a vertex array name;
+*   'M' : a sampler name;
+*   'Q' : a query name;
+*   'Y' : a sync object.
+* Names are remapped at replay time onto the objects created by the
+* replayer.
+*
+* Calls whose arguments point to client memory (sources, data, arrays)
+* or that create objects are not in these tables: they are traced by
+* dedicated code, see OBJECTGL_GL_TRACED_CUSTOM_CALLS and
+* OBJECTGL_GL_TRACED_CORE_CUSTOM_CALLS.
+*/
+
+
+//---------------------------------------------------------------------------
+/** \brief The calls with values only, loaded by GLEW. */
+#define OBJECTGL_GL_TRACED_GLEW_CALLS(CALL)                                 \
+    CALL(AttachShader,                                  "PS")               \
+    CALL(BindBuffer,                                    "vB")               \
+    CALL(BindBufferBase,                                "vvB")              \
+    CALL(BindBufferRange,                               "vvBvv")            \
+    CALL(BindImageTexture,                              "vTvvvvv")          \
+    CALL(BindSampler,                                   "vM")               \
+    CALL(BindTextureUnit,                               "vT")               \
+    CALL(BindVertexArray,                               "A")                \
+    CALL(BindVertexBuffer,                              "vBvv")             \
+    CALL(BlendEquationSeparate,                         "vv")               \
+    CALL(BlendFuncSeparate,                             "vvvv")             \
+    CALL(ClientWaitSync,                                "Yvv")              \
+    CALL(CompileShader,                                 "S")                \
+    CALL(CopyBufferSubData,                             "vvvvv")            \
+    CALL(CopyNamedBufferSubData,                        "BBvvv")            \
+    CALL(DetachShader,                                  "PS")               \
+    CALL(DispatchCompute,                               "vvv")              \
+    CALL(DispatchComputeIndirect,                       "v")                \
+    CALL(DrawArraysIndirect,                            "vo")               \
+    CALL(DrawArraysInstancedBaseInstance,               "vvvvv")            \
+    CALL(DrawElementsIndirect,                          "vvo")              \
+    CALL(DrawElementsInstancedBaseVertexBaseInstance,   "vvvovvv")          \
+    CALL(EnableVertexArrayAttrib,                       "Av")               \
+    CALL(EnableVertexAttribArray,                       "v")                \
+    CALL(LinkProgram,                                   "P")                \
+    CALL(MaxShaderCompilerThreadsARB,                   "v")                \
+    CALL(MaxShaderCompilerThreadsKHR,                   "v")                \
+    CALL(MemoryBarrier,                                 "v")                \
+    CALL(MultiDrawArraysIndirect,                       "vovv")             \
+    CALL(MultiDrawElementsIndirect,                     "vvovv")            \
+    CALL(MultiDrawElementsIndirectCount,                "vvovvv")           \
+    CALL(MultiDrawElementsIndirectCountARB,             "vvovvv")           \
+    CALL(ProgramParameteri,                             "Pvv")              \
+    CALL(QueryCounter,                                  "Qv")               \
+    CALL(SamplerParameteri,                             "Mvv")              \
+    CALL(TextureStorage2D,                              "Tvvvv")            \
+    CALL(UseProgram,                                    "P")                \
+    CALL(VertexArrayAttribBinding,                      "Avv")              \
+    CALL(VertexArrayAttribFormat,                       "Avvvvv")           \
+    CALL(VertexArrayAttribIFormat,                      "Avvvv")            \
+    CALL(VertexArrayAttribLFormat,                      "Avvvv")            \
+    CALL(VertexArrayBindingDivisor,                     "Avv")              \
+    CALL(VertexArrayElementBuffer,                      "AB")               \
+    CALL(VertexArrayVertexBuffer,                       "AvBvv")            \
+    CALL(VertexAttribBinding,                           "vv")               \
+    CALL(VertexAttribFormat,                            "vvvvv")            \
+    CALL(VertexAttribIFormat,                           "vvvv")             \
+    CALL(VertexAttribLFormat,                           "vvvv")             \
+    CALL(VertexBindingDivisor,                          "vv")
+
+
+//---------------------------------------------------------------------------
+/** \brief The calls with values only, exported by the OpenGL 1.1 library itself (see trace/gl_dispatch.h). */
+#define OBJECTGL_GL_TRACED_CORE_CALLS(CALL)                                 \
+    CALL(ColorMask,                                     "vvvv")             \
+    CALL(CullFace,                                      "v")                \
+    CALL(DepthFunc,                                     "v")                \
+    CALL(DepthMask,                                     "v")                \
+    CALL(Disable,                                       "v")                \
+    CALL(Enable,                                        "v")                \
+    CALL(Flush,                                         "")                 \
+    CALL(FrontFace,                                     "v")                \
+    CALL(PolygonMode,                                   "vv")               \
+    CALL(PolygonOffset,                                 "vv")               \
+    CALL(Scissor,                                       "vvvv")             \
+    CALL(StencilFunc,                                   "vvv")              \
+    CALL(StencilMask,                                   "v")                \
+    CALL(StencilOp,                                     "vvv")              \
+    CALL(Viewport,                                      "vvvv")
+
+
+//---------------------------------------------------------------------------
+/** \brief The typed uniform arrays calls: name, element type, count of elements per uniform. */
+#define OBJECTGL_GL_TRACED_UNIFORM_CALLS(CALL)                              \
+    CALL(ProgramUniform1dv,         GLdouble,   1)                          \
+    CALL(ProgramUniform1fv,         GLfloat,    1)                          \
+    CALL(ProgramUniform1iv,         GLint,      1)                          \
+    CALL(ProgramUniform1uiv,        GLuint,     1)                          \
+    CALL(ProgramUniform2dv,         GLdouble,   2)                          \
+    CALL(ProgramUniform2fv,         GLfloat,    2)                          \
+    CALL(ProgramUniform2iv,         GLint,      2)                          \
+    CALL(ProgramUniform2uiv,        GLuint,     2)                          \
+    CALL(ProgramUniform3dv,         GLdouble,   3)                          \
+    CALL(ProgramUniform3fv,         GLfloat,    3)                          \
+    CALL(ProgramUniform3iv,         GLint,      3)                          \
+    CALL(ProgramUniform3uiv,        GLuint,     3)                          \
+    CALL(ProgramUniform4dv,         GLdouble,   4)                          \
+    CALL(ProgramUniform4fv,         GLfloat,    4)                          \
+    CALL(ProgramUniform4iv,         GLint,      4)                          \
+    CALL(ProgramUniform4uiv,        GLuint,     4)
+
+
+/** \brief The typed uniform matrices calls: name, element type, count of elements per matrix. */
+#define OBJECTGL_GL_TRACED_UNIFORM_MATRIX_CALLS(CALL)                       \
+    CALL(ProgramUniformMatrix2dv,   GLdouble,   4)                          \
+    CALL(ProgramUniformMatrix2fv,   GLfloat,    4)                          \
+    CALL(ProgramUniformMatrix2x3dv, GLdouble,   6)                          \
+    CALL(ProgramUniformMatrix2x3fv, GLfloat,    6)                          \
+    CALL(ProgramUniformMatrix2x4dv, GLdouble,   8)                          \
+    CALL(ProgramUniformMatrix2x4fv, GLfloat,    8)                          \
+    CALL(ProgramUniformMatrix3dv,   GLdouble,   9)                          \
+    CALL(ProgramUniformMatrix3fv,   GLfloat,    9)                          \
+    CALL(ProgramUniformMatrix3x2dv, GLdouble,   6)                          \
+    CALL(ProgramUniformMatrix3x2fv, GLfloat,    6)                          \
+    CALL(ProgramUniformMatrix3x4dv, GLdouble,   12)                         \
+    CALL(ProgramUniformMatrix3x4fv, GLfloat,    12)                         \
+    CALL(ProgramUniformMatrix4dv,   GLdouble,   16)                         \
+    CALL(ProgramUniformMatrix4fv,   GLfloat,    16)                         \
+    CALL(ProgramUniformMatrix4x2dv, GLdouble,   8)                          \
+    CALL(ProgramUniformMatrix4x2fv, GLfloat,    8)                          \
+    CALL(ProgramUniformMatrix4x3dv, GLdouble,   12)                         \
+    CALL(ProgramUniformMatrix4x3fv, GLfloat,    12)
+
+
+//---------------------------------------------------------------------------
+/** \brief The calls traced by dedicated code. */
+#define OBJECTGL_GL_TRACED_CUSTOM_CALLS(CALL)                               \
+    CALL(BindBuffersRange)                                                  \
+    CALL(BindSamplers)                                                      \
+    CALL(BindTextures)                                                      \
+    CALL(BindVertexBuffers)                                                 \
+    CALL(BufferStorage)                                                     \
+    CALL(BufferSubData)                                                     \
+    CALL(CreateBuffers)                                                     \
+    CALL(CreateProgram)                                                     \
+    CALL(CreateSamplers)                                                    \
+    CALL(CreateShader)                                                      \
+    CALL(CreateTextures)                                                    \
+    CALL(CreateVertexArrays)                                                \
+    CALL(DeleteBuffers)                                                     \
+    CALL(DeleteProgram)                                                     \
+    CALL(DeleteQueries)                                                     \
+    CALL(DeleteSamplers)                                                    \
+    CALL(DeleteShader)                                                      \
+    CALL(DeleteSync)                                                        \
+    CALL(DeleteVertexArrays)                                                \
+    CALL(FenceSync)                                                         \
+    CALL(FlushMappedBufferRange)                                            \
+    CALL(FlushMappedNamedBufferRange)                                       \
+    CALL(GenBuffers)                                                        \
+    CALL(GenQueries)                                                        \
+    CALL(GenVertexArrays)                                                   \
+    CALL(MapBufferRange)                                                    \
+    CALL(MapNamedBufferRange)                                               \
+    CALL(NamedBufferStorage)                                                \
+    CALL(NamedBufferSubData)                                                \
+    CALL(ProgramBinary)                                                     \
+    CALL(ShaderBinary)                                                      \
+    CALL(ShaderSource)                                                      \
+    CALL(SpecializeShader)                                                  \
+    CALL(SpecializeShaderARB)                                               \
+    CALL(UniformSubroutinesuiv)                                             \
+    CALL(UnmapBuffer)                                                       \
+    CALL(UnmapNamedBuffer)                                                  \
+    CALL(VertexArrayVertexBuffers)
+
+
+/** \brief The calls traced by dedicated code, exported by the OpenGL 1.1 library itself. */
+#define OBJECTGL_GL_TRACED_CORE_CUSTOM_CALLS(CALL)                          \
+    CALL(DeleteTextures)
+
+
+//---------------------------------------------------------------------------
+/** \brief The calls that are not traced (queries, debug annotations), loaded by GLEW. */
+#define OBJECTGL_GL_UNTRACED_GLEW_CALLS(CALL)                               \
+    CALL(GetActiveSubroutineName)                                           \
+    CALL(GetActiveSubroutineUniformName)                                    \
+    CALL(GetActiveSubroutineUniformiv)                                      \
+    CALL(GetBufferSubData)                                                  \
+    CALL(GetIntegeri_v)                                                     \
+    CALL(GetNamedBufferSubData)                                             \
+    CALL(GetProgramBinary)                                                  \
+    CALL(GetProgramInfoLog)                                                 \
+    CALL(GetProgramInterfaceiv)                                             \
+    CALL(GetProgramResourceName)                                            \
+    CALL(GetProgramResourceiv)                                              \
+    CALL(GetProgramStageiv)                                                 \
+    CALL(GetProgramiv)                                                      \
+    CALL(GetQueryObjectiv)                                                  \
+    CALL(GetQueryObjectui64v)                                               \
+    CALL(GetShaderInfoLog)                                                  \
+    CALL(GetShaderiv)                                                       \
+    CALL(GetStringi)                                                        \
+    CALL(GetSubroutineUniformLocation)                                      \
+    CALL(IsBuffer)                                                          \
+    CALL(IsProgram)                                                         \
+    CALL(IsShader)                                                          \
+    CALL(IsVertexArray)                                                     \
+    CALL(ObjectLabel)                                                       \
+    CALL(PopDebugGroup)                                                     \
+    CALL(PushDebugGroup)
+
+
+/** \brief The calls that are not traced, exported by the OpenGL 1.1 library itself. */
+#define OBJECTGL_GL_UNTRACED_CORE_CALLS(CALL)                               \
+    CALL(GetIntegerv)                                                       \
+    CALL(GetString)                                                         \
+    CALL(ReadPixels)
+
+
+//---------------------------------------------------------------------------
+/** \brief The OpenGL versions checked by ObjectGL through their GLEW flags: major and minor numbers. */
+#define OBJECTGL_GL_CHECKED_VERSIONS(VERSION)                               \
+    VERSION(1, 1)   VERSION(1, 2)   VERSION(1, 3)   VERSION(1, 4)           \
+    VERSION(1, 5)   VERSION(2, 0)   VERSION(2, 1)   VERSION(3, 0)           \
+    VERSION(3, 1)   VERSION(3, 2)   VERSION(3, 3)   VERSION(4, 0)           \
+    VERSION(4, 1)   VERSION(4, 2)   VERSION(4, 3)   VERSION(4, 4)           \
+    VERSION(4, 5)   VERSION(4, 6)
+
+
+/** \brief The OpenGL extensions checked by ObjectGL through their GLEW flags, without their 'GL_' prefix. */
+#define OBJECTGL_GL_CHECKED_EXTENSIONS(EXTENSION)                           \
+    EXTENSION(ARB_buffer_storage)                                           \
+    EXTENSION(ARB_direct_state_access)                                      \
+    EXTENSION(ARB_gl_spirv)                                                 \
+    EXTENSION(ARB_indirect_parameters)                                      \
+    EXTENSION(ARB_multi_bind)                                               \
+    EXTENSION(ARB_multi_draw_indirect)                                      \
+    EXTENSION(ARB_parallel_shader_compile)                                  \
+    EXTENSION(ARB_shader_storage_buffer_object)                             \
+    EXTENSION(ARB_timer_query)                                              \
+    EXTENSION(KHR_debug)                                                    \
+    EXTENSION(KHR_parallel_shader_compile)
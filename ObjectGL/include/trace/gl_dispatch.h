@@ -0,0 +1,79 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include "GL/glew.h"
+
+#include "trace/gl_calls.h"
+
+
+//===========================================================================
+/* The dispatch of the OpenGL 1.1 calls issued by ObjectGL.
+*
+* GLEW loads the entry points of OpenGL 1.2 and above into function
+* pointers, which GLTrace swaps for tracing wrappers while capturing
+* and GLBackend swaps for the ones of its backends.  OpenGL 1.1 entry
+* points are exported by the OpenGL library itself though,  and get
+* called directly.  The translation units that issue any of the OpenGL
+* 1.1 calls of OBJECTGL_GL_TRACED_CORE_CALLS, of
+* OBJECTGL_GL_TRACED_CORE_CUSTOM_CALLS or of
+* OBJECTGL_GL_UNTRACED_CORE_CALLS include this header AFTER all other
+* headers so that these calls get redirected through the function
+* pointers below, initialized with the OpenGL entry points and swapped
+* by GLTrace and GLBackend too.
+*
+* The translation unit that defines these pointers defines macro
+* OBJECTGL_GL_DISPATCH_DEFINITIONS before including this header, so
+* that it still gets the OpenGL entry points.
+*/
+#define OBJECTGL_GL_DISPATCH_DECLARE(name, ...) extern decltype(&::gl##name) objectgl_gl##name;
+OBJECTGL_GL_TRACED_CORE_CALLS(OBJECTGL_GL_DISPATCH_DECLARE)
+#undef OBJECTGL_GL_DISPATCH_DECLARE
+#define OBJECTGL_GL_DISPATCH_CUSTOM_DECLARE(name) extern decltype(&::gl##name) objectgl_gl##name;
+OBJECTGL_GL_TRACED_CORE_CUSTOM_CALLS(OBJECTGL_GL_DISPATCH_CUSTOM_DECLARE)
+OBJECTGL_GL_UNTRACED_CORE_CALLS(OBJECTGL_GL_DISPATCH_CUSTOM_DECLARE)
+#undef OBJECTGL_GL_DISPATCH_CUSTOM_DECLARE
+
+#ifndef OBJECTGL_GL_DISPATCH_DEFINITIONS
+#define glColorMask         objectgl_glColorMask
+#define glCullFace          objectgl_glCullFace
+#define glDeleteTextures    objectgl_glDeleteTextures
+#define glDepthFunc         objectgl_glDepthFunc
+#define glDepthMask         objectgl_glDepthMask
+#define glDisable           objectgl_glDisable
+#define glEnable            objectgl_glEnable
+#define glFlush             objectgl_glFlush
+#define glFrontFace         objectgl_glFrontFace
+#define glGetIntegerv       objectgl_glGetIntegerv
+#define glGetString         objectgl_glGetString
+#define glPolygonMode       objectgl_glPolygonMode
+#define glPolygonOffset     objectgl_glPolygonOffset
+#define glReadPixels        objectgl_glReadPixels
+#define glScissor           objectgl_glScissor
+#define glStencilFunc       objectgl_glStencilFunc
+#define glStencilMask       objectgl_glStencilMask
+#define glStencilOp         objectgl_glStencilOp
+#define glViewport          objectgl_glViewport
+#endif
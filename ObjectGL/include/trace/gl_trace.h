@@ -0,0 +1,167 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "GL/glew.h"
+
+#include "trace/gl_calls.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The capture of the OpenGL calls into binary traces, for deterministic replays.
+*
+* While capturing, the OpenGL calls of the tables of trace/gl_calls.h
+* are recorded into a compact binary trace, with all the client memory
+* they read: shader sources and binaries, buffer contents and uniform
+* values.  The trace can then be replayed with no application around
+* it (see GLTraceReplayer and tool gl_trace_replay), e.g. to measure
+* the CPU cost of the submission path of production frames in
+* performance regression tests.
+*
+* Capture swaps the function pointers loaded by GLEW (and the ones of
+* trace/gl_dispatch.h) for recording wrappers: when not capturing,
+* calls pay nothing. Writes into mapped memory cannot be intercepted
+* though:
+*   - for non-persistent mappings, the mapped range is recorded when
+*     flushed or unmapped;
+*   - for persistent mappings, the writers record what they wrote with
+*     'on_mapped_write()', as RingBuffer and MultiDrawBatcher do.
+* Queries results and other read backs are not recorded: the replay
+* does not depend on them.
+*
+* Format:
+*   - an 8 bytes header: "OGLTRC01";
+*   - then records, each starting with its uint16 'Record' id, then
+*     the arguments of the call, each with the size of its C type but
+*     pointers, written as uint64.  Client memory is written as uint32
+*     count of elements, then the elements, with count 0xFFFFFFFF for
+*     NULL pointers.  Objects names are the ones of the capture, and
+*     get remapped at replay time.
+*   All integers are little-endian.  Record ids follow the order of the
+*   tables, so traces are replayed by the same version of ObjectGL.
+*
+* Usage:
+*   // right after the creation of the context, before ObjectGL objects
+*   GLTrace::start("frames.trace");
+*   ... each frame:
+*   render();
+*   GLTrace::end_frame();
+*   ...
+*   GLTrace::stop();
+*
+* Notice: objects created before the start of the capture are unknown
+*         to the replayer, which binds object 0 instead.  Capture
+*         expects all OpenGL calls to be issued from a single thread.
+*/
+class GLTrace {
+public:
+
+    /** \brief The ids of the records of traces.
+    */
+    enum Record : uint16_t {
+#       define OBJECTGL_GL_TRACE_RECORD(name, ...) RECORD_##name,
+#       define OBJECTGL_GL_TRACE_CUSTOM_RECORD(name) RECORD_##name,
+        OBJECTGL_GL_TRACED_GLEW_CALLS(OBJECTGL_GL_TRACE_RECORD)
+        OBJECTGL_GL_TRACED_CORE_CALLS(OBJECTGL_GL_TRACE_RECORD)
+        OBJECTGL_GL_TRACED_UNIFORM_CALLS(OBJECTGL_GL_TRACE_RECORD)
+        OBJECTGL_GL_TRACED_UNIFORM_MATRIX_CALLS(OBJECTGL_GL_TRACE_RECORD)
+        OBJECTGL_GL_TRACED_CUSTOM_CALLS(OBJECTGL_GL_TRACE_CUSTOM_RECORD)
+        OBJECTGL_GL_TRACED_CORE_CUSTOM_CALLS(OBJECTGL_GL_TRACE_CUSTOM_RECORD)
+#       undef OBJECTGL_GL_TRACE_CUSTOM_RECORD
+#       undef OBJECTGL_GL_TRACE_RECORD
+        RECORD_MAPPED_WRITE,    //!< uint32 buffer name, int64 offset in the buffer, then the written bytes.
+        RECORD_FRAME,           //!< the end of a frame.
+        RECORD_END              //!< the end of the trace.
+    };
+
+
+    /** \brief The header of traces.
+    */
+    static const char HEADER[8];
+
+
+    /** \brief The count of elements written for NULL pointers to client memory.
+    */
+    static const uint32_t NULL_COUNT = 0xFFFFFFFFu;
+
+
+    /** \brief Starts capturing.
+    *
+    * GLEW must have been initialized in the current context.
+    *
+    * \param filepath : the path of the trace file.
+    *
+    * \return false if capture is already started or if the trace file
+    *       cannot be opened, or true else.
+    */
+    static bool start(const string& filepath);
+
+
+    /** \brief Stops capturing, restores the OpenGL function pointers and closes the trace file.
+    */
+    static void stop();
+
+
+    /** \brief Returns true once capture has been started and until it gets stopped.
+    */
+    static inline const bool is_capturing() {
+        return prvt_capturing;
+    }
+
+
+    /** \brief Records the end of a frame, and writes the pending records into the trace file.
+    */
+    static void end_frame();
+
+
+    /** \brief Records data written into the persistently mapped memory of a buffer.
+    *
+    * \param buffer : the name of the buffer.
+    * \param offset : the offset in the buffer of the first written byte.
+    * \param size : the count of written bytes.
+    * \param data : a pointer to the written bytes.
+    */
+    static void on_mapped_write(const GLuint buffer, const GLintptr offset, const GLsizeiptr size, const void* data);
+
+
+    /** \brief Returns the count of frames recorded since start.
+    */
+    static uint64_t get_frames_count();
+
+
+    /** \brief Returns the count of bytes recorded since start.
+    */
+    static uint64_t get_bytes_count();
+
+
+private:
+    static bool prvt_capturing;
+};
@@ -0,0 +1,199 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "trace/gl_trace.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of replayers of the OpenGL traces captured by GLTrace.
+*
+* The whole trace is loaded into memory at construction time, so that
+* no file access gets measured.  Frames are then replayed one by one
+* in the current context, which must provide the entry points used at
+* capture time (e.g. OpenGL 4.5 core for ObjectGL).  Objects names,
+* sync objects and mapped pointers of the capture are remapped onto
+* the ones created by the replay.  Buffers storage always gets
+* GL_DYNAMIC_STORAGE_BIT, so that writes into mapped memory can be
+* replayed with glNamedBufferSubData() when no replayed mapping covers
+* them.
+*
+* The replay of each frame is timed on the CPU:  it is the cost of the
+* submission path of the frame, decoding of the trace included, which
+* is a small copy per call.  The GPU is not waited for unless the
+* captured calls did (e.g. glClientWaitSync()).
+*
+* Shaders are compiled from their captured sources:  uniforms locations
+* and subroutines indices are replayed as captured, hence traces are
+* meant to be replayed by the OpenGL implementation they were captured
+* with, or one that assigns locations the same way.
+*
+* Usage:
+*   GLTraceReplayer replayer("frames.trace");
+*   GLTraceReplayer::FrameStats stats;
+*   while (replayer.replay_frame(stats))
+*       cout << stats.cpu_ms << " ms" << endl;
+*
+* Notice: an OpenGL context must be current when calling  methods
+*   of this class.
+*/
+class GLTraceReplayer {
+public:
+
+    /** \brief The statistics of the replay of a frame.
+    */
+    struct FrameStats {
+        double      cpu_ms;     //!< the CPU time spent replaying the frame, in milliseconds.
+        uint64_t    calls;      //!< the count of replayed calls.
+        uint64_t    bytes;      //!< the count of bytes of client memory passed to OpenGL (e.g. buffers contents, uniforms).
+    };
+
+
+    /** \brief Constructor. Loads a trace.
+    *
+    * \param filepath : the path of the trace file.
+    */
+    GLTraceReplayer(const string& filepath);
+
+
+    /** \brief Destructor. Deletes all the objects created by the replay.
+    */
+    ~GLTraceReplayer();
+
+
+    GLTraceReplayer(const GLTraceReplayer& copy) = delete;
+    GLTraceReplayer& operator= (const GLTraceReplayer& copy) = delete;
+
+
+    /** \brief Replays the next frame of the trace.
+    *
+    * \param stats : a reference to the statistics of the replayed
+    *       frame, set on return.
+    *
+    * \return true if a whole frame has been replayed, or false once
+    *       the end of the trace has been reached (the calls after the
+    *       last frame are replayed though) or if the trace is corrupt.
+    */
+    bool replay_frame(FrameStats& stats);
+
+
+    /** \brief Returns the count of frames replayed so far.
+    */
+    inline const uint64_t get_replayed_frames() const {
+        return prvt_replayed_frames;
+    }
+
+
+    /** \brief Returns the count of calls skipped because their entry point is not available in the current context.
+    */
+    inline const uint64_t get_skipped_calls() const {
+        return prvt_skipped_calls;
+    }
+
+
+    /** \brief Returns true if the trace has been loaded and has not turned out to be corrupt.
+    */
+    inline const bool is_ok() const {
+        return !prvt_trace.empty() && !prvt_corrupt;
+    }
+
+
+    /** \brief Returns true once the end of the trace has been reached.
+    */
+    inline const bool is_finished() const {
+        return prvt_finished;
+    }
+
+
+private:
+    // the kinds of objects whose names get remapped.
+    enum NamesKind {
+        BUFFERS, TEXTURES, PROGRAMS, SHADERS, VERTEX_ARRAYS, SAMPLERS, QUERIES, NAMES_KINDS_COUNT
+    };
+
+    // a buffer mapped by the replay, by name of the capture.
+    struct Mapping {
+        unsigned char*  data;
+        GLintptr        offset;
+        GLsizeiptr      length;
+    };
+
+    template<typename T>
+    T prvt_read();
+
+    template<typename T>
+    T prvt_read_argument(const char kind);
+
+    template<typename T>
+    T* prvt_read_array(const size_t scratch_index, uint32_t& count);
+
+    const GLuint* prvt_read_names(const char kind, const size_t scratch_index, uint32_t& count);
+
+    const unsigned char* prvt_read_bytes(uint32_t& count);
+
+    template<typename R, typename... Args, size_t... I>
+    void prvt_replay_call(R (GLAPIENTRY* function)(Args...), const char* kinds, index_sequence<I...>);
+
+    template<typename T>
+    void prvt_replay_uniform(void (GLAPIENTRY* function)(GLuint, GLint, GLsizei, const T*), const uint32_t elements_count);
+
+    template<typename T>
+    void prvt_replay_uniform_matrix(void (GLAPIENTRY* function)(GLuint, GLint, GLsizei, GLboolean, const T*), const uint32_t elements_count);
+
+    void prvt_replay_record(const GLTrace::Record record);
+
+    void prvt_create_names(const char kind, void (GLAPIENTRY* function)(GLsizei, GLuint*));
+
+    void prvt_delete_names(const char kind, void (GLAPIENTRY* function)(GLsizei, const GLuint*));
+
+    void prvt_delete_name(const char kind, void (GLAPIENTRY* function)(GLuint));
+
+    void prvt_replay_mapped_write();
+
+    GLuint prvt_remap(const char kind, const GLuint name) const;
+
+    vector<unsigned char>               prvt_trace;         // the whole trace file.
+    size_t                              prvt_cursor;        // the offset of the next record in the trace.
+    bool                                prvt_corrupt;
+    bool                                prvt_finished;
+    uint64_t                            prvt_replayed_frames;
+    uint64_t                            prvt_skipped_calls;
+    uint64_t                            prvt_bytes;         // the count of bytes passed to OpenGL in the current frame.
+    unordered_map<GLuint, GLuint>       prvt_names[NAMES_KINDS_COUNT];  // the names of the replay, by names of the capture.
+    unordered_map<uint64_t, GLsync>     prvt_syncs;         // the sync objects of the replay, by the ones of the capture.
+    unordered_map<GLuint, Mapping>      prvt_mappings;      // the mappings of the replay, by buffer names of the capture.
+    vector<uint64_t>                    prvt_scratches[3];  // aligned copies of client arrays.
+};
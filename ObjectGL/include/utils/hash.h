@@ -0,0 +1,88 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief 64-bits FNV-1a hashing of bytes sequences.
+*
+* Used by ObjectGL everywhere a cheap, stable and platform-independent
+* content hash is needed (program binaries cache keys, preprocessed
+* sources, pipeline states descriptions, ...).  Its results are  the
+* same from one run to another and may then be stored on disk.
+*/
+namespace fnv1a {
+
+    constexpr uint64_t OFFSET_BASIS = 0xcbf29ce484222325ULL; //!< the FNV-1a initial hash value.
+    constexpr uint64_t PRIME        = 0x00000100000001b3ULL; //!< the FNV-1a multiplier.
+
+
+    /** \brief Hashes a sequence of bytes, starting from some previous hash value.
+    *
+    * \param data : a pointer to the first byte to be hashed.
+    * \param size : the count of bytes to be hashed.
+    * \param hash : the initial hash value, to be used when chaining
+    *       many calls. Defaults to the FNV-1a offset basis.
+    *
+    * \return the resulting 64-bits hash value.
+    */
+    inline uint64_t hash(const void* data, const size_t size, uint64_t hash = OFFSET_BASIS) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= uint64_t(bytes[i]);
+            hash *= PRIME;
+        }
+        return hash;
+    }
+
+
+    /** \brief Hashes the content of a string, starting from some previous hash value.
+    */
+    inline uint64_t hash(const string& text, uint64_t hash = OFFSET_BASIS) {
+        return fnv1a::hash(text.data(), text.size(), hash);
+    }
+
+
+    /** \brief Hashes a trivially copyable value, starting from some previous hash value.
+    */
+    template<typename T>
+    inline uint64_t hash_value(const T& value, uint64_t hash = OFFSET_BASIS) {
+        return fnv1a::hash(&value, sizeof(T), hash);
+    }
+
+
+    /** \brief Combines two hash values in an order-dependant manner.
+    */
+    inline uint64_t combine(const uint64_t seed, const uint64_t value) {
+        return hash_value(value, seed);
+    }
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+
+
+//===========================================================================
+/** \brief The class of read-only memory-mapped files.
+*
+* Maps the whole content of a file into memory, with no copy.  The
+* mapping is released at destruction time.  Used to pass the content
+* of files straight to OpenGL (e.g. shaders source codes) without any
+* intermediate buffering.
+*/
+class MappedFile {
+public:
+
+    /** \brief Constructor.
+    *
+    * Opens and maps the specified file. In case of any error,
+    * 'is_ok()' returns false.
+    *
+    * \param filepath : a C NULL-terminated string  describing
+    *       the path of the file to be mapped.
+    */
+    MappedFile(const char* filepath);
+
+
+    /** \brief Copy constructor is not allowed on mapped files.
+    */
+    MappedFile(const MappedFile& copy) = delete;
+
+
+    /** \brief Move constructor.
+    */
+    MappedFile(MappedFile&& other) noexcept;
+
+
+    /** \brief Destructor. Unmaps and closes the file.
+    */
+    ~MappedFile();
+
+
+    /** \brief Returns a pointer to the first mapped byte.
+    *
+    * Notice: the mapped content is not NULL-terminated.  Empty
+    *   files are mapped as a valid pointer to zero bytes.
+    */
+    inline const char* data() const {
+        return prvt_data;
+    }
+
+
+    /** \brief Returns true if the file has been successfully mapped.
+    */
+    inline const bool is_ok() const {
+        return prvt_data != nullptr;
+    }
+
+
+    /** \brief Returns the size of the mapped content, in bytes.
+    */
+    inline const size_t size() const {
+        return prvt_size;
+    }
+
+
+private:
+    const char* prvt_data;  // the mapped content, or nullptr on error.
+    size_t      prvt_size;  // the size of the mapped content.
+#if defined(_WIN32)
+    void*       prvt_file_handle;       // the Windows handle of the mapped file.
+    void*       prvt_mapping_handle;    // the Windows handle of the file mapping object.
+#else
+    int         prvt_fd;                // the POSIX descriptor of the mapped file.
+#endif
+
+    void prvt_unmap();
+};
@@ -0,0 +1,182 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "context/gl_state.h"
+#include "objects/object.h"
+#include "buffers/buffers.h"
+#include "buffers/index_buffer.h"
+#include "shaders/shaders_program.h"
+#include "vertex_layout.h"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The class of OpenGL Vertex Array Objects.
+*
+* The format of the vertex attributes is set once from a compile-time
+* layout  (see  vertex_layout.h)  with  the  Direct State Access calls
+* glVertexArrayAttribFormat() and glVertexArrayAttribBinding(), the
+* locations of the attributes being taken from the reflected inputs
+* of a linked shaders program.
+*
+* Vertex buffers are then attached to buffer bindings with
+* glVertexArrayVertexBuffer().  Meshes that share the same vertex
+* format can reuse one single vertex array: only buffers have to be
+* attached again between them.
+*
+* When extension ARB_direct_state_access is not available,  the vertex
+* array is bound to be edited, and the previously bound vertex array
+* gets then unbound.
+*
+* Vertex arrays cannot be shared between OpenGL contexts. They can be
+* moved but cannot be copied.
+*/
+class VertexArray : public Object {
+public:
+
+    /** \brief Empty constructor.
+    *
+    * Creates an OpenGL Vertex Array object with no attributes.
+    */
+    VertexArray();
+
+
+    /** \brief Constructor with layout setting.
+    *
+    * \sa set_layout().
+    */
+    template<size_t N>
+    VertexArray(const VertexAttribute (&attributes)[N], const ShadersProgram& program)
+        : VertexArray()
+    {
+        set_layout(attributes, N, program);
+    }
+
+
+    /** \brief Move constructor.
+    */
+    VertexArray(VertexArray&& other);
+
+
+    /** \brief Destructor.
+    */
+    ~VertexArray();
+
+
+    /** \brief Move assignment.
+    */
+    VertexArray& operator= (VertexArray&& other);
+
+
+    /** \brief Binds this vertex array, through the state cache of the current context.
+    */
+    inline void bind() const {
+        GLStateCache::get_current().bind_vertex_array(name);
+    }
+
+
+    /** \brief Returns the stride of a buffer binding, as set by the layout, or 0 if unknown.
+    */
+    inline const GLsizei get_stride(const GLuint binding) const {
+        return binding < prvt_strides.size() ? prvt_strides[binding] : 0;
+    }
+
+
+    /** \brief Sets the divisor of a buffer binding, for instanced attributes.
+    */
+    void set_binding_divisor(const GLuint binding, const GLuint divisor);
+
+
+    /** \brief Attaches an index buffer to this vertex array.
+    */
+    void set_index_buffer(const IndexBuffer& buffer);
+
+
+    /** \brief Sets the format of the vertex attributes of this vertex array.
+    *
+    * Attributes are matched by name against the reflected inputs of a
+    * linked  shaders program.  Attributes that are not active in the
+    * program are skipped.
+    *
+    * \param attributes : a pointer to the descriptions of the attributes.
+    * \param count : the count of attributes.
+    * \param program : a reference to the linked shaders program the
+    *       attributes are matched against.
+    *
+    * \return true if all the inputs of the program are fed by the
+    *       layout, or false else.
+    */
+    bool set_layout(const VertexAttribute* attributes, const size_t count, const ShadersProgram& program);
+
+
+    /** \brief Sets the format of the vertex attributes of this vertex array from a constant array of descriptions.
+    */
+    template<size_t N>
+    inline bool set_layout(const VertexAttribute (&attributes)[N], const ShadersProgram& program) {
+        return set_layout(attributes, N, program);
+    }
+
+
+    /** \brief Attaches a vertex buffer to a buffer binding of this vertex array.
+    *
+    * The stride is the one set by the layout for this binding.
+    *
+    * \param binding : the index of the buffer binding.
+    * \param buffer : a reference to the vertex buffer.
+    * \param offset : the offset of the first vertex in the buffer.
+    *       Defaults to 0.
+    */
+    void set_vertex_buffer(const GLuint binding, const Buffer& buffer, const GLintptr offset = 0);
+
+
+    /** \brief Attaches many vertex buffers to consecutive buffer bindings at once.
+    *
+    * \param first_binding : the index of the first buffer binding.
+    * \param count : the count of buffers to attach.
+    * \param buffers : the OpenGL identifiers of the buffers.
+    * \param offsets : the offsets of the first vertex in each buffer.
+    */
+    void set_vertex_buffers(const GLuint first_binding, const GLsizei count, const GLuint* buffers, const GLintptr* offsets);
+
+
+    /** Class method. Returns true if a name is the one of an OpenGL Vertex Array object.
+    */
+    static inline const bool is_vertex_array(const GLuint name) {
+        return glIsVertexArray(name) == GL_TRUE;
+    }
+
+
+private:
+    vector<GLsizei> prvt_strides;   // the stride of each buffer binding, as set by the layout.
+
+    void prvt_release();
+};
@@ -0,0 +1,190 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+
+#include "GL/glew.h"
+#include "Eigen/Core"
+
+using namespace std;
+
+
+//===========================================================================
+/** \brief The traits of the C++ types of vertex attributes.
+*
+* Each specialization provides, as compile-time constants:
+*   - 'type', the OpenGL type of the components of the attribute;
+*   - 'components', the count of components of the attribute;
+*   - 'is_integer', true if values are integer ones,  to be fed to
+*     'int', 'ivec' or 'uvec' shader inputs unless normalized;
+*   - 'is_double', true if values are double precision ones,  to be
+*     fed to 'double' or 'dvec' shader inputs.
+*
+* Plain scalars, C arrays of scalars (e.g. 'GLfloat[3]') and Eigen
+* fixed-size vectors are supported.
+*/
+template<typename T>
+struct GLTypeTraits;
+
+
+#define OBJECTGL_GL_TYPE_TRAITS(T, TYPE, COMPONENTS, IS_INTEGER, IS_DOUBLE) \
+    template<>                                                              \
+    struct GLTypeTraits<T> {                                                \
+        static constexpr GLenum type = TYPE;                                \
+        static constexpr GLint  components = COMPONENTS;                    \
+        static constexpr bool   is_integer = IS_INTEGER;                    \
+        static constexpr bool   is_double = IS_DOUBLE;                      \
+    };
+
+OBJECTGL_GL_TYPE_TRAITS(GLfloat,  GL_FLOAT,          1, false, false)
+OBJECTGL_GL_TYPE_TRAITS(GLdouble, GL_DOUBLE,         1, false, true)
+OBJECTGL_GL_TYPE_TRAITS(GLbyte,   GL_BYTE,           1, true,  false)
+OBJECTGL_GL_TYPE_TRAITS(GLubyte,  GL_UNSIGNED_BYTE,  1, true,  false)
+OBJECTGL_GL_TYPE_TRAITS(GLshort,  GL_SHORT,          1, true,  false)
+OBJECTGL_GL_TYPE_TRAITS(GLushort, GL_UNSIGNED_SHORT, 1, true,  false)
+OBJECTGL_GL_TYPE_TRAITS(GLint,    GL_INT,            1, true,  false)
+OBJECTGL_GL_TYPE_TRAITS(GLuint,   GL_UNSIGNED_INT,   1, true,  false)
+
+#undef OBJECTGL_GL_TYPE_TRAITS
+
+
+/** \brief The traits of C arrays of scalars, e.g. 'GLfloat[3]'.
+*/
+template<typename T, size_t N>
+struct GLTypeTraits<T[N]> {
+    static constexpr GLenum type = GLTypeTraits<T>::type;
+    static constexpr GLint  components = GLint(N);
+    static constexpr bool   is_integer = GLTypeTraits<T>::is_integer;
+    static constexpr bool   is_double = GLTypeTraits<T>::is_double;
+};
+
+
+/** \brief The traits of Eigen fixed-size vectors, e.g. 'Eigen::Vector3f'.
+*/
+template<typename T, int ROWS, int OPTIONS, int MAX_ROWS>
+struct GLTypeTraits<Eigen::Matrix<T, ROWS, 1, OPTIONS, MAX_ROWS, 1>> {
+    static constexpr GLenum type = GLTypeTraits<T>::type;
+    static constexpr GLint  components = ROWS;
+    static constexpr bool   is_integer = GLTypeTraits<T>::is_integer;
+    static constexpr bool   is_double = GLTypeTraits<T>::is_double;
+};
+
+
+//===========================================================================
+/** \brief The description of one vertex attribute.
+*
+* Descriptions are plain compile-time constants, built with macros
+* OBJECTGL_VERTEX_ATTRIBUTE() and the like, from the members of vertex
+* structures.  They involve no runtime parsing at all.
+*
+* Attributes are matched by name against the reflected inputs of the
+* shaders programs they are used with.
+*/
+struct VertexAttribute {
+
+    /** \brief The kinds of attributes, i.e. how values are fed to shaders.
+    */
+    enum Kind {
+        FLOATING = 0,   //!< values are converted to floats, set with glVertexArrayAttribFormat().
+        INTEGER,        //!< values are kept as integers, set with glVertexArrayAttribIFormat().
+        DOUBLE          //!< values are kept as doubles, set with glVertexArrayAttribLFormat().
+    };
+
+    const char* name;               //!< the name of the related shader input.
+    GLint       components;         //!< the count of components of the attribute.
+    GLenum      type;               //!< the OpenGL type of the components.
+    GLboolean   normalized;         //!< true if integer values are normalized into floats.
+    Kind        kind;               //!< the kind of the attribute.
+    GLuint      relative_offset;    //!< the offset of the attribute in the vertex.
+    GLuint      binding;            //!< the index of the vertex buffer binding this attribute is fetched from.
+    GLsizei     stride;             //!< the stride between consecutive vertices in the vertex buffer.
+};
+
+
+/** \brief Builds the description of an attribute of C++ type T.
+*
+* \sa macros OBJECTGL_VERTEX_ATTRIBUTE(), OBJECTGL_VERTEX_ATTRIBUTE_NORMALIZED()
+*   and OBJECTGL_VERTEX_STREAM().
+*/
+template<typename T>
+constexpr VertexAttribute make_vertex_attribute(const char* name, const GLuint relative_offset, const GLuint binding, const GLsizei stride, const bool normalized = false)
+{
+    return VertexAttribute{
+        name,
+        GLTypeTraits<T>::components,
+        GLTypeTraits<T>::type,
+        GLboolean(normalized ? GL_TRUE : GL_FALSE),
+        GLTypeTraits<T>::is_double ? VertexAttribute::DOUBLE
+                                   : (GLTypeTraits<T>::is_integer && !normalized) ? VertexAttribute::INTEGER
+                                                                                 : VertexAttribute::FLOATING,
+        relative_offset,
+        binding,
+        stride
+    };
+}
+
+
+/** \brief Describes a member of an interleaved vertex structure, fetched from buffer binding 0.
+*
+* Usage:
+*   struct Vertex {
+*       Eigen::Vector3f position;
+*       Eigen::Vector3f normal;
+*       GLubyte         color[4];
+*   };
+*
+*   static constexpr VertexAttribute VERTEX_LAYOUT[] = {
+*       OBJECTGL_VERTEX_ATTRIBUTE(Vertex, position, "in_position"),
+*       OBJECTGL_VERTEX_ATTRIBUTE(Vertex, normal, "in_normal"),
+*       OBJECTGL_VERTEX_ATTRIBUTE_NORMALIZED(Vertex, color, "in_color")
+*   };
+*/
+#define OBJECTGL_VERTEX_ATTRIBUTE(VERTEX, MEMBER, NAME) \
+    make_vertex_attribute<decltype(VERTEX::MEMBER)>(NAME, GLuint(offsetof(VERTEX, MEMBER)), 0, GLsizei(sizeof(VERTEX)))
+
+
+/** \brief Describes a member of an interleaved vertex structure whose integer values are normalized into floats.
+*/
+#define OBJECTGL_VERTEX_ATTRIBUTE_NORMALIZED(VERTEX, MEMBER, NAME) \
+    make_vertex_attribute<decltype(VERTEX::MEMBER)>(NAME, GLuint(offsetof(VERTEX, MEMBER)), 0, GLsizei(sizeof(VERTEX)), true)
+
+
+/** \brief Describes a separate stream of attributes of C++ type T (i.e. SoA layouts), fetched from its own buffer binding.
+*
+* Usage:
+*   static constexpr VertexAttribute STREAMS_LAYOUT[] = {
+*       OBJECTGL_VERTEX_STREAM(Eigen::Vector3f, 0, "in_position"),
+*       OBJECTGL_VERTEX_STREAM(Eigen::Vector2f, 1, "in_uv")
+*   };
+*/
+#define OBJECTGL_VERTEX_STREAM(T, BINDING, NAME) \
+    make_vertex_attribute<T>(NAME, 0, BINDING, GLsizei(sizeof(T)))
+
+
+/** \brief Describes a separate stream of attributes of C++ type T whose integer values are normalized into floats.
+*/
+#define OBJECTGL_VERTEX_STREAM_NORMALIZED(T, BINDING, NAME) \
+    make_vertex_attribute<T>(NAME, 0, BINDING, GLsizei(sizeof(T)), true)
@@ -0,0 +1,220 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <iostream>
+#include "buffers/buffers.h"
+#include "profiling/cpu_profiler.h"
+
+using namespace std;
+
+
+Buffer::Buffer(const GLenum target)
+    : SharableObject(),
+      prvt_target(target),
+      prvt_size(0),
+      prvt_flags(0),
+      prvt_mapped(NULL)
+{
+    if (is_dsa_supported())
+        glCreateBuffers(1, &name);
+    else {
+        // binding is what actually creates the buffer object
+        glGenBuffers(1, &name);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, name);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+
+Buffer::Buffer(const GLenum target, const GLsizeiptr size, const void* data, const GLbitfield flags)
+    : Buffer(target)
+{
+    allocate(size, data, flags);
+}
+
+
+Buffer::Buffer(Buffer&& other)
+    : SharableObject(other.name),
+      prvt_target(other.prvt_target),
+      prvt_size(other.prvt_size),
+      prvt_flags(other.prvt_flags),
+      prvt_mapped(other.prvt_mapped)
+{
+    other.name = 0;
+    other.prvt_size = 0;
+    other.prvt_mapped = NULL;
+}
+
+
+Buffer::~Buffer()
+{
+    prvt_release();
+}
+
+
+Buffer& Buffer::operator= (Buffer&& other)
+{
+    if (this != &other) {
+        prvt_release();
+
+        name = other.name;
+        prvt_target = other.prvt_target;
+        prvt_size = other.prvt_size;
+        prvt_flags = other.prvt_flags;
+        prvt_mapped = other.prvt_mapped;
+
+        other.name = 0;
+        other.prvt_size = 0;
+        other.prvt_mapped = NULL;
+    }
+    return *this;
+}
+
+
+bool Buffer::allocate(const GLsizeiptr size, const void* data, const GLbitfield flags)
+{
+    OBJECTGL_CPU_ZONE("Buffer::allocate");
+    if (!is_ok() || prvt_size != 0) {
+        cerr << "!!! buffer storage can be allocated only once" << endl;
+        return false;
+    }
+    if (!(GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)) {
+        cerr << "!!! immutable buffer storage is not supported" << endl;
+        return false;
+    }
+
+    if (is_dsa_supported())
+        glNamedBufferStorage(name, size, data, flags);
+    else {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, name);
+        glBufferStorage(GL_COPY_WRITE_BUFFER, size, data, flags);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    prvt_size = size;
+    prvt_flags = flags;
+    return true;
+}
+
+
+void Buffer::copy_to(Buffer& destination, const GLintptr read_offset, const GLintptr write_offset, const GLsizeiptr size) const
+{
+    if (is_dsa_supported())
+        glCopyNamedBufferSubData(name, destination.name, read_offset, write_offset, size);
+    else {
+        glBindBuffer(GL_COPY_READ_BUFFER, name);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, destination.name);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, read_offset, write_offset, size);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+}
+
+
+void Buffer::flush_mapped_range(const GLintptr offset, const GLsizeiptr size)
+{
+    if (is_dsa_supported())
+        glFlushMappedNamedBufferRange(name, offset, size);
+    else {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, name);
+        glFlushMappedBufferRange(GL_COPY_WRITE_BUFFER, offset, size);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+
+void Buffer::get_data(const GLintptr offset, const GLsizeiptr size, void* data) const
+{
+    if (is_dsa_supported())
+        glGetNamedBufferSubData(name, offset, size, data);
+    else {
+        glBindBuffer(GL_COPY_READ_BUFFER, name);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, offset, size, data);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+}
+
+
+void* Buffer::map(const GLintptr offset, const GLsizeiptr size, const GLbitfield access)
+{
+    if (prvt_mapped != NULL) {
+        cerr << "!!! buffer " << name << " is already mapped" << endl;
+        return NULL;
+    }
+
+    if (is_dsa_supported())
+        prvt_mapped = glMapNamedBufferRange(name, offset, size, access);
+    else {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, name);
+        prvt_mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, access);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    if (prvt_mapped == NULL)
+        cerr << "!!! failed to map " << size << " bytes of buffer " << name << endl;
+    return prvt_mapped;
+}
+
+
+void Buffer::set_data(const GLintptr offset, const GLsizeiptr size, const void* data)
+{
+    OBJECTGL_CPU_ZONE("Buffer::set_data");
+    if (is_dsa_supported())
+        glNamedBufferSubData(name, offset, size, data);
+    else {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, name);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+}
+
+
+bool Buffer::unmap()
+{
+    if (prvt_mapped == NULL)
+        return true;
+    prvt_mapped = NULL;
+
+    if (is_dsa_supported())
+        return glUnmapNamedBuffer(name) == GL_TRUE;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, name);
+    const bool ok = glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return ok;
+}
+
+
+void Buffer::prvt_release()
+{
+    if (is_ok()) {
+        unmap();
+        GLStateCache::get_current().on_buffer_deleted(name);
+        glDeleteBuffers(1, &name);
+        name = 0;
+    }
+    prvt_size = 0;
+}
@@ -0,0 +1,144 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include "buffers/ring_buffer.h"
+#include "trace/gl_dispatch.h"
+
+using namespace std;
+
+
+// the timeout of each wait for a fence, in nanoseconds
+static const GLuint64 FENCE_WAIT_TIMEOUT = 1000000000;
+
+
+RingBuffer::RingBuffer(const GLsizeiptr frame_size, const GLuint frames_count, const GLenum target)
+    : Buffer(target),
+      prvt_alignment(1),
+      prvt_frame_size(0),
+      prvt_frames_count(frames_count < 1 ? 1 : frames_count),
+      prvt_frame(0),
+      prvt_head(0),
+      prvt_mapped(NULL),
+      prvt_fences(prvt_frames_count, (GLsync)NULL),
+      prvt_stats{ 0, 0, 0, 0 }
+{
+    if (!is_supported()) {
+        cerr << "!!! persistently mapped buffers are not supported" << endl;
+        return;
+    }
+
+    if (target == GL_UNIFORM_BUFFER)
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &prvt_alignment);
+    else if (target == GL_SHADER_STORAGE_BUFFER)
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &prvt_alignment);
+    else if (target == GL_TEXTURE_BUFFER)
+        glGetIntegerv(GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT, &prvt_alignment);
+    if (prvt_alignment < 1)
+        prvt_alignment = 1;
+
+    prvt_frame_size = (frame_size + prvt_alignment - 1) / prvt_alignment * prvt_alignment;
+    const GLsizeiptr total_size = prvt_frame_size * prvt_frames_count;
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    if (Buffer::allocate(total_size, NULL, flags))
+        prvt_mapped = static_cast<unsigned char*>(map(0, total_size, flags));
+}
+
+
+RingBuffer::~RingBuffer()
+{
+    // the GPU must be done with all frames before the buffer gets unmapped and deleted
+    for (GLuint frame = 0; frame < prvt_frames_count; ++frame)
+        prvt_wait(frame);
+}
+
+
+RingBuffer::Allocation RingBuffer::allocate(const GLsizeiptr size)
+{
+    const GLsizeiptr aligned_size = (size + prvt_alignment - 1) / prvt_alignment * prvt_alignment;
+
+    if (prvt_mapped == NULL || size <= 0 || prvt_head + aligned_size > prvt_frame_size) {
+        ++prvt_stats.overflows;
+        return Allocation{ 0, 0, NULL };
+    }
+
+    const GLintptr offset = prvt_frame * prvt_frame_size + prvt_head;
+    prvt_head += aligned_size;
+
+    ++prvt_stats.allocations;
+    prvt_stats.bytes += aligned_size;
+    return Allocation{ offset, size, prvt_mapped + offset };
+}
+
+
+void RingBuffer::begin_frame()
+{
+    if (prvt_fences[prvt_frame] != NULL) {
+        if (glClientWaitSync(prvt_fences[prvt_frame], 0, 0) == GL_TIMEOUT_EXPIRED)
+            ++prvt_stats.waits;
+        prvt_wait(prvt_frame);
+    }
+    prvt_head = 0;
+}
+
+
+void RingBuffer::end_frame()
+{
+    if (prvt_mapped == NULL)
+        return;
+
+    if (prvt_fences[prvt_frame] != NULL)
+        glDeleteSync(prvt_fences[prvt_frame]);
+    prvt_fences[prvt_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    prvt_frame = (prvt_frame + 1) % prvt_frames_count;
+    prvt_head = 0;
+}
+
+
+void RingBuffer::prvt_wait(const GLuint frame)
+{
+    GLsync& fence = prvt_fences[frame];
+    if (fence == NULL)
+        return;
+
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    for (;;) {
+        const GLenum status = glClientWaitSync(fence, flags, FENCE_WAIT_TIMEOUT);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+            break;
+        if (status == GL_WAIT_FAILED) {
+            cerr << "!!! failed waiting for ring buffer frame " << frame << endl;
+            break;
+        }
+        flags = 0;  // commands have been flushed already
+    }
+
+    glDeleteSync(fence);
+    fence = NULL;
+}
@@ -0,0 +1,442 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include "commands/command_buffer.h"
+#include "context/gl_state.h"
+#include "context/memory_barriers.h"
+#include "profiling/cpu_profiler.h"
+
+using namespace std;
+
+
+//===========================================================================
+// the opcodes of commands
+enum CommandOpcode : uint32_t {
+    CMD_BIND_BUFFER = 0,
+    CMD_BIND_BUFFER_RANGE,
+    CMD_BIND_TEXTURES,
+    CMD_BIND_VERTEX_ARRAY,
+    CMD_CALL,
+    CMD_DISPATCH_COMPUTE,
+    CMD_DRAW_ARRAYS,
+    CMD_DRAW_ELEMENTS,
+    CMD_MEMORY_BARRIER,
+    CMD_SET_UNIFORM,
+    CMD_UPLOAD,
+    CMD_USE_PIPELINE,
+    CMD_USE_PROGRAM
+};
+
+// the header of each recorded command, followed by its payload
+struct CommandHeader {
+    uint32_t opcode;
+    uint32_t size;      // the size of the whole command, header included, multiple of 8
+};
+
+struct BindBufferCommand        { GLenum target; GLuint buffer; };
+struct BindBufferRangeCommand   { GLenum target; GLuint index; GLuint buffer; GLintptr offset; GLsizeiptr size; };
+struct BindTexturesCommand      { GLuint first; GLsizei count; };  // followed by the textures names
+struct BindVertexArrayCommand   { GLuint vertex_array; };
+struct CallCommand              { void (*function)(void*); void* user_data; };
+struct DispatchComputeCommand   { GLuint groups_x, groups_y, groups_z; };
+struct DrawArraysCommand        { GLenum mode; GLint first; GLsizei count; GLsizei instance_count; GLuint base_instance; };
+struct DrawElementsCommand      { GLenum mode; GLsizei count; GLenum index_type; GLint base_vertex; GLintptr offset; GLsizei instance_count; GLuint base_instance; };
+struct MemoryBarrierCommand     { GLbitfield barriers; };
+struct SetUniformCommand        { ShadersProgram* program; GLint slot; GLint first_element; GLsizei count; };  // followed by the values
+struct UploadCommand            { Buffer* buffer; GLintptr offset; GLsizeiptr size; };  // followed by the data
+struct UsePipelineCommand       { PipelineStateCache* pipeline_states; const PipelineState* state; };
+struct UseProgramCommand        { ShadersProgram* program; };
+
+static inline size_t align8(const size_t size) {
+    return (size + 7) & ~size_t(7);
+}
+
+
+//===========================================================================
+CommandArena::CommandArena()
+    : prvt_free(NULL), prvt_returned(NULL)
+{}
+
+
+CommandArena::~CommandArena()
+{
+    prvt_free_list(prvt_free);
+    prvt_free_list(prvt_returned.exchange(NULL));
+}
+
+
+CommandArena::Chunk* CommandArena::acquire(const size_t min_capacity)
+{
+    if (min_capacity <= CHUNK_CAPACITY) {
+        if (prvt_free == NULL)
+            prvt_free = prvt_returned.exchange(NULL, memory_order_acquire);
+        if (prvt_free != NULL) {
+            Chunk* chunk = prvt_free;
+            prvt_free = chunk->next;
+            chunk->next = NULL;
+            chunk->used = 0;
+            return chunk;
+        }
+    }
+
+    const size_t capacity = min_capacity > CHUNK_CAPACITY ? min_capacity : CHUNK_CAPACITY;
+    Chunk* chunk = static_cast<Chunk*>(malloc(sizeof(Chunk) + capacity));
+    if (chunk == NULL) {
+        cerr << "!!! cannot allocate a commands chunk of " << capacity << " bytes" << endl;
+        return NULL;
+    }
+    chunk->next = NULL;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    return chunk;
+}
+
+
+void CommandArena::release(Chunk* first)
+{
+    while (first != NULL) {
+        Chunk* chunk = first;
+        first = first->next;
+
+        if (chunk->capacity > CHUNK_CAPACITY)
+            free(chunk);  // oversized chunks are not recycled
+        else {
+            chunk->next = prvt_returned.load(memory_order_relaxed);
+            while (!prvt_returned.compare_exchange_weak(chunk->next, chunk, memory_order_release, memory_order_relaxed))
+                ;
+        }
+    }
+}
+
+
+const shared_ptr<CommandArena>& CommandArena::get_local()
+{
+    static thread_local shared_ptr<CommandArena> local_arena = make_shared<CommandArena>();
+    return local_arena;
+}
+
+
+void CommandArena::prvt_free_list(Chunk* chunk)
+{
+    while (chunk != NULL) {
+        Chunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+
+//===========================================================================
+CommandBuffer::CommandBuffer()
+    : MPSCNode(),
+      prvt_arena(CommandArena::get_local()),
+      prvt_first(NULL),
+      prvt_last(NULL),
+      prvt_commands_count(0)
+{}
+
+
+CommandBuffer::~CommandBuffer()
+{
+    prvt_arena->release(prvt_first);
+}
+
+
+void CommandBuffer::bind_buffer(const GLenum target, const Buffer& buffer)
+{
+    BindBufferCommand* command = static_cast<BindBufferCommand*>(prvt_record(CMD_BIND_BUFFER, sizeof(BindBufferCommand)));
+    if (command != NULL)
+        *command = BindBufferCommand{ target, buffer.name };
+}
+
+
+void CommandBuffer::bind_buffer_range(const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size)
+{
+    BindBufferRangeCommand* command = static_cast<BindBufferRangeCommand*>(prvt_record(CMD_BIND_BUFFER_RANGE, sizeof(BindBufferRangeCommand)));
+    if (command != NULL)
+        *command = BindBufferRangeCommand{ target, index, buffer, offset, size };
+}
+
+
+void CommandBuffer::bind_textures(const GLuint first, const GLsizei count, const GLuint* textures)
+{
+    BindTexturesCommand* command = static_cast<BindTexturesCommand*>(prvt_record(CMD_BIND_TEXTURES, sizeof(BindTexturesCommand) + count * sizeof(GLuint)));
+    if (command != NULL) {
+        *command = BindTexturesCommand{ first, count };
+        memcpy(command + 1, textures, count * sizeof(GLuint));
+    }
+}
+
+
+void CommandBuffer::bind_vertex_array(const VertexArray& vertex_array)
+{
+    BindVertexArrayCommand* command = static_cast<BindVertexArrayCommand*>(prvt_record(CMD_BIND_VERTEX_ARRAY, sizeof(BindVertexArrayCommand)));
+    if (command != NULL)
+        *command = BindVertexArrayCommand{ vertex_array.name };
+}
+
+
+void CommandBuffer::call(void (*function)(void*), void* user_data)
+{
+    CallCommand* command = static_cast<CallCommand*>(prvt_record(CMD_CALL, sizeof(CallCommand)));
+    if (command != NULL)
+        *command = CallCommand{ function, user_data };
+}
+
+
+void CommandBuffer::dispatch_compute(const GLuint groups_x, const GLuint groups_y, const GLuint groups_z)
+{
+    DispatchComputeCommand* command = static_cast<DispatchComputeCommand*>(prvt_record(CMD_DISPATCH_COMPUTE, sizeof(DispatchComputeCommand)));
+    if (command != NULL)
+        *command = DispatchComputeCommand{ groups_x, groups_y, groups_z };
+}
+
+
+void CommandBuffer::draw_arrays(const GLenum mode, const GLint first, const GLsizei count, const GLsizei instance_count, const GLuint base_instance)
+{
+    DrawArraysCommand* command = static_cast<DrawArraysCommand*>(prvt_record(CMD_DRAW_ARRAYS, sizeof(DrawArraysCommand)));
+    if (command != NULL)
+        *command = DrawArraysCommand{ mode, first, count, instance_count, base_instance };
+}
+
+
+void CommandBuffer::draw_elements(const GLenum mode, const GLsizei count, const GLenum index_type, const GLintptr offset,
+                                  const GLint base_vertex, const GLsizei instance_count, const GLuint base_instance)
+{
+    DrawElementsCommand* command = static_cast<DrawElementsCommand*>(prvt_record(CMD_DRAW_ELEMENTS, sizeof(DrawElementsCommand)));
+    if (command != NULL)
+        *command = DrawElementsCommand{ mode, count, index_type, base_vertex, offset, instance_count, base_instance };
+}
+
+
+void CommandBuffer::memory_barrier(const GLbitfield barriers)
+{
+    MemoryBarrierCommand* command = static_cast<MemoryBarrierCommand*>(prvt_record(CMD_MEMORY_BARRIER, sizeof(MemoryBarrierCommand)));
+    if (command != NULL)
+        *command = MemoryBarrierCommand{ barriers };
+}
+
+
+void CommandBuffer::set_uniform(ShadersProgram& program, const GLint slot, const GLint first_element, const GLsizei count, const void* values, const size_t size)
+{
+    // a mismatch would read or copy past the values at replay time
+    const UniformsShadow& shadow = program.get_uniforms_shadow();
+    if (slot < 0 || slot >= shadow.get_slots_count() || count < 0) {
+        cerr << "!!! cannot record the setting of uniform slot " << slot << ": no such slot in program " << program.name << endl;
+        return;
+    }
+    if (size != size_t(count) * shadow.get_element_size(slot)) {
+        cerr << "!!! cannot record the setting of uniform slot " << slot << ": " << size << " bytes for "
+             << count << " elements of " << shadow.get_element_size(slot) << " bytes" << endl;
+        return;
+    }
+
+    SetUniformCommand* command = static_cast<SetUniformCommand*>(prvt_record(CMD_SET_UNIFORM, align8(sizeof(SetUniformCommand)) + size));
+    if (command != NULL) {
+        *command = SetUniformCommand{ &program, slot, first_element, count };
+        memcpy(reinterpret_cast<unsigned char*>(command) + align8(sizeof(SetUniformCommand)), values, size);
+    }
+}
+
+
+void CommandBuffer::upload(Buffer& buffer, const GLintptr offset, const GLsizeiptr size, const void* data)
+{
+    UploadCommand* command = static_cast<UploadCommand*>(prvt_record(CMD_UPLOAD, sizeof(UploadCommand) + size));
+    if (command != NULL) {
+        *command = UploadCommand{ &buffer, offset, size };
+        memcpy(command + 1, data, size);
+    }
+}
+
+
+void CommandBuffer::use_pipeline(PipelineStateCache& pipeline_states, const PipelineState* state)
+{
+    UsePipelineCommand* command = static_cast<UsePipelineCommand*>(prvt_record(CMD_USE_PIPELINE, sizeof(UsePipelineCommand)));
+    if (command != NULL)
+        *command = UsePipelineCommand{ &pipeline_states, state };
+}
+
+
+void CommandBuffer::use_program(ShadersProgram& program)
+{
+    UseProgramCommand* command = static_cast<UseProgramCommand*>(prvt_record(CMD_USE_PROGRAM, sizeof(UseProgramCommand)));
+    if (command != NULL)
+        *command = UseProgramCommand{ &program };
+}
+
+
+void CommandBuffer::execute() const
+{
+    OBJECTGL_CPU_ZONE("CommandBuffer::execute");
+    GLStateCache& cache = GLStateCache::get_current();
+    MemoryBarriers& barriers = MemoryBarriers::get_current();
+    ShadersProgram* current_program = NULL;
+
+    for (CommandArena::Chunk* chunk = prvt_first; chunk != NULL; chunk = chunk->next) {
+        const unsigned char* cursor = chunk->data();
+        const unsigned char* end = cursor + chunk->used;
+
+        while (cursor < end) {
+            const CommandHeader* header = reinterpret_cast<const CommandHeader*>(cursor);
+            const void* payload = header + 1;
+            cursor += header->size;
+
+            switch (header->opcode) {
+            case CMD_BIND_BUFFER: {
+                const BindBufferCommand* command = static_cast<const BindBufferCommand*>(payload);
+                cache.bind_buffer(command->target, command->buffer);
+                break;
+            }
+            case CMD_BIND_BUFFER_RANGE: {
+                const BindBufferRangeCommand* command = static_cast<const BindBufferRangeCommand*>(payload);
+                cache.bind_buffer_range(command->target, command->index, command->buffer, command->offset, command->size);
+                break;
+            }
+            case CMD_BIND_TEXTURES: {
+                const BindTexturesCommand* command = static_cast<const BindTexturesCommand*>(payload);
+                cache.bind_textures(command->first, command->count, reinterpret_cast<const GLuint*>(command + 1));
+                break;
+            }
+            case CMD_BIND_VERTEX_ARRAY:
+                cache.bind_vertex_array(static_cast<const BindVertexArrayCommand*>(payload)->vertex_array);
+                break;
+            case CMD_CALL: {
+                const CallCommand* command = static_cast<const CallCommand*>(payload);
+                command->function(command->user_data);
+                break;
+            }
+            case CMD_DISPATCH_COMPUTE: {
+                const DispatchComputeCommand* command = static_cast<const DispatchComputeCommand*>(payload);
+                if (current_program != NULL)
+                    current_program->flush_uniforms();
+                barriers.flush();
+                glDispatchCompute(command->groups_x, command->groups_y, command->groups_z);
+                break;
+            }
+            case CMD_DRAW_ARRAYS: {
+                const DrawArraysCommand* command = static_cast<const DrawArraysCommand*>(payload);
+                if (current_program != NULL)
+                    current_program->flush_uniforms();
+                barriers.flush();
+                glDrawArraysInstancedBaseInstance(command->mode, command->first, command->count, command->instance_count, command->base_instance);
+                break;
+            }
+            case CMD_DRAW_ELEMENTS: {
+                const DrawElementsCommand* command = static_cast<const DrawElementsCommand*>(payload);
+                if (current_program != NULL)
+                    current_program->flush_uniforms();
+                barriers.flush();
+                glDrawElementsInstancedBaseVertexBaseInstance(command->mode, command->count, command->index_type,
+                                                              reinterpret_cast<const void*>(command->offset),
+                                                              command->instance_count, command->base_vertex, command->base_instance);
+                break;
+            }
+            case CMD_MEMORY_BARRIER:
+                glMemoryBarrier(static_cast<const MemoryBarrierCommand*>(payload)->barriers);
+                break;
+            case CMD_SET_UNIFORM: {
+                const SetUniformCommand* command = static_cast<const SetUniformCommand*>(payload);
+                const unsigned char* values = reinterpret_cast<const unsigned char*>(command) + align8(sizeof(SetUniformCommand));
+                command->program->get_uniforms_shadow().set(command->slot, command->first_element, command->count, values);
+                break;
+            }
+            case CMD_UPLOAD: {
+                const UploadCommand* command = static_cast<const UploadCommand*>(payload);
+                command->buffer->set_data(command->offset, command->size, command + 1);
+                break;
+            }
+            case CMD_USE_PIPELINE: {
+                const UsePipelineCommand* command = static_cast<const UsePipelineCommand*>(payload);
+                command->pipeline_states->apply(command->state);
+                if (command->state->get_desc().program != NULL)
+                    current_program = command->state->get_desc().program;
+                break;
+            }
+            case CMD_USE_PROGRAM:
+                current_program = static_cast<const UseProgramCommand*>(payload)->program;
+                current_program->use();
+                break;
+            }
+        }
+    }
+}
+
+
+void CommandBuffer::clear()
+{
+    for (CommandArena::Chunk* chunk = prvt_first; chunk != NULL; chunk = chunk->next)
+        chunk->used = 0;
+    prvt_last = prvt_first;
+    prvt_commands_count = 0;
+}
+
+
+const size_t CommandBuffer::get_size() const
+{
+    size_t size = 0;
+    for (CommandArena::Chunk* chunk = prvt_first; chunk != NULL; chunk = chunk->next)
+        size += chunk->used;
+    return size;
+}
+
+
+void* CommandBuffer::prvt_record(const uint32_t opcode, const size_t payload_size)
+{
+    const size_t size = align8(sizeof(CommandHeader) + payload_size);
+
+    if (prvt_last == NULL) {
+        prvt_first = prvt_last = prvt_arena->acquire(size);
+        if (prvt_last == NULL)
+            return NULL;
+    }
+    else if (prvt_last->used + size > prvt_last->capacity) {
+        // moves to next chunk, kept from before last clear() if big enough
+        CommandArena::Chunk* next = prvt_last->next;
+        if (next == NULL || next->capacity < size) {
+            CommandArena::Chunk* chunk = prvt_arena->acquire(size);
+            if (chunk == NULL)
+                return NULL;
+            chunk->next = next;
+            prvt_last->next = chunk;
+            next = chunk;
+        }
+        prvt_last = next;
+    }
+
+    CommandHeader* header = reinterpret_cast<CommandHeader*>(prvt_last->data() + prvt_last->used);
+    header->opcode = opcode;
+    header->size = uint32_t(size);
+    prvt_last->used += size;
+    ++prvt_commands_count;
+
+    return header + 1;
+}
@@ -0,0 +1,166 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include "commands/command_thread.h"
+
+using namespace std;
+
+
+CommandThread::CommandThread()
+    : prvt_sleeping(false),
+      prvt_stopping(false),
+      prvt_submitting(0),
+      prvt_submitted(0),
+      prvt_replayed(0),
+      prvt_commands(0)
+{}
+
+
+CommandThread::~CommandThread()
+{
+    stop();
+    prvt_delete_pending();  // e.g. submitted while the thread was not started
+}
+
+
+CommandThread::Stats CommandThread::get_stats() const
+{
+    return Stats{ prvt_submitted.load(), prvt_replayed.load(), prvt_commands.load() };
+}
+
+
+bool CommandThread::start(function<void()> on_start, function<void()> on_stop)
+{
+    if (is_running())
+        return false;
+    prvt_stopping = false;
+    prvt_thread = thread(&CommandThread::prvt_run, this, on_start, on_stop);
+    return true;
+}
+
+
+void CommandThread::stop()
+{
+    if (!is_running())
+        return;
+    {
+        lock_guard<mutex> lock(prvt_mutex);
+        prvt_stopping = true;
+    }
+    prvt_wakeup.notify_one();
+    prvt_thread.join();
+
+    // submitted concurrently with the stop, after the thread emptied the queue
+    while (prvt_submitting.load() != 0)
+        this_thread::yield();
+    prvt_delete_pending();
+}
+
+
+void CommandThread::submit(CommandBuffer* commands)
+{
+    // a submission which sees no stop is waited for by 'stop()' before it empties the queue
+    ++prvt_submitting;
+
+    // no thread would replay nor delete the command buffer anymore
+    if (prvt_stopping.load()) {
+        --prvt_submitting;
+        cerr << "!!! command buffer submitted to a stopped command thread is dropped" << endl;
+        delete commands;
+        return;
+    }
+
+    ++prvt_submitted;
+    prvt_queue.push(commands);
+    --prvt_submitting;
+
+    if (prvt_sleeping.load()) {
+        // locking ensures the command thread is either waiting or has not checked the queue yet
+        lock_guard<mutex> lock(prvt_mutex);
+    }
+    prvt_wakeup.notify_one();
+}
+
+
+void CommandThread::wait_idle()
+{
+    const size_t submitted = prvt_submitted.load();
+    unique_lock<mutex> lock(prvt_mutex);
+    prvt_idle.wait(lock, [&]() { return prvt_replayed.load() >= submitted || !is_running(); });
+}
+
+
+void CommandThread::prvt_delete_pending()
+{
+    while (!prvt_queue.is_empty()) {
+        CommandBuffer* commands = prvt_queue.pop();
+        if (commands != NULL)
+            delete commands;
+        else
+            this_thread::yield();  // some producer is pushing
+    }
+}
+
+
+void CommandThread::prvt_run(function<void()> on_start, function<void()> on_stop)
+{
+    if (on_start)
+        on_start();
+
+    for (;;) {
+        CommandBuffer* commands = prvt_queue.pop();
+
+        if (commands != NULL) {
+            commands->execute();
+            prvt_commands += commands->get_commands_count();
+            delete commands;
+            ++prvt_replayed;
+            continue;
+        }
+
+        if (!prvt_queue.is_empty()) {
+            this_thread::yield();  // some producer is pushing
+            continue;
+        }
+
+        unique_lock<mutex> lock(prvt_mutex);
+        prvt_idle.notify_all();
+        if (prvt_stopping)
+            break;
+
+        prvt_sleeping = true;
+        prvt_wakeup.wait(lock, [this]() { return !prvt_queue.is_empty() || prvt_stopping.load(); });
+        prvt_sleeping = false;
+    }
+
+    if (on_stop)
+        on_stop();
+}
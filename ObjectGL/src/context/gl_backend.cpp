@@ -0,0 +1,751 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "context/gl_backend.h"
+#include "trace/gl_trace.h"
+
+#define OBJECTGL_GL_DISPATCH_DEFINITIONS
+#include "trace/gl_dispatch.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+// The OpenGL 1.1 entry points of trace/gl_dispatch.h.
+#define OBJECTGL_GL_DISPATCH_DEFINE(name, ...) decltype(&::gl##name) objectgl_gl##name = &::gl##name;
+OBJECTGL_GL_TRACED_CORE_CALLS(OBJECTGL_GL_DISPATCH_DEFINE)
+#undef OBJECTGL_GL_DISPATCH_DEFINE
+#define OBJECTGL_GL_DISPATCH_CUSTOM_DEFINE(name) decltype(&::gl##name) objectgl_gl##name = &::gl##name;
+OBJECTGL_GL_TRACED_CORE_CUSTOM_CALLS(OBJECTGL_GL_DISPATCH_CUSTOM_DEFINE)
+OBJECTGL_GL_UNTRACED_CORE_CALLS(OBJECTGL_GL_DISPATCH_CUSTOM_DEFINE)
+#undef OBJECTGL_GL_DISPATCH_CUSTOM_DEFINE
+
+
+//---------------------------------------------------------------------------
+// The count of calls of the function pointed to by a dispatch function pointer.
+template<auto POINTER>
+struct GLBackendCounter {
+    static inline uint64_t count = 0;
+};
+
+
+// The OpenGL entry point of a dispatch function pointer while another backend is set.
+template<auto POINTER>
+struct GLBackendReal {
+    static inline remove_pointer_t<decltype(POINTER)> function = NULL;
+};
+
+
+// The name and the counter of each function of the dispatch table.
+struct GLBackendEntry {
+    const char* name;
+    uint64_t*   count;
+};
+
+
+//---------------------------------------------------------------------------
+#define OBJECTGL_GL_BACKEND_GLEW_ENTRY(name, ...) { "gl" #name, &GLBackendCounter<&__glew##name>::count },
+#define OBJECTGL_GL_BACKEND_GLEW_CUSTOM_ENTRY(name) { "gl" #name, &GLBackendCounter<&__glew##name>::count },
+#define OBJECTGL_GL_BACKEND_CORE_ENTRY(name, ...) { "gl" #name, &GLBackendCounter<&objectgl_gl##name>::count },
+#define OBJECTGL_GL_BACKEND_CORE_CUSTOM_ENTRY(name) { "gl" #name, &GLBackendCounter<&objectgl_gl##name>::count },
+static const GLBackendEntry                 entries[] = {
+    OBJECTGL_GL_TRACED_GLEW_CALLS(OBJECTGL_GL_BACKEND_GLEW_ENTRY)
+    OBJECTGL_GL_TRACED_UNIFORM_CALLS(OBJECTGL_GL_BACKEND_GLEW_ENTRY)
+    OBJECTGL_GL_TRACED_UNIFORM_MATRIX_CALLS(OBJECTGL_GL_BACKEND_GLEW_ENTRY)
+    OBJECTGL_GL_TRACED_CUSTOM_CALLS(OBJECTGL_GL_BACKEND_GLEW_CUSTOM_ENTRY)
+    OBJECTGL_GL_UNTRACED_GLEW_CALLS(OBJECTGL_GL_BACKEND_GLEW_CUSTOM_ENTRY)
+    OBJECTGL_GL_TRACED_CORE_CALLS(OBJECTGL_GL_BACKEND_CORE_ENTRY)
+    OBJECTGL_GL_TRACED_CORE_CUSTOM_CALLS(OBJECTGL_GL_BACKEND_CORE_CUSTOM_ENTRY)
+    OBJECTGL_GL_UNTRACED_CORE_CALLS(OBJECTGL_GL_BACKEND_CORE_CUSTOM_ENTRY)
+};
+#undef OBJECTGL_GL_BACKEND_CORE_CUSTOM_ENTRY
+#undef OBJECTGL_GL_BACKEND_CORE_ENTRY
+#undef OBJECTGL_GL_BACKEND_GLEW_CUSTOM_ENTRY
+#undef OBJECTGL_GL_BACKEND_GLEW_ENTRY
+
+// the GLEW flags of the versions and extensions checked by ObjectGL, all set by the mock backend
+#define OBJECTGL_GL_BACKEND_VERSION_FLAG(major, minor) &__GLEW_VERSION_##major##_##minor,
+#define OBJECTGL_GL_BACKEND_EXTENSION_FLAG(name) &__GLEW_##name,
+static GLboolean* const                     mocked_flags[] = {
+    OBJECTGL_GL_CHECKED_VERSIONS(OBJECTGL_GL_BACKEND_VERSION_FLAG)
+    OBJECTGL_GL_CHECKED_EXTENSIONS(OBJECTGL_GL_BACKEND_EXTENSION_FLAG)
+};
+#undef OBJECTGL_GL_BACKEND_EXTENSION_FLAG
+#undef OBJECTGL_GL_BACKEND_VERSION_FLAG
+static const size_t                         MOCKED_FLAGS_COUNT = sizeof(mocked_flags) / sizeof(mocked_flags[0]);
+static GLboolean                            real_flags[MOCKED_FLAGS_COUNT];
+
+static uint64_t                             errors_count = 0;
+
+static GLuint                               mock_names = 0;                 // the last name returned by the mock backend.
+static uintptr_t                            mock_syncs = 0;                 // the last sync object returned by the mock backend.
+static GLenum                               mock_subroutines_stage = GL_NONE;
+static GLint                                mock_subroutines_uniforms = 0;
+static GLint                                mock_subroutines_functions = 0;
+static GLenum                               mock_uniforms_type = GL_NONE;
+static GLint                                mock_uniforms_count = 0;
+static GLint                                mock_uniforms_array_size = 1;
+static unordered_map<uint64_t, vector<unsigned char>> mock_mappings;        // the mapped memory, by buffer name or by target (above 32 bits).
+
+static const GLint                          MOCK_MAX_NAME_LENGTH = 16;
+static const GLint                          MOCK_PROGRAM_BINARY_LENGTH = 64;
+static const GLenum                         MOCK_PROGRAM_BINARY_FORMAT = 0x4d4f434b;  // i.e. "MOCK"
+
+GLBackend::Type GLBackend::prvt_type = GLBackend::REAL;
+
+
+//---------------------------------------------------------------------------
+// Reports the OpenGL errors raised by the function of a counter.
+static void check_errors(const uint64_t* count)
+{
+    for (GLenum error = ::glGetError(); error != GL_NO_ERROR; error = ::glGetError()) {
+        const char* name = "?";
+        for (const GLBackendEntry& entry : entries)
+            if (entry.count == count) {
+                name = entry.name;
+                break;
+            }
+        char code[16];
+        snprintf(code, sizeof(code), "0x%04X", unsigned(error));
+        cerr << "!!! " << name << "(): OpenGL error " << code << endl;
+        ++errors_count;
+    }
+}
+
+
+//---------------------------------------------------------------------------
+// The validating wrapper of the calls.
+template<auto POINTER>
+struct GLBackendValidating;
+
+template<typename R, typename... Args, R (GLAPIENTRY** POINTER)(Args...)>
+struct GLBackendValidating<POINTER> {
+    static R GLAPIENTRY call(Args... args) {
+        ++GLBackendCounter<POINTER>::count;
+        if constexpr (is_void<R>::value) {
+            GLBackendReal<POINTER>::function(args...);
+            check_errors(&GLBackendCounter<POINTER>::count);
+        }
+        else {
+            const R result = GLBackendReal<POINTER>::function(args...);
+            check_errors(&GLBackendCounter<POINTER>::count);
+            return result;
+        }
+    }
+};
+
+
+//---------------------------------------------------------------------------
+// The mock of the calls: counts them, then answers them.
+template<auto POINTER>
+struct GLBackendMock;
+
+template<typename R, typename... Args, R (GLAPIENTRY** POINTER)(Args...)>
+struct GLBackendMock<POINTER> {
+    static R GLAPIENTRY call(Args... args) {
+        ++GLBackendCounter<POINTER>::count;
+        return answer(args...);
+    }
+
+    // does nothing and returns 0, unless specialized below.
+    static R answer(Args...) {
+        return R();
+    }
+};
+
+
+//---------------------------------------------------------------------------
+// The answers of the mock backend to the calls that return something.
+static void mock_names_creation(const GLsizei n, GLuint* names)
+{
+    for (GLsizei i = 0; i < n; ++i)
+        names[i] = ++mock_names;
+}
+
+
+static void* mock_map(const uint64_t key, const GLsizeiptr length)
+{
+    vector<unsigned char>& memory = mock_mappings[key];
+    if (memory.size() < size_t(length))
+        memory.resize(size_t(length));
+    return memory.data();
+}
+
+
+static const uint64_t mock_target_key(const GLenum target)
+{
+    return uint64_t(target) << 32;
+}
+
+
+static void mock_log(const GLsizei buffer_size, GLsizei* length, GLchar* log)
+{
+    if (length != NULL)
+        *length = 0;
+    if (buffer_size > 0 && log != NULL)
+        log[0] = '\0';
+}
+
+
+static void mock_indexed_name(const char* prefix, const GLuint index, const GLsizei buffer_size, GLsizei* length, GLchar* name)
+{
+    const int written = buffer_size > 0 ? snprintf(name, size_t(buffer_size), "%s%u", prefix, index) : 0;
+    if (length != NULL)
+        *length = GLsizei(min(written, int(buffer_size) - 1));
+}
+
+
+static const GLenum mock_subroutine_uniform_interface(const GLenum shader_type)
+{
+    switch (shader_type) {
+    case GL_VERTEX_SHADER:          return GL_VERTEX_SUBROUTINE_UNIFORM;
+    case GL_TESS_CONTROL_SHADER:    return GL_TESS_CONTROL_SUBROUTINE_UNIFORM;
+    case GL_TESS_EVALUATION_SHADER: return GL_TESS_EVALUATION_SUBROUTINE_UNIFORM;
+    case GL_GEOMETRY_SHADER:        return GL_GEOMETRY_SUBROUTINE_UNIFORM;
+    case GL_FRAGMENT_SHADER:        return GL_FRAGMENT_SUBROUTINE_UNIFORM;
+    case GL_COMPUTE_SHADER:         return GL_COMPUTE_SUBROUTINE_UNIFORM;
+    default:                        return GL_NONE;
+    }
+}
+
+
+//--- names -----------------------------------------------------------------
+template<>
+void GLBackendMock<&__glewCreateBuffers>::answer(GLsizei n, GLuint* names)
+{
+    mock_names_creation(n, names);
+}
+
+
+template<>
+GLuint GLBackendMock<&__glewCreateProgram>::answer()
+{
+    return ++mock_names;
+}
+
+
+template<>
+void GLBackendMock<&__glewCreateSamplers>::answer(GLsizei n, GLuint* names)
+{
+    mock_names_creation(n, names);
+}
+
+
+template<>
+GLuint GLBackendMock<&__glewCreateShader>::answer(GLenum)
+{
+    return ++mock_names;
+}
+
+
+template<>
+void GLBackendMock<&__glewCreateTextures>::answer(GLenum, GLsizei n, GLuint* names)
+{
+    mock_names_creation(n, names);
+}
+
+
+template<>
+void GLBackendMock<&__glewCreateVertexArrays>::answer(GLsizei n, GLuint* names)
+{
+    mock_names_creation(n, names);
+}
+
+
+template<>
+void GLBackendMock<&__glewGenBuffers>::answer(GLsizei n, GLuint* names)
+{
+    mock_names_creation(n, names);
+}
+
+
+template<>
+void GLBackendMock<&__glewGenQueries>::answer(GLsizei n, GLuint* names)
+{
+    mock_names_creation(n, names);
+}
+
+
+template<>
+void GLBackendMock<&__glewGenVertexArrays>::answer(GLsizei n, GLuint* names)
+{
+    mock_names_creation(n, names);
+}
+
+
+template<>
+GLboolean GLBackendMock<&__glewIsBuffer>::answer(GLuint)
+{
+    return GL_TRUE;
+}
+
+
+template<>
+GLboolean GLBackendMock<&__glewIsProgram>::answer(GLuint)
+{
+    return GL_TRUE;
+}
+
+
+template<>
+GLboolean GLBackendMock<&__glewIsShader>::answer(GLuint)
+{
+    return GL_TRUE;
+}
+
+
+template<>
+GLboolean GLBackendMock<&__glewIsVertexArray>::answer(GLuint)
+{
+    return GL_TRUE;
+}
+
+
+//--- buffers and sync objects ----------------------------------------------
+template<>
+void GLBackendMock<&__glewDeleteBuffers>::answer(GLsizei n, const GLuint* names)
+{
+    for (GLsizei i = 0; i < n; ++i)
+        mock_mappings.erase(uint64_t(names[i]));
+}
+
+
+template<>
+void* GLBackendMock<&__glewMapBufferRange>::answer(GLenum target, GLintptr, GLsizeiptr length, GLbitfield)
+{
+    return mock_map(mock_target_key(target), length);
+}
+
+
+template<>
+void* GLBackendMock<&__glewMapNamedBufferRange>::answer(GLuint buffer, GLintptr, GLsizeiptr length, GLbitfield)
+{
+    return mock_map(uint64_t(buffer), length);
+}
+
+
+template<>
+GLboolean GLBackendMock<&__glewUnmapBuffer>::answer(GLenum target)
+{
+    mock_mappings.erase(mock_target_key(target));
+    return GL_TRUE;
+}
+
+
+template<>
+GLboolean GLBackendMock<&__glewUnmapNamedBuffer>::answer(GLuint buffer)
+{
+    mock_mappings.erase(uint64_t(buffer));
+    return GL_TRUE;
+}
+
+
+template<>
+void GLBackendMock<&__glewGetBufferSubData>::answer(GLenum, GLintptr, GLsizeiptr size, void* data)
+{
+    memset(data, 0, size_t(size));
+}
+
+
+template<>
+void GLBackendMock<&__glewGetNamedBufferSubData>::answer(GLuint, GLintptr, GLsizeiptr size, void* data)
+{
+    memset(data, 0, size_t(size));
+}
+
+
+template<>
+GLsync GLBackendMock<&__glewFenceSync>::answer(GLenum, GLbitfield)
+{
+    return reinterpret_cast<GLsync>(++mock_syncs);
+}
+
+
+template<>
+GLenum GLBackendMock<&__glewClientWaitSync>::answer(GLsync, GLbitfield, GLuint64)
+{
+    return GL_ALREADY_SIGNALED;
+}
+
+
+//--- shaders and programs --------------------------------------------------
+template<>
+void GLBackendMock<&__glewGetShaderiv>::answer(GLuint, GLenum pname, GLint* param)
+{
+    *param = (pname == GL_COMPILE_STATUS || pname == GL_COMPLETION_STATUS_KHR) ? GL_TRUE : 0;
+}
+
+
+template<>
+void GLBackendMock<&__glewGetShaderInfoLog>::answer(GLuint, GLsizei buffer_size, GLsizei* length, GLchar* log)
+{
+    mock_log(buffer_size, length, log);
+}
+
+
+template<>
+void GLBackendMock<&__glewGetProgramiv>::answer(GLuint, GLenum pname, GLint* param)
+{
+    switch (pname) {
+    case GL_LINK_STATUS:
+    case GL_VALIDATE_STATUS:
+    case GL_COMPLETION_STATUS_KHR:
+        *param = GL_TRUE;
+        break;
+    case GL_COMPUTE_WORK_GROUP_SIZE:
+        param[0] = param[1] = param[2] = 1;
+        break;
+    case GL_PROGRAM_BINARY_LENGTH:
+        *param = MOCK_PROGRAM_BINARY_LENGTH;
+        break;
+    default:
+        *param = 0;
+    }
+}
+
+
+template<>
+void GLBackendMock<&__glewGetProgramInfoLog>::answer(GLuint, GLsizei buffer_size, GLsizei* length, GLchar* log)
+{
+    mock_log(buffer_size, length, log);
+}
+
+
+template<>
+void GLBackendMock<&__glewGetProgramBinary>::answer(GLuint, GLsizei buffer_size, GLsizei* length, GLenum* binary_format, void* binary)
+{
+    const GLsizei binary_length = min(buffer_size, MOCK_PROGRAM_BINARY_LENGTH);
+    memset(binary, 0, size_t(binary_length));
+    if (length != NULL)
+        *length = binary_length;
+    *binary_format = MOCK_PROGRAM_BINARY_FORMAT;
+}
+
+
+template<>
+void GLBackendMock<&__glewGetProgramInterfaceiv>::answer(GLuint, GLenum program_interface, GLenum pname, GLint* params)
+{
+    const bool subroutines = mock_subroutines_uniforms > 0 && program_interface == mock_subroutine_uniform_interface(mock_subroutines_stage);
+    const bool uniforms = mock_uniforms_count > 0 && program_interface == GL_UNIFORM;
+    if (subroutines && pname == GL_ACTIVE_RESOURCES)
+        *params = mock_subroutines_uniforms;
+    else if (uniforms && pname == GL_ACTIVE_RESOURCES)
+        *params = mock_uniforms_count;
+    else if ((subroutines || uniforms) && pname == GL_MAX_NAME_LENGTH)
+        *params = MOCK_MAX_NAME_LENGTH;
+    else
+        *params = 0;
+}
+
+
+template<>
+void GLBackendMock<&__glewGetProgramResourceiv>::answer(GLuint, GLenum program_interface, GLuint index, GLsizei props_count, const GLenum* props, GLsizei buffer_size, GLsizei* length, GLint* params)
+{
+    const bool uniform = program_interface == GL_UNIFORM && GLint(index) < mock_uniforms_count;
+    const GLsizei count = min(props_count, buffer_size);
+    for (GLsizei i = 0; i < count; ++i) {
+        params[i] = 0;
+        if (uniform)
+            switch (props[i]) {
+            case GL_TYPE:           params[i] = GLint(mock_uniforms_type);                  break;
+            case GL_LOCATION:       params[i] = GLint(index) * mock_uniforms_array_size;    break;
+            case GL_ARRAY_SIZE:     params[i] = mock_uniforms_array_size;                   break;
+            case GL_BLOCK_INDEX:
+            case GL_OFFSET:
+            case GL_ARRAY_STRIDE:
+            case GL_MATRIX_STRIDE:  params[i] = -1;                                         break;
+            }
+    }
+    if (length != NULL)
+        *length = count;
+}
+
+
+template<>
+void GLBackendMock<&__glewGetProgramResourceName>::answer(GLuint, GLenum program_interface, GLuint index, GLsizei buffer_size, GLsizei* length, GLchar* name)
+{
+    if (program_interface == GL_UNIFORM && GLint(index) < mock_uniforms_count)
+        mock_indexed_name("value", index, buffer_size, length, name);
+    else
+        mock_log(buffer_size, length, name);
+}
+
+
+//--- subroutines -----------------------------------------------------------
+template<>
+void GLBackendMock<&__glewGetProgramStageiv>::answer(GLuint, GLenum shader_type, GLenum pname, GLint* values)
+{
+    *values = 0;
+    if (shader_type != mock_subroutines_stage)
+        return;
+    switch (pname) {
+    case GL_ACTIVE_SUBROUTINE_UNIFORM_LOCATIONS:
+    case GL_ACTIVE_SUBROUTINE_UNIFORMS:
+        *values = mock_subroutines_uniforms;
+        break;
+    case GL_ACTIVE_SUBROUTINES:
+        *values = mock_subroutines_functions;
+        break;
+    case GL_ACTIVE_SUBROUTINE_MAX_LENGTH:
+    case GL_ACTIVE_SUBROUTINE_UNIFORM_MAX_LENGTH:
+        *values = MOCK_MAX_NAME_LENGTH;
+        break;
+    }
+}
+
+
+template<>
+void GLBackendMock<&__glewGetActiveSubroutineName>::answer(GLuint, GLenum, GLuint index, GLsizei buffer_size, GLsizei* length, GLchar* name)
+{
+    mock_indexed_name("function", index, buffer_size, length, name);
+}
+
+
+template<>
+void GLBackendMock<&__glewGetActiveSubroutineUniformName>::answer(GLuint, GLenum, GLuint index, GLsizei buffer_size, GLsizei* length, GLchar* name)
+{
+    mock_indexed_name("uniform", index, buffer_size, length, name);
+}
+
+
+template<>
+void GLBackendMock<&__glewGetActiveSubroutineUniformiv>::answer(GLuint, GLenum, GLuint, GLenum pname, GLint* values)
+{
+    switch (pname) {
+    case GL_NUM_COMPATIBLE_SUBROUTINES:
+        *values = mock_subroutines_functions;
+        break;
+    case GL_COMPATIBLE_SUBROUTINES:
+        for (GLint i = 0; i < mock_subroutines_functions; ++i)
+            values[i] = i;
+        break;
+    case GL_UNIFORM_SIZE:
+        *values = 1;
+        break;
+    default:
+        *values = 0;
+    }
+}
+
+
+template<>
+GLint GLBackendMock<&__glewGetSubroutineUniformLocation>::answer(GLuint, GLenum shader_type, const GLchar* name)
+{
+    if (shader_type != mock_subroutines_stage || strncmp(name, "uniform", 7) != 0)
+        return -1;
+    const GLint location = GLint(atoi(name + 7));
+    return location < mock_subroutines_uniforms ? location : -1;
+}
+
+
+//--- queries ---------------------------------------------------------------
+template<>
+void GLBackendMock<&__glewGetQueryObjectiv>::answer(GLuint, GLenum pname, GLint* params)
+{
+    *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+
+
+template<>
+void GLBackendMock<&__glewGetQueryObjectui64v>::answer(GLuint, GLenum, GLuint64* params)
+{
+    *params = 0;
+}
+
+
+template<>
+void GLBackendMock<&__glewGetIntegeri_v>::answer(GLenum target, GLuint, GLint* data)
+{
+    *data = target == GL_MAX_COMPUTE_WORK_GROUP_COUNT ? 65535 : 0;
+}
+
+
+template<>
+void GLBackendMock<&objectgl_glGetIntegerv>::answer(GLenum pname, GLint* data)
+{
+    switch (pname) {
+    case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:
+    case GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT:
+    case GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT:
+        *data = 256;
+        break;
+    case GL_NUM_PROGRAM_BINARY_FORMATS:
+        *data = 1;
+        break;
+    default:
+        *data = 0;
+    }
+}
+
+
+template<>
+const GLubyte* GLBackendMock<&objectgl_glGetString>::answer(GLenum)
+{
+    return reinterpret_cast<const GLubyte*>("ObjectGL mock");
+}
+
+
+//---------------------------------------------------------------------------
+// Dispatches the calls of one function pointer to a backend.
+template<auto POINTER>
+static void dispatch(const GLBackend::Type type)
+{
+    switch (type) {
+    case GLBackend::REAL:
+        *POINTER = GLBackendReal<POINTER>::function;
+        break;
+    case GLBackend::MOCK:
+        GLBackendReal<POINTER>::function = *POINTER;
+        *POINTER = &GLBackendMock<POINTER>::call;
+        break;
+    case GLBackend::VALIDATING:
+        GLBackendReal<POINTER>::function = *POINTER;
+        if (*POINTER != NULL)
+            *POINTER = &GLBackendValidating<POINTER>::call;
+        break;
+    }
+}
+
+
+static void dispatch_all(const GLBackend::Type type)
+{
+#define OBJECTGL_GL_BACKEND_DISPATCH(name, ...) dispatch<&__glew##name>(type);
+    OBJECTGL_GL_TRACED_GLEW_CALLS(OBJECTGL_GL_BACKEND_DISPATCH)
+    OBJECTGL_GL_TRACED_UNIFORM_CALLS(OBJECTGL_GL_BACKEND_DISPATCH)
+    OBJECTGL_GL_TRACED_UNIFORM_MATRIX_CALLS(OBJECTGL_GL_BACKEND_DISPATCH)
+#undef OBJECTGL_GL_BACKEND_DISPATCH
+#define OBJECTGL_GL_BACKEND_DISPATCH(name) dispatch<&__glew##name>(type);
+    OBJECTGL_GL_TRACED_CUSTOM_CALLS(OBJECTGL_GL_BACKEND_DISPATCH)
+    OBJECTGL_GL_UNTRACED_GLEW_CALLS(OBJECTGL_GL_BACKEND_DISPATCH)
+#undef OBJECTGL_GL_BACKEND_DISPATCH
+#define OBJECTGL_GL_BACKEND_DISPATCH(name, ...) dispatch<&objectgl_gl##name>(type);
+    OBJECTGL_GL_TRACED_CORE_CALLS(OBJECTGL_GL_BACKEND_DISPATCH)
+#undef OBJECTGL_GL_BACKEND_DISPATCH
+#define OBJECTGL_GL_BACKEND_DISPATCH(name) dispatch<&objectgl_gl##name>(type);
+    OBJECTGL_GL_TRACED_CORE_CUSTOM_CALLS(OBJECTGL_GL_BACKEND_DISPATCH)
+    OBJECTGL_GL_UNTRACED_CORE_CALLS(OBJECTGL_GL_BACKEND_DISPATCH)
+#undef OBJECTGL_GL_BACKEND_DISPATCH
+}
+
+
+//---------------------------------------------------------------------------
+bool GLBackend::set(const Type type)
+{
+    if (type == prvt_type)
+        return true;
+    if (GLTrace::is_capturing()) {
+        cerr << "!!! OpenGL backend cannot be changed while capturing a trace" << endl;
+        return false;
+    }
+
+    // always through the real backend, so that the saved entry points are the real ones
+    if (prvt_type != REAL) {
+        dispatch_all(REAL);
+        if (prvt_type == MOCK) {
+            for (size_t i = 0; i < MOCKED_FLAGS_COUNT; ++i)
+                *mocked_flags[i] = real_flags[i];
+            mock_mappings.clear();
+        }
+    }
+
+    if (type != REAL) {
+        dispatch_all(type);
+        if (type == MOCK) {
+            for (size_t i = 0; i < MOCKED_FLAGS_COUNT; ++i) {
+                real_flags[i] = *mocked_flags[i];
+                *mocked_flags[i] = GL_TRUE;
+            }
+        }
+    }
+
+    prvt_type = type;
+    return true;
+}
+
+
+uint64_t GLBackend::get_calls_count()
+{
+    uint64_t count = 0;
+    for (const GLBackendEntry& entry : entries)
+        count += *entry.count;
+    return count;
+}
+
+
+uint64_t GLBackend::get_calls_count(const string& function_name)
+{
+    for (const GLBackendEntry& entry : entries)
+        if (function_name == entry.name)
+            return *entry.count;
+    return 0;
+}
+
+
+void GLBackend::get_calls_counts(vector<pair<string, uint64_t>>& counts)
+{
+    counts.clear();
+    for (const GLBackendEntry& entry : entries)
+        if (*entry.count > 0)
+            counts.emplace_back(entry.name, *entry.count);
+    sort(counts.begin(), counts.end());
+}
+
+
+void GLBackend::reset_counts()
+{
+    for (const GLBackendEntry& entry : entries)
+        *entry.count = 0;
+    errors_count = 0;
+}
+
+
+uint64_t GLBackend::get_errors_count()
+{
+    return errors_count;
+}
+
+
+void GLBackend::set_mock_subroutines(const GLenum shader_type, const GLint uniforms_count, const GLint functions_count)
+{
+    mock_subroutines_stage = uniforms_count > 0 ? shader_type : GL_NONE;
+    mock_subroutines_uniforms = max(uniforms_count, 0);
+    mock_subroutines_functions = max(functions_count, 0);
+}
+
+
+void GLBackend::set_mock_uniforms(const GLenum type, const GLint uniforms_count, const GLint array_size)
+{
+    mock_uniforms_type = uniforms_count > 0 ? type : GL_NONE;
+    mock_uniforms_count = max(uniforms_count, 0);
+    mock_uniforms_array_size = max(array_size, 1);
+}
@@ -0,0 +1,500 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(__linux__)
+#include <dlfcn.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "context/gl_context.h"
+#include "trace/gl_dispatch.h"
+
+using namespace std;
+
+
+#if defined(__linux__)
+//---------------------------------------------------------------------------
+// The subset of GL/osmesa.h used here: libOSMesa is loaded at run time, and its headers are not needed.
+typedef struct osmesa_context*  OSMesaContext;
+typedef void (*OSMesaProc)();
+typedef OSMesaContext (GLAPIENTRY* OSMesaCreateContextAttribsProc)(const int* attributes, OSMesaContext shared);
+typedef GLboolean (GLAPIENTRY* OSMesaMakeCurrentProc)(OSMesaContext context, void* buffer, GLenum type, GLsizei width, GLsizei height);
+typedef void (GLAPIENTRY* OSMesaDestroyContextProc)(OSMesaContext context);
+typedef OSMesaProc (GLAPIENTRY* OSMesaGetProcAddressProc)(const char* name);
+
+static const int                            OSMESA_RGBA = GL_RGBA;
+static const int                            OSMESA_FORMAT = 0x22;
+static const int                            OSMESA_DEPTH_BITS = 0x30;
+static const int                            OSMESA_STENCIL_BITS = 0x31;
+static const int                            OSMESA_ACCUM_BITS = 0x32;
+static const int                            OSMESA_PROFILE = 0x33;
+static const int                            OSMESA_CORE_PROFILE = 0x34;
+static const int                            OSMESA_COMPAT_PROFILE = 0x35;
+static const int                            OSMESA_CONTEXT_MAJOR_VERSION = 0x36;
+static const int                            OSMESA_CONTEXT_MINOR_VERSION = 0x37;
+
+static const char* const                    OSMESA_LIBRARIES[] = { "libOSMesa.so.8", "libOSMesa.so.6", "libOSMesa.so" };
+
+static void*                                osmesa_library = NULL;
+static OSMesaCreateContextAttribsProc       osmesa_create_context_attribs = NULL;
+static OSMesaMakeCurrentProc                osmesa_make_current = NULL;
+static OSMesaDestroyContextProc             osmesa_destroy_context = NULL;
+static OSMesaGetProcAddressProc             osmesa_get_proc_address = NULL;
+
+
+//---------------------------------------------------------------------------
+static const EGLint                         MAX_EGL_DEVICES = 16;
+
+static mutex                                displays_mutex;
+static unordered_map<EGLDisplay, int>       displays_references;    // the initialized EGL displays, with their counts of contexts.
+#endif
+
+static mutex                                entry_points_mutex;
+static bool                                 entry_points_loaded = false;
+static thread_local GLContext*              current_context = NULL;
+
+
+#if defined(__linux__)
+//---------------------------------------------------------------------------
+// Returns true if a space-separated list of extensions contains one.
+static bool has_extension(const char* extensions, const char* extension)
+{
+    if (extensions == NULL)
+        return false;
+    const size_t length = strlen(extension);
+    for (const char* start = strstr(extensions, extension); start != NULL; start = strstr(start + length, extension))
+        if ((start == extensions || start[-1] == ' ') && (start[length] == ' ' || start[length] == '\0'))
+            return true;
+    return false;
+}
+
+
+static void release_display(EGLDisplay display)
+{
+    lock_guard<mutex> lock(displays_mutex);
+    if (--displays_references[display] <= 0) {
+        displays_references.erase(display);
+        eglTerminate(display);
+    }
+}
+
+
+static bool load_osmesa()
+{
+    static mutex osmesa_mutex;
+    lock_guard<mutex> lock(osmesa_mutex);
+    if (osmesa_library != NULL)
+        return true;
+
+    for (const char* library_name : OSMESA_LIBRARIES)
+        if ((osmesa_library = dlopen(library_name, RTLD_NOW | RTLD_LOCAL)) != NULL)
+            break;
+    if (osmesa_library == NULL)
+        return false;
+
+    osmesa_create_context_attribs = reinterpret_cast<OSMesaCreateContextAttribsProc>(dlsym(osmesa_library, "OSMesaCreateContextAttribs"));
+    osmesa_make_current = reinterpret_cast<OSMesaMakeCurrentProc>(dlsym(osmesa_library, "OSMesaMakeCurrent"));
+    osmesa_destroy_context = reinterpret_cast<OSMesaDestroyContextProc>(dlsym(osmesa_library, "OSMesaDestroyContext"));
+    osmesa_get_proc_address = reinterpret_cast<OSMesaGetProcAddressProc>(dlsym(osmesa_library, "OSMesaGetProcAddress"));
+    if (osmesa_create_context_attribs == NULL || osmesa_make_current == NULL || osmesa_destroy_context == NULL || osmesa_get_proc_address == NULL) {
+        cerr << "!!! libOSMesa is too old: OSMesaCreateContextAttribs() is missing" << endl;
+        dlclose(osmesa_library);
+        osmesa_library = NULL;
+        return false;
+    }
+    return true;
+}
+
+
+//---------------------------------------------------------------------------
+// Loads the entry points of the tables of trace/gl_calls.h from OSMesa, and sets the GLEW flags checked by ObjectGL.
+static void load_osmesa_entry_points()
+{
+#define OBJECTGL_GL_CONTEXT_LOAD(name, ...) \
+    __glew##name = reinterpret_cast<decltype(__glew##name)>(osmesa_get_proc_address("gl" #name));
+    OBJECTGL_GL_TRACED_GLEW_CALLS(OBJECTGL_GL_CONTEXT_LOAD)
+    OBJECTGL_GL_TRACED_UNIFORM_CALLS(OBJECTGL_GL_CONTEXT_LOAD)
+    OBJECTGL_GL_TRACED_UNIFORM_MATRIX_CALLS(OBJECTGL_GL_CONTEXT_LOAD)
+#undef OBJECTGL_GL_CONTEXT_LOAD
+#define OBJECTGL_GL_CONTEXT_LOAD(name) \
+    __glew##name = reinterpret_cast<decltype(__glew##name)>(osmesa_get_proc_address("gl" #name));
+    OBJECTGL_GL_TRACED_CUSTOM_CALLS(OBJECTGL_GL_CONTEXT_LOAD)
+    OBJECTGL_GL_UNTRACED_GLEW_CALLS(OBJECTGL_GL_CONTEXT_LOAD)
+#undef OBJECTGL_GL_CONTEXT_LOAD
+#define OBJECTGL_GL_CONTEXT_LOAD(name, ...) \
+    objectgl_gl##name = reinterpret_cast<decltype(objectgl_gl##name)>(osmesa_get_proc_address("gl" #name));
+    OBJECTGL_GL_TRACED_CORE_CALLS(OBJECTGL_GL_CONTEXT_LOAD)
+#undef OBJECTGL_GL_CONTEXT_LOAD
+#define OBJECTGL_GL_CONTEXT_LOAD(name) \
+    objectgl_gl##name = reinterpret_cast<decltype(objectgl_gl##name)>(osmesa_get_proc_address("gl" #name));
+    OBJECTGL_GL_TRACED_CORE_CUSTOM_CALLS(OBJECTGL_GL_CONTEXT_LOAD)
+    OBJECTGL_GL_UNTRACED_CORE_CALLS(OBJECTGL_GL_CONTEXT_LOAD)
+#undef OBJECTGL_GL_CONTEXT_LOAD
+
+    int major = 0, minor = 0;
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    if (version == NULL || sscanf(version, "%d.%d", &major, &minor) != 2)
+        major = minor = 0;
+#define OBJECTGL_GL_CONTEXT_VERSION_FLAG(flag_major, flag_minor) \
+    __GLEW_VERSION_##flag_major##_##flag_minor = (major > flag_major || (major == flag_major && minor >= flag_minor)) ? GL_TRUE : GL_FALSE;
+    OBJECTGL_GL_CHECKED_VERSIONS(OBJECTGL_GL_CONTEXT_VERSION_FLAG)
+#undef OBJECTGL_GL_CONTEXT_VERSION_FLAG
+
+    unordered_set<string> extensions;
+    GLint extensions_count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensions_count);
+    for (GLint i = 0; i < extensions_count && glGetStringi != NULL; ++i)
+        extensions.insert(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, GLuint(i))));
+#define OBJECTGL_GL_CONTEXT_EXTENSION_FLAG(name) \
+    __GLEW_##name = extensions.count("GL_" #name) > 0 ? GL_TRUE : GL_FALSE;
+    OBJECTGL_GL_CHECKED_EXTENSIONS(OBJECTGL_GL_CONTEXT_EXTENSION_FLAG)
+#undef OBJECTGL_GL_CONTEXT_EXTENSION_FLAG
+}
+#endif
+
+
+//---------------------------------------------------------------------------
+// Loads the OpenGL entry points, once the first context is current.
+static bool load_entry_points(const GLContext::Platform platform)
+{
+    lock_guard<mutex> lock(entry_points_mutex);
+    if (entry_points_loaded)
+        return true;
+
+#if defined(__linux__)
+    if (platform == GLContext::PLATFORM_OSMESA)
+        load_osmesa_entry_points();
+    else
+#endif
+    {
+        glewExperimental = GL_TRUE;
+        const GLenum status = glewInit();
+        // GLEW built for GLX reports the missing GLX display, once OpenGL entry points are loaded
+        if (status != GLEW_OK && status != GLEW_ERROR_NO_GLX_DISPLAY) {
+            cerr << "!!! failed initializing GLEW: " << glewGetErrorString(status) << endl;
+            return false;
+        }
+    }
+    entry_points_loaded = true;
+    return true;
+}
+
+
+//---------------------------------------------------------------------------
+GLContext::GLContext(const Config& config)
+    : prvt_platform(PLATFORM_ANY),
+      prvt_config(config),
+      prvt_display(NULL),
+      prvt_egl_config(NULL),
+      prvt_surface(NULL),
+      prvt_context(NULL),
+      prvt_width(config.width > 0 && config.height > 0 ? config.width : 0),
+      prvt_height(config.width > 0 && config.height > 0 ? config.height : 0)
+{
+#if defined(__linux__)
+    static const Platform PLATFORMS[] = { PLATFORM_EGL_DEVICE, PLATFORM_EGL_SURFACELESS, PLATFORM_OSMESA };
+    for (const Platform platform : PLATFORMS) {
+        if (config.platform != PLATFORM_ANY && config.platform != platform)
+            continue;
+        prvt_platform = platform;
+        if (platform == PLATFORM_OSMESA ? prvt_create_osmesa(NULL) : prvt_create_egl(platform, NULL))
+            break;
+    }
+    if (!is_ok()) {
+        cerr << "!!! no headless OpenGL " << config.major_version << "." << config.minor_version << " context could be created" << endl;
+        prvt_platform = config.platform;
+        return;
+    }
+    if (!make_current() || !load_entry_points(prvt_platform))
+        prvt_destroy();
+#else
+    cerr << "!!! headless OpenGL contexts are available on Linux only" << endl;
+#endif
+}
+
+
+GLContext::GLContext(GLContext& shared, const GLsizei width, const GLsizei height)
+    : prvt_platform(shared.prvt_platform),
+      prvt_config(shared.prvt_config),
+      prvt_display(NULL),
+      prvt_egl_config(NULL),
+      prvt_surface(NULL),
+      prvt_context(NULL),
+      prvt_width(width > 0 && height > 0 ? width : 0),
+      prvt_height(width > 0 && height > 0 ? height : 0)
+{
+    prvt_config.width = prvt_width;
+    prvt_config.height = prvt_height;
+    if (!shared.is_ok()) {
+        cerr << "!!! cannot share the objects of a context that has not been created" << endl;
+        return;
+    }
+#if defined(__linux__)
+    if (prvt_platform == PLATFORM_OSMESA)
+        prvt_create_osmesa(&shared);
+    else
+        prvt_create_egl(prvt_platform, &shared);
+#endif
+}
+
+
+GLContext::~GLContext()
+{
+    prvt_destroy();
+}
+
+
+bool GLContext::make_current()
+{
+    if (!is_ok())
+        return false;
+
+    bool ok = false;
+#if defined(__linux__)
+    if (prvt_platform == PLATFORM_OSMESA)
+        ok = osmesa_make_current(static_cast<OSMesaContext>(prvt_context), prvt_color_buffer.data(), GL_UNSIGNED_BYTE,
+                                 max(prvt_width, 1), max(prvt_height, 1)) == GL_TRUE;
+    else
+        ok = eglBindAPI(EGL_OPENGL_API) == EGL_TRUE &&
+             eglMakeCurrent(prvt_display, prvt_surface, prvt_surface, prvt_context) == EGL_TRUE;
+#endif
+    if (!ok) {
+        cerr << "!!! cannot make the OpenGL context current" << endl;
+        return false;
+    }
+
+    current_context = this;
+    GLStateCache::set_current(&prvt_state_cache);
+    return true;
+}
+
+
+void GLContext::done_current()
+{
+    if (current_context != this)
+        return;
+#if defined(__linux__)
+    if (prvt_platform == PLATFORM_OSMESA)
+        osmesa_make_current(NULL, NULL, GL_UNSIGNED_BYTE, 0, 0);
+    else {
+        // releasing applies to the context of the current API of the thread
+        eglBindAPI(EGL_OPENGL_API);
+        eglMakeCurrent(prvt_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+#endif
+    current_context = NULL;
+    GLStateCache::set_current(NULL);
+}
+
+
+const char* GLContext::get_platform_name(const Platform platform)
+{
+    switch (platform) {
+    case PLATFORM_EGL_DEVICE:       return "EGL device";
+    case PLATFORM_EGL_SURFACELESS:  return "EGL surfaceless";
+    case PLATFORM_OSMESA:           return "OSMesa";
+    default:                        return "any";
+    }
+}
+
+
+bool GLContext::read_pixels(vector<unsigned char>& rgba)
+{
+    if (prvt_width == 0 || current_context != this) {
+        cerr << "!!! pixels can only be read from the offscreen default framebuffer of the current context" << endl;
+        return false;
+    }
+    rgba.resize(size_t(prvt_width) * size_t(prvt_height) * 4);
+    glReadPixels(0, 0, prvt_width, prvt_height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    return true;
+}
+
+
+GLContext* GLContext::get_current()
+{
+    return current_context;
+}
+
+
+#if defined(__linux__)
+//---------------------------------------------------------------------------
+bool GLContext::prvt_create_egl(const Platform platform, GLContext* shared)
+{
+    EGLDisplay display = EGL_NO_DISPLAY;
+    if (shared != NULL)
+        display = shared->prvt_display;
+    else {
+        const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display == NULL)
+            return false;
+
+        if (platform == PLATFORM_EGL_DEVICE) {
+            PFNEGLQUERYDEVICESEXTPROC query_devices =
+                reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+            EGLDeviceEXT devices[MAX_EGL_DEVICES];
+            EGLint devices_count = 0;
+            if (!has_extension(client_extensions, "EGL_EXT_platform_device") || query_devices == NULL ||
+                !query_devices(MAX_EGL_DEVICES, devices, &devices_count) || prvt_config.device < 0 || prvt_config.device >= devices_count)
+                return false;
+            display = get_platform_display(EGL_PLATFORM_DEVICE_EXT, devices[prvt_config.device], NULL);
+        }
+        else {
+            if (!has_extension(client_extensions, "EGL_MESA_platform_surfaceless"))
+                return false;
+            display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        }
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+            return false;
+    }
+    {
+        lock_guard<mutex> lock(displays_mutex);
+        ++displays_references[display];
+    }
+    prvt_display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        cerr << "!!! EGL " << get_platform_name(platform) << ": OpenGL is not supported" << endl;
+        prvt_destroy();
+        return false;
+    }
+
+    // a frame buffer configuration is needed for pbuffers, or when contexts cannot be created without any
+    const bool framebuffer = prvt_width > 0;
+    EGLConfig egl_config = EGL_NO_CONFIG_KHR;
+    if (framebuffer || !has_extension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_no_config_context")) {
+        const EGLint attributes[] = {
+            EGL_SURFACE_TYPE, framebuffer ? EGL_PBUFFER_BIT : 0,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_STENCIL_SIZE, 8,
+            EGL_SAMPLE_BUFFERS, prvt_config.samples > 0 ? 1 : 0,
+            EGL_SAMPLES, prvt_config.samples,
+            EGL_NONE
+        };
+        EGLint configs_count = 0;
+        if (!eglChooseConfig(display, attributes, &egl_config, 1, &configs_count) || configs_count == 0) {
+            cerr << "!!! EGL " << get_platform_name(platform) << ": no frame buffer configuration for OpenGL" << (framebuffer ? " pbuffers" : "") << endl;
+            prvt_destroy();
+            return false;
+        }
+    }
+    prvt_egl_config = egl_config;
+
+    const EGLint attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION_KHR, prvt_config.major_version,
+        EGL_CONTEXT_MINOR_VERSION_KHR, prvt_config.minor_version,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, prvt_config.core_profile ? EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR : EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT_KHR,
+        EGL_CONTEXT_FLAGS_KHR, prvt_config.debug ? EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR : 0,
+        EGL_NONE
+    };
+    prvt_context = eglCreateContext(display, egl_config, shared != NULL ? shared->prvt_context : EGL_NO_CONTEXT, attributes);
+    if (prvt_context == EGL_NO_CONTEXT) {
+        cerr << "!!! EGL " << get_platform_name(platform) << ": cannot create an OpenGL " << prvt_config.major_version << "."
+             << prvt_config.minor_version << " context (error 0x" << hex << eglGetError() << dec << ")" << endl;
+        prvt_context = NULL;
+        prvt_destroy();
+        return false;
+    }
+
+    if (framebuffer) {
+        const EGLint surface_attributes[] = { EGL_WIDTH, prvt_width, EGL_HEIGHT, prvt_height, EGL_NONE };
+        prvt_surface = eglCreatePbufferSurface(display, egl_config, surface_attributes);
+        if (prvt_surface == EGL_NO_SURFACE) {
+            cerr << "!!! EGL " << get_platform_name(platform) << ": cannot create a " << prvt_width << "x" << prvt_height << " pbuffer" << endl;
+            prvt_surface = NULL;
+            prvt_destroy();
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool GLContext::prvt_create_osmesa(GLContext* shared)
+{
+    if (!load_osmesa())
+        return false;
+
+    const int attributes[] = {
+        OSMESA_FORMAT, OSMESA_RGBA,
+        OSMESA_DEPTH_BITS, 24,
+        OSMESA_STENCIL_BITS, 8,
+        OSMESA_ACCUM_BITS, 0,
+        OSMESA_PROFILE, prvt_config.core_profile ? OSMESA_CORE_PROFILE : OSMESA_COMPAT_PROFILE,
+        OSMESA_CONTEXT_MAJOR_VERSION, prvt_config.major_version,
+        OSMESA_CONTEXT_MINOR_VERSION, prvt_config.minor_version,
+        0
+    };
+    prvt_context = osmesa_create_context_attribs(attributes, shared != NULL ? static_cast<OSMesaContext>(shared->prvt_context) : NULL);
+    if (prvt_context == NULL) {
+        cerr << "!!! OSMesa: cannot create an OpenGL " << prvt_config.major_version << "." << prvt_config.minor_version << " context" << endl;
+        return false;
+    }
+
+    // OSMesa contexts get current with a color buffer only: a 1x1 one when there is no default framebuffer
+    prvt_color_buffer.assign(size_t(max(prvt_width, 1)) * size_t(max(prvt_height, 1)) * 4, 0);
+    return true;
+}
+#endif
+
+
+void GLContext::prvt_destroy()
+{
+    done_current();
+#if defined(__linux__)
+    if (prvt_platform == PLATFORM_OSMESA) {
+        if (prvt_context != NULL)
+            osmesa_destroy_context(static_cast<OSMesaContext>(prvt_context));
+        prvt_color_buffer.clear();
+    }
+    else if (prvt_display != NULL) {
+        if (prvt_surface != NULL)
+            eglDestroySurface(prvt_display, prvt_surface);
+        if (prvt_context != NULL)
+            eglDestroyContext(prvt_display, prvt_context);
+        release_display(prvt_display);
+    }
+#endif
+    prvt_display = NULL;
+    prvt_egl_config = NULL;
+    prvt_surface = NULL;
+    prvt_context = NULL;
+}
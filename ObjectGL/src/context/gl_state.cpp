@@ -0,0 +1,550 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include "context/gl_state.h"
+#include "trace/gl_dispatch.h"
+
+using namespace std;
+
+
+// the cached non-indexed buffer targets
+static const GLenum BUFFER_TARGETS[] = {
+    GL_ARRAY_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_DISPATCH_INDIRECT_BUFFER, GL_PARAMETER_BUFFER,
+    GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_QUERY_BUFFER
+};
+
+// the cached indexed buffer targets
+static const GLenum INDEXED_TARGETS[] = {
+    GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_ATOMIC_COUNTER_BUFFER
+};
+
+// the cached capabilities
+static const GLenum CAPABILITIES[] = {
+    GL_BLEND, GL_CULL_FACE, GL_DEPTH_CLAMP, GL_DEPTH_TEST, GL_FRAMEBUFFER_SRGB,
+    GL_MULTISAMPLE, GL_POLYGON_OFFSET_FILL, GL_PRIMITIVE_RESTART, GL_PRIMITIVE_RESTART_FIXED_INDEX,
+    GL_PROGRAM_POINT_SIZE, GL_RASTERIZER_DISCARD, GL_SAMPLE_ALPHA_TO_COVERAGE, GL_SCISSOR_TEST,
+    GL_STENCIL_TEST, GL_TEXTURE_CUBE_MAP_SEAMLESS
+};
+
+// the state cache of the current context of each thread, NULL for the default one
+static thread_local GLStateCache* current_cache = NULL;
+
+
+GLStateCache::GLStateCache()
+    : prvt_frame_stats{ 0, 0 },
+      prvt_last_frame_stats{ 0, 0 },
+      prvt_total_stats{ 0, 0 }
+{
+    static_assert(sizeof(BUFFER_TARGETS) / sizeof(GLenum) == BUFFER_TARGETS_COUNT, "unexpected count of buffer targets");
+    static_assert(sizeof(INDEXED_TARGETS) / sizeof(GLenum) == INDEXED_TARGETS_COUNT, "unexpected count of indexed targets");
+    static_assert(sizeof(CAPABILITIES) / sizeof(GLenum) == CAPABILITIES_COUNT, "unexpected count of capabilities");
+    invalidate();
+}
+
+
+bool GLStateCache::bind_buffer(const GLenum target, const GLuint buffer)
+{
+    const int index = prvt_buffer_target_index(target);
+    if (index >= 0) {
+        if (prvt_buffers[index] == buffer)
+            return prvt_elide();
+        prvt_buffers[index] = buffer;
+    }
+    glBindBuffer(target, buffer);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::bind_buffer_base(const GLenum target, const GLuint index, const GLuint buffer)
+{
+    const int target_index = prvt_indexed_target_index(target);
+    if (target_index >= 0 && index < MAX_TRACKED_UNITS) {
+        BufferRange& range = prvt_buffer_ranges[target_index][index];
+        if (range.buffer == buffer && range.size == -1)
+            return prvt_elide();
+        range = BufferRange{ buffer, 0, -1 };
+    }
+    glBindBufferBase(target, index, buffer);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::bind_buffer_range(const GLenum target, const GLuint index, const GLuint buffer, const GLintptr offset, const GLsizeiptr size)
+{
+    const int target_index = prvt_indexed_target_index(target);
+    if (target_index >= 0 && index < MAX_TRACKED_UNITS) {
+        BufferRange& range = prvt_buffer_ranges[target_index][index];
+        if (range.buffer == buffer && range.offset == offset && range.size == size)
+            return prvt_elide();
+        range = BufferRange{ buffer, offset, size };
+    }
+    glBindBufferRange(target, index, buffer, offset, size);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::bind_buffers_range(const GLenum target, const GLuint first, const GLsizei count, const GLuint* buffers, const GLintptr* offsets, const GLsizeiptr* sizes)
+{
+    const int target_index = prvt_indexed_target_index(target);
+    if (target_index < 0 || first + count > MAX_TRACKED_UNITS) {
+        if (GLEW_ARB_multi_bind)
+            glBindBuffersRange(target, first, count, buffers, offsets, sizes);
+        else
+            for (GLsizei i = 0; i < count; ++i)
+                glBindBufferRange(target, first + i, buffers[i], offsets[i], sizes[i]);
+        return prvt_issue(GLEW_ARB_multi_bind ? 1 : count);
+    }
+
+    // evaluates the sub-range of changing bindings
+    BufferRange* ranges = prvt_buffer_ranges[target_index] + first;
+    GLsizei begin = count, end = 0;
+    for (GLsizei i = 0; i < count; ++i) {
+        if (ranges[i].buffer != buffers[i] || ranges[i].offset != offsets[i] || ranges[i].size != sizes[i]) {
+            if (i < begin)
+                begin = i;
+            end = i + 1;
+            ranges[i] = BufferRange{ buffers[i], offsets[i], sizes[i] };
+        }
+    }
+    if (begin >= end)
+        return prvt_elide(count);
+
+    prvt_elide(count - (end - begin));
+    if (GLEW_ARB_multi_bind) {
+        glBindBuffersRange(target, first + begin, end - begin, buffers + begin, offsets + begin, sizes + begin);
+        return prvt_issue();
+    }
+    for (GLsizei i = begin; i < end; ++i)
+        glBindBufferRange(target, first + i, buffers[i], offsets[i], sizes[i]);
+    return prvt_issue(end - begin);
+}
+
+
+bool GLStateCache::bind_vertex_array(const GLuint vertex_array)
+{
+    if (prvt_vertex_array == vertex_array)
+        return prvt_elide();
+    prvt_vertex_array = vertex_array;
+    glBindVertexArray(vertex_array);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::use_program(const GLuint program)
+{
+    if (prvt_program == program)
+        return prvt_elide();
+    prvt_program = program;
+    glUseProgram(program);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::bind_sampler(const GLuint unit, const GLuint sampler)
+{
+    if (unit < MAX_TRACKED_UNITS) {
+        if (prvt_samplers[unit] == sampler)
+            return prvt_elide();
+        prvt_samplers[unit] = sampler;
+    }
+    glBindSampler(unit, sampler);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::bind_samplers(const GLuint first, const GLsizei count, const GLuint* samplers)
+{
+    GLsizei begin = 0, end = count;
+    if (first + count <= MAX_TRACKED_UNITS) {
+        // evaluates the sub-range of changing bindings
+        begin = count;
+        end = 0;
+        for (GLsizei i = 0; i < count; ++i) {
+            if (prvt_samplers[first + i] != samplers[i]) {
+                if (i < begin)
+                    begin = i;
+                end = i + 1;
+                prvt_samplers[first + i] = samplers[i];
+            }
+        }
+        if (begin >= end)
+            return prvt_elide(count);
+        prvt_elide(count - (end - begin));
+    }
+
+    if (GLEW_ARB_multi_bind) {
+        glBindSamplers(first + begin, end - begin, samplers + begin);
+        return prvt_issue();
+    }
+    for (GLsizei i = begin; i < end; ++i)
+        glBindSampler(first + i, samplers[i]);
+    return prvt_issue(end - begin);
+}
+
+
+bool GLStateCache::bind_texture(const GLuint unit, const GLuint texture)
+{
+    if (!(GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access || GLEW_ARB_multi_bind)) {
+        cerr << "!!! binding textures with no target needs ARB_multi_bind or ARB_direct_state_access" << endl;
+        return false;
+    }
+
+    if (unit < MAX_TRACKED_UNITS) {
+        if (prvt_textures[unit] == texture)
+            return prvt_elide();
+        prvt_textures[unit] = texture;
+    }
+
+    if (GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access)
+        glBindTextureUnit(unit, texture);
+    else
+        glBindTextures(unit, 1, &texture);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::bind_textures(const GLuint first, const GLsizei count, const GLuint* textures)
+{
+    if (!GLEW_ARB_multi_bind) {
+        bool issued = false;
+        for (GLsizei i = 0; i < count; ++i)
+            issued = bind_texture(first + i, textures[i]) || issued;
+        return issued;
+    }
+
+    GLsizei begin = 0, end = count;
+    if (first + count <= MAX_TRACKED_UNITS) {
+        // evaluates the sub-range of changing bindings
+        begin = count;
+        end = 0;
+        for (GLsizei i = 0; i < count; ++i) {
+            if (prvt_textures[first + i] != textures[i]) {
+                if (i < begin)
+                    begin = i;
+                end = i + 1;
+                prvt_textures[first + i] = textures[i];
+            }
+        }
+        if (begin >= end)
+            return prvt_elide(count);
+        prvt_elide(count - (end - begin));
+    }
+
+    glBindTextures(first + begin, end - begin, textures + begin);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::blend_equation(const GLenum mode_rgb, const GLenum mode_alpha)
+{
+    if ((prvt_known & KNOWN_BLEND_EQUATION) && prvt_blend_equation[0] == mode_rgb && prvt_blend_equation[1] == mode_alpha)
+        return prvt_elide();
+    prvt_known |= KNOWN_BLEND_EQUATION;
+    prvt_blend_equation[0] = mode_rgb;
+    prvt_blend_equation[1] = mode_alpha;
+    glBlendEquationSeparate(mode_rgb, mode_alpha);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::blend_func(const GLenum src_rgb, const GLenum dst_rgb, const GLenum src_alpha, const GLenum dst_alpha)
+{
+    if ((prvt_known & KNOWN_BLEND_FUNC) && prvt_blend_func[0] == src_rgb && prvt_blend_func[1] == dst_rgb &&
+                                           prvt_blend_func[2] == src_alpha && prvt_blend_func[3] == dst_alpha)
+        return prvt_elide();
+    prvt_known |= KNOWN_BLEND_FUNC;
+    prvt_blend_func[0] = src_rgb;
+    prvt_blend_func[1] = dst_rgb;
+    prvt_blend_func[2] = src_alpha;
+    prvt_blend_func[3] = dst_alpha;
+    glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::color_mask(const bool red, const bool green, const bool blue, const bool alpha)
+{
+    if ((prvt_known & KNOWN_COLOR_MASK) && prvt_color_mask[0] == red && prvt_color_mask[1] == green &&
+                                           prvt_color_mask[2] == blue && prvt_color_mask[3] == alpha)
+        return prvt_elide();
+    prvt_known |= KNOWN_COLOR_MASK;
+    prvt_color_mask[0] = red;
+    prvt_color_mask[1] = green;
+    prvt_color_mask[2] = blue;
+    prvt_color_mask[3] = alpha;
+    glColorMask(red, green, blue, alpha);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::cull_face(const GLenum mode)
+{
+    if ((prvt_known & KNOWN_CULL_FACE) && prvt_cull_face == mode)
+        return prvt_elide();
+    prvt_known |= KNOWN_CULL_FACE;
+    prvt_cull_face = mode;
+    glCullFace(mode);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::depth_func(const GLenum func)
+{
+    if ((prvt_known & KNOWN_DEPTH_FUNC) && prvt_depth_func == func)
+        return prvt_elide();
+    prvt_known |= KNOWN_DEPTH_FUNC;
+    prvt_depth_func = func;
+    glDepthFunc(func);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::depth_mask(const bool enabled)
+{
+    if ((prvt_known & KNOWN_DEPTH_MASK) && prvt_depth_mask == enabled)
+        return prvt_elide();
+    prvt_known |= KNOWN_DEPTH_MASK;
+    prvt_depth_mask = enabled;
+    glDepthMask(enabled);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::front_face(const GLenum mode)
+{
+    if ((prvt_known & KNOWN_FRONT_FACE) && prvt_front_face == mode)
+        return prvt_elide();
+    prvt_known |= KNOWN_FRONT_FACE;
+    prvt_front_face = mode;
+    glFrontFace(mode);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::polygon_mode(const GLenum mode)
+{
+    if ((prvt_known & KNOWN_POLYGON_MODE) && prvt_polygon_mode == mode)
+        return prvt_elide();
+    prvt_known |= KNOWN_POLYGON_MODE;
+    prvt_polygon_mode = mode;
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::polygon_offset(const GLfloat factor, const GLfloat units)
+{
+    if ((prvt_known & KNOWN_POLYGON_OFFSET) && prvt_polygon_offset[0] == factor && prvt_polygon_offset[1] == units)
+        return prvt_elide();
+    prvt_known |= KNOWN_POLYGON_OFFSET;
+    prvt_polygon_offset[0] = factor;
+    prvt_polygon_offset[1] = units;
+    glPolygonOffset(factor, units);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::scissor(const GLint x, const GLint y, const GLsizei width, const GLsizei height)
+{
+    if ((prvt_known & KNOWN_SCISSOR) && prvt_scissor[0] == x && prvt_scissor[1] == y &&
+                                        prvt_scissor[2] == width && prvt_scissor[3] == height)
+        return prvt_elide();
+    prvt_known |= KNOWN_SCISSOR;
+    prvt_scissor[0] = x;
+    prvt_scissor[1] = y;
+    prvt_scissor[2] = width;
+    prvt_scissor[3] = height;
+    glScissor(x, y, width, height);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::stencil_func(const GLenum func, const GLint reference, const GLuint mask)
+{
+    if ((prvt_known & KNOWN_STENCIL_FUNC) && prvt_stencil_func == func && prvt_stencil_reference == reference && prvt_stencil_read_mask == mask)
+        return prvt_elide();
+    prvt_known |= KNOWN_STENCIL_FUNC;
+    prvt_stencil_func = func;
+    prvt_stencil_reference = reference;
+    prvt_stencil_read_mask = mask;
+    glStencilFunc(func, reference, mask);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::stencil_mask(const GLuint mask)
+{
+    if ((prvt_known & KNOWN_STENCIL_MASK) && prvt_stencil_write_mask == mask)
+        return prvt_elide();
+    prvt_known |= KNOWN_STENCIL_MASK;
+    prvt_stencil_write_mask = mask;
+    glStencilMask(mask);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::stencil_op(const GLenum stencil_fail, const GLenum depth_fail, const GLenum depth_pass)
+{
+    if ((prvt_known & KNOWN_STENCIL_OP) && prvt_stencil_op[0] == stencil_fail && prvt_stencil_op[1] == depth_fail && prvt_stencil_op[2] == depth_pass)
+        return prvt_elide();
+    prvt_known |= KNOWN_STENCIL_OP;
+    prvt_stencil_op[0] = stencil_fail;
+    prvt_stencil_op[1] = depth_fail;
+    prvt_stencil_op[2] = depth_pass;
+    glStencilOp(stencil_fail, depth_fail, depth_pass);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::set_capability(const GLenum capability, const bool enabled)
+{
+    const int index = prvt_capability_index(capability);
+    if (index >= 0) {
+        if (prvt_capabilities[index] == int8_t(enabled))
+            return prvt_elide();
+        prvt_capabilities[index] = int8_t(enabled);
+    }
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+    return prvt_issue();
+}
+
+
+bool GLStateCache::viewport(const GLint x, const GLint y, const GLsizei width, const GLsizei height)
+{
+    if ((prvt_known & KNOWN_VIEWPORT) && prvt_viewport[0] == x && prvt_viewport[1] == y &&
+                                         prvt_viewport[2] == width && prvt_viewport[3] == height)
+        return prvt_elide();
+    prvt_known |= KNOWN_VIEWPORT;
+    prvt_viewport[0] = x;
+    prvt_viewport[1] = y;
+    prvt_viewport[2] = width;
+    prvt_viewport[3] = height;
+    glViewport(x, y, width, height);
+    return prvt_issue();
+}
+
+
+void GLStateCache::invalidate()
+{
+    prvt_program = UNKNOWN;
+    prvt_vertex_array = UNKNOWN;
+    for (GLuint i = 0; i < BUFFER_TARGETS_COUNT; ++i)
+        prvt_buffers[i] = UNKNOWN;
+    for (GLuint t = 0; t < INDEXED_TARGETS_COUNT; ++t)
+        for (GLuint i = 0; i < MAX_TRACKED_UNITS; ++i)
+            prvt_buffer_ranges[t][i] = BufferRange{ UNKNOWN, 0, 0 };
+    for (GLuint i = 0; i < MAX_TRACKED_UNITS; ++i)
+        prvt_textures[i] = prvt_samplers[i] = UNKNOWN;
+    memset(prvt_capabilities, -1, sizeof(prvt_capabilities));
+    prvt_known = 0;
+}
+
+
+void GLStateCache::on_buffer_deleted(const GLuint buffer)
+{
+    for (GLuint i = 0; i < BUFFER_TARGETS_COUNT; ++i)
+        if (prvt_buffers[i] == buffer)
+            prvt_buffers[i] = 0;
+    for (GLuint t = 0; t < INDEXED_TARGETS_COUNT; ++t)
+        for (GLuint i = 0; i < MAX_TRACKED_UNITS; ++i)
+            if (prvt_buffer_ranges[t][i].buffer == buffer)
+                prvt_buffer_ranges[t][i] = BufferRange{ 0, 0, -1 };
+}
+
+
+void GLStateCache::on_sampler_deleted(const GLuint sampler)
+{
+    for (GLuint i = 0; i < MAX_TRACKED_UNITS; ++i)
+        if (prvt_samplers[i] == sampler)
+            prvt_samplers[i] = 0;
+}
+
+
+void GLStateCache::on_texture_deleted(const GLuint texture)
+{
+    for (GLuint i = 0; i < MAX_TRACKED_UNITS; ++i)
+        if (prvt_textures[i] == texture)
+            prvt_textures[i] = 0;
+}
+
+
+void GLStateCache::on_vertex_array_deleted(const GLuint vertex_array)
+{
+    if (prvt_vertex_array == vertex_array)
+        prvt_vertex_array = 0;
+}
+
+
+void GLStateCache::end_frame()
+{
+    prvt_last_frame_stats = prvt_frame_stats;
+    prvt_frame_stats = Stats{ 0, 0 };
+}
+
+
+GLStateCache& GLStateCache::get_current()
+{
+    static thread_local GLStateCache default_cache;
+    return current_cache != NULL ? *current_cache : default_cache;
+}
+
+
+void GLStateCache::set_current(GLStateCache* cache)
+{
+    current_cache = cache;
+}
+
+
+int GLStateCache::prvt_buffer_target_index(const GLenum target)
+{
+    for (GLuint i = 0; i < BUFFER_TARGETS_COUNT; ++i)
+        if (BUFFER_TARGETS[i] == target)
+            return int(i);
+    return -1;
+}
+
+
+int GLStateCache::prvt_capability_index(const GLenum capability)
+{
+    for (GLuint i = 0; i < CAPABILITIES_COUNT; ++i)
+        if (CAPABILITIES[i] == capability)
+            return int(i);
+    return -1;
+}
+
+
+int GLStateCache::prvt_indexed_target_index(const GLenum target)
+{
+    for (GLuint i = 0; i < INDEXED_TARGETS_COUNT; ++i)
+        if (INDEXED_TARGETS[i] == target)
+            return int(i);
+    return -1;
+}
@@ -0,0 +1,104 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include "context/memory_barriers.h"
+
+using namespace std;
+
+
+// the memory barriers tracker of the current context of each thread, NULL for the default one
+static thread_local MemoryBarriers* current_barriers = NULL;
+
+
+MemoryBarriers::MemoryBarriers()
+    : prvt_pending(0),
+      prvt_stats{ 0, 0, 0 }
+{}
+
+
+GLbitfield MemoryBarriers::flush()
+{
+    const GLbitfield issued = prvt_pending;
+    if (issued == 0)
+        return 0;
+
+    glMemoryBarrier(issued);
+    ++prvt_stats.barriers;
+    prvt_pending = 0;
+
+    // barriers are global: all written resources are covered by the issued bits
+    for (unordered_map<uint64_t, GLbitfield>::iterator it = prvt_written.begin(); it != prvt_written.end(); ) {
+        it->second |= issued;
+        if (it->second == GL_ALL_BARRIER_BITS)
+            it = prvt_written.erase(it);
+        else
+            ++it;
+    }
+    return issued;
+}
+
+
+void MemoryBarriers::reset()
+{
+    prvt_written.clear();
+    prvt_pending = 0;
+}
+
+
+MemoryBarriers& MemoryBarriers::get_current()
+{
+    static thread_local MemoryBarriers default_barriers;
+    return current_barriers != NULL ? *current_barriers : default_barriers;
+}
+
+
+void MemoryBarriers::set_current(MemoryBarriers* barriers)
+{
+    current_barriers = barriers;
+}
+
+
+void MemoryBarriers::prvt_on_written(const uint64_t key)
+{
+    prvt_written[key] = 0;
+}
+
+
+void MemoryBarriers::prvt_require(const uint64_t key, const GLbitfield barrier_bits)
+{
+    unordered_map<uint64_t, GLbitfield>::const_iterator it = prvt_written.find(key);
+    if (it == prvt_written.end())
+        return;  // not written by shaders, or fully covered
+
+    ++prvt_stats.required;
+    const GLbitfield missing = barrier_bits & ~it->second;
+    if (missing == 0)
+        ++prvt_stats.elided;
+    else
+        prvt_pending |= missing;
+}
@@ -0,0 +1,505 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include "culling/gpu_culling.h"
+#include "context/gl_state.h"
+#include "context/memory_barriers.h"
+#include "profiling/gpu_profiler.h"
+#include "profiling/cpu_profiler.h"
+#include "trace/gl_dispatch.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+// Tests the bounds of one instance per invocation. The visible draw
+// commands of a work group get one single atomic addition on the global
+// counter when compacted.
+static const char* CULL_SHADER_SOURCE = R"glsl(
+layout(local_size_x = 64) in;
+
+struct Mesh {
+    uint count;
+    uint first_index;
+    int  base_vertex;
+    uint padding;
+};
+
+struct Instance {
+    vec4 sphere;
+    vec3 extents;
+    uint mesh;
+};
+
+struct Command {
+    uint count;
+    uint instance_count;
+    uint first_index;
+    int  base_vertex;
+    uint base_instance;
+};
+
+layout(std430, binding = 0) readonly buffer Meshes { Mesh meshes[]; };
+layout(std430, binding = 1) readonly buffer Instances { Instance instances[]; };
+layout(std430, binding = 2) writeonly buffer Commands { Command commands[]; };
+layout(std430, binding = 3) buffer DrawCount { uint draw_count; };
+layout(binding = 0) uniform sampler2D u_hiz;
+
+uniform mat4  u_view_projection;
+uniform vec4  u_planes[6];
+uniform uint  u_instances_count;
+uniform uint  u_occlusion;
+uniform ivec2 u_hiz_size;
+uniform int   u_hiz_max_level;
+
+shared uint s_count;
+shared uint s_first;
+
+bool is_in_frustum(vec3 center, float radius, vec3 extents, bool is_box) {
+    for (int i = 0; i < 6; ++i) {
+        float reach = is_box ? dot(abs(u_planes[i].xyz), extents) : radius;
+        if (dot(u_planes[i].xyz, center) + u_planes[i].w < -reach)
+            return false;
+    }
+    return true;
+}
+
+// levels sizes are evaluated rather than queried, since some implementations
+// (e.g. llvmpipe) do not support non-uniform levels with textureSize()
+void get_texels(vec2 uv_min, vec2 uv_max, int level, out ivec2 texel_min, out ivec2 texel_max) {
+    ivec2 level_size = max(u_hiz_size >> level, ivec2(1));
+    texel_min = clamp(ivec2(uv_min * vec2(level_size)), ivec2(0), level_size - 1);
+    texel_max = clamp(ivec2(uv_max * vec2(level_size)), ivec2(0), level_size - 1);
+}
+
+bool is_unoccluded(vec3 center, vec3 extents) {
+    vec3 ndc_min = vec3(1.0);
+    vec3 ndc_max = vec3(-1.0);
+    for (int i = 0; i < 8; ++i) {
+        vec3 corner = center + extents * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = u_view_projection * vec4(corner, 1.0);
+        if (clip.w <= 1e-5)
+            return true;    // crosses the near plane
+        vec3 ndc = clip.xyz / clip.w;
+        ndc_min = min(ndc_min, ndc);
+        ndc_max = max(ndc_max, ndc);
+    }
+
+    vec2 uv_min = clamp(ndc_min.xy * 0.5 + 0.5, 0.0, 1.0);
+    vec2 uv_max = clamp(ndc_max.xy * 0.5 + 0.5, 0.0, 1.0);
+    vec2 extent = (uv_max - uv_min) * vec2(u_hiz_size);
+    int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), 0, u_hiz_max_level);
+
+    // floored levels sizes may spread the bounds over 3 texels: goes one level up then
+    ivec2 texel_min, texel_max;
+    get_texels(uv_min, uv_max, level, texel_min, texel_max);
+    if (any(greaterThan(texel_max - texel_min, ivec2(1)))) {
+        if (level == u_hiz_max_level)
+            return true;
+        get_texels(uv_min, uv_max, ++level, texel_min, texel_max);
+        if (any(greaterThan(texel_max - texel_min, ivec2(1))))
+            return true;
+    }
+
+    float occluder_depth = max(max(texelFetch(u_hiz, texel_min, level).r,
+                                   texelFetch(u_hiz, ivec2(texel_max.x, texel_min.y), level).r),
+                               max(texelFetch(u_hiz, ivec2(texel_min.x, texel_max.y), level).r,
+                                   texelFetch(u_hiz, texel_max, level).r));
+    return ndc_min.z * 0.5 + 0.5 <= occluder_depth;
+}
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    bool visible = false;
+    Instance instance;
+    if (index < u_instances_count) {
+        instance = instances[index];
+        bool is_box = any(greaterThan(instance.extents, vec3(0.0)));
+        vec3 extents = is_box ? instance.extents : vec3(instance.sphere.w);
+        visible = is_in_frustum(instance.sphere.xyz, instance.sphere.w, extents, is_box) &&
+                  (u_occlusion == 0u || is_unoccluded(instance.sphere.xyz, extents));
+    }
+
+    if (gl_LocalInvocationIndex == 0u)
+        s_count = 0u;
+    barrier();
+    uint local_slot = visible ? atomicAdd(s_count, 1u) : 0u;
+    barrier();
+    if (gl_LocalInvocationIndex == 0u && s_count > 0u)
+        s_first = atomicAdd(draw_count, s_count);
+    barrier();
+
+    if (index >= u_instances_count)
+        return;
+    Mesh mesh = meshes[instance.mesh];
+#if COMPACT
+    if (visible)
+        commands[s_first + local_slot] = Command(mesh.count, 1u, mesh.first_index, mesh.base_vertex, index);
+#else
+    commands[index] = Command(mesh.count, visible ? 1u : 0u, mesh.first_index, mesh.base_vertex, index);
+#endif
+}
+)glsl";
+
+
+//---------------------------------------------------------------------------
+// Reduces one level of the HiZ pyramid into the next one, keeping the
+// farthest depth. Odd sizes get their last row and column folded into
+// the last destination texels.
+static const char* REDUCE_SHADER_SOURCE = R"glsl(
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D u_source;
+layout(r32f, binding = 0) writeonly uniform image2D u_destination;
+
+uniform int u_source_level;
+
+void main() {
+    ivec2 destination_size = imageSize(u_destination);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, destination_size)))
+        return;
+
+    ivec2 source_size = textureSize(u_source, u_source_level);
+    ivec2 first = texel * 2;
+    ivec2 last = min(first + 1 + ivec2(equal(texel, destination_size - 1)) * (source_size & 1), source_size - 1);
+    float depth = 0.0;
+    for (int y = first.y; y <= last.y; ++y)
+        for (int x = first.x; x <= last.x; ++x)
+            depth = max(depth, texelFetch(u_source, ivec2(x, y), u_source_level).r);
+    imageStore(u_destination, texel, vec4(depth));
+}
+)glsl";
+
+
+//---------------------------------------------------------------------------
+// Frustum tests shared by the CPU reference.
+static inline bool is_in_frustum(const Eigen::Vector4f planes[6], const CullingInstance& instance)
+{
+    const Eigen::Vector3f center(instance.center[0], instance.center[1], instance.center[2]);
+    const Eigen::Vector3f extents(instance.extents[0], instance.extents[1], instance.extents[2]);
+    const bool is_box = extents.x() > 0.0f || extents.y() > 0.0f || extents.z() > 0.0f;
+    for (int i = 0; i < 6; ++i) {
+        const Eigen::Vector3f normal = planes[i].head<3>();
+        const float reach = is_box ? normal.cwiseAbs().dot(extents) : instance.radius;
+        if (normal.dot(center) + planes[i].w() < -reach)
+            return false;
+    }
+    return true;
+}
+
+
+GPUCulling::GPUCulling(const GLuint max_instances, const GLuint max_meshes, const bool verbose, const bool compact)
+    : prvt_max_instances(max_instances),
+      prvt_max_meshes(max_meshes),
+      prvt_instances_count(0),
+      prvt_compacted(compact && is_draw_count_supported()),
+      prvt_meshes(max_meshes * sizeof(CullingMesh)),
+      prvt_instances(max_instances * sizeof(CullingInstance)),
+      prvt_commands(max_instances * sizeof(DrawElementsIndirectCommand)),
+      prvt_draw_count(GL_PARAMETER_BUFFER_ARB, sizeof(GLuint)),
+      prvt_view_projection(prvt_cull_program, "u_view_projection"),
+      prvt_planes(prvt_cull_program, "u_planes"),
+      prvt_instances_uniform(prvt_cull_program, "u_instances_count"),
+      prvt_occlusion(prvt_cull_program, "u_occlusion"),
+      prvt_hiz_size(prvt_cull_program, "u_hiz_size"),
+      prvt_hiz_max_level(prvt_cull_program, "u_hiz_max_level"),
+      prvt_source_level(prvt_reduce_program, "u_source_level"),
+      prvt_hiz_texture(0),
+      prvt_hiz_width(0),
+      prvt_hiz_height(0),
+      prvt_hiz_levels(0),
+      prvt_depth_sampler(0),
+      prvt_hiz_sampler(0)
+{
+    if (!is_supported()) {
+        cerr << "!!! GPU culling needs compute shaders and direct state access" << endl;
+        return;
+    }
+
+    const string header = string("#version 430 core\n#define COMPACT ") + (prvt_compacted ? "1" : "0") + "\n";
+    prvt_cull_shader.set_source_code(header + CULL_SHADER_SOURCE);
+    prvt_reduce_shader.set_source_code(header + REDUCE_SHADER_SOURCE);
+
+    prvt_cull_program.set_label("gpu culling");
+    prvt_reduce_program.set_label("hiz reduction");
+    if (prvt_cull_program.attach_shader(prvt_cull_shader) && prvt_cull_program.compile_shaders(verbose))
+        prvt_cull_program.link();
+    if (prvt_reduce_program.attach_shader(prvt_reduce_shader) && prvt_reduce_program.compile_shaders(verbose))
+        prvt_reduce_program.link();
+    if (!is_ok())
+        cerr << "!!! GPU culling programs failed to link" << endl;
+
+    glCreateSamplers(1, &prvt_depth_sampler);
+    glSamplerParameteri(prvt_depth_sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glSamplerParameteri(prvt_depth_sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glSamplerParameteri(prvt_depth_sampler, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+    glCreateSamplers(1, &prvt_hiz_sampler);
+    glSamplerParameteri(prvt_hiz_sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glSamplerParameteri(prvt_hiz_sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+
+GPUCulling::~GPUCulling()
+{
+    prvt_release_hiz();
+    GLStateCache& cache = GLStateCache::get_current();
+    const GLuint samplers[2] = { prvt_depth_sampler, prvt_hiz_sampler };
+    for (const GLuint sampler : samplers) {
+        if (sampler != 0) {
+            cache.on_sampler_deleted(sampler);
+            glDeleteSamplers(1, &sampler);
+        }
+    }
+}
+
+
+void GPUCulling::build_hiz(const GLuint depth_texture, const GLsizei width, const GLsizei height)
+{
+    if (!is_ok() || width <= 0 || height <= 0)
+        return;
+
+    OBJECTGL_GPU_ZONE("hiz pyramid");
+
+    const GLsizei hiz_width = max(width / 2, 1);
+    const GLsizei hiz_height = max(height / 2, 1);
+    if (prvt_hiz_texture == 0 || hiz_width != prvt_hiz_width || hiz_height != prvt_hiz_height) {
+        prvt_release_hiz();
+        prvt_hiz_width = hiz_width;
+        prvt_hiz_height = hiz_height;
+        prvt_hiz_levels = 1;
+        for (GLsizei size = max(hiz_width, hiz_height); size > 1; size /= 2)
+            ++prvt_hiz_levels;
+        glCreateTextures(GL_TEXTURE_2D, 1, &prvt_hiz_texture);
+        glTextureStorage2D(prvt_hiz_texture, prvt_hiz_levels, GL_R32F, prvt_hiz_width, prvt_hiz_height);
+    }
+
+    GLStateCache& cache = GLStateCache::get_current();
+    prvt_reduce_program.clear_resources();
+    prvt_reduce_program.add_image_input(prvt_hiz_texture, GL_TEXTURE_FETCH_BARRIER_BIT);
+    prvt_reduce_program.add_image_output(prvt_hiz_texture);
+
+    // level 0 from the depth buffer, then each level from the previous one
+    for (GLint level = 0; level < prvt_hiz_levels; ++level) {
+        if (level == 0) {
+            cache.bind_texture(0, depth_texture);
+            cache.bind_sampler(0, prvt_depth_sampler);
+        }
+        else if (level == 1) {
+            cache.bind_texture(0, prvt_hiz_texture);
+            cache.bind_sampler(0, prvt_hiz_sampler);
+        }
+        prvt_source_level = level == 0 ? 0 : level - 1;
+        glBindImageTexture(0, prvt_hiz_texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        prvt_reduce_program.dispatch_for(GLuint(max(prvt_hiz_width >> level, 1)), GLuint(max(prvt_hiz_height >> level, 1)));
+    }
+}
+
+
+void GPUCulling::cull(const Eigen::Matrix4f& view_projection, const bool occlusion)
+{
+    OBJECTGL_CPU_ZONE("GPUCulling::cull");
+    if (!is_ok())
+        return;
+
+    MemoryBarriers& barriers = MemoryBarriers::get_current();
+    barriers.require_buffer(prvt_draw_count.name, GL_BUFFER_UPDATE_BARRIER_BIT);
+    barriers.flush();
+    const GLuint zero = 0;
+    prvt_draw_count.set_data(0, sizeof(GLuint), &zero);
+
+    Eigen::Vector4f planes[6];
+    get_frustum_planes(view_projection, planes);
+    prvt_view_projection = view_projection;
+    prvt_planes.set(planes, 6);
+    prvt_instances_uniform = prvt_instances_count;
+
+    const bool occlusion_tests = occlusion && prvt_hiz_texture != 0;
+    prvt_occlusion = GLuint(occlusion_tests ? 1 : 0);
+    prvt_hiz_size = Eigen::Vector2i(prvt_hiz_width, prvt_hiz_height);
+    prvt_hiz_max_level = max(prvt_hiz_levels - 1, 0);
+
+    GLStateCache& cache = GLStateCache::get_current();
+    cache.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 0, prvt_meshes.name);
+    cache.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 1, prvt_instances.name);
+    cache.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 2, prvt_commands.name);
+    cache.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, 3, prvt_draw_count.name);
+    if (occlusion_tests) {
+        cache.bind_texture(0, prvt_hiz_texture);
+        cache.bind_sampler(0, prvt_hiz_sampler);
+    }
+
+    prvt_cull_program.clear_resources();
+    if (occlusion_tests)
+        prvt_cull_program.add_image_input(prvt_hiz_texture, GL_TEXTURE_FETCH_BARRIER_BIT);
+    prvt_cull_program.add_buffer_output(prvt_commands);
+    prvt_cull_program.add_buffer_output(prvt_draw_count);
+    prvt_cull_program.dispatch_for(prvt_instances_count);
+}
+
+
+void GPUCulling::draw(PipelineStateCache& pipeline_states, const PipelineState* state, const GLenum mode, const GLenum index_type)
+{
+    OBJECTGL_CPU_ZONE("GPUCulling::draw");
+    if (!is_ok() || prvt_instances_count == 0)
+        return;
+
+    ShadersProgram* program = state->get_desc().program;
+    GPUZone zone(program == NULL || program->get_label().empty() ? "culled draws" : program->get_label().c_str());
+    pipeline_states.apply(state);
+    if (program != NULL)
+        program->flush_uniforms();
+
+    MemoryBarriers& barriers = MemoryBarriers::get_current();
+    barriers.require_buffer(prvt_commands.name, GL_COMMAND_BARRIER_BIT);
+    barriers.require_buffer(prvt_draw_count.name, GL_COMMAND_BARRIER_BIT);
+    barriers.flush();
+
+    GLStateCache& cache = GLStateCache::get_current();
+    cache.bind_buffer(GL_DRAW_INDIRECT_BUFFER, prvt_commands.name);
+    if (prvt_compacted) {
+        cache.bind_buffer(GL_PARAMETER_BUFFER_ARB, prvt_draw_count.name);
+        if (GLEW_VERSION_4_6)
+            glMultiDrawElementsIndirectCount(mode, index_type, NULL, 0, prvt_instances_count, 0);
+        else
+            glMultiDrawElementsIndirectCountARB(mode, index_type, NULL, 0, prvt_instances_count, 0);
+    }
+    else
+        glMultiDrawElementsIndirect(mode, index_type, NULL, prvt_instances_count, 0);
+}
+
+
+void GPUCulling::get_frustum_planes(const Eigen::Matrix4f& view_projection, Eigen::Vector4f planes[6])
+{
+    const Eigen::Vector4f row_x = view_projection.row(0).transpose();
+    const Eigen::Vector4f row_y = view_projection.row(1).transpose();
+    const Eigen::Vector4f row_z = view_projection.row(2).transpose();
+    const Eigen::Vector4f row_w = view_projection.row(3).transpose();
+
+    planes[0] = row_w + row_x;
+    planes[1] = row_w - row_x;
+    planes[2] = row_w + row_y;
+    planes[3] = row_w - row_y;
+    planes[4] = row_w + row_z;
+    planes[5] = row_w - row_z;
+    for (int i = 0; i < 6; ++i) {
+        const float length = planes[i].head<3>().norm();
+        if (length > 0.0f)
+            planes[i] /= length;
+    }
+}
+
+
+GLuint GPUCulling::get_visible_count()
+{
+    MemoryBarriers& barriers = MemoryBarriers::get_current();
+    barriers.require_buffer(prvt_draw_count.name, GL_BUFFER_UPDATE_BARRIER_BIT);
+    barriers.flush();
+
+    GLuint count = 0;
+    prvt_draw_count.get_data(0, sizeof(GLuint), &count);
+    return count;
+}
+
+
+void GPUCulling::get_visible_instances(vector<GLuint>& visible)
+{
+    visible.clear();
+    const GLuint visible_count = get_visible_count();
+    const GLuint records_count = prvt_compacted ? min(visible_count, prvt_instances_count) : prvt_instances_count;
+    if (records_count == 0)
+        return;
+
+    MemoryBarriers& barriers = MemoryBarriers::get_current();
+    barriers.require_buffer(prvt_commands.name, GL_BUFFER_UPDATE_BARRIER_BIT);
+    barriers.flush();
+
+    vector<DrawElementsIndirectCommand> commands(records_count);
+    prvt_commands.get_data(0, records_count * sizeof(DrawElementsIndirectCommand), commands.data());
+    for (const DrawElementsIndirectCommand& command : commands) {
+        if (command.instance_count > 0)
+            visible.push_back(command.base_instance);
+    }
+    sort(visible.begin(), visible.end());
+}
+
+
+bool GPUCulling::set_instances(const CullingInstance* instances, const GLuint count)
+{
+    if (count > prvt_max_instances) {
+        cerr << "!!! too many instances for GPU culling: " << count << " > " << prvt_max_instances << endl;
+        return false;
+    }
+    if (count > 0)
+        prvt_instances.set_data(0, count * sizeof(CullingInstance), instances);
+    prvt_instances_count = count;
+    return true;
+}
+
+
+bool GPUCulling::set_meshes(const CullingMesh* meshes, const GLuint count)
+{
+    if (count > prvt_max_meshes) {
+        cerr << "!!! too many meshes for GPU culling: " << count << " > " << prvt_max_meshes << endl;
+        return false;
+    }
+    if (count > 0)
+        prvt_meshes.set_data(0, count * sizeof(CullingMesh), meshes);
+    return true;
+}
+
+
+size_t GPUCulling::cull_on_cpu(const Eigen::Matrix4f& view_projection, const CullingInstance* instances, const size_t count, vector<GLuint>& visible)
+{
+    Eigen::Vector4f planes[6];
+    get_frustum_planes(view_projection, planes);
+
+    size_t visible_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (is_in_frustum(planes, instances[i])) {
+            visible.push_back(GLuint(i));
+            ++visible_count;
+        }
+    }
+    return visible_count;
+}
+
+
+void GPUCulling::prvt_release_hiz()
+{
+    if (prvt_hiz_texture != 0) {
+        GLStateCache::get_current().on_texture_deleted(prvt_hiz_texture);
+        glDeleteTextures(1, &prvt_hiz_texture);
+        prvt_hiz_texture = 0;
+    }
+    prvt_hiz_width = prvt_hiz_height = 0;
+    prvt_hiz_levels = 0;
+}
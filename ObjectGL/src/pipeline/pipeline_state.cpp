@@ -0,0 +1,289 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include "pipeline/pipeline_state.h"
+#include "context/gl_state.h"
+#include "utils/hash.h"
+
+using namespace std;
+
+
+bool BlendState::operator== (const BlendState& other) const
+{
+    return enabled == other.enabled &&
+           src_rgb == other.src_rgb && dst_rgb == other.dst_rgb &&
+           src_alpha == other.src_alpha && dst_alpha == other.dst_alpha &&
+           equation_rgb == other.equation_rgb && equation_alpha == other.equation_alpha &&
+           color_mask[0] == other.color_mask[0] && color_mask[1] == other.color_mask[1] &&
+           color_mask[2] == other.color_mask[2] && color_mask[3] == other.color_mask[3];
+}
+
+
+uint64_t BlendState::hash(uint64_t seed) const
+{
+    seed = fnv1a::hash_value(enabled, seed);
+    seed = fnv1a::hash_value(src_rgb, seed);
+    seed = fnv1a::hash_value(dst_rgb, seed);
+    seed = fnv1a::hash_value(src_alpha, seed);
+    seed = fnv1a::hash_value(dst_alpha, seed);
+    seed = fnv1a::hash_value(equation_rgb, seed);
+    seed = fnv1a::hash_value(equation_alpha, seed);
+    for (const bool mask : color_mask)
+        seed = fnv1a::hash_value(mask, seed);
+    return seed;
+}
+
+
+bool DepthStencilState::operator== (const DepthStencilState& other) const
+{
+    return depth_test == other.depth_test && depth_write == other.depth_write && depth_func == other.depth_func &&
+           stencil_test == other.stencil_test && stencil_func == other.stencil_func &&
+           stencil_reference == other.stencil_reference &&
+           stencil_read_mask == other.stencil_read_mask && stencil_write_mask == other.stencil_write_mask &&
+           stencil_fail == other.stencil_fail && depth_fail == other.depth_fail && depth_pass == other.depth_pass;
+}
+
+
+uint64_t DepthStencilState::hash(uint64_t seed) const
+{
+    seed = fnv1a::hash_value(depth_test, seed);
+    seed = fnv1a::hash_value(depth_write, seed);
+    seed = fnv1a::hash_value(depth_func, seed);
+    seed = fnv1a::hash_value(stencil_test, seed);
+    seed = fnv1a::hash_value(stencil_func, seed);
+    seed = fnv1a::hash_value(stencil_reference, seed);
+    seed = fnv1a::hash_value(stencil_read_mask, seed);
+    seed = fnv1a::hash_value(stencil_write_mask, seed);
+    seed = fnv1a::hash_value(stencil_fail, seed);
+    seed = fnv1a::hash_value(depth_fail, seed);
+    return fnv1a::hash_value(depth_pass, seed);
+}
+
+
+bool RasterizerState::operator== (const RasterizerState& other) const
+{
+    return cull_enabled == other.cull_enabled && cull_face == other.cull_face &&
+           front_face == other.front_face && polygon_mode == other.polygon_mode &&
+           polygon_offset_enabled == other.polygon_offset_enabled &&
+           polygon_offset_factor == other.polygon_offset_factor &&
+           polygon_offset_units == other.polygon_offset_units &&
+           rasterizer_discard == other.rasterizer_discard;
+}
+
+
+uint64_t RasterizerState::hash(uint64_t seed) const
+{
+    seed = fnv1a::hash_value(cull_enabled, seed);
+    seed = fnv1a::hash_value(cull_face, seed);
+    seed = fnv1a::hash_value(front_face, seed);
+    seed = fnv1a::hash_value(polygon_mode, seed);
+    seed = fnv1a::hash_value(polygon_offset_enabled, seed);
+    seed = fnv1a::hash_value(polygon_offset_factor, seed);
+    seed = fnv1a::hash_value(polygon_offset_units, seed);
+    return fnv1a::hash_value(rasterizer_discard, seed);
+}
+
+
+bool ViewportState::operator== (const ViewportState& other) const
+{
+    return viewport[0] == other.viewport[0] && viewport[1] == other.viewport[1] &&
+           viewport[2] == other.viewport[2] && viewport[3] == other.viewport[3] &&
+           scissor_test == other.scissor_test &&
+           scissor[0] == other.scissor[0] && scissor[1] == other.scissor[1] &&
+           scissor[2] == other.scissor[2] && scissor[3] == other.scissor[3];
+}
+
+
+uint64_t ViewportState::hash(uint64_t seed) const
+{
+    seed = fnv1a::hash(viewport, sizeof(viewport), seed);
+    seed = fnv1a::hash_value(scissor_test, seed);
+    return fnv1a::hash(scissor, sizeof(scissor), seed);
+}
+
+
+bool PipelineDesc::operator== (const PipelineDesc& other) const
+{
+    return program == other.program && vertex_array == other.vertex_array &&
+           blend == other.blend && depth_stencil == other.depth_stencil &&
+           rasterizer == other.rasterizer && viewport == other.viewport;
+}
+
+
+uint64_t PipelineDesc::hash() const
+{
+    uint64_t seed = fnv1a::hash_value(program);
+    seed = fnv1a::hash_value(vertex_array, seed);
+    seed = blend.hash(seed);
+    seed = depth_stencil.hash(seed);
+    seed = rasterizer.hash(seed);
+    return viewport.hash(seed);
+}
+
+
+void PipelineState::apply(const PipelineState* previous) const
+{
+    // program and vertex array may have been changed since, e.g. by compute
+    // dispatches: they are always applied, the state cache dropping redundant calls
+    if (prvt_desc.program != NULL)
+        prvt_desc.program->use();
+    if (prvt_desc.vertex_array != NULL)
+        prvt_desc.vertex_array->bind();
+
+    if (previous == this)
+        return;
+
+    if (previous == NULL) {
+        prvt_apply_blend();
+        prvt_apply_depth_stencil();
+        prvt_apply_rasterizer();
+        prvt_apply_viewport();
+        return;
+    }
+
+    const PipelineDesc& before = previous->prvt_desc;
+    if (prvt_desc.blend != before.blend)
+        prvt_apply_blend();
+    if (prvt_desc.depth_stencil != before.depth_stencil)
+        prvt_apply_depth_stencil();
+    if (prvt_desc.rasterizer != before.rasterizer)
+        prvt_apply_rasterizer();
+    if (prvt_desc.viewport != before.viewport)
+        prvt_apply_viewport();
+}
+
+
+void PipelineState::prvt_apply_blend() const
+{
+    GLStateCache& cache = GLStateCache::get_current();
+    const BlendState& blend = prvt_desc.blend;
+
+    cache.set_capability(GL_BLEND, blend.enabled);
+    if (blend.enabled) {
+        cache.blend_func(blend.src_rgb, blend.dst_rgb, blend.src_alpha, blend.dst_alpha);
+        cache.blend_equation(blend.equation_rgb, blend.equation_alpha);
+    }
+    cache.color_mask(blend.color_mask[0], blend.color_mask[1], blend.color_mask[2], blend.color_mask[3]);
+}
+
+
+void PipelineState::prvt_apply_depth_stencil() const
+{
+    GLStateCache& cache = GLStateCache::get_current();
+    const DepthStencilState& depth_stencil = prvt_desc.depth_stencil;
+
+    cache.set_capability(GL_DEPTH_TEST, depth_stencil.depth_test);
+    if (depth_stencil.depth_test)
+        cache.depth_func(depth_stencil.depth_func);
+    cache.depth_mask(depth_stencil.depth_write);
+
+    cache.set_capability(GL_STENCIL_TEST, depth_stencil.stencil_test);
+    if (depth_stencil.stencil_test) {
+        cache.stencil_func(depth_stencil.stencil_func, depth_stencil.stencil_reference, depth_stencil.stencil_read_mask);
+        cache.stencil_op(depth_stencil.stencil_fail, depth_stencil.depth_fail, depth_stencil.depth_pass);
+    }
+    cache.stencil_mask(depth_stencil.stencil_write_mask);
+}
+
+
+void PipelineState::prvt_apply_rasterizer() const
+{
+    GLStateCache& cache = GLStateCache::get_current();
+    const RasterizerState& rasterizer = prvt_desc.rasterizer;
+
+    cache.set_capability(GL_CULL_FACE, rasterizer.cull_enabled);
+    if (rasterizer.cull_enabled)
+        cache.cull_face(rasterizer.cull_face);
+    cache.front_face(rasterizer.front_face);
+    cache.polygon_mode(rasterizer.polygon_mode);
+
+    cache.set_capability(GL_POLYGON_OFFSET_FILL, rasterizer.polygon_offset_enabled);
+    if (rasterizer.polygon_offset_enabled)
+        cache.polygon_offset(rasterizer.polygon_offset_factor, rasterizer.polygon_offset_units);
+
+    cache.set_capability(GL_RASTERIZER_DISCARD, rasterizer.rasterizer_discard);
+}
+
+
+void PipelineState::prvt_apply_viewport() const
+{
+    GLStateCache& cache = GLStateCache::get_current();
+    const ViewportState& viewport = prvt_desc.viewport;
+
+    if (viewport.viewport[2] > 0 && viewport.viewport[3] > 0)
+        cache.viewport(viewport.viewport[0], viewport.viewport[1], viewport.viewport[2], viewport.viewport[3]);
+
+    cache.set_capability(GL_SCISSOR_TEST, viewport.scissor_test);
+    if (viewport.scissor_test)
+        cache.scissor(viewport.scissor[0], viewport.scissor[1], viewport.scissor[2], viewport.scissor[3]);
+}
+
+
+PipelineStateCache::PipelineStateCache()
+    : prvt_last_applied(NULL)
+{}
+
+
+const PipelineState* PipelineStateCache::acquire(const PipelineDesc& desc)
+{
+    const uint64_t hash = desc.hash();
+    lock_guard<mutex> lock(prvt_mutex);
+
+    vector<const PipelineState*>& bucket = prvt_buckets[hash];
+    for (const PipelineState* state : bucket)
+        if (state->prvt_desc == desc)
+            return state;
+
+    prvt_states.emplace_back(new PipelineState(desc, hash, GLuint(prvt_states.size())));
+    bucket.push_back(prvt_states.back().get());
+    return bucket.back();
+}
+
+
+void PipelineStateCache::apply(const PipelineState* state)
+{
+    state->apply(prvt_last_applied);
+    prvt_last_applied = state;
+}
+
+
+void PipelineStateCache::clear()
+{
+    lock_guard<mutex> lock(prvt_mutex);
+    prvt_buckets.clear();
+    prvt_states.clear();
+    prvt_last_applied = NULL;
+}
+
+
+size_t PipelineStateCache::size() const
+{
+    lock_guard<mutex> lock(prvt_mutex);
+    return prvt_states.size();
+}
@@ -0,0 +1,318 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "profiling/cpu_profiler.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+// The single-producer single-consumer ring of events of one thread.
+struct CPUProfilerRing {
+    vector<CPUProfiler::Event>  events;
+    uint64_t                    mask;
+    uint32_t                    thread_id;
+    atomic<uint64_t>            dropped;
+    alignas(64) atomic<uint64_t> head;      // written by the producer thread only.
+    alignas(64) atomic<uint64_t> tail;      // written by the flusher thread only.
+
+    CPUProfilerRing(const size_t capacity, const uint32_t id)
+        : events(capacity), mask(capacity - 1), thread_id(id), dropped(0), head(0), tail(0)
+    {}
+};
+
+
+//---------------------------------------------------------------------------
+static mutex                                    registry_mutex;
+static vector<shared_ptr<CPUProfilerRing>>      registry;               // the rings of all threads.
+static atomic<size_t>                           ring_capacity(size_t(1) << 16);
+static atomic<uint32_t>                         next_thread_id(0);
+static thread_local shared_ptr<CPUProfilerRing> thread_ring;             // keeps the ring of the thread alive.
+static thread_local CPUProfilerRing*            thread_ring_pointer = NULL; // trivial, hence with no TLS wrapper call.
+static uint64_t                                 pruned_dropped = 0;     // the dropped events of pruned rings.
+
+static mutex                                    flusher_mutex;
+static condition_variable                       flusher_condition;
+static thread                                   flusher;
+static bool                                     flusher_stop = false;
+static ofstream                                 output;
+static CPUProfiler::Format                      output_format = CPUProfiler::CHROME_TRACE;
+static chrono::milliseconds                     flush_interval(50);
+static bool                                     first_output_event = true;
+static unordered_map<const char*, uint32_t>     names_ids;              // used by the flusher only.
+static uint64_t                                 origin_ticks = 0;
+static chrono::steady_clock::time_point         origin_time;
+static double                                   ns_per_tick = 1.0;
+
+atomic<bool> CPUProfiler::prvt_enabled(false);
+
+
+//---------------------------------------------------------------------------
+// Stops profiling at exit, before the flusher thread gets destroyed.
+static struct CPUProfilerExitGuard {
+    ~CPUProfilerExitGuard() {
+        CPUProfiler::stop();
+    }
+} exit_guard;
+
+
+//---------------------------------------------------------------------------
+static CPUProfilerRing* register_thread()
+{
+    size_t capacity = 1;
+    while (capacity < ring_capacity.load(memory_order_relaxed))
+        capacity <<= 1;
+
+    thread_ring = make_shared<CPUProfilerRing>(capacity, next_thread_id.fetch_add(1));
+    thread_ring_pointer = thread_ring.get();
+    lock_guard<mutex> lock(registry_mutex);
+    registry.push_back(thread_ring);
+    return thread_ring_pointer;
+}
+
+
+static void calibrate()
+{
+#ifdef OBJECTGL_CPU_PROFILING_RDTSC
+    // the longer the measure, the finer the ratio
+    const double elapsed_ns = double(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin_time).count());
+    const uint64_t elapsed_ticks = CPUProfiler::now() - origin_ticks;
+    if (elapsed_ticks > 0)
+        ns_per_tick = elapsed_ns / double(elapsed_ticks);
+#else
+    ns_per_tick = 1e9 * double(chrono::steady_clock::period::num) / double(chrono::steady_clock::period::den);
+#endif
+}
+
+
+static inline uint64_t to_ns(const uint64_t ticks)
+{
+    return ticks > origin_ticks ? uint64_t(double(ticks - origin_ticks) * ns_per_tick) : 0;
+}
+
+
+static void write_json_string(ostream& out, const char* text)
+{
+    out << '"';
+    for (; *text != '\0'; ++text) {
+        const char c = *text;
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            out << "\\u" << hex << setw(4) << setfill('0') << int(c) << dec << setfill(' ');
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+
+template<typename T>
+static inline void write_binary(const T value)
+{
+    output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+
+static void write_event(const uint32_t thread_id, const CPUProfiler::Event& event)
+{
+    const uint64_t begin_ns = to_ns(event.begin);
+    const uint64_t end_ns = max(begin_ns, to_ns(event.end));
+
+    if (output_format == CPUProfiler::CHROME_TRACE) {
+        output << (first_output_event ? "\n" : ",\n") << "{\"name\":";
+        write_json_string(output, event.name);
+        output << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread_id
+               << ",\"ts\":" << double(begin_ns) * 1e-3
+               << ",\"dur\":" << double(end_ns - begin_ns) * 1e-3 << "}";
+        first_output_event = false;
+        return;
+    }
+
+    unordered_map<const char*, uint32_t>::const_iterator it = names_ids.find(event.name);
+    if (it == names_ids.end()) {
+        const uint32_t length = uint32_t(strlen(event.name));
+        it = names_ids.emplace(event.name, uint32_t(names_ids.size())).first;
+        output.put('N');
+        write_binary(it->second);
+        write_binary(length);
+        output.write(event.name, length);
+    }
+    output.put('Z');
+    write_binary(thread_id);
+    write_binary(it->second);
+    write_binary(begin_ns);
+    write_binary(end_ns);
+}
+
+
+// Empties all rings, writing their events when 'write' is true.
+static void drain(const bool write)
+{
+    vector<shared_ptr<CPUProfilerRing>> rings;
+    {
+        lock_guard<mutex> lock(registry_mutex);
+        rings = registry;
+    }
+
+    calibrate();
+    for (const shared_ptr<CPUProfilerRing>& ring : rings) {
+        const uint64_t tail = ring->tail.load(memory_order_relaxed);
+        const uint64_t head = ring->head.load(memory_order_acquire);
+        if (write)
+            for (uint64_t i = tail; i != head; ++i)
+                write_event(ring->thread_id, ring->events[i & ring->mask]);
+        ring->tail.store(head, memory_order_release);
+    }
+    rings.clear();
+    if (write)
+        output.flush();
+
+    // prunes the empty rings of terminated threads
+    lock_guard<mutex> lock(registry_mutex);
+    for (size_t i = 0; i < registry.size(); ) {
+        CPUProfilerRing& ring = *registry[i];
+        if (registry[i].use_count() == 1 && ring.head.load(memory_order_acquire) == ring.tail.load(memory_order_relaxed)) {
+            pruned_dropped += ring.dropped.load(memory_order_relaxed);
+            registry[i] = registry.back();
+            registry.pop_back();
+        }
+        else
+            ++i;
+    }
+}
+
+
+static void flush_loop()
+{
+    unique_lock<mutex> lock(flusher_mutex);
+    while (!flusher_stop) {
+        flusher_condition.wait_for(lock, flush_interval);
+        lock.unlock();
+        drain(true);
+        lock.lock();
+    }
+}
+
+
+uint64_t CPUProfiler::get_dropped_events()
+{
+    lock_guard<mutex> lock(registry_mutex);
+    uint64_t dropped = pruned_dropped;
+    for (const shared_ptr<CPUProfilerRing>& ring : registry)
+        dropped += ring->dropped.load(memory_order_relaxed);
+    return dropped;
+}
+
+
+void CPUProfiler::record(const char* name, const uint64_t begin, const uint64_t end)
+{
+    CPUProfilerRing* ring = thread_ring_pointer;
+    if (ring == NULL)
+        ring = register_thread();
+
+    const uint64_t head = ring->head.load(memory_order_relaxed);
+    if (head - ring->tail.load(memory_order_acquire) > ring->mask) {
+        ring->dropped.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    ring->events[head & ring->mask] = Event{ name, begin, end };
+    ring->head.store(head + 1, memory_order_release);
+}
+
+
+void CPUProfiler::set_ring_capacity(const size_t events_count)
+{
+    ring_capacity.store(max(events_count, size_t(2)), memory_order_relaxed);
+}
+
+
+bool CPUProfiler::start(const string& filepath, const Format format, const unsigned flush_interval_ms)
+{
+    if (flusher.joinable()) {
+        cerr << "!!! CPU profiler already started" << endl;
+        return false;
+    }
+
+    output.open(filepath, ios::out | ios::binary | ios::trunc);
+    if (!output) {
+        cerr << "!!! CPU profiler: cannot open output file " << filepath << endl;
+        return false;
+    }
+    output_format = format;
+    flush_interval = chrono::milliseconds(max(flush_interval_ms, 1u));
+    first_output_event = true;
+    names_ids.clear();
+    if (format == CHROME_TRACE)
+        output << fixed << setprecision(3) << "{\"traceEvents\":[";
+    else
+        output.write("OGLCPU01", 8);
+
+    // discards the events left by a previous session
+    drain(false);
+
+    origin_time = chrono::steady_clock::now();
+    origin_ticks = now();
+#ifdef OBJECTGL_CPU_PROFILING_RDTSC
+    // first estimate of the ticks rate, refined at each draining
+    while (chrono::steady_clock::now() - origin_time < chrono::milliseconds(2))
+        ;
+#endif
+    calibrate();
+
+    flusher_stop = false;
+    prvt_enabled.store(true, memory_order_relaxed);
+    flusher = thread(flush_loop);
+    return true;
+}
+
+
+void CPUProfiler::stop()
+{
+    if (!flusher.joinable())
+        return;
+
+    prvt_enabled.store(false, memory_order_relaxed);
+    {
+        lock_guard<mutex> lock(flusher_mutex);
+        flusher_stop = true;
+    }
+    flusher_condition.notify_one();
+    flusher.join();
+
+    drain(true);
+    if (output_format == CHROME_TRACE)
+        output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    output.close();
+}
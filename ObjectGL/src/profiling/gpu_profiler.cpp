@@ -0,0 +1,366 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "profiling/gpu_profiler.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+const char* GPUProfiler::FRAME_ZONE_NAME = "frame";
+
+thread_local GPUProfiler* GPUProfiler::prvt_current = NULL;
+
+
+//---------------------------------------------------------------------------
+static inline const bool are_debug_groups_supported()
+{
+    return GLEW_VERSION_4_3 || GLEW_KHR_debug;
+}
+
+
+static void write_json_string(ostream& out, const string& text)
+{
+    out << '"';
+    for (const char c : text) {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            out << "\\u" << hex << setw(4) << setfill('0') << int(c) << dec << setfill(' ');
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+
+GPUProfiler::GPUProfiler(const GLuint frames_latency, const size_t window)
+    : prvt_frames(frames_latency + 1),
+      prvt_frame_index(0),
+      prvt_frame(NULL),
+      prvt_opened_untimed(0),
+      prvt_window(max(window, size_t(1))),
+      prvt_dropped_frames(0),
+      prvt_trace_capacity(0),
+      prvt_recording(false),
+      prvt_enabled(false)
+{
+    for (Frame& frame : prvt_frames)
+        frame = Frame{ vector<Zone>(), vector<GLuint>(), 0, 0, 0, 0, false };
+    prvt_get_name_id(FRAME_ZONE_NAME);
+}
+
+
+GPUProfiler::~GPUProfiler()
+{
+    for (Frame& frame : prvt_frames) {
+        if (!frame.queries.empty())
+            glDeleteQueries(GLsizei(frame.queries.size()), frame.queries.data());
+        if (frame.begin_query != 0) {
+            glDeleteQueries(1, &frame.begin_query);
+            glDeleteQueries(1, &frame.end_query);
+        }
+    }
+    if (prvt_current == this)
+        prvt_current = NULL;
+}
+
+
+void GPUProfiler::begin_frame()
+{
+    if (prvt_frame != NULL)
+        end_frame();
+
+    // reads back, oldest first, the frames that are at least 'latency' frames old
+    const uint64_t frames_count = prvt_frames.size();
+    const uint64_t latency = frames_count - 1;
+    for (uint64_t age = frames_count; age >= latency && age > 0; --age) {
+        if (age > prvt_frame_index)
+            continue;
+        Frame& frame = prvt_frames[(prvt_frame_index - age) % frames_count];
+        if (frame.pending && !prvt_read_back(frame))
+            break;
+    }
+
+    if (!prvt_enabled || !is_supported())
+        return;
+
+    Frame& frame = prvt_frames[prvt_frame_index % frames_count];
+    if (frame.pending) {
+        // still not available: never waits for it
+        frame.pending = false;
+        ++prvt_dropped_frames;
+    }
+    if (frame.begin_query == 0) {
+        glGenQueries(1, &frame.begin_query);
+        glGenQueries(1, &frame.end_query);
+    }
+    frame.zones.clear();
+    frame.queries_used = 0;
+    frame.index = prvt_frame_index;
+
+    glQueryCounter(frame.begin_query, GL_TIMESTAMP);
+    prvt_frame = &frame;
+}
+
+
+void GPUProfiler::begin_zone(const char* name)
+{
+    if (are_debug_groups_supported())
+        glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+
+    if (prvt_frame == NULL) {
+        ++prvt_opened_untimed;
+        return;
+    }
+
+    const Zone zone{ prvt_get_name_id(name), uint32_t(prvt_opened.size()), prvt_get_query(*prvt_frame), 0 };
+    glQueryCounter(zone.begin_query, GL_TIMESTAMP);
+    prvt_opened.push_back(prvt_frame->zones.size());
+    prvt_frame->zones.push_back(zone);
+}
+
+
+void GPUProfiler::end_zone()
+{
+    if (!prvt_opened.empty()) {
+        Zone& zone = prvt_frame->zones[prvt_opened.back()];
+        prvt_opened.pop_back();
+        zone.end_query = prvt_get_query(*prvt_frame);
+        glQueryCounter(zone.end_query, GL_TIMESTAMP);
+    }
+    else if (prvt_opened_untimed > 0)
+        --prvt_opened_untimed;
+    else {
+        cerr << "!!! GPU profiler: closing a zone that has not been opened" << endl;
+        return;
+    }
+
+    if (are_debug_groups_supported())
+        glPopDebugGroup();
+}
+
+
+void GPUProfiler::end_frame()
+{
+    if (prvt_frame == NULL)
+        return;
+
+    if (!prvt_opened.empty()) {
+        // timed till the end of the frame, they are still closed by their owners,
+        // e.g. GPUZone guards, as zones opened out of frames
+        cerr << "!!! GPU profiler: " << prvt_opened.size() << " zone(s) left opened at the end of the frame" << endl;
+        for (const size_t index : prvt_opened) {
+            Zone& zone = prvt_frame->zones[index];
+            zone.end_query = prvt_get_query(*prvt_frame);
+            glQueryCounter(zone.end_query, GL_TIMESTAMP);
+        }
+        prvt_opened_untimed += prvt_opened.size();
+        prvt_opened.clear();
+    }
+
+    glQueryCounter(prvt_frame->end_query, GL_TIMESTAMP);
+    prvt_frame->pending = true;
+    prvt_frame = NULL;
+    ++prvt_frame_index;
+}
+
+
+void GPUProfiler::get_stats(vector<pair<string, ZoneStats>>& stats) const
+{
+    stats.clear();
+    for (size_t id = 0; id < prvt_names.size(); ++id) {
+        ZoneStats zone_stats;
+        if (get_zone_stats(prvt_names[id], zone_stats))
+            stats.emplace_back(prvt_names[id], zone_stats);
+    }
+    sort(stats.begin(), stats.end(),
+         [](const pair<string, ZoneStats>& a, const pair<string, ZoneStats>& b) { return a.first < b.first; });
+}
+
+
+bool GPUProfiler::get_zone_stats(const string& name, ZoneStats& stats) const
+{
+    const unordered_map<string, uint32_t>::const_iterator it = prvt_names_ids.find(name);
+    if (it == prvt_names_ids.end() || prvt_histories[it->second].samples.empty())
+        return false;
+
+    vector<double> samples = prvt_histories[it->second].samples;
+    double sum = 0.0;
+    for (const double sample : samples)
+        sum += sample;
+
+    const size_t p99_index = (samples.size() * 99 + 99) / 100 - 1;
+    nth_element(samples.begin(), samples.begin() + p99_index, samples.end());
+    stats.p99_ms = samples[p99_index];
+    stats.min_ms = *min_element(samples.begin(), samples.end());
+    stats.avg_ms = sum / double(samples.size());
+    stats.samples = samples.size();
+    return true;
+}
+
+
+void GPUProfiler::set_recording(const bool recording, const size_t max_events)
+{
+    prvt_recording = recording;
+    prvt_trace_capacity = max_events;
+}
+
+
+void GPUProfiler::clear_trace()
+{
+    prvt_trace.clear();
+}
+
+
+void GPUProfiler::write_chrome_trace(ostream& out) const
+{
+    GLuint64 origin = ~GLuint64(0);
+    for (const TraceEvent& event : prvt_trace)
+        origin = min(origin, event.begin_ns);
+
+    const ios_base::fmtflags flags = out.flags();
+    const streamsize precision = out.precision();
+    out << fixed << setprecision(3);
+
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < prvt_trace.size(); ++i) {
+        const TraceEvent& event = prvt_trace[i];
+        out << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+        write_json_string(out, prvt_names[event.name_id]);
+        out << ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0"
+            << ",\"ts\":" << double(event.begin_ns - origin) * 1e-3
+            << ",\"dur\":" << double(event.end_ns - event.begin_ns) * 1e-3
+            << ",\"args\":{\"frame\":" << event.frame << ",\"depth\":" << event.depth << "}}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+
+bool GPUProfiler::write_chrome_trace(const string& filepath) const
+{
+    ofstream out(filepath);
+    if (!out) {
+        cerr << "!!! GPU profiler: cannot open trace file " << filepath << endl;
+        return false;
+    }
+    write_chrome_trace(out);
+    return bool(out);
+}
+
+
+GPUProfiler& GPUProfiler::get_current()
+{
+    if (prvt_current != NULL)
+        return *prvt_current;
+    static thread_local GPUProfiler default_profiler;
+    return default_profiler;
+}
+
+
+void GPUProfiler::set_current(GPUProfiler* profiler)
+{
+    prvt_current = profiler;
+}
+
+
+void GPUProfiler::prvt_add_sample(const uint32_t name_id, const double duration_ms)
+{
+    History& history = prvt_histories[name_id];
+    if (history.samples.size() < prvt_window)
+        history.samples.push_back(duration_ms);
+    else
+        history.samples[history.next] = duration_ms;
+    history.next = (history.next + 1) % prvt_window;
+}
+
+
+uint32_t GPUProfiler::prvt_get_name_id(const char* name)
+{
+    const unordered_map<string, uint32_t>::const_iterator it = prvt_names_ids.find(name);
+    if (it != prvt_names_ids.end())
+        return it->second;
+
+    const uint32_t id = uint32_t(prvt_names.size());
+    prvt_names.emplace_back(name);
+    prvt_names_ids.emplace(prvt_names.back(), id);
+    prvt_histories.push_back(History{ vector<double>(), 0 });
+    return id;
+}
+
+
+GLuint GPUProfiler::prvt_get_query(Frame& frame)
+{
+    if (frame.queries_used == frame.queries.size()) {
+        // grows the pool of this frame by chunks
+        const size_t chunk = max(frame.queries.size(), size_t(32));
+        frame.queries.resize(frame.queries.size() + chunk);
+        glGenQueries(GLsizei(chunk), frame.queries.data() + frame.queries_used);
+    }
+    return frame.queries[frame.queries_used++];
+}
+
+
+bool GPUProfiler::prvt_read_back(Frame& frame)
+{
+    // the end of the frame is the last timestamp issued in it
+    GLint available = 0;
+    glGetQueryObjectiv(frame.end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    GLuint64 frame_begin = 0, frame_end = 0;
+    glGetQueryObjectui64v(frame.begin_query, GL_QUERY_RESULT, &frame_begin);
+    glGetQueryObjectui64v(frame.end_query, GL_QUERY_RESULT, &frame_end);
+    frame_end = max(frame_begin, frame_end);
+    prvt_add_sample(0, double(frame_end - frame_begin) * 1e-6);
+
+    const bool recording = prvt_recording && prvt_trace.size() < prvt_trace_capacity;
+    if (recording)
+        prvt_trace.push_back(TraceEvent{ 0, 0, frame.index, frame_begin, frame_end });
+
+    for (const Zone& zone : frame.zones) {
+        if (zone.end_query == 0)
+            continue;
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(zone.begin_query, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(zone.end_query, GL_QUERY_RESULT, &end);
+        end = max(begin, end);
+        prvt_add_sample(zone.name_id, double(end - begin) * 1e-6);
+        if (recording && prvt_trace.size() < prvt_trace_capacity)
+            prvt_trace.push_back(TraceEvent{ zone.name_id, zone.depth + 1, frame.index, begin, end });
+    }
+
+    frame.pending = false;
+    return true;
+}
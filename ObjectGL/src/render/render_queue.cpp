@@ -0,0 +1,189 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "render/render_queue.h"
+#include "context/gl_state.h"
+#include "context/memory_barriers.h"
+#include "profiling/gpu_profiler.h"
+#include "profiling/cpu_profiler.h"
+
+using namespace std;
+
+
+RenderQueue::RenderQueue(const GLuint constants_binding, const size_t reserved_count)
+    : prvt_constants_binding(constants_binding),
+      prvt_sorted(true),
+      prvt_stats{ 0, 0, 0, 0 }
+{
+    prvt_packets.reserve(reserved_count);
+}
+
+
+void RenderQueue::sort()
+{
+    const size_t count = prvt_packets.size();
+    prvt_keys.resize(2 * count);
+    prvt_order.resize(2 * count);
+
+    uint64_t* keys = prvt_keys.data();
+    uint64_t* keys_tmp = keys + count;
+    uint32_t* order = prvt_order.data();
+    uint32_t* order_tmp = order + count;
+
+    for (size_t i = 0; i < count; ++i) {
+        keys[i] = prvt_packets[i].key;
+        order[i] = uint32_t(i);
+    }
+
+    // builds the histograms of all the 8 bytes at once
+    size_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+    for (size_t i = 0; i < count; ++i)
+        for (int byte = 0; byte < 8; ++byte)
+            ++histograms[byte][(keys[i] >> (8 * byte)) & 0xff];
+
+    // LSD radix sort, skipping the bytes that are the same for all keys
+    for (int byte = 0; byte < 8; ++byte) {
+        size_t* histogram = histograms[byte];
+        if (count == 0 || histogram[(keys[0] >> (8 * byte)) & 0xff] == count)
+            continue;
+
+        size_t offset = 0;
+        for (int value = 0; value < 256; ++value) {
+            const size_t value_count = histogram[value];
+            histogram[value] = offset;
+            offset += value_count;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const size_t destination = histogram[(keys[i] >> (8 * byte)) & 0xff]++;
+            keys_tmp[destination] = keys[i];
+            order_tmp[destination] = order[i];
+        }
+        swap(keys, keys_tmp);
+        swap(order, order_tmp);
+    }
+
+    // the sorted indices are expected at the beginning of the buffer
+    if (order != prvt_order.data())
+        memcpy(prvt_order.data(), order, count * sizeof(uint32_t));
+    prvt_order.resize(count);
+    prvt_sorted = true;
+}
+
+
+void RenderQueue::submit(PipelineStateCache& pipeline_states)
+{
+    OBJECTGL_CPU_ZONE("RenderQueue::submit");
+    if (!prvt_sorted)
+        sort();
+
+    GLStateCache& cache = GLStateCache::get_current();
+    prvt_stats = Stats{ 0, 0, 0, 0 };
+
+    // e.g. vertex buffers or textures written by previous dispatches
+    MemoryBarriers::get_current().flush();
+
+    // one GPU zone per run of draws with the same program
+    OBJECTGL_GPU_ZONE("render queue");
+    GPUProfiler& profiler = GPUProfiler::get_current();
+    const bool profiling = profiler.is_enabled();
+    const ShadersProgram* zone_program = NULL;
+    bool zone_opened = false;
+
+    const GLuint* textures = NULL;
+    GLsizei textures_count = 0;
+
+    for (const uint32_t index : prvt_order) {
+        const DrawPacket& packet = prvt_packets[index];
+
+        const PipelineState* previous_state = pipeline_states.get_last_applied();
+        if (packet.state != previous_state) {
+            ++prvt_stats.state_changes;
+            if (previous_state == NULL || packet.state->get_desc().program != previous_state->get_desc().program)
+                ++prvt_stats.program_changes;
+            pipeline_states.apply(packet.state);
+        }
+
+        ShadersProgram* program = packet.state->get_desc().program;
+        if (profiling && (!zone_opened || program != zone_program)) {
+            if (zone_opened)
+                profiler.end_zone();
+            profiler.begin_zone(program == NULL || program->get_label().empty() ? "draws" : program->get_label().c_str());
+            zone_program = program;
+            zone_opened = true;
+        }
+        if (program != NULL)
+            program->flush_uniforms();
+
+        if (packet.textures_count > 0 && (packet.textures != textures || packet.textures_count != textures_count)) {
+            ++prvt_stats.textures_changes;
+            cache.bind_textures(0, packet.textures_count, packet.textures);
+            textures = packet.textures;
+            textures_count = packet.textures_count;
+        }
+
+        if (packet.constants_buffer != 0)
+            cache.bind_buffer_range(GL_UNIFORM_BUFFER, prvt_constants_binding, packet.constants_buffer, packet.constants_offset, packet.constants_size);
+
+        if (packet.index_type != 0)
+            glDrawElementsInstancedBaseVertexBaseInstance(packet.mode, packet.count, packet.index_type,
+                                                          reinterpret_cast<const void*>(packet.first),
+                                                          packet.instance_count, packet.base_vertex, packet.base_instance);
+        else
+            glDrawArraysInstancedBaseInstance(packet.mode, GLint(packet.first), packet.count, packet.instance_count, packet.base_instance);
+        ++prvt_stats.draws;
+    }
+
+    if (zone_opened)
+        profiler.end_zone();
+}
+
+
+uint64_t RenderQueue::make_key(const uint32_t layer, const bool translucent, const uint32_t program_id, const uint32_t pipeline_id, const uint32_t material_id, const float depth)
+{
+    // the bits of positive floats sort as the floats themselves do
+    uint32_t depth_bits = 0;
+    if (depth > 0.0f) {
+        memcpy(&depth_bits, &depth, sizeof(depth_bits));
+        depth_bits >>= 11;  // i.e. 20 bits, sign bit excluded
+    }
+
+    const uint64_t state = (uint64_t(program_id & MAX_PROGRAM_ID) << 29) |
+                           (uint64_t(pipeline_id & MAX_PIPELINE_ID) << 15) |
+                           uint64_t(material_id & MAX_MATERIAL_ID);
+    uint64_t key = uint64_t(layer & MAX_LAYER) << 60;
+
+    if (translucent)
+        key |= (uint64_t(1) << 59) | (uint64_t(0xfffff - depth_bits) << 39) | state;
+    else
+        key |= (state << 20) | uint64_t(depth_bits);
+    return key;
+}
@@ -0,0 +1,133 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <iostream>
+#include "shaders/compute_program.h"
+#include "profiling/gpu_profiler.h"
+#include "profiling/cpu_profiler.h"
+
+using namespace std;
+
+
+ComputeProgram::ComputeProgram(ComputeShader& shader, const bool verbose)
+    : ComputeProgram()
+{
+    ShadersList shaders{ &shader };
+    if (attach_shaders(shaders))
+        if (compile_shaders(verbose))
+            link();
+}
+
+
+ComputeProgram::ComputeProgram(ComputeShader& shader, ProgramBinaryCache& cache, const bool verbose)
+    : ComputeProgram()
+{
+    ShadersList shaders{ &shader };
+    if (attach_shaders(shaders))
+        link(cache, verbose);
+}
+
+
+void ComputeProgram::dispatch(const GLuint groups_x, const GLuint groups_y, const GLuint groups_z)
+{
+    OBJECTGL_CPU_ZONE("ComputeProgram::dispatch");
+    if (!linked || groups_x == 0 || groups_y == 0 || groups_z == 0)
+        return;
+
+    GPUZone zone(get_label().empty() ? "dispatch" : get_label().c_str());
+    prvt_before_dispatch();
+    glDispatchCompute(groups_x, groups_y, groups_z);
+    prvt_after_dispatch();
+}
+
+
+void ComputeProgram::dispatch_for(const GLuint size_x, const GLuint size_y, const GLuint size_z)
+{
+    dispatch(get_groups_count(size_x, 0), get_groups_count(size_y, 1), get_groups_count(size_z, 2));
+}
+
+
+void ComputeProgram::dispatch_indirect(const Buffer& buffer, const GLintptr offset)
+{
+    OBJECTGL_CPU_ZONE("ComputeProgram::dispatch_indirect");
+    if (!linked)
+        return;
+
+    GPUZone zone(get_label().empty() ? "dispatch" : get_label().c_str());
+    MemoryBarriers::get_current().require_buffer(buffer.name, GL_COMMAND_BARRIER_BIT);
+    prvt_before_dispatch();
+    GLStateCache::get_current().bind_buffer(GL_DISPATCH_INDIRECT_BUFFER, buffer.name);
+    glDispatchComputeIndirect(offset);
+    prvt_after_dispatch();
+}
+
+
+const GLint* ComputeProgram::get_work_group_size()
+{
+    if (prvt_work_group_link_count != get_link_count()) {
+        prvt_work_group_link_count = get_link_count();
+        if (linked)
+            glGetProgramiv(name, GL_COMPUTE_WORK_GROUP_SIZE, prvt_work_group_size);
+        else
+            prvt_work_group_size[0] = prvt_work_group_size[1] = prvt_work_group_size[2] = 0;
+    }
+    return prvt_work_group_size;
+}
+
+
+void ComputeProgram::get_max_groups_count(GLint counts[3])
+{
+    for (GLuint i = 0; i < 3; ++i)
+        glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, i, counts + i);
+}
+
+
+void ComputeProgram::prvt_before_dispatch()
+{
+    use();
+    flush_uniforms();
+
+    MemoryBarriers& barriers = MemoryBarriers::get_current();
+    for (const Resource& input : prvt_inputs) {
+        if (input.is_texture)
+            barriers.require_texture(input.name, input.barrier_bits);
+        else
+            barriers.require_buffer(input.name, input.barrier_bits);
+    }
+    barriers.flush();
+}
+
+
+void ComputeProgram::prvt_after_dispatch()
+{
+    MemoryBarriers& barriers = MemoryBarriers::get_current();
+    for (const Resource& output : prvt_outputs) {
+        if (output.is_texture)
+            barriers.on_texture_written(output.name);
+        else
+            barriers.on_buffer_written(output.name);
+    }
+}
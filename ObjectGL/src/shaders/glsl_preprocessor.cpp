@@ -0,0 +1,331 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <filesystem>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "shaders/glsl_preprocessor.h"
+#include "utils/mapped_file.h"
+
+using namespace std;
+
+
+GLSLPreprocessor::GLSLPreprocessor(const vector<string>& include_directories)
+    : prvt_include_directories(include_directories),
+      prvt_stats{ 0, 0 }
+{}
+
+
+void GLSLPreprocessor::add_include_directory(const string& directory_path)
+{
+    prvt_include_directories.push_back(directory_path);
+}
+
+
+void GLSLPreprocessor::clear()
+{
+    prvt_units.clear();
+    prvt_dependents.clear();
+}
+
+
+vector<string> GLSLPreprocessor::get_dependents(const string& filepath) const
+{
+    vector<string> dependents;
+    set<string> visited;
+    vector<string> to_visit(1, prvt_canonical(filepath));
+
+    while (!to_visit.empty()) {
+        const string path = to_visit.back();
+        to_visit.pop_back();
+
+        const auto found = prvt_dependents.find(path);
+        if (found != prvt_dependents.end())
+            for (const string& dependent : found->second)
+                if (visited.insert(dependent).second) {
+                    dependents.push_back(dependent);
+                    to_visit.push_back(dependent);
+                }
+    }
+    return dependents;
+}
+
+
+vector<string> GLSLPreprocessor::get_includes(const string& filepath) const
+{
+    vector<string> includes;
+    const auto found = prvt_units.find(prvt_canonical(filepath));
+    if (found != prvt_units.end())
+        for (const Segment& segment : found->second.segments)
+            if (segment.is_include && find(includes.begin(), includes.end(), segment.content) == includes.end())
+                includes.push_back(segment.content);
+    return includes;
+}
+
+
+void GLSLPreprocessor::invalidate(const string& filepath)
+{
+    // dependency edges are kept, so that dependents can still be evaluated until next parsing
+    prvt_units.erase(prvt_canonical(filepath));
+}
+
+
+bool GLSLPreprocessor::preprocess(const string& filepath, string& out_source_code, vector<string>* out_source_paths)
+{
+    set<string> inserted;
+    vector<string> stack;
+    vector<string> sources;
+
+    out_source_code.clear();
+    const bool ok = prvt_expand(prvt_canonical(filepath), inserted, stack, sources, out_source_code);
+    if (out_source_paths != NULL)
+        out_source_paths->swap(sources);
+    return ok;
+}
+
+
+const string GLSLPreprocessor::prvt_canonical(const filesystem::path& path)
+{
+    error_code err;
+    const filesystem::path canonical = filesystem::weakly_canonical(path, err);
+    return err ? path.lexically_normal().generic_string() : canonical.generic_string();
+}
+
+
+bool GLSLPreprocessor::prvt_expand(const string& path, set<string>& inserted, vector<string>& stack, vector<string>& sources, string& out)
+{
+    if (find(stack.begin(), stack.end(), path) != stack.end()) {
+        cerr << "!!! cyclic inclusion of GLSL file '" << path << "'" << endl;
+        return false;
+    }
+
+    const Unit* unit = prvt_get_unit(path);
+    if (unit == NULL)
+        return false;
+
+    const bool is_root = stack.empty();
+    if (!inserted.insert(path).second && unit->once)
+        return true;
+
+    const size_t source_index = sources.size();
+    sources.push_back(path);
+    if (!is_root)
+        out += "#line 1 " + to_string(source_index) + "\n";
+
+    stack.push_back(path);
+    for (const Segment& segment : unit->segments) {
+        if (segment.is_include) {
+            if (!prvt_expand(segment.content, inserted, stack, sources, out))
+                return false;
+            out += "#line " + to_string(segment.next_line) + " " + to_string(source_index) + "\n";
+        }
+        else
+            out += segment.content;
+    }
+    stack.pop_back();
+    return true;
+}
+
+
+const GLSLPreprocessor::Unit* GLSLPreprocessor::prvt_get_unit(const string& path)
+{
+    error_code err;
+    const filesystem::file_time_type mtime = filesystem::last_write_time(path, err);
+    if (err) {
+        cerr << "!!! cannot access GLSL file '" << path << "': " << err.message() << endl;
+        return NULL;
+    }
+
+    auto found = prvt_units.find(path);
+    if (found != prvt_units.end() && found->second.mtime == mtime) {
+        ++prvt_stats.cache_hits;
+        return &found->second;
+    }
+
+    Unit unit;
+    unit.mtime = mtime;
+    if (!prvt_parse(path, unit))
+        return NULL;
+
+    // updates the dependency graph
+    for (const string& include : get_includes(path))
+        prvt_dependents[include].erase(path);
+    for (const Segment& segment : unit.segments)
+        if (segment.is_include)
+            prvt_dependents[segment.content].insert(path);
+
+    Unit& cached = prvt_units[path];
+    cached = move(unit);
+    return &cached;
+}
+
+
+// returns the identifier that starts at position 'i' in 'line', and moves 'i' past it
+static const string get_identifier(const string& line, size_t& i)
+{
+    while (i < line.size() && (line[i] == ' ' || line[i] == '\t'))
+        ++i;
+    const size_t start = i;
+    while (i < line.size() && (isalnum((unsigned char)line[i]) || line[i] == '_'))
+        ++i;
+    return line.substr(start, i - start);
+}
+
+
+bool GLSLPreprocessor::prvt_parse(const string& path, Unit& unit)
+{
+    MappedFile file(path.c_str());
+    if (!file.is_ok()) {
+        cerr << "!!! cannot map GLSL file '" << path << "'" << endl;
+        return false;
+    }
+    ++prvt_stats.parses;
+
+    unit.segments.clear();
+    unit.once = false;
+
+    string text;                    // the text segment under construction
+    vector<string> significants;    // the first two significant lines, plus the last one
+    bool in_block_comment = false;
+    unsigned line_number = 0;
+
+    const char* cursor = file.data();
+    const char* const end = cursor + file.size();
+    while (cursor < end) {
+        const char* eol = find(cursor, end, '\n');
+        const string line(cursor, eol);
+        cursor = (eol < end) ? eol + 1 : end;
+        ++line_number;
+
+        const bool directive_allowed = !in_block_comment;
+        bool significant = in_block_comment;
+        for (size_t i = 0; i < line.size(); ++i) {
+            if (in_block_comment) {
+                if (line.compare(i, 2, "*/") == 0) {
+                    in_block_comment = false;
+                    ++i;
+                }
+            }
+            else if (line.compare(i, 2, "//") == 0)
+                break;
+            else if (line.compare(i, 2, "/*") == 0) {
+                in_block_comment = true;
+                ++i;
+            }
+            else if (line[i] != ' ' && line[i] != '\t' && line[i] != '\r')
+                significant = true;
+        }
+
+        size_t i = line.find_first_not_of(" \t");
+        if (directive_allowed && i != string::npos && line[i] == '#') {
+            ++i;
+            const string directive = get_identifier(line, i);
+
+            if (directive == "include") {
+                while (i < line.size() && (line[i] == ' ' || line[i] == '\t'))
+                    ++i;
+                const char closing = (i < line.size() && line[i] == '<') ? '>' : '"';
+                const size_t closing_pos = (i < line.size()) ? line.find(closing, i + 1) : string::npos;
+                if (i >= line.size() || (line[i] != '"' && line[i] != '<') || closing_pos == string::npos) {
+                    cerr << "!!! " << path << "(" << line_number << "): malformed #include directive" << endl;
+                    return false;
+                }
+
+                const string include_name = line.substr(i + 1, closing_pos - i - 1);
+                const string include_path = prvt_resolve(include_name, closing == '"', path);
+                if (include_path.empty()) {
+                    cerr << "!!! " << path << "(" << line_number << "): cannot find included file '" << include_name << "'" << endl;
+                    return false;
+                }
+
+                if (!text.empty())
+                    unit.segments.push_back(Segment{ false, move(text), line_number });
+                text.clear();
+                unit.segments.push_back(Segment{ true, include_path, line_number + 1 });
+                continue;
+            }
+
+            if (directive == "pragma") {
+                size_t j = i;
+                if (get_identifier(line, j) == "once") {
+                    unit.once = true;
+                    text += '\n';   // keeps lines numbering
+                    continue;
+                }
+            }
+        }
+
+        if (significant && directive_allowed) {
+            if (significants.size() < 3)
+                significants.push_back(line);
+            else
+                significants[2] = line;
+        }
+
+        text += line;
+        text += '\n';
+    }
+    if (!text.empty())
+        unit.segments.push_back(Segment{ false, move(text), line_number + 1 });
+
+    // include guards detection: '#ifndef X' and '#define X' first, '#endif' last
+    if (!unit.once && significants.size() == 3) {
+        string directives[3], macros[2];
+        for (int k = 0; k < 3; ++k) {
+            size_t i = significants[k].find_first_not_of(" \t");
+            if (i == string::npos || significants[k][i] != '#')
+                return true;
+            ++i;
+            directives[k] = get_identifier(significants[k], i);
+            if (k < 2)
+                macros[k] = get_identifier(significants[k], i);
+        }
+        unit.once = directives[0] == "ifndef" && directives[1] == "define" &&
+                    directives[2] == "endif" && !macros[0].empty() && macros[0] == macros[1];
+    }
+    return true;
+}
+
+
+const string GLSLPreprocessor::prvt_resolve(const string& include_name, const bool quoted, const string& includer_path) const
+{
+    error_code err;
+    if (quoted) {
+        const filesystem::path candidate = filesystem::path(includer_path).parent_path() / include_name;
+        if (filesystem::is_regular_file(candidate, err))
+            return prvt_canonical(candidate);
+    }
+    for (const string& directory : prvt_include_directories) {
+        const filesystem::path candidate = filesystem::path(directory) / include_name;
+        if (filesystem::is_regular_file(candidate, err))
+            return prvt_canonical(candidate);
+    }
+    return string();
+}
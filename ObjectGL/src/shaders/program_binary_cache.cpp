@@ -0,0 +1,207 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "shaders/program_binary_cache.h"
+#include "trace/gl_dispatch.h"
+
+using namespace std;
+
+
+// the header of each cached binary file
+struct ProgramBinaryFileHeader {
+    uint32_t magic;     // always 'OGPB'
+    uint32_t version;   // the version of this file format
+    uint64_t key;       // the cache key, checked against collisions of file names
+    uint32_t format;    // the driver-specific binary format
+    uint32_t length;    // the length of the binary, in bytes
+};
+
+static const uint32_t PROGRAM_BINARY_MAGIC   = 0x4250474f;  // i.e. "OGPB"
+static const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+
+ProgramBinaryCache::ProgramBinaryCache(const string& directory_path)
+    : prvt_directory_path(directory_path),
+      prvt_driver_hash(0),
+      prvt_stats{ 0, 0, 0, 0 },
+      prvt_formats_count(-1)
+{
+    error_code err;
+    filesystem::create_directories(prvt_directory_path, err);
+    if (err)
+        cerr << "!!! cannot create program binaries cache directory '" << prvt_directory_path << "': " << err.message() << endl;
+}
+
+
+void ProgramBinaryCache::clear()
+{
+    error_code err;
+    for (const filesystem::directory_entry& entry : filesystem::directory_iterator(prvt_directory_path, err))
+        if (entry.path().extension() == ".bin")
+            filesystem::remove(entry.path(), err);
+}
+
+
+uint64_t ProgramBinaryCache::evaluate_key(const ShadersList& shaders)
+{
+    uint64_t key = prvt_get_driver_hash();
+    for (const Shader* shader : shaders)
+        key = fnv1a::combine(key, shader->get_source_hash());
+    return key;
+}
+
+
+bool ProgramBinaryCache::is_supported()
+{
+    if (prvt_formats_count < 0)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &prvt_formats_count);
+    return prvt_formats_count > 0;
+}
+
+
+bool ProgramBinaryCache::load(const GLuint program_name, const uint64_t key)
+{
+    if (!is_supported()) {
+        ++prvt_stats.misses;
+        return false;
+    }
+
+    const string filepath = prvt_get_filepath(key);
+    ifstream in_stream(filepath, ios::binary);
+    if (!in_stream.is_open()) {
+        ++prvt_stats.misses;
+        return false;
+    }
+
+    ProgramBinaryFileHeader header;
+    in_stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    // the binary must fill the rest of the file exactly, so that a corrupted length never gets allocated
+    error_code err;
+    const uintmax_t file_size = filesystem::file_size(filepath, err);
+
+    vector<char> binary;
+    bool ok = in_stream.good() &&
+              header.magic == PROGRAM_BINARY_MAGIC &&
+              header.version == PROGRAM_BINARY_VERSION &&
+              header.key == key &&
+              !err && header.length > 0 && file_size - sizeof(header) == header.length;
+    if (ok) {
+        binary.resize(header.length);
+        in_stream.read(binary.data(), header.length);
+        ok = in_stream.good();
+    }
+    in_stream.close();
+
+    if (ok) {
+        GLint status = GL_FALSE;
+        glProgramBinary(program_name, GLenum(header.format), binary.data(), GLsizei(header.length));
+        glGetProgramiv(program_name, GL_LINK_STATUS, &status);
+        ok = (status == GL_TRUE);
+    }
+
+    if (ok)
+        ++prvt_stats.hits;
+    else {
+        // either a corrupted file or a binary that is rejected by the driver
+        ++prvt_stats.invalidations;
+        filesystem::remove(filepath, err);
+    }
+    return ok;
+}
+
+
+bool ProgramBinaryCache::store(const GLuint program_name, const uint64_t key)
+{
+    if (!is_supported())
+        return false;
+
+    GLint length = 0;
+    glGetProgramiv(program_name, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return false;
+
+    vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program_name, length, &length, &format, binary.data());
+
+    ProgramBinaryFileHeader header{ PROGRAM_BINARY_MAGIC, PROGRAM_BINARY_VERSION, key, uint32_t(format), uint32_t(length) };
+
+    // writes into a temporary file first so that concurrent processes never read partial binaries
+    const string filepath = prvt_get_filepath(key);
+    const string tmp_filepath = filepath + ".tmp";
+    ofstream out_stream(tmp_filepath, ios::binary | ios::trunc);
+    if (!out_stream.is_open()) {
+        cerr << "!!! cannot write program binary file '" << tmp_filepath << "'" << endl;
+        return false;
+    }
+    out_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out_stream.write(binary.data(), length);
+    out_stream.close();
+
+    error_code err;
+    filesystem::rename(tmp_filepath, filepath, err);
+    if (err) {
+        filesystem::remove(tmp_filepath, err);
+        return false;
+    }
+
+    ++prvt_stats.stores;
+    return true;
+}
+
+
+const string ProgramBinaryCache::prvt_get_filepath(const uint64_t key) const
+{
+    ostringstream filename;
+    filename << hex << setw(16) << setfill('0') << key << ".bin";
+    return (filesystem::path(prvt_directory_path) / filename.str()).string();
+}
+
+
+uint64_t ProgramBinaryCache::prvt_get_driver_hash()
+{
+    if (prvt_driver_hash == 0) {
+        uint64_t hash = fnv1a::OFFSET_BASIS;
+        const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+        for (const GLenum name : names) {
+            const GLubyte* text = glGetString(name);
+            if (text != NULL)
+                hash = fnv1a::hash(string(reinterpret_cast<const char*>(text)), hash);
+        }
+        prvt_driver_hash = hash;
+    }
+    return prvt_driver_hash;
+}
@@ -0,0 +1,121 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "shaders/program_reflection.h"
+
+using namespace std;
+
+
+// the OpenGL program interface of each reflected interface
+static const GLenum PROGRAM_INTERFACES[ProgramReflection::INTERFACES_COUNT] = {
+    GL_UNIFORM, GL_PROGRAM_INPUT, GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK, GL_ATOMIC_COUNTER_BUFFER
+};
+
+
+const ProgramReflection::Resource* ProgramReflection::find(const Interface itf, const char* name) const
+{
+    const size_t length = strlen(name);
+    for (const Resource& resource : prvt_resources[itf]) {
+        const char* resource_name = get_name(resource);
+        if (strncmp(resource_name, name, length) == 0 &&
+            (resource_name[length] == '\0' || strcmp(resource_name + length, "[0]") == 0))
+            return &resource;
+    }
+    return NULL;
+}
+
+
+void ProgramReflection::reflect(const GLuint program_name)
+{
+    prvt_names.clear();
+    for (int itf = 0; itf < INTERFACES_COUNT; ++itf)
+        prvt_reflect_interface(program_name, Interface(itf));
+}
+
+
+void ProgramReflection::prvt_reflect_interface(const GLuint program_name, const Interface itf)
+{
+    vector<Resource>& resources = prvt_resources[itf];
+    resources.clear();
+
+    const GLenum program_interface = PROGRAM_INTERFACES[itf];
+    GLint count = 0;
+    glGetProgramInterfaceiv(program_name, program_interface, GL_ACTIVE_RESOURCES, &count);
+    resources.reserve(count);
+
+    const bool named = (itf != ATOMIC_COUNTER_BUFFERS);
+    GLint max_name_length = 0;
+    if (named)
+        glGetProgramInterfaceiv(program_name, program_interface, GL_MAX_NAME_LENGTH, &max_name_length);
+    vector<GLchar> name(size_t(max_name_length) + 1, '\0');
+
+    for (GLint index = 0; index < count; ++index) {
+        Resource resource{ GLuint(prvt_names.size()), 0, -1, 1, -1, -1, -1, -1, -1 };
+
+        switch (itf) {
+        case UNIFORMS: {
+            const GLenum props[] = { GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE, GL_BLOCK_INDEX, GL_OFFSET, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE };
+            GLint values[7];
+            glGetProgramResourceiv(program_name, program_interface, GLuint(index), 7, props, 7, NULL, values);
+            resource.type = GLenum(values[0]);
+            resource.location = values[1];
+            resource.array_size = values[2];
+            resource.block_index = values[3];
+            resource.offset = values[4];
+            resource.array_stride = values[5];
+            resource.matrix_stride = values[6];
+            break;
+        }
+        case INPUTS: {
+            const GLenum props[] = { GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE };
+            GLint values[3];
+            glGetProgramResourceiv(program_name, program_interface, GLuint(index), 3, props, 3, NULL, values);
+            resource.type = GLenum(values[0]);
+            resource.location = values[1];
+            resource.array_size = values[2];
+            break;
+        }
+        default: {
+            const GLenum props[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+            GLint values[2];
+            glGetProgramResourceiv(program_name, program_interface, GLuint(index), 2, props, 2, NULL, values);
+            resource.binding = values[0];
+            resource.offset = values[1];
+            break;
+        }
+        }
+
+        GLsizei length = 0;
+        if (named)
+            glGetProgramResourceName(program_name, program_interface, GLuint(index), GLsizei(name.size()), &length, name.data());
+        prvt_names.insert(prvt_names.end(), name.data(), name.data() + length);
+        prvt_names.push_back('\0');
+
+        resources.push_back(resource);
+    }
+}
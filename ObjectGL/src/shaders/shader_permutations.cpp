@@ -0,0 +1,236 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "shaders/program_binary_cache.h"
+#include "shaders/shader_permutations.h"
+
+using namespace std;
+
+
+// the estimated footprint of a variant when the driver does not report the size of its binary
+static const size_t DEFAULT_VARIANT_MEMORY = 64 * 1024;
+
+
+// gathers the compile logs of the failing shaders, or the linking log of the program once all shaders compiled
+static string build_log(const ShadersList& shaders, ShadersProgram& program, const bool loaded)
+{
+    // sources which could not be loaded have already been reported while loading them
+    if (!loaded)
+        return string();
+
+    string log, shader_log;
+    for (Shader* shader : shaders)
+        if (!shader->compile(shader_log))
+            log += "\n" + shader_log;
+    if (!log.empty())
+        return log;
+
+    program.get_linking_log(log);
+    return log.empty() ? log : "\n" + log;
+}
+
+
+ShaderPermutations::ShaderPermutations(const string& glsl_version, const vector<string>& keywords)
+    : prvt_version("#version " + glsl_version + "\n"),
+      prvt_stats{ 0, 0, 0, 0, 0 },
+      prvt_memory_budget(0),
+      prvt_tick(0),
+      prvt_binary_cache(NULL),
+      prvt_preprocessor(NULL)
+{
+    if (keywords.size() > 64)
+        cerr << "!!! shader permutations are limited to 64 keywords, extra ones are ignored" << endl;
+
+    const size_t count = keywords.size() < 64 ? keywords.size() : 64;
+    prvt_keywords.assign(keywords.begin(), keywords.begin() + count);
+    prvt_defines.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        prvt_defines.push_back("#define " + keywords[i] + " 1\n");
+}
+
+
+ShaderPermutations::~ShaderPermutations()
+{
+    clear();
+}
+
+
+void ShaderPermutations::add_stage_file(const GLenum type, const string& filepath)
+{
+    prvt_stages.push_back(Stage{ type, filepath, string() });
+}
+
+
+void ShaderPermutations::add_stage_source(const GLenum type, const string& source_code)
+{
+    prvt_stages.push_back(Stage{ type, string(), source_code });
+}
+
+
+void ShaderPermutations::clear()
+{
+    for (auto& entry : prvt_variants)
+        prvt_release(entry.second);
+    prvt_variants.clear();
+    prvt_last_key.reset();
+    prvt_stats.memory_used = 0;
+}
+
+
+ShadersProgram* ShaderPermutations::get(const Key key, const bool verbose)
+{
+    ++prvt_tick;
+
+    auto found = prvt_variants.find(key);
+    if (found != prvt_variants.end()) {
+        if (found->second.program) {
+            ++prvt_stats.hits;
+            found->second.last_use = prvt_tick;
+            prvt_last_key = key;
+        }
+        return found->second.program.get();
+    }
+
+    Variant& variant = prvt_variants[key];
+    variant.last_use = prvt_tick;
+    prvt_build(key, variant, verbose);
+    if (!variant.program)
+        return NULL;
+
+    prvt_stats.memory_used += variant.memory;
+    prvt_last_key = key;
+    prvt_evict_cold_variants(key);
+    return variant.program.get();
+}
+
+
+ShaderPermutations::Key ShaderPermutations::get_key(const vector<string>& enabled_keywords) const
+{
+    Key key = 0;
+    for (const string& keyword : enabled_keywords)
+        for (size_t i = 0; i < prvt_keywords.size(); ++i)
+            if (prvt_keywords[i] == keyword) {
+                key |= Key(1) << i;
+                break;
+            }
+    return key;
+}
+
+
+void ShaderPermutations::set_memory_budget(const size_t budget)
+{
+    prvt_memory_budget = budget;
+    prvt_evict_cold_variants(prvt_last_key);
+}
+
+
+void ShaderPermutations::prvt_build(const Key key, Variant& variant, const bool verbose)
+{
+    string prelude(prvt_version);
+    for (size_t i = 0; i < prvt_defines.size(); ++i)
+        if (key & (Key(1) << i))
+            prelude += prvt_defines[i];
+
+    bool loaded = true;
+    ShadersList shaders;
+    for (const Stage& stage : prvt_stages) {
+        variant.shaders.emplace_back(new Shader(stage.type));
+        Shader* shader = variant.shaders.back().get();
+        shaders.push_back(shader);
+
+        if (stage.filepath.empty()) {
+            const GLchar* chunks[2] = { prelude.data(), stage.source_code.data() };
+            const GLint lengths[2] = { GLint(prelude.size()), GLint(stage.source_code.size()) };
+            shader->set_source_code(2, chunks, lengths);
+        }
+        else if (prvt_preprocessor != NULL)
+            loaded = loaded && shader->load_source_code(stage.filepath.c_str(), *prvt_preprocessor, prelude);
+        else
+            loaded = loaded && shader->load_source_code(stage.filepath.c_str(), prelude);
+    }
+
+    variant.program.reset(new ShadersProgram());
+    bool ok = loaded && variant.program->attach_shaders(shaders);
+    if (ok) {
+        if (prvt_binary_cache != NULL)
+            ok = variant.program->link(*prvt_binary_cache, false);
+        else
+            ok = variant.program->compile_shaders(false) && variant.program->link();
+    }
+
+    if (!ok) {
+        if (verbose)
+            cerr << "!!! shader permutation 0x" << hex << key << dec << " failed to build" << build_log(shaders, *variant.program, loaded) << endl;
+        ++prvt_stats.failures;
+        prvt_release(variant);
+        variant.memory = 0;
+        return;
+    }
+
+    GLint binary_length = 0;
+    glGetProgramiv(variant.program->name, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+    variant.memory = binary_length > 0 ? size_t(binary_length) : DEFAULT_VARIANT_MEMORY;
+    ++prvt_stats.builds;
+}
+
+
+void ShaderPermutations::prvt_evict_cold_variants(const optional<Key>& protected_key)
+{
+    if (prvt_memory_budget == 0)
+        return;
+
+    while (prvt_stats.memory_used > prvt_memory_budget) {
+        // negative entries are kept, so that failing variants are not built again
+        auto coldest = prvt_variants.end();
+        for (auto it = prvt_variants.begin(); it != prvt_variants.end(); ++it)
+            if (it->second.program && it->first != protected_key && (coldest == prvt_variants.end() || it->second.last_use < coldest->second.last_use))
+                coldest = it;
+        if (coldest == prvt_variants.end())
+            break;
+
+        prvt_stats.memory_used -= coldest->second.memory;
+        prvt_release(coldest->second);
+        prvt_variants.erase(coldest);
+        ++prvt_stats.evictions;
+    }
+}
+
+
+void ShaderPermutations::prvt_release(Variant& variant)
+{
+    if (variant.program) {
+        variant.program->detach_all_shaders();
+        variant.program->prepare_delete();
+        variant.program.reset();
+    }
+    for (unique_ptr<Shader>& shader : variant.shaders)
+        shader->prepare_delete();
+    variant.shaders.clear();
+}
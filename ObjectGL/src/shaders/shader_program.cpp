@@ -29,12 +29,14 @@ SOFTWARE.
 #include <sstream>
 #include <string>
 #include "shaders/shaders_program.h"
+#include "shaders/program_binary_cache.h"
+#include "profiling/cpu_profiler.h"
 
 using namespace std;
 
 
 ShadersProgram::ShadersProgram(ShadersList& shaders, const bool immediate_use, const bool verbose)
-    : Object(glCreateProgram()), linked(false)
+    : Object(glCreateProgram()), linked(false), prvt_link_pending(false), prvt_link_count(0)
 {
     if (attach_shaders(shaders))
         if (compile_shaders(verbose))
@@ -44,8 +46,19 @@ ShadersProgram::ShadersProgram(ShadersList& shaders, const bool immediate_use, c
 }
 
 
+ShadersProgram::ShadersProgram(ShadersList& shaders, ProgramBinaryCache& cache, const bool immediate_use, const bool verbose)
+    : Object(glCreateProgram()), linked(false), prvt_link_pending(false), prvt_link_count(0)
+{
+    if (attach_shaders(shaders))
+        if (link(cache, verbose))
+            if (immediate_use)
+                use();
+}
+
+
 bool ShadersProgram::attach_shaders(ShadersList& shaders)
 {
+    OBJECTGL_CPU_ZONE("ShadersProgram::attach_shaders");
     bool ok = true;
     for(Shader* shader: shaders) {
         if (shader->name == 0)
@@ -61,6 +74,7 @@ bool ShadersProgram::attach_shaders(ShadersList& shaders)
 
 bool ShadersProgram::compile_shaders(const bool verbose)
 {
+    OBJECTGL_CPU_ZONE("ShadersProgram::compile_shaders");
     bool ok = true;
     for (ShadersList::iterator shader_it = prvt_attached_shaders.begin(); shader_it != prvt_attached_shaders.end(); ++shader_it) {
         if ((*shader_it)->is_ok()) {
@@ -113,20 +127,152 @@ bool ShadersProgram::detach_all_shaders()
 
 bool ShadersProgram::link()
 {
+    OBJECTGL_CPU_ZONE("ShadersProgram::link");
     GLint ok;
-    glLinkProgram(name);
+    if (!prvt_link_pending)
+        glLinkProgram(name);
     glGetProgramiv(name, GL_LINK_STATUS, &ok);
     linked = (ok == GL_TRUE);
+    prvt_link_pending = false;
+    if (linked)
+        prvt_on_linked();
+    return linked;
+}
+
+
+void ShadersProgram::link_async()
+{
+    for (Shader* shader : prvt_attached_shaders)
+        if (shader->is_ok())
+            shader->compile_async();
+    glLinkProgram(name);
+    linked = false;
+    prvt_link_pending = true;
+}
+
+
+bool ShadersProgram::ready()
+{
+    if (prvt_link_pending) {
+        if (GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile) {
+            GLint completed;
+            glGetProgramiv(name, GL_COMPLETION_STATUS_KHR, &completed);
+            if (completed == GL_FALSE)
+                return false;
+        }
+        // linking is completed, so are the compilations of the attached shaders: no more stall here
+        for (Shader* shader : prvt_attached_shaders)
+            if (shader->is_ok())
+                shader->compile();
+        link();
+    }
+    return linked;
+}
+
+
+bool ShadersProgram::set_max_compiler_threads(const GLuint threads_count)
+{
+    if (GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(threads_count);
+        return true;
+    }
+    else if (GLEW_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(threads_count);
+        return true;
+    }
+    else
+        return false;
+}
+
+
+bool ShadersProgram::link(ProgramBinaryCache& cache, const bool verbose)
+{
+    OBJECTGL_CPU_ZONE("ShadersProgram::link");
+    const uint64_t key = cache.evaluate_key(prvt_attached_shaders);
+    if (cache.load(name, key)) {
+        linked = true;
+        prvt_on_linked();
+        return true;
+    }
+
+    glProgramParameteri(name, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    if (compile_shaders(verbose) && link())
+        cache.store(name, key);
     return linked;
 }
 
 
+GLuint ShadersProgram::link_replacement(const bool verbose)
+{
+    if (!compile_shaders(verbose))
+        return 0;
+
+    const GLuint new_name = glCreateProgram();
+    for (Shader* shader : prvt_attached_shaders)
+        glAttachShader(new_name, shader->name);
+
+    GLint ok;
+    glLinkProgram(new_name);
+    glGetProgramiv(new_name, GL_LINK_STATUS, &ok);
+    if (ok != GL_TRUE) {
+        if (verbose) {
+            string error_log(1024, '\0');
+            GLsizei length = 0;
+            glGetProgramInfoLog(new_name, GLsizei(error_log.size()), &length, &error_log.front());
+            error_log.resize(length);
+            cerr << error_log << endl;
+        }
+        glDeleteProgram(new_name);
+        return 0;
+    }
+
+    return new_name;
+}
+
+
+void ShadersProgram::replace(const GLuint new_name)
+{
+    glDeleteProgram(name);
+    name = new_name;
+    linked = true;
+    prvt_link_pending = false;
+    prvt_on_linked();
+    if (!prvt_label.empty())
+        set_label(prvt_label);
+}
+
+
+void ShadersProgram::set_label(const string& label)
+{
+    prvt_label = label;
+    if (GLEW_VERSION_4_3 || GLEW_KHR_debug)
+        glObjectLabel(GL_PROGRAM, name, GLsizei(label.size()), label.c_str());
+}
+
+
 void ShadersProgram::get_linking_log(string& info_log, const GLsizei max_length)
 {
+    info_log.clear();
     if (linked)
-        info_log.clear();
-    else {
-        info_log.reserve(max_length);
-        glGetProgramInfoLog(name, max_length - 1, NULL, &info_log.front());
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(name, GL_INFO_LOG_LENGTH, &length);
+    if (length > max_length)
+        length = max_length;
+    if (length > 1) {
+        GLsizei written = 0;
+        info_log.resize(size_t(length));
+        glGetProgramInfoLog(name, length, &written, &info_log.front());
+        info_log.resize(size_t(written));
     }
-}
\ No newline at end of file
+}
+
+
+void ShadersProgram::prvt_on_linked()
+{
+    prvt_subroutines.reflect(name);
+    prvt_reflection.reflect(name);
+    prvt_uniforms_shadow.build(prvt_reflection);
+    ++prvt_link_count;
+}
@@ -1,4 +1,3 @@
-#pragma once
 /**
 MIT License
 
@@ -32,12 +31,20 @@ using namespace std;
 #include "shaders/shader_subroutines.h"
 
 
+// returns the location of a subroutine uniform from the reflected subroutines state of a program
+static GLint get_location(ShadersProgram& program, GLenum shader_type, const char* subroutine_name)
+{
+    SubroutinesStageState* stage = program.get_subroutines().get_stage(shader_type);
+    return stage == NULL ? -1 : stage->get_uniform_location(subroutine_name);
+}
+
+
 ShaderSubroutine::ShaderSubroutine(
     ShadersProgram& program,
     GLenum shader_type,
     const char* subroutine_name)
     : prvt_program(program),
-      prvt_location(glGetSubroutineUniformLocation(program.name, shader_type, subroutine_name)),
+      prvt_location(get_location(program, shader_type, subroutine_name)),
       prvt_shader_type(shader_type)
 {}
 
@@ -47,28 +54,34 @@ ShaderSubroutine::ShaderSubroutine(
     GLenum shader_type,
     const string& subroutine_name)
     : prvt_program(program),
-      prvt_location(glGetSubroutineUniformLocation(program.name, shader_type, subroutine_name.c_str())),
+      prvt_location(get_location(program, shader_type, subroutine_name.c_str())),
       prvt_shader_type(shader_type)
 {}
 
 
+GLuint ShaderSubroutine::get_function_index(const char* function_name)
+{
+    SubroutinesStageState* stage = prvt_program.get_subroutines().get_stage(prvt_shader_type);
+    return stage == NULL ? GL_INVALID_INDEX : stage->get_function_index(function_name);
+}
+
+
 bool ShaderSubroutine::select(const char* function_name)
 {
-    bool ok = is_ok();
-    if (ok) {
-        GLuint function_index = glGetSubroutineIndex(prvt_program.name, prvt_shader_type, function_name);
-        ok = function_index != GL_INVALID_INDEX;
-        
-        if (ok) {
-            GLsizei functions_count;
-            glGetIntegerv(GL_MAX_SUBROUTINE_UNIFORM_LOCATIONS, &functions_count);
-
-            GLuint* indices = new GLuint[functions_count];
-            indices[prvt_location] = function_index;
-            glUniformSubroutinesuiv(prvt_shader_type, functions_count, indices);
-
-            delete[] indices;
-        }
-    }
-    return ok;
+    return select(get_function_index(function_name), true);
+}
+
+
+bool ShaderSubroutine::select(const GLuint function_index, const bool immediate)
+{
+    if (!is_ok() || function_index == GL_INVALID_INDEX)
+        return false;
+
+    SubroutinesStageState* stage = prvt_program.get_subroutines().get_stage(prvt_shader_type);
+    if (stage == NULL || !stage->select(prvt_location, function_index))
+        return false;
+
+    if (immediate)
+        stage->apply();
+    return true;
 }
@@ -24,55 +24,283 @@ SOFTWARE.
 
 //===========================================================================
 #include <cstddef>
-#include <fstream>
+#include <cstring>
 #include <iostream>
-#include <sstream>
 #include <string>
+#include <vector>
+#include "shaders/glsl_preprocessor.h"
 #include "shaders/shaders.h"
+#include "utils/mapped_file.h"
+#include "profiling/cpu_profiler.h"
 
 using namespace std;
 
 
+// the first word of SPIR-V binaries, in the endianness of the host
+static const GLuint SPIRV_MAGIC_NUMBER = 0x07230203;
+
+
 bool Shader::compile()
 {
+	OBJECTGL_CPU_ZONE("Shader::compile");
 	if (!compiled) {
 		GLint ok;
-		glCompileShader(name);
+		if (!prvt_compile_pending)
+			prvt_submit_compile();
 		glGetShaderiv(name, GL_COMPILE_STATUS, &ok);
 		compiled = (ok == GL_TRUE);
+		prvt_compile_pending = false;
 	}
 	return compiled;
 }
 
 
+bool Shader::compile(string& error_log)
+{
+	error_log.clear();
+	if (compile())
+		return true;
+
+	GLint length = 0;
+	glGetShaderiv(name, GL_INFO_LOG_LENGTH, &length);
+	if (length > 1) {
+		error_log.resize(size_t(length));
+		glGetShaderInfoLog(name, length, NULL, &error_log.front());
+		error_log.resize(size_t(length) - 1);
+	}
+	return false;
+}
+
+
+void Shader::compile_async()
+{
+	if (!compiled && !prvt_compile_pending) {
+		prvt_submit_compile();
+		prvt_compile_pending = true;
+	}
+}
+
+
+bool Shader::is_compile_completed()
+{
+	if (!prvt_compile_pending)
+		return true;
+	if (GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile) {
+		GLint completed;
+		glGetShaderiv(name, GL_COMPLETION_STATUS_KHR, &completed);
+		if (completed != GL_TRUE)
+			return false;
+	}
+	// either completed by the driver threads, or completed here by the status query
+	compile();
+	return true;
+}
+
+
 void Shader::get_compile_log(string& info_log, const GLsizei max_length)
 {
+	info_log.clear();
 	if (compiled)
-		info_log.clear();
-	else {
-		info_log.reserve(max_length);
-		glGetShaderInfoLog(name, max_length - 1, NULL, &info_log.front());
+		return;
+
+	GLint length = 0;
+	glGetShaderiv(name, GL_INFO_LOG_LENGTH, &length);
+	if (length > max_length)
+		length = max_length;
+	if (length > 1) {
+		GLsizei written = 0;
+		info_log.resize(size_t(length));
+		glGetShaderInfoLog(name, length, &written, &info_log.front());
+		info_log.resize(size_t(written));
 	}
 }
 
 
 bool Shader::load_source_code(const char* filepath)
 {
-	try {
-		ifstream in_stream(filepath);
+	return load_source_code(vector<string>(1, string(filepath)), string());
+}
+
 
-		ostringstream source_code;
-		source_code << in_stream.rdbuf();
-		in_stream.close();
+bool Shader::load_source_code(const char* filepath, const string& prelude)
+{
+	return load_source_code(vector<string>(1, string(filepath)), prelude);
+}
 
-		set_source_code(source_code.str());
 
-		return true;
+bool Shader::load_source_code(const vector<string>& filepaths, const string& prelude)
+{
+	vector<MappedFile> files;
+	files.reserve(filepaths.size());
+	for (const string& filepath : filepaths) {
+		files.emplace_back(filepath.c_str());
+		if (!files.back().is_ok()) {
+			cerr << "!!! cannot map shader source file '" << filepath << "'" << endl;
+			return false;
+		}
+	}
+
+	vector<const GLchar*> chunks;
+	vector<GLint> lengths;
+	chunks.reserve(files.size() + 1);
+	lengths.reserve(files.size() + 1);
+	if (!prelude.empty()) {
+		chunks.push_back(prelude.data());
+		lengths.push_back(GLint(prelude.size()));
+	}
+	for (const MappedFile& file : files) {
+		chunks.push_back(file.data());
+		lengths.push_back(GLint(file.size()));
+	}
+
+	// OpenGL copies the chunks, so files may be unmapped as soon as this call returns
+	set_source_code(GLsizei(chunks.size()), chunks.data(), lengths.data());
+
+	prvt_source_filepaths = filepaths;
+	prvt_prelude = prelude;
+	return true;
+}
+
+
+bool Shader::load_source_code(const char* filepath, GLSLPreprocessor& preprocessor, const string& prelude)
+{
+	string source_code;
+	if (!preprocessor.preprocess(filepath, source_code))
+		return false;
+
+	const GLchar* chunks[2] = { prelude.data(), source_code.data() };
+	const GLint lengths[2] = { GLint(prelude.size()), GLint(source_code.size()) };
+	set_source_code(2, chunks, lengths);
+
+	prvt_source_filepaths.assign(1, string(filepath));
+	prvt_prelude = prelude;
+	prvt_preprocessor = &preprocessor;
+	return true;
+}
+
+
+bool Shader::reload_source_code()
+{
+	if (prvt_source_filepaths.empty())
+		return false;
+
+	// copies are needed, since loading resets them
+	const vector<string> filepaths(prvt_source_filepaths);
+	const string prelude(prvt_prelude);
+	if (prvt_spirv)
+		return load_spirv(filepaths.front().c_str());
+	else if (prvt_preprocessor != NULL)
+		return load_source_code(filepaths.front().c_str(), *prvt_preprocessor, prelude);
+	else
+		return load_source_code(filepaths, prelude);
+}
+
+
+void Shader::set_source_code(const GLsizei count, const GLchar* const* chunks, const GLint* lengths)
+{
+	glShaderSource(name, count, chunks, lengths);
+
+	uint64_t hash = fnv1a::hash_value(type);
+	for (GLsizei i = 0; i < count; ++i)
+		if (lengths[i] < 0)
+			hash = fnv1a::hash(chunks[i], strlen(chunks[i]), hash);
+		else
+			hash = fnv1a::hash(chunks[i], size_t(lengths[i]), hash);
+	prvt_source_hash = hash;
+
+	prvt_source_filepaths.clear();
+	prvt_prelude.clear();
+	prvt_preprocessor = NULL;
+	prvt_spirv = false;
+	prvt_binary.clear();
+	prvt_binary.shrink_to_fit();
+
+	compiled = false;
+	prvt_compile_pending = false;
+}
+
+
+bool Shader::load_spirv(const char* filepath)
+{
+	if (!is_spirv_supported()) {
+		cerr << "!!! SPIR-V shaders are not supported by this driver" << endl;
+		return false;
+	}
+
+	MappedFile file(filepath);
+	if (!file.is_ok()) {
+		cerr << "!!! cannot map SPIR-V file '" << filepath << "'" << endl;
+		return false;
 	}
-	catch (ifstream::failure& e) {
-		cerr << "!!! " << e.what() << endl;
+	GLuint magic_number = 0;
+	if (file.size() >= sizeof(GLuint))
+		memcpy(&magic_number, file.data(), sizeof(GLuint));
+	if (file.size() % sizeof(GLuint) != 0 || magic_number != SPIRV_MAGIC_NUMBER) {
+		cerr << "!!! '" << filepath << "' is not a SPIR-V binary" << endl;
 		return false;
 	}
+
+	prvt_binary.resize(file.size() / sizeof(GLuint));
+	memcpy(prvt_binary.data(), file.data(), file.size());
+	prvt_upload_spirv();
+
+	prvt_spirv = true;
+	prvt_binary_hash = fnv1a::hash(file.data(), file.size(), fnv1a::hash_value(type));
+	prvt_source_filepaths.assign(1, string(filepath));
+	prvt_prelude.clear();
+	prvt_preprocessor = NULL;
+	set_specialization(prvt_specialization, prvt_entry_point.empty() ? string("main") : prvt_entry_point);
+	return true;
+}
+
+
+void Shader::set_specialization(const vector<SpecializationConstant>& constants, const string& entry_point)
+{
+	prvt_specialization = constants;
+	prvt_entry_point = entry_point;
+
+	if (prvt_spirv) {
+		// specialization is part of the identity of the final shader, e.g. for programs binaries caching
+		uint64_t hash = fnv1a::hash(entry_point, prvt_binary_hash);
+		for (const SpecializationConstant& constant : constants)
+			hash = fnv1a::hash_value(constant.value, fnv1a::hash_value(constant.id, hash));
+		prvt_source_hash = hash;
+
+		compiled = false;
+		prvt_compile_pending = false;
+	}
+}
+
+
+void Shader::prvt_submit_compile()
+{
+	if (prvt_spirv) {
+		// a shader binary is specialized once only
+		if (prvt_specialized)
+			prvt_upload_spirv();
+
+		vector<GLuint> ids, values;
+		ids.reserve(prvt_specialization.size());
+		values.reserve(prvt_specialization.size());
+		for (const SpecializationConstant& constant : prvt_specialization) {
+			ids.push_back(constant.id);
+			values.push_back(constant.value);
+		}
+		if (GLEW_VERSION_4_6)
+			glSpecializeShader(name, prvt_entry_point.c_str(), GLuint(ids.size()), ids.data(), values.data());
+		else
+			glSpecializeShaderARB(name, prvt_entry_point.c_str(), GLuint(ids.size()), ids.data(), values.data());
+		prvt_specialized = true;
+	}
+	else
+		glCompileShader(name);
+}
+
+
+void Shader::prvt_upload_spirv()
+{
+	glShaderBinary(1, &name, GL_SHADER_BINARY_FORMAT_SPIR_V, prvt_binary.data(), GLsizei(prvt_binary.size() * sizeof(GLuint)));
+	prvt_specialized = false;
 }
 
 
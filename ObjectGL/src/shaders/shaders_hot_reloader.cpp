@@ -0,0 +1,342 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "shaders/glsl_preprocessor.h"
+#include "shaders/shaders_hot_reloader.h"
+#include "trace/gl_dispatch.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+
+// returns the canonical form of a path, as used by the GLSL preprocessor also
+static const string canonical_path(const filesystem::path& path)
+{
+    error_code err;
+    const filesystem::path canonical = filesystem::weakly_canonical(path, err);
+    return err ? path.lexically_normal().generic_string() : canonical.generic_string();
+}
+
+
+ShadersHotReloader::ShadersHotReloader()
+    : prvt_stats{ 0, 0, 0 },
+      prvt_has_changes(false),
+      prvt_has_replacements(false),
+      prvt_running(false),
+      prvt_inotify_fd(-1),
+      prvt_wakeup_fds{ -1, -1 }
+{
+#if defined(__linux__)
+    prvt_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (prvt_inotify_fd < 0)
+        cerr << "!!! cannot initialize inotify for shaders hot reloading" << endl;
+#endif
+}
+
+
+ShadersHotReloader::~ShadersHotReloader()
+{
+    stop();
+
+    for (Replacement& replacement : prvt_replacements) {
+        glDeleteSync(replacement.fence);
+        glDeleteProgram(replacement.new_name);
+    }
+
+#if defined(__linux__)
+    if (prvt_inotify_fd >= 0)
+        close(prvt_inotify_fd);
+#endif
+}
+
+
+void ShadersHotReloader::notify_changed(const string& filepath)
+{
+    const string path = canonical_path(filepath);
+    lock_guard<mutex> lock(prvt_mutex);
+    if (prvt_file_shaders.find(path) != prvt_file_shaders.end()) {
+        ++prvt_stats.notifications;
+        prvt_changed_files.insert(path);
+        prvt_has_changes.store(true, memory_order_release);
+    }
+}
+
+
+size_t ShadersHotReloader::process_pending(const bool verbose)
+{
+    if (!prvt_has_changes.load(memory_order_acquire))
+        return 0;
+
+    // takes the notified files over, the watching thread filling a new set meanwhile
+    set<string> changed_files;
+    set<Shader*> shaders;
+    {
+        lock_guard<mutex> lock(prvt_mutex);
+        prvt_has_changes.store(false, memory_order_relaxed);
+        changed_files.swap(prvt_changed_files);
+        for (const string& path : changed_files) {
+            const auto found = prvt_file_shaders.find(path);
+            if (found != prvt_file_shaders.end())
+                shaders.insert(found->second.begin(), found->second.end());
+        }
+    }
+
+    set<ShadersProgram*> programs;
+    set<ShadersProgram*> failing_programs;
+    size_t failures = 0;
+    for (Shader* shader : shaders) {
+        // shaders and their preprocessors get modified here only, while being read by 'watch()' under lock
+        bool ok;
+        {
+            lock_guard<mutex> lock(prvt_mutex);
+            ok = shader->reload_source_code();
+            prvt_register_shader(shader);   // included files may have changed
+        }
+
+        string error_log;
+        if (ok)
+            ok = shader->compile(error_log);
+        else if (verbose && !shader->get_source_filepaths().empty())
+            error_log = "!!! cannot reload shader '" + shader->get_source_filepaths().front() + "'";
+
+        lock_guard<mutex> lock(prvt_mutex);
+        const set<ShadersProgram*>& shader_programs = prvt_shader_programs[shader];
+        if (ok)
+            programs.insert(shader_programs.begin(), shader_programs.end());
+        else {
+            ++failures;
+            failing_programs.insert(shader_programs.begin(), shader_programs.end());
+            if (verbose)
+                cerr << error_log << endl;
+        }
+    }
+
+    // relinks the programs whose shaders all compiled
+    size_t relinks_count = 0;
+    for (ShadersProgram* program : programs) {
+        if (failing_programs.count(program) > 0)
+            continue;
+
+        const GLuint new_name = program->link_replacement(verbose);
+        if (new_name == 0) {
+            ++failures;
+            continue;
+        }
+
+        // the rendering thread may run another context: the driver must have completed the building first
+        const GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        lock_guard<mutex> lock(prvt_mutex);
+        prvt_replacements.push_back(Replacement{ program, new_name, fence });
+        prvt_has_replacements.store(true, memory_order_release);
+        ++relinks_count;
+    }
+
+    lock_guard<mutex> lock(prvt_mutex);
+    prvt_stats.relinks += relinks_count;
+    prvt_stats.failures += failures;
+    return relinks_count;
+}
+
+
+bool ShadersHotReloader::start()
+{
+#if defined(__linux__)
+    if (prvt_running.load())
+        return true;
+    if (prvt_inotify_fd < 0 || pipe2(prvt_wakeup_fds, O_CLOEXEC) != 0)
+        return false;
+
+    prvt_running.store(true);
+    prvt_thread = thread(&ShadersHotReloader::prvt_run, this);
+    return true;
+#else
+    cerr << "!!! shaders files watching is available on Linux only, use notify_changed() instead" << endl;
+    return false;
+#endif
+}
+
+
+void ShadersHotReloader::stop()
+{
+#if defined(__linux__)
+    if (!prvt_running.load())
+        return;
+
+    prvt_running.store(false);
+    const char wakeup = 0;
+    if (write(prvt_wakeup_fds[1], &wakeup, 1) != 1)
+        cerr << "!!! cannot wake up shaders watching thread" << endl;
+    prvt_thread.join();
+
+    close(prvt_wakeup_fds[0]);
+    close(prvt_wakeup_fds[1]);
+    prvt_wakeup_fds[0] = prvt_wakeup_fds[1] = -1;
+#endif
+}
+
+
+size_t ShadersHotReloader::swap_reloaded()
+{
+    if (!prvt_has_replacements.load(memory_order_acquire))
+        return 0;
+
+    size_t swaps_count = 0;
+    lock_guard<mutex> lock(prvt_mutex);
+    for (auto it = prvt_replacements.begin(); it != prvt_replacements.end(); ) {
+        const GLenum status = glClientWaitSync(it->fence, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            glDeleteSync(it->fence);
+            it->program->replace(it->new_name);
+            it = prvt_replacements.erase(it);
+            ++swaps_count;
+        }
+        else
+            ++it;
+    }
+    prvt_has_replacements.store(!prvt_replacements.empty(), memory_order_release);
+    return swaps_count;
+}
+
+
+void ShadersHotReloader::unwatch(ShadersProgram& program)
+{
+    lock_guard<mutex> lock(prvt_mutex);
+    for (auto& shader_programs : prvt_shader_programs)
+        shader_programs.second.erase(&program);
+
+    for (auto it = prvt_replacements.begin(); it != prvt_replacements.end(); ) {
+        if (it->program == &program) {
+            glDeleteSync(it->fence);
+            glDeleteProgram(it->new_name);
+            it = prvt_replacements.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+
+bool ShadersHotReloader::watch(ShadersProgram& program)
+{
+    bool watched = false;
+    lock_guard<mutex> lock(prvt_mutex);
+    for (Shader* shader : program.get_attached_shaders()) {
+        if (shader->get_source_filepaths().empty())
+            continue;
+        prvt_shader_programs[shader].insert(&program);
+        prvt_register_shader(shader);
+        watched = true;
+    }
+    return watched;
+}
+
+
+void ShadersHotReloader::prvt_register_shader(Shader* shader)
+{
+    vector<string> files;
+    for (const string& filepath : shader->get_source_filepaths())
+        files.push_back(canonical_path(filepath));
+
+    // adds all the files that are included, directly or not
+    GLSLPreprocessor* preprocessor = shader->get_preprocessor();
+    if (preprocessor != NULL)
+        for (size_t i = 0; i < files.size(); ++i)
+            for (const string& include : preprocessor->get_includes(files[i]))
+                if (find(files.begin(), files.end(), include) == files.end())
+                    files.push_back(include);
+
+    for (const string& file : files) {
+        prvt_file_shaders[file].insert(shader);
+        prvt_watch_directory(filesystem::path(file).parent_path().generic_string());
+    }
+}
+
+
+void ShadersHotReloader::prvt_run()
+{
+#if defined(__linux__)
+    // inotify events are aligned on their watch descriptors
+    alignas(inotify_event) char buffer[16 * 1024];
+    pollfd fds[2] = { { prvt_inotify_fd, POLLIN, 0 }, { prvt_wakeup_fds[0], POLLIN, 0 } };
+
+    while (prvt_running.load()) {
+        if (poll(fds, 2, -1) < 0 || (fds[1].revents & POLLIN))
+            continue;
+
+        ssize_t length;
+        while ((length = read(prvt_inotify_fd, buffer, sizeof(buffer))) > 0) {
+            for (char* cursor = buffer; cursor < buffer + length; ) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+                cursor += sizeof(inotify_event) + event->len;
+                if (event->len == 0 || !(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)))
+                    continue;
+
+                string directory;
+                {
+                    lock_guard<mutex> lock(prvt_mutex);
+                    const auto found = prvt_watched_directories.find(event->wd);
+                    if (found == prvt_watched_directories.end())
+                        continue;
+                    directory = found->second;
+                }
+                notify_changed(directory + "/" + event->name);
+            }
+        }
+    }
+#endif
+}
+
+
+void ShadersHotReloader::prvt_watch_directory(const string& directory_path)
+{
+#if defined(__linux__)
+    if (prvt_inotify_fd < 0 || prvt_directory_watches.find(directory_path) != prvt_directory_watches.end())
+        return;
+
+    const int wd = inotify_add_watch(prvt_inotify_fd, directory_path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+        cerr << "!!! cannot watch shaders directory '" << directory_path << "'" << endl;
+        return;
+    }
+    prvt_directory_watches[directory_path] = wd;
+    prvt_watched_directories[wd] = directory_path;
+#endif
+}
@@ -0,0 +1,171 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "shaders/subroutines_state.h"
+
+using namespace std;
+
+
+SubroutinesStageState::SubroutinesStageState(const GLenum shader_type)
+    : prvt_shader_type(shader_type),
+      prvt_dirty(false)
+{}
+
+
+void SubroutinesStageState::apply(const bool force)
+{
+    if ((prvt_dirty || force) && !prvt_selected.empty()) {
+        glUniformSubroutinesuiv(prvt_shader_type, GLsizei(prvt_selected.size()), prvt_selected.data());
+        prvt_dirty = false;
+    }
+}
+
+
+GLuint SubroutinesStageState::get_function_index(const char* function_name) const
+{
+    for (size_t i = 0; i < prvt_function_names.size(); ++i)
+        if (prvt_function_names[i] == function_name)
+            return GLuint(i);
+    return GL_INVALID_INDEX;
+}
+
+
+GLint SubroutinesStageState::get_uniform_location(const char* uniform_name) const
+{
+    for (size_t i = 0; i < prvt_uniform_names.size(); ++i)
+        if (prvt_uniform_names[i] == uniform_name)
+            return prvt_uniforms[i].location;
+    return -1;
+}
+
+
+void SubroutinesStageState::reflect(const GLuint program_name)
+{
+    prvt_uniforms.clear();
+    prvt_uniform_names.clear();
+    prvt_compatibles.clear();
+    prvt_function_names.clear();
+    prvt_location_uniforms.clear();
+    prvt_selected.clear();
+    prvt_dirty = false;
+
+    GLint locations_count = 0, uniforms_count = 0, functions_count = 0, max_name_length = 0, max_uniform_name_length = 0;
+    glGetProgramStageiv(program_name, prvt_shader_type, GL_ACTIVE_SUBROUTINE_UNIFORM_LOCATIONS, &locations_count);
+    if (locations_count <= 0)
+        return;
+    glGetProgramStageiv(program_name, prvt_shader_type, GL_ACTIVE_SUBROUTINE_UNIFORMS, &uniforms_count);
+    glGetProgramStageiv(program_name, prvt_shader_type, GL_ACTIVE_SUBROUTINES, &functions_count);
+    glGetProgramStageiv(program_name, prvt_shader_type, GL_ACTIVE_SUBROUTINE_MAX_LENGTH, &max_name_length);
+    glGetProgramStageiv(program_name, prvt_shader_type, GL_ACTIVE_SUBROUTINE_UNIFORM_MAX_LENGTH, &max_uniform_name_length);
+
+    vector<GLchar> name_buffer(size_t(max_name_length > max_uniform_name_length ? max_name_length : max_uniform_name_length) + 1);
+    GLsizei length;
+
+    prvt_function_names.resize(functions_count);
+    for (GLint i = 0; i < functions_count; ++i) {
+        glGetActiveSubroutineName(program_name, prvt_shader_type, GLuint(i), GLsizei(name_buffer.size()), &length, name_buffer.data());
+        prvt_function_names[i].assign(name_buffer.data(), length);
+    }
+
+    prvt_location_uniforms.assign(locations_count, -1);
+    prvt_selected.assign(locations_count, 0);
+    prvt_uniforms.reserve(uniforms_count);
+    prvt_uniform_names.reserve(uniforms_count);
+
+    for (GLint i = 0; i < uniforms_count; ++i) {
+        glGetActiveSubroutineUniformName(program_name, prvt_shader_type, GLuint(i), GLsizei(name_buffer.size()), &length, name_buffer.data());
+        const string uniform_name(name_buffer.data(), length);
+
+        GLint compatibles_count = 0, size = 1;
+        glGetActiveSubroutineUniformiv(program_name, prvt_shader_type, GLuint(i), GL_NUM_COMPATIBLE_SUBROUTINES, &compatibles_count);
+        glGetActiveSubroutineUniformiv(program_name, prvt_shader_type, GLuint(i), GL_UNIFORM_SIZE, &size);
+
+        const GLuint compatibles_start = GLuint(prvt_compatibles.size());
+        prvt_compatibles.resize(prvt_compatibles.size() + compatibles_count);
+        if (compatibles_count > 0)
+            glGetActiveSubroutineUniformiv(program_name, prvt_shader_type, GLuint(i), GL_COMPATIBLE_SUBROUTINES,
+                                           reinterpret_cast<GLint*>(prvt_compatibles.data() + compatibles_start));
+
+        const GLint location = glGetSubroutineUniformLocation(program_name, prvt_shader_type, uniform_name.c_str());
+        prvt_uniforms.push_back(UniformEntry{ location, size, compatibles_start, GLuint(compatibles_count) });
+        prvt_uniform_names.push_back(uniform_name);
+
+        // each location gets a valid default selection, so that no slot is ever left uninitialized
+        for (GLint k = 0; k < size; ++k)
+            if (location >= 0 && location + k < locations_count) {
+                prvt_location_uniforms[location + k] = i;
+                if (compatibles_count > 0)
+                    prvt_selected[location + k] = prvt_compatibles[compatibles_start];
+            }
+    }
+    prvt_dirty = true;
+}
+
+
+bool SubroutinesStageState::select(const GLint location, const GLuint function_index)
+{
+    if (location < 0 || location >= GLint(prvt_selected.size()) || prvt_location_uniforms[location] < 0)
+        return false;
+
+    const UniformEntry& uniform = prvt_uniforms[prvt_location_uniforms[location]];
+    for (GLuint i = uniform.compatibles_start; i < uniform.compatibles_start + uniform.compatibles_count; ++i)
+        if (prvt_compatibles[i] == function_index) {
+            if (prvt_selected[location] != function_index) {
+                prvt_selected[location] = function_index;
+                prvt_dirty = true;
+            }
+            return true;
+        }
+    return false;
+}
+
+
+void SubroutinesState::reflect(const GLuint program_name)
+{
+    // pairs of shader types and subroutine uniforms interfaces
+    static const GLenum SHADER_TYPES[][2] = {
+        { GL_VERTEX_SHADER,          GL_VERTEX_SUBROUTINE_UNIFORM },
+        { GL_TESS_CONTROL_SHADER,    GL_TESS_CONTROL_SUBROUTINE_UNIFORM },
+        { GL_TESS_EVALUATION_SHADER, GL_TESS_EVALUATION_SUBROUTINE_UNIFORM },
+        { GL_GEOMETRY_SHADER,        GL_GEOMETRY_SUBROUTINE_UNIFORM },
+        { GL_FRAGMENT_SHADER,        GL_FRAGMENT_SUBROUTINE_UNIFORM },
+        { GL_COMPUTE_SHADER,         GL_COMPUTE_SUBROUTINE_UNIFORM }
+    };
+
+    // glGetProgramStageiv() fails on stages the program does not contain,
+    // while interfaces queries just return no resources
+    prvt_stages.clear();
+    for (const GLenum* types : SHADER_TYPES) {
+        GLint uniforms_count = 0;
+        glGetProgramInterfaceiv(program_name, types[1], GL_ACTIVE_RESOURCES, &uniforms_count);
+        if (uniforms_count > 0) {
+            prvt_stages.emplace_back(types[0]);
+            prvt_stages.back().reflect(program_name);
+        }
+    }
+}
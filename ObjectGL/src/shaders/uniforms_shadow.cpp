@@ -0,0 +1,227 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "shaders/uniforms_shadow.h"
+#include "shaders/uniform.h"
+#include "profiling/cpu_profiler.h"
+
+using namespace std;
+
+
+UniformsShadow::UniformsShadow()
+    : prvt_stats{ 0, 0, 0 }
+{}
+
+
+void UniformsShadow::build(const ProgramReflection& reflection)
+{
+    const vector<ProgramReflection::Resource>& resources = reflection.get_resources(ProgramReflection::UNIFORMS);
+
+    prvt_slots.clear();
+    prvt_dirty_slots.clear();
+    prvt_resource_slots.assign(resources.size(), -1);
+
+    GLuint data_size = 0;
+    GLuint states_count = 0;
+    for (size_t i = 0; i < resources.size(); ++i) {
+        const ProgramReflection::Resource& resource = resources[i];
+        const GLuint element_size = get_type_size(resource.type);
+        if (resource.location < 0 || element_size == 0)
+            continue;  // uniforms in named blocks are not shadowed
+
+        const GLint array_size = resource.array_size < 1 ? 1 : resource.array_size;
+        prvt_resource_slots[i] = GLint(prvt_slots.size());
+        prvt_slots.push_back(Slot{ resource.location, resource.type, array_size, element_size, data_size, states_count, false });
+        data_size += element_size * array_size;
+        states_count += array_size;
+    }
+
+    prvt_values.assign(data_size, 0);
+    prvt_states.assign(states_count, UNKNOWN);
+}
+
+
+GLint UniformsShadow::find(const ProgramReflection& reflection, const char* uniform_name) const
+{
+    const ProgramReflection::Resource* resource = reflection.find(ProgramReflection::UNIFORMS, uniform_name);
+    if (resource == NULL)
+        return -1;
+
+    const size_t index = resource - reflection.get_resources(ProgramReflection::UNIFORMS).data();
+    return index < prvt_resource_slots.size() ? prvt_resource_slots[index] : -1;
+}
+
+
+void UniformsShadow::flush(const GLuint program_name)
+{
+    OBJECTGL_CPU_ZONE("UniformsShadow::flush");
+    for (const GLint slot_index : prvt_dirty_slots) {
+        Slot& slot = prvt_slots[slot_index];
+        ElementState* states = prvt_states.data() + slot.state_offset;
+
+        // consecutive dirty elements are uploaded at once
+        GLint element = 0;
+        while (element < slot.array_size) {
+            if (states[element] != DIRTY) {
+                ++element;
+                continue;
+            }
+            const GLint first = element;
+            while (element < slot.array_size && states[element] == DIRTY)
+                states[element++] = CLEAN;
+
+            prvt_upload(program_name, slot.type, slot.location + first, element - first,
+                        prvt_values.data() + slot.data_offset + size_t(first) * slot.element_size);
+            ++prvt_stats.uploads;
+        }
+        slot.listed = false;
+    }
+    prvt_dirty_slots.clear();
+}
+
+
+bool UniformsShadow::set(const GLint slot_index, const GLint first_element, const GLsizei count, const void* values, const bool deferred)
+{
+    Slot& slot = prvt_slots[slot_index];
+    if (first_element < 0 || first_element >= slot.array_size)
+        return false;
+    const GLint last_element = count > slot.array_size - first_element ? slot.array_size : first_element + count;
+
+    const unsigned char* source = static_cast<const unsigned char*>(values);
+    unsigned char* shadow = prvt_values.data() + slot.data_offset + size_t(first_element) * slot.element_size;
+    ElementState* states = prvt_states.data() + slot.state_offset;
+    const ElementState new_state = deferred ? DIRTY : CLEAN;
+
+    bool modified = false;
+    for (GLint element = first_element; element < last_element; ++element) {
+        if (states[element] != UNKNOWN && memcmp(shadow, source, slot.element_size) == 0)
+            ++prvt_stats.skipped;
+        else {
+            memcpy(shadow, source, slot.element_size);
+            if (states[element] != DIRTY)
+                states[element] = new_state;
+            ++prvt_stats.modified;
+            modified = true;
+        }
+        source += slot.element_size;
+        shadow += slot.element_size;
+    }
+
+    if (modified && deferred && !slot.listed) {
+        slot.listed = true;
+        prvt_dirty_slots.push_back(slot_index);
+    }
+    if (modified && !deferred)
+        ++prvt_stats.uploads;
+
+    return modified;
+}
+
+
+GLuint UniformsShadow::get_type_size(const GLenum type)
+{
+    switch (type) {
+    case GL_FLOAT: case GL_INT: case GL_UNSIGNED_INT: case GL_BOOL:
+        return 4;
+    case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2: case GL_DOUBLE:
+        return 8;
+    case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3:
+        return 12;
+    case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4: case GL_DOUBLE_VEC2: case GL_FLOAT_MAT2:
+        return 16;
+    case GL_DOUBLE_VEC3: case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT3x2:
+        return 24;
+    case GL_DOUBLE_VEC4: case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT4x2: case GL_DOUBLE_MAT2:
+        return 32;
+    case GL_FLOAT_MAT3:
+        return 36;
+    case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x3: case GL_DOUBLE_MAT2x3: case GL_DOUBLE_MAT3x2:
+        return 48;
+    case GL_FLOAT_MAT4: case GL_DOUBLE_MAT2x4: case GL_DOUBLE_MAT4x2:
+        return 64;
+    case GL_DOUBLE_MAT3:
+        return 72;
+    case GL_DOUBLE_MAT3x4: case GL_DOUBLE_MAT4x3:
+        return 96;
+    case GL_DOUBLE_MAT4:
+        return 128;
+    default:
+        return is_opaque_uniform_type(type) ? 4 : 0;
+    }
+}
+
+
+void UniformsShadow::prvt_upload(const GLuint program_name, const GLenum type, const GLint location, const GLsizei count, const void* values)
+{
+    const GLfloat*  f = static_cast<const GLfloat*>(values);
+    const GLdouble* d = static_cast<const GLdouble*>(values);
+    const GLint*    i = static_cast<const GLint*>(values);
+    const GLuint*   u = static_cast<const GLuint*>(values);
+
+    switch (type) {
+    case GL_FLOAT:              glProgramUniform1fv(program_name, location, count, f);  break;
+    case GL_FLOAT_VEC2:         glProgramUniform2fv(program_name, location, count, f);  break;
+    case GL_FLOAT_VEC3:         glProgramUniform3fv(program_name, location, count, f);  break;
+    case GL_FLOAT_VEC4:         glProgramUniform4fv(program_name, location, count, f);  break;
+    case GL_DOUBLE:             glProgramUniform1dv(program_name, location, count, d);  break;
+    case GL_DOUBLE_VEC2:        glProgramUniform2dv(program_name, location, count, d);  break;
+    case GL_DOUBLE_VEC3:        glProgramUniform3dv(program_name, location, count, d);  break;
+    case GL_DOUBLE_VEC4:        glProgramUniform4dv(program_name, location, count, d);  break;
+    case GL_INT:
+    case GL_BOOL:               glProgramUniform1iv(program_name, location, count, i);  break;
+    case GL_INT_VEC2:
+    case GL_BOOL_VEC2:          glProgramUniform2iv(program_name, location, count, i);  break;
+    case GL_INT_VEC3:
+    case GL_BOOL_VEC3:          glProgramUniform3iv(program_name, location, count, i);  break;
+    case GL_INT_VEC4:
+    case GL_BOOL_VEC4:          glProgramUniform4iv(program_name, location, count, i);  break;
+    case GL_UNSIGNED_INT:       glProgramUniform1uiv(program_name, location, count, u); break;
+    case GL_UNSIGNED_INT_VEC2:  glProgramUniform2uiv(program_name, location, count, u); break;
+    case GL_UNSIGNED_INT_VEC3:  glProgramUniform3uiv(program_name, location, count, u); break;
+    case GL_UNSIGNED_INT_VEC4:  glProgramUniform4uiv(program_name, location, count, u); break;
+    case GL_FLOAT_MAT2:         glProgramUniformMatrix2fv(program_name, location, count, GL_FALSE, f);   break;
+    case GL_FLOAT_MAT3:         glProgramUniformMatrix3fv(program_name, location, count, GL_FALSE, f);   break;
+    case GL_FLOAT_MAT4:         glProgramUniformMatrix4fv(program_name, location, count, GL_FALSE, f);   break;
+    case GL_FLOAT_MAT2x3:       glProgramUniformMatrix2x3fv(program_name, location, count, GL_FALSE, f); break;
+    case GL_FLOAT_MAT2x4:       glProgramUniformMatrix2x4fv(program_name, location, count, GL_FALSE, f); break;
+    case GL_FLOAT_MAT3x2:       glProgramUniformMatrix3x2fv(program_name, location, count, GL_FALSE, f); break;
+    case GL_FLOAT_MAT3x4:       glProgramUniformMatrix3x4fv(program_name, location, count, GL_FALSE, f); break;
+    case GL_FLOAT_MAT4x2:       glProgramUniformMatrix4x2fv(program_name, location, count, GL_FALSE, f); break;
+    case GL_FLOAT_MAT4x3:       glProgramUniformMatrix4x3fv(program_name, location, count, GL_FALSE, f); break;
+    case GL_DOUBLE_MAT2:        glProgramUniformMatrix2dv(program_name, location, count, GL_FALSE, d);   break;
+    case GL_DOUBLE_MAT3:        glProgramUniformMatrix3dv(program_name, location, count, GL_FALSE, d);   break;
+    case GL_DOUBLE_MAT4:        glProgramUniformMatrix4dv(program_name, location, count, GL_FALSE, d);   break;
+    case GL_DOUBLE_MAT2x3:      glProgramUniformMatrix2x3dv(program_name, location, count, GL_FALSE, d); break;
+    case GL_DOUBLE_MAT2x4:      glProgramUniformMatrix2x4dv(program_name, location, count, GL_FALSE, d); break;
+    case GL_DOUBLE_MAT3x2:      glProgramUniformMatrix3x2dv(program_name, location, count, GL_FALSE, d); break;
+    case GL_DOUBLE_MAT3x4:      glProgramUniformMatrix3x4dv(program_name, location, count, GL_FALSE, d); break;
+    case GL_DOUBLE_MAT4x2:      glProgramUniformMatrix4x2dv(program_name, location, count, GL_FALSE, d); break;
+    case GL_DOUBLE_MAT4x3:      glProgramUniformMatrix4x3dv(program_name, location, count, GL_FALSE, d); break;
+    default:                    glProgramUniform1iv(program_name, location, count, i);  break;  // opaque types
+    }
+}
@@ -0,0 +1,711 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "trace/gl_trace.h"
+#include "trace/gl_dispatch.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+// A buffer mapped while capturing.
+struct GLTraceMapping {
+    unsigned char*  data;
+    GLintptr        offset;
+    GLsizeiptr      length;
+    GLbitfield      access;
+};
+
+
+//---------------------------------------------------------------------------
+static const size_t                         FLUSH_THRESHOLD = size_t(1) << 22;
+
+static ofstream                             output;
+static vector<unsigned char>                pending;            // the records not written into the file yet.
+static unordered_map<GLuint, GLTraceMapping> mappings;          // the mapped buffers, by name.
+static uint64_t                             frames_count = 0;
+static uint64_t                             bytes_count = 0;
+
+bool GLTrace::prvt_capturing = false;
+const char GLTrace::HEADER[8] = { 'O', 'G', 'L', 'T', 'R', 'C', '0', '1' };
+
+
+//---------------------------------------------------------------------------
+// Stops capturing at exit, so that the trace file gets complete.
+static struct GLTraceExitGuard {
+    ~GLTraceExitGuard() {
+        GLTrace::stop();
+    }
+} exit_guard;
+
+
+//---------------------------------------------------------------------------
+// The original function pointed to by a GLEW (or dispatch) function pointer while capturing.
+template<auto POINTER>
+struct GLTraceOriginal {
+    static inline remove_pointer_t<decltype(POINTER)> function = NULL;
+};
+
+#define OBJECTGL_GL_ORIGINAL(name) GLTraceOriginal<&__glew##name>::function
+
+
+//---------------------------------------------------------------------------
+static void flush_pending()
+{
+    if (pending.empty())
+        return;
+    output.write(reinterpret_cast<const char*>(pending.data()), streamsize(pending.size()));
+    bytes_count += pending.size();
+    pending.clear();
+}
+
+
+static inline void write_bytes(const void* data, const size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    pending.insert(pending.end(), bytes, bytes + size);
+}
+
+
+template<typename T>
+static inline void write_value(const T value)
+{
+    if constexpr (is_pointer<T>::value) {
+        const uint64_t address = uint64_t(reinterpret_cast<uintptr_t>(value));
+        write_bytes(&address, sizeof(address));
+    }
+    else
+        write_bytes(&value, sizeof(T));
+}
+
+
+static inline void write_record(const GLTrace::Record record)
+{
+    if (pending.size() >= FLUSH_THRESHOLD)
+        flush_pending();
+    write_value(uint16_t(record));
+}
+
+
+template<typename T>
+static void write_array(const T* values, const size_t count)
+{
+    if (values == NULL) {
+        write_value(GLTrace::NULL_COUNT);
+        return;
+    }
+    write_value(uint32_t(count));
+    write_bytes(values, count * sizeof(T));
+}
+
+
+static GLuint get_bound_buffer(const GLenum target)
+{
+    GLenum binding = 0;
+    switch (target) {
+    case GL_ARRAY_BUFFER:               binding = GL_ARRAY_BUFFER_BINDING;              break;
+    case GL_ATOMIC_COUNTER_BUFFER:      binding = GL_ATOMIC_COUNTER_BUFFER_BINDING;     break;
+    case GL_COPY_READ_BUFFER:           binding = GL_COPY_READ_BUFFER_BINDING;          break;
+    case GL_COPY_WRITE_BUFFER:          binding = GL_COPY_WRITE_BUFFER_BINDING;         break;
+    case GL_DISPATCH_INDIRECT_BUFFER:   binding = GL_DISPATCH_INDIRECT_BUFFER_BINDING;  break;
+    case GL_DRAW_INDIRECT_BUFFER:       binding = GL_DRAW_INDIRECT_BUFFER_BINDING;      break;
+    case GL_ELEMENT_ARRAY_BUFFER:       binding = GL_ELEMENT_ARRAY_BUFFER_BINDING;      break;
+    case GL_PARAMETER_BUFFER:           binding = GL_PARAMETER_BUFFER_BINDING;          break;
+    case GL_PIXEL_PACK_BUFFER:          binding = GL_PIXEL_PACK_BUFFER_BINDING;         break;
+    case GL_PIXEL_UNPACK_BUFFER:        binding = GL_PIXEL_UNPACK_BUFFER_BINDING;       break;
+    case GL_QUERY_BUFFER:               binding = GL_QUERY_BUFFER_BINDING;              break;
+    case GL_SHADER_STORAGE_BUFFER:      binding = GL_SHADER_STORAGE_BUFFER_BINDING;     break;
+    case GL_TEXTURE_BUFFER:             binding = GL_TEXTURE_BUFFER_BINDING;            break;
+    case GL_TRANSFORM_FEEDBACK_BUFFER:  binding = GL_TRANSFORM_FEEDBACK_BUFFER_BINDING; break;
+    case GL_UNIFORM_BUFFER:             binding = GL_UNIFORM_BUFFER_BINDING;            break;
+    default:                            return 0;
+    }
+
+    GLint name = 0;
+    glGetIntegerv(binding, &name);
+    return GLuint(name);
+}
+
+
+static void on_mapped(const GLuint buffer, void* data, const GLintptr offset, const GLsizeiptr length, const GLbitfield access)
+{
+    if (data != NULL)
+        mappings[buffer] = GLTraceMapping{ static_cast<unsigned char*>(data), offset, length, access };
+}
+
+
+// Records a range of a mapping, given relatively to the mapping.
+static void write_mapped_range(const GLuint buffer, const GLintptr offset, const GLsizeiptr length)
+{
+    const auto found = mappings.find(buffer);
+    if (found == mappings.end() || (found->second.access & GL_MAP_WRITE_BIT) == 0)
+        return;
+    const GLTraceMapping& mapping = found->second;
+    GLTrace::on_mapped_write(buffer, mapping.offset + offset, length, mapping.data + offset);
+}
+
+
+// Records the whole range of a mapping about to be unmapped, unless it has been recorded already.
+static void on_unmapping(const GLuint buffer)
+{
+    const auto found = mappings.find(buffer);
+    if (found == mappings.end())
+        return;
+    const GLbitfield access = found->second.access;
+    if ((access & (GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_PERSISTENT_BIT)) == 0)
+        write_mapped_range(buffer, 0, found->second.length);
+    mappings.erase(found);
+}
+
+
+//---------------------------------------------------------------------------
+// Checks the count of kinds of arguments of each call of the tables.
+template<typename F>
+struct GLTraceArity;
+
+template<typename R, typename... Args>
+struct GLTraceArity<R (GLAPIENTRY*)(Args...)> {
+    static const size_t value = sizeof...(Args);
+};
+
+#define OBJECTGL_GL_TRACE_CHECK(name, kinds) \
+    static_assert(GLTraceArity<decltype(__glew##name)>::value == sizeof(kinds) - 1, "wrong count of kinds of arguments of gl" #name);
+OBJECTGL_GL_TRACED_GLEW_CALLS(OBJECTGL_GL_TRACE_CHECK)
+#undef OBJECTGL_GL_TRACE_CHECK
+#define OBJECTGL_GL_TRACE_CHECK(name, kinds) \
+    static_assert(GLTraceArity<decltype(objectgl_gl##name)>::value == sizeof(kinds) - 1, "wrong count of kinds of arguments of gl" #name);
+OBJECTGL_GL_TRACED_CORE_CALLS(OBJECTGL_GL_TRACE_CHECK)
+#undef OBJECTGL_GL_TRACE_CHECK
+
+
+//---------------------------------------------------------------------------
+// The wrapper of the calls with values only.
+template<GLTrace::Record RECORD, auto POINTER>
+struct GLTraceCall;
+
+template<GLTrace::Record RECORD, typename R, typename... Args, R (GLAPIENTRY** POINTER)(Args...)>
+struct GLTraceCall<RECORD, POINTER> {
+    static R GLAPIENTRY call(Args... args) {
+        write_record(RECORD);
+        (write_value(args), ...);
+        return GLTraceOriginal<POINTER>::function(args...);
+    }
+};
+
+
+//---------------------------------------------------------------------------
+// The wrappers of the calls that create or delete arrays of objects.
+template<GLTrace::Record RECORD, auto POINTER>
+static void GLAPIENTRY traced_names_creation(GLsizei n, GLuint* names)
+{
+    GLTraceOriginal<POINTER>::function(n, names);
+    write_record(RECORD);
+    write_array(names, size_t(n));
+}
+
+
+template<GLTrace::Record RECORD, auto POINTER>
+static void GLAPIENTRY traced_names_deletion(GLsizei n, const GLuint* names)
+{
+    write_record(RECORD);
+    write_array(names, size_t(n));
+    GLTraceOriginal<POINTER>::function(n, names);
+}
+
+
+static const auto traced_CreateBuffers = &traced_names_creation<GLTrace::RECORD_CreateBuffers, &__glewCreateBuffers>;
+static const auto traced_CreateSamplers = &traced_names_creation<GLTrace::RECORD_CreateSamplers, &__glewCreateSamplers>;
+static const auto traced_CreateVertexArrays = &traced_names_creation<GLTrace::RECORD_CreateVertexArrays, &__glewCreateVertexArrays>;
+static const auto traced_GenBuffers = &traced_names_creation<GLTrace::RECORD_GenBuffers, &__glewGenBuffers>;
+static const auto traced_GenQueries = &traced_names_creation<GLTrace::RECORD_GenQueries, &__glewGenQueries>;
+static const auto traced_GenVertexArrays = &traced_names_creation<GLTrace::RECORD_GenVertexArrays, &__glewGenVertexArrays>;
+static const auto traced_DeleteBuffers = &traced_names_deletion<GLTrace::RECORD_DeleteBuffers, &__glewDeleteBuffers>;
+static const auto traced_DeleteQueries = &traced_names_deletion<GLTrace::RECORD_DeleteQueries, &__glewDeleteQueries>;
+static const auto traced_DeleteSamplers = &traced_names_deletion<GLTrace::RECORD_DeleteSamplers, &__glewDeleteSamplers>;
+static const auto traced_DeleteVertexArrays = &traced_names_deletion<GLTrace::RECORD_DeleteVertexArrays, &__glewDeleteVertexArrays>;
+static const auto traced_DeleteTextures = &traced_names_deletion<GLTrace::RECORD_DeleteTextures, &objectgl_glDeleteTextures>;
+
+
+// Deletions of single objects are traced as values, but replayed by dedicated code.
+static const auto traced_DeleteProgram = &GLTraceCall<GLTrace::RECORD_DeleteProgram, &__glewDeleteProgram>::call;
+static const auto traced_DeleteShader = &GLTraceCall<GLTrace::RECORD_DeleteShader, &__glewDeleteShader>::call;
+static const auto traced_DeleteSync = &GLTraceCall<GLTrace::RECORD_DeleteSync, &__glewDeleteSync>::call;
+
+
+static void GLAPIENTRY traced_CreateTextures(GLenum target, GLsizei n, GLuint* textures)
+{
+    OBJECTGL_GL_ORIGINAL(CreateTextures)(target, n, textures);
+    write_record(GLTrace::RECORD_CreateTextures);
+    write_value(target);
+    write_array(textures, size_t(n));
+}
+
+
+static GLuint GLAPIENTRY traced_CreateProgram()
+{
+    const GLuint program = OBJECTGL_GL_ORIGINAL(CreateProgram)();
+    write_record(GLTrace::RECORD_CreateProgram);
+    write_value(program);
+    return program;
+}
+
+
+static GLuint GLAPIENTRY traced_CreateShader(GLenum type)
+{
+    const GLuint shader = OBJECTGL_GL_ORIGINAL(CreateShader)(type);
+    write_record(GLTrace::RECORD_CreateShader);
+    write_value(type);
+    write_value(shader);
+    return shader;
+}
+
+
+static GLsync GLAPIENTRY traced_FenceSync(GLenum condition, GLbitfield flags)
+{
+    const GLsync sync = OBJECTGL_GL_ORIGINAL(FenceSync)(condition, flags);
+    write_record(GLTrace::RECORD_FenceSync);
+    write_value(condition);
+    write_value(flags);
+    write_value(sync);
+    return sync;
+}
+
+
+//---------------------------------------------------------------------------
+// The wrappers of the calls that bind arrays of objects.
+static void GLAPIENTRY traced_BindBuffersRange(GLenum target, GLuint first, GLsizei count, const GLuint* buffers, const GLintptr* offsets, const GLsizeiptr* sizes)
+{
+    write_record(GLTrace::RECORD_BindBuffersRange);
+    write_value(target);
+    write_value(first);
+    write_value(count);
+    write_array(buffers, size_t(count));
+    write_array(offsets, size_t(count));
+    write_array(sizes, size_t(count));
+    OBJECTGL_GL_ORIGINAL(BindBuffersRange)(target, first, count, buffers, offsets, sizes);
+}
+
+
+static void GLAPIENTRY traced_BindSamplers(GLuint first, GLsizei count, const GLuint* samplers)
+{
+    write_record(GLTrace::RECORD_BindSamplers);
+    write_value(first);
+    write_value(count);
+    write_array(samplers, size_t(count));
+    OBJECTGL_GL_ORIGINAL(BindSamplers)(first, count, samplers);
+}
+
+
+static void GLAPIENTRY traced_BindTextures(GLuint first, GLsizei count, const GLuint* textures)
+{
+    write_record(GLTrace::RECORD_BindTextures);
+    write_value(first);
+    write_value(count);
+    write_array(textures, size_t(count));
+    OBJECTGL_GL_ORIGINAL(BindTextures)(first, count, textures);
+}
+
+
+static void GLAPIENTRY traced_BindVertexBuffers(GLuint first, GLsizei count, const GLuint* buffers, const GLintptr* offsets, const GLsizei* strides)
+{
+    write_record(GLTrace::RECORD_BindVertexBuffers);
+    write_value(first);
+    write_value(count);
+    write_array(buffers, size_t(count));
+    write_array(offsets, size_t(count));
+    write_array(strides, size_t(count));
+    OBJECTGL_GL_ORIGINAL(BindVertexBuffers)(first, count, buffers, offsets, strides);
+}
+
+
+static void GLAPIENTRY traced_VertexArrayVertexBuffers(GLuint vaobj, GLuint first, GLsizei count, const GLuint* buffers, const GLintptr* offsets, const GLsizei* strides)
+{
+    write_record(GLTrace::RECORD_VertexArrayVertexBuffers);
+    write_value(vaobj);
+    write_value(first);
+    write_value(count);
+    write_array(buffers, size_t(count));
+    write_array(offsets, size_t(count));
+    write_array(strides, size_t(count));
+    OBJECTGL_GL_ORIGINAL(VertexArrayVertexBuffers)(vaobj, first, count, buffers, offsets, strides);
+}
+
+
+//---------------------------------------------------------------------------
+// The wrappers of the calls that upload buffers contents.
+static void GLAPIENTRY traced_BufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags)
+{
+    write_record(GLTrace::RECORD_BufferStorage);
+    write_value(target);
+    write_value(size);
+    write_array(static_cast<const unsigned char*>(data), size_t(size));
+    write_value(flags);
+    OBJECTGL_GL_ORIGINAL(BufferStorage)(target, size, data, flags);
+}
+
+
+static void GLAPIENTRY traced_NamedBufferStorage(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield flags)
+{
+    write_record(GLTrace::RECORD_NamedBufferStorage);
+    write_value(buffer);
+    write_value(size);
+    write_array(static_cast<const unsigned char*>(data), size_t(size));
+    write_value(flags);
+    OBJECTGL_GL_ORIGINAL(NamedBufferStorage)(buffer, size, data, flags);
+}
+
+
+static void GLAPIENTRY traced_BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    write_record(GLTrace::RECORD_BufferSubData);
+    write_value(target);
+    write_value(offset);
+    write_array(static_cast<const unsigned char*>(data), size_t(size));
+    OBJECTGL_GL_ORIGINAL(BufferSubData)(target, offset, size, data);
+}
+
+
+static void GLAPIENTRY traced_NamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    write_record(GLTrace::RECORD_NamedBufferSubData);
+    write_value(buffer);
+    write_value(offset);
+    write_array(static_cast<const unsigned char*>(data), size_t(size));
+    OBJECTGL_GL_ORIGINAL(NamedBufferSubData)(buffer, offset, size, data);
+}
+
+
+//---------------------------------------------------------------------------
+// The wrappers of the mapping calls.  Calls on targets also record the name of the bound buffer.
+static void* GLAPIENTRY traced_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    void* data = OBJECTGL_GL_ORIGINAL(MapBufferRange)(target, offset, length, access);
+    const GLuint buffer = get_bound_buffer(target);
+    write_record(GLTrace::RECORD_MapBufferRange);
+    write_value(target);
+    write_value(offset);
+    write_value(length);
+    write_value(access);
+    write_value(buffer);
+    on_mapped(buffer, data, offset, length, access);
+    return data;
+}
+
+
+static void* GLAPIENTRY traced_MapNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    void* data = OBJECTGL_GL_ORIGINAL(MapNamedBufferRange)(buffer, offset, length, access);
+    write_record(GLTrace::RECORD_MapNamedBufferRange);
+    write_value(buffer);
+    write_value(offset);
+    write_value(length);
+    write_value(access);
+    on_mapped(buffer, data, offset, length, access);
+    return data;
+}
+
+
+static void GLAPIENTRY traced_FlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length)
+{
+    write_mapped_range(get_bound_buffer(target), offset, length);
+    write_record(GLTrace::RECORD_FlushMappedBufferRange);
+    write_value(target);
+    write_value(offset);
+    write_value(length);
+    OBJECTGL_GL_ORIGINAL(FlushMappedBufferRange)(target, offset, length);
+}
+
+
+static void GLAPIENTRY traced_FlushMappedNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr length)
+{
+    write_mapped_range(buffer, offset, length);
+    write_record(GLTrace::RECORD_FlushMappedNamedBufferRange);
+    write_value(buffer);
+    write_value(offset);
+    write_value(length);
+    OBJECTGL_GL_ORIGINAL(FlushMappedNamedBufferRange)(buffer, offset, length);
+}
+
+
+static GLboolean GLAPIENTRY traced_UnmapBuffer(GLenum target)
+{
+    const GLuint buffer = get_bound_buffer(target);
+    on_unmapping(buffer);
+    write_record(GLTrace::RECORD_UnmapBuffer);
+    write_value(target);
+    write_value(buffer);
+    return OBJECTGL_GL_ORIGINAL(UnmapBuffer)(target);
+}
+
+
+static GLboolean GLAPIENTRY traced_UnmapNamedBuffer(GLuint buffer)
+{
+    on_unmapping(buffer);
+    write_record(GLTrace::RECORD_UnmapNamedBuffer);
+    write_value(buffer);
+    return OBJECTGL_GL_ORIGINAL(UnmapNamedBuffer)(buffer);
+}
+
+
+//---------------------------------------------------------------------------
+// The wrappers of the calls that upload shaders and programs.
+static void GLAPIENTRY traced_ShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+{
+    write_record(GLTrace::RECORD_ShaderSource);
+    write_value(shader);
+    write_value(count);
+    for (GLsizei i = 0; i < count; ++i) {
+        const size_t chars_count = length != NULL && length[i] >= 0 ? size_t(length[i]) : strlen(string[i]);
+        write_array(string[i], chars_count);
+    }
+    OBJECTGL_GL_ORIGINAL(ShaderSource)(shader, count, string, length);
+}
+
+
+static void GLAPIENTRY traced_ShaderBinary(GLsizei count, const GLuint* shaders, GLenum binaryformat, const void* binary, GLsizei length)
+{
+    write_record(GLTrace::RECORD_ShaderBinary);
+    write_array(shaders, size_t(count));
+    write_value(binaryformat);
+    write_array(static_cast<const unsigned char*>(binary), size_t(length));
+    OBJECTGL_GL_ORIGINAL(ShaderBinary)(count, shaders, binaryformat, binary, length);
+}
+
+
+static void write_specialization(const GLTrace::Record record, GLuint shader, const GLchar* entry_point, GLuint count, const GLuint* indices, const GLuint* values)
+{
+    write_record(record);
+    write_value(shader);
+    write_array(entry_point, entry_point != NULL ? strlen(entry_point) : 0);
+    write_array(indices, size_t(count));
+    write_array(values, size_t(count));
+}
+
+
+static void GLAPIENTRY traced_SpecializeShader(GLuint shader, const GLchar* entry_point, GLuint count, const GLuint* indices, const GLuint* values)
+{
+    write_specialization(GLTrace::RECORD_SpecializeShader, shader, entry_point, count, indices, values);
+    OBJECTGL_GL_ORIGINAL(SpecializeShader)(shader, entry_point, count, indices, values);
+}
+
+
+static void GLAPIENTRY traced_SpecializeShaderARB(GLuint shader, const GLchar* entry_point, GLuint count, const GLuint* indices, const GLuint* values)
+{
+    write_specialization(GLTrace::RECORD_SpecializeShaderARB, shader, entry_point, count, indices, values);
+    OBJECTGL_GL_ORIGINAL(SpecializeShaderARB)(shader, entry_point, count, indices, values);
+}
+
+
+static void GLAPIENTRY traced_ProgramBinary(GLuint program, GLenum binary_format, const void* binary, GLsizei length)
+{
+    write_record(GLTrace::RECORD_ProgramBinary);
+    write_value(program);
+    write_value(binary_format);
+    write_array(static_cast<const unsigned char*>(binary), size_t(length));
+    OBJECTGL_GL_ORIGINAL(ProgramBinary)(program, binary_format, binary, length);
+}
+
+
+//---------------------------------------------------------------------------
+// The wrappers of the calls that upload uniforms.
+template<GLTrace::Record RECORD, auto POINTER, typename T, size_t N>
+static void GLAPIENTRY traced_uniform(GLuint program, GLint location, GLsizei count, const T* value)
+{
+    write_record(RECORD);
+    write_value(program);
+    write_value(location);
+    write_array(value, size_t(count) * N);
+    GLTraceOriginal<POINTER>::function(program, location, count, value);
+}
+
+
+template<GLTrace::Record RECORD, auto POINTER, typename T, size_t N>
+static void GLAPIENTRY traced_uniform_matrix(GLuint program, GLint location, GLsizei count, GLboolean transpose, const T* value)
+{
+    write_record(RECORD);
+    write_value(program);
+    write_value(location);
+    write_value(transpose);
+    write_array(value, size_t(count) * N);
+    GLTraceOriginal<POINTER>::function(program, location, count, transpose, value);
+}
+
+
+static void GLAPIENTRY traced_UniformSubroutinesuiv(GLenum shadertype, GLsizei count, const GLuint* indices)
+{
+    write_record(GLTrace::RECORD_UniformSubroutinesuiv);
+    write_value(shadertype);
+    write_array(indices, size_t(count));
+    OBJECTGL_GL_ORIGINAL(UniformSubroutinesuiv)(shadertype, count, indices);
+}
+
+
+//---------------------------------------------------------------------------
+template<auto POINTER, typename F>
+static void install(const F traced)
+{
+    if (*POINTER == NULL || GLTraceOriginal<POINTER>::function != NULL)
+        return;
+    GLTraceOriginal<POINTER>::function = *POINTER;
+    *POINTER = traced;
+}
+
+
+template<auto POINTER>
+static void uninstall()
+{
+    if (GLTraceOriginal<POINTER>::function == NULL)
+        return;
+    *POINTER = GLTraceOriginal<POINTER>::function;
+    GLTraceOriginal<POINTER>::function = NULL;
+}
+
+
+static void install_all()
+{
+#define OBJECTGL_GL_TRACE_INSTALL(name, ...) \
+    install<&__glew##name>(&GLTraceCall<GLTrace::RECORD_##name, &__glew##name>::call);
+    OBJECTGL_GL_TRACED_GLEW_CALLS(OBJECTGL_GL_TRACE_INSTALL)
+#undef OBJECTGL_GL_TRACE_INSTALL
+#define OBJECTGL_GL_TRACE_INSTALL(name, ...) \
+    install<&objectgl_gl##name>(&GLTraceCall<GLTrace::RECORD_##name, &objectgl_gl##name>::call);
+    OBJECTGL_GL_TRACED_CORE_CALLS(OBJECTGL_GL_TRACE_INSTALL)
+#undef OBJECTGL_GL_TRACE_INSTALL
+#define OBJECTGL_GL_TRACE_INSTALL(name, T, N) \
+    install<&__glew##name>(&traced_uniform<GLTrace::RECORD_##name, &__glew##name, T, N>);
+    OBJECTGL_GL_TRACED_UNIFORM_CALLS(OBJECTGL_GL_TRACE_INSTALL)
+#undef OBJECTGL_GL_TRACE_INSTALL
+#define OBJECTGL_GL_TRACE_INSTALL(name, T, N) \
+    install<&__glew##name>(&traced_uniform_matrix<GLTrace::RECORD_##name, &__glew##name, T, N>);
+    OBJECTGL_GL_TRACED_UNIFORM_MATRIX_CALLS(OBJECTGL_GL_TRACE_INSTALL)
+#undef OBJECTGL_GL_TRACE_INSTALL
+#define OBJECTGL_GL_TRACE_INSTALL(name) \
+    install<&__glew##name>(traced_##name);
+    OBJECTGL_GL_TRACED_CUSTOM_CALLS(OBJECTGL_GL_TRACE_INSTALL)
+#undef OBJECTGL_GL_TRACE_INSTALL
+#define OBJECTGL_GL_TRACE_INSTALL(name) \
+    install<&objectgl_gl##name>(traced_##name);
+    OBJECTGL_GL_TRACED_CORE_CUSTOM_CALLS(OBJECTGL_GL_TRACE_INSTALL)
+#undef OBJECTGL_GL_TRACE_INSTALL
+}
+
+
+static void uninstall_all()
+{
+#define OBJECTGL_GL_TRACE_UNINSTALL(name, ...) uninstall<&__glew##name>();
+    OBJECTGL_GL_TRACED_GLEW_CALLS(OBJECTGL_GL_TRACE_UNINSTALL)
+    OBJECTGL_GL_TRACED_UNIFORM_CALLS(OBJECTGL_GL_TRACE_UNINSTALL)
+    OBJECTGL_GL_TRACED_UNIFORM_MATRIX_CALLS(OBJECTGL_GL_TRACE_UNINSTALL)
+#undef OBJECTGL_GL_TRACE_UNINSTALL
+#define OBJECTGL_GL_TRACE_UNINSTALL(name, ...) uninstall<&objectgl_gl##name>();
+    OBJECTGL_GL_TRACED_CORE_CALLS(OBJECTGL_GL_TRACE_UNINSTALL)
+#undef OBJECTGL_GL_TRACE_UNINSTALL
+#define OBJECTGL_GL_TRACE_UNINSTALL(name) uninstall<&__glew##name>();
+    OBJECTGL_GL_TRACED_CUSTOM_CALLS(OBJECTGL_GL_TRACE_UNINSTALL)
+#undef OBJECTGL_GL_TRACE_UNINSTALL
+#define OBJECTGL_GL_TRACE_UNINSTALL(name) uninstall<&objectgl_gl##name>();
+    OBJECTGL_GL_TRACED_CORE_CUSTOM_CALLS(OBJECTGL_GL_TRACE_UNINSTALL)
+#undef OBJECTGL_GL_TRACE_UNINSTALL
+}
+
+
+//===========================================================================
+bool GLTrace::start(const string& filepath)
+{
+    if (prvt_capturing) {
+        cerr << "!!! GL trace capture is already started" << endl;
+        return false;
+    }
+
+    output.open(filepath, ios::binary | ios::trunc);
+    if (!output) {
+        cerr << "!!! failed opening GL trace file " << filepath << endl;
+        return false;
+    }
+    output.write(HEADER, sizeof(HEADER));
+
+    pending.clear();
+    pending.reserve(FLUSH_THRESHOLD + (size_t(1) << 16));
+    mappings.clear();
+    frames_count = 0;
+    bytes_count = sizeof(HEADER);
+
+    install_all();
+    prvt_capturing = true;
+    return true;
+}
+
+
+void GLTrace::stop()
+{
+    if (!prvt_capturing)
+        return;
+    prvt_capturing = false;
+    uninstall_all();
+
+    write_record(RECORD_END);
+    flush_pending();
+    output.close();
+    mappings.clear();
+}
+
+
+void GLTrace::end_frame()
+{
+    if (!prvt_capturing)
+        return;
+    write_record(RECORD_FRAME);
+    flush_pending();
+    ++frames_count;
+}
+
+
+void GLTrace::on_mapped_write(const GLuint buffer, const GLintptr offset, const GLsizeiptr size, const void* data)
+{
+    if (!prvt_capturing || size <= 0)
+        return;
+    write_record(RECORD_MAPPED_WRITE);
+    write_value(buffer);
+    write_value(int64_t(offset));
+    write_array(static_cast<const unsigned char*>(data), size_t(size));
+}
+
+
+uint64_t GLTrace::get_frames_count()
+{
+    return frames_count;
+}
+
+
+uint64_t GLTrace::get_bytes_count()
+{
+    return bytes_count + pending.size();
+}
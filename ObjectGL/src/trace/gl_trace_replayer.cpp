@@ -0,0 +1,684 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "trace/gl_trace_replayer.h"
+#include "trace/gl_dispatch.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+// Replays a call traced by dedicated code, unless the trace is corrupt or its entry point is not available.
+#define OBJECTGL_GL_REPLAY_CUSTOM(name, ...)    \
+    do {                                        \
+        if (prvt_corrupt)                       \
+            break;                              \
+        if (__glew##name != NULL)               \
+            gl##name(__VA_ARGS__);              \
+        else                                    \
+            ++prvt_skipped_calls;               \
+    } while (false)
+
+
+//---------------------------------------------------------------------------
+static inline size_t get_names_kind(const char kind)
+{
+    switch (kind) {
+    case 'B':   return 0;
+    case 'T':   return 1;
+    case 'P':   return 2;
+    case 'S':   return 3;
+    case 'A':   return 4;
+    case 'M':   return 5;
+    case 'Q':   return 6;
+    default:    return 7;
+    }
+}
+
+
+static inline GLuint* get_names_storage(vector<uint64_t>& scratch, const uint32_t count)
+{
+    scratch.resize(count / 2 + 1);
+    return reinterpret_cast<GLuint*>(scratch.data());
+}
+
+
+//===========================================================================
+GLTraceReplayer::GLTraceReplayer(const string& filepath)
+    : prvt_cursor(sizeof(GLTrace::HEADER)),
+      prvt_corrupt(false),
+      prvt_finished(false),
+      prvt_replayed_frames(0),
+      prvt_skipped_calls(0),
+      prvt_bytes(0)
+{
+    static_assert(NAMES_KINDS_COUNT == 7, "names kinds do not match get_names_kind()");
+
+    ifstream input(filepath, ios::binary | ios::ate);
+    if (!input) {
+        cerr << "!!! failed opening GL trace file " << filepath << endl;
+        return;
+    }
+    const streamsize size = input.tellg();
+    input.seekg(0);
+    prvt_trace.resize(size_t(size));
+    if (size < streamsize(sizeof(GLTrace::HEADER)) || !input.read(reinterpret_cast<char*>(prvt_trace.data()), size)
+        || memcmp(prvt_trace.data(), GLTrace::HEADER, sizeof(GLTrace::HEADER)) != 0) {
+        cerr << "!!! " << filepath << " is not a GL trace file" << endl;
+        prvt_trace.clear();
+    }
+}
+
+
+GLTraceReplayer::~GLTraceReplayer()
+{
+    for (const auto& mapping : prvt_mappings) {
+        const GLuint buffer = prvt_remap('B', mapping.first);
+        if (buffer != 0)
+            glUnmapNamedBuffer(buffer);
+    }
+
+    for (const auto& name : prvt_names[get_names_kind('B')])
+        glDeleteBuffers(1, &name.second);
+    for (const auto& name : prvt_names[get_names_kind('T')])
+        glDeleteTextures(1, &name.second);
+    for (const auto& name : prvt_names[get_names_kind('P')])
+        glDeleteProgram(name.second);
+    for (const auto& name : prvt_names[get_names_kind('S')])
+        glDeleteShader(name.second);
+    for (const auto& name : prvt_names[get_names_kind('A')])
+        glDeleteVertexArrays(1, &name.second);
+    for (const auto& name : prvt_names[get_names_kind('M')])
+        glDeleteSamplers(1, &name.second);
+    for (const auto& name : prvt_names[get_names_kind('Q')])
+        glDeleteQueries(1, &name.second);
+    for (const auto& sync : prvt_syncs)
+        glDeleteSync(sync.second);
+}
+
+
+bool GLTraceReplayer::replay_frame(FrameStats& stats)
+{
+    stats = FrameStats{ 0.0, 0, 0 };
+    if (!is_ok() || prvt_finished)
+        return false;
+
+    prvt_bytes = 0;
+    bool frame_ended = false;
+    const chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+
+    while (!frame_ended && !prvt_finished) {
+        if (prvt_cursor >= prvt_trace.size()) {
+            prvt_finished = true;   // truncated trace, e.g. of a crashed application
+            break;
+        }
+
+        const uint16_t record = prvt_read<uint16_t>();
+        if (record == GLTrace::RECORD_FRAME)
+            frame_ended = true;
+        else if (record == GLTrace::RECORD_END)
+            prvt_finished = true;
+        else {
+            prvt_replay_record(GLTrace::Record(record));
+            ++stats.calls;
+        }
+
+        if (prvt_corrupt) {
+            cerr << "!!! corrupt GL trace at offset " << prvt_cursor << endl;
+            prvt_finished = true;
+            return false;
+        }
+    }
+
+    stats.cpu_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+    stats.bytes = prvt_bytes;
+    if (frame_ended)
+        ++prvt_replayed_frames;
+    return frame_ended;
+}
+
+
+template<typename T>
+T GLTraceReplayer::prvt_read()
+{
+    T value = T();
+    if (prvt_cursor + sizeof(T) > prvt_trace.size()) {
+        prvt_corrupt = true;
+        return value;
+    }
+    memcpy(&value, prvt_trace.data() + prvt_cursor, sizeof(T));
+    prvt_cursor += sizeof(T);
+    return value;
+}
+
+
+template<typename T>
+T GLTraceReplayer::prvt_read_argument(const char kind)
+{
+    if constexpr (is_pointer<T>::value) {
+        const uint64_t value = prvt_read<uint64_t>();
+        if (kind == 'Y') {
+            const auto found = prvt_syncs.find(value);
+            return reinterpret_cast<T>(found != prvt_syncs.end() ? found->second : NULL);
+        }
+        return reinterpret_cast<T>(uintptr_t(value));
+    }
+    else if constexpr (is_same<T, GLuint>::value)
+        return prvt_remap(kind, prvt_read<GLuint>());
+    else
+        return prvt_read<T>();
+}
+
+
+template<typename T>
+T* GLTraceReplayer::prvt_read_array(const size_t scratch_index, uint32_t& count)
+{
+    count = prvt_read<uint32_t>();
+    if (prvt_corrupt || count == GLTrace::NULL_COUNT) {
+        count = 0;
+        return NULL;
+    }
+
+    const size_t size = size_t(count) * sizeof(T);
+    if (prvt_cursor + size > prvt_trace.size()) {
+        prvt_corrupt = true;
+        count = 0;
+        return NULL;
+    }
+
+    // records are not aligned in the trace: arrays get copied
+    vector<uint64_t>& scratch = prvt_scratches[scratch_index];
+    scratch.resize(size / sizeof(uint64_t) + 1);
+    memcpy(scratch.data(), prvt_trace.data() + prvt_cursor, size);
+    prvt_cursor += size;
+    prvt_bytes += size;
+    return reinterpret_cast<T*>(scratch.data());
+}
+
+
+const GLuint* GLTraceReplayer::prvt_read_names(const char kind, const size_t scratch_index, uint32_t& count)
+{
+    GLuint* names = prvt_read_array<GLuint>(scratch_index, count);
+    for (uint32_t i = 0; i < count; ++i)
+        names[i] = prvt_remap(kind, names[i]);
+    return names;
+}
+
+
+const unsigned char* GLTraceReplayer::prvt_read_bytes(uint32_t& count)
+{
+    count = prvt_read<uint32_t>();
+    if (prvt_corrupt || count == GLTrace::NULL_COUNT) {
+        count = 0;
+        return NULL;
+    }
+    if (prvt_cursor + count > prvt_trace.size()) {
+        prvt_corrupt = true;
+        count = 0;
+        return NULL;
+    }
+
+    const unsigned char* bytes = prvt_trace.data() + prvt_cursor;
+    prvt_cursor += count;
+    prvt_bytes += count;
+    return bytes;
+}
+
+
+template<typename R, typename... Args, size_t... I>
+void GLTraceReplayer::prvt_replay_call(R (GLAPIENTRY* function)(Args...), const char* kinds, index_sequence<I...>)
+{
+    // the initializers of a braced list are evaluated in order
+    tuple<Args...> arguments{ prvt_read_argument<Args>(kinds[I])... };
+
+    if (prvt_corrupt)
+        return;
+    if (function == NULL)
+        ++prvt_skipped_calls;
+    else
+        apply(function, arguments);
+}
+
+
+template<typename T>
+void GLTraceReplayer::prvt_replay_uniform(void (GLAPIENTRY* function)(GLuint, GLint, GLsizei, const T*), const uint32_t elements_count)
+{
+    const GLuint program = prvt_remap('P', prvt_read<GLuint>());
+    const GLint location = prvt_read<GLint>();
+    uint32_t count = 0;
+    const T* values = prvt_read_array<T>(0, count);
+    if (prvt_corrupt)
+        return;
+    if (function == NULL)
+        ++prvt_skipped_calls;
+    else
+        function(program, location, GLsizei(count / elements_count), values);
+}
+
+
+template<typename T>
+void GLTraceReplayer::prvt_replay_uniform_matrix(void (GLAPIENTRY* function)(GLuint, GLint, GLsizei, GLboolean, const T*), const uint32_t elements_count)
+{
+    const GLuint program = prvt_remap('P', prvt_read<GLuint>());
+    const GLint location = prvt_read<GLint>();
+    const GLboolean transpose = prvt_read<GLboolean>();
+    uint32_t count = 0;
+    const T* values = prvt_read_array<T>(0, count);
+    if (prvt_corrupt)
+        return;
+    if (function == NULL)
+        ++prvt_skipped_calls;
+    else
+        function(program, location, GLsizei(count / elements_count), transpose, values);
+}
+
+
+void GLTraceReplayer::prvt_replay_record(const GLTrace::Record record)
+{
+    uint32_t count = 0;
+
+    switch (record) {
+#define OBJECTGL_GL_REPLAY(name, kinds) \
+    case GLTrace::RECORD_##name: prvt_replay_call(__glew##name, kinds, make_index_sequence<sizeof(kinds) - 1>()); break;
+    OBJECTGL_GL_TRACED_GLEW_CALLS(OBJECTGL_GL_REPLAY)
+#undef OBJECTGL_GL_REPLAY
+#define OBJECTGL_GL_REPLAY(name, kinds) \
+    case GLTrace::RECORD_##name: prvt_replay_call(objectgl_gl##name, kinds, make_index_sequence<sizeof(kinds) - 1>()); break;
+    OBJECTGL_GL_TRACED_CORE_CALLS(OBJECTGL_GL_REPLAY)
+#undef OBJECTGL_GL_REPLAY
+#define OBJECTGL_GL_REPLAY(name, T, N) \
+    case GLTrace::RECORD_##name: prvt_replay_uniform<T>(__glew##name, N); break;
+    OBJECTGL_GL_TRACED_UNIFORM_CALLS(OBJECTGL_GL_REPLAY)
+#undef OBJECTGL_GL_REPLAY
+#define OBJECTGL_GL_REPLAY(name, T, N) \
+    case GLTrace::RECORD_##name: prvt_replay_uniform_matrix<T>(__glew##name, N); break;
+    OBJECTGL_GL_TRACED_UNIFORM_MATRIX_CALLS(OBJECTGL_GL_REPLAY)
+#undef OBJECTGL_GL_REPLAY
+
+    // objects creations and deletions
+    case GLTrace::RECORD_CreateBuffers:         prvt_create_names('B', __glewCreateBuffers);        break;
+    case GLTrace::RECORD_CreateSamplers:        prvt_create_names('M', __glewCreateSamplers);       break;
+    case GLTrace::RECORD_CreateVertexArrays:    prvt_create_names('A', __glewCreateVertexArrays);   break;
+    case GLTrace::RECORD_GenBuffers:            prvt_create_names('B', __glewGenBuffers);           break;
+    case GLTrace::RECORD_GenQueries:            prvt_create_names('Q', __glewGenQueries);           break;
+    case GLTrace::RECORD_GenVertexArrays:       prvt_create_names('A', __glewGenVertexArrays);      break;
+    case GLTrace::RECORD_DeleteBuffers:         prvt_delete_names('B', __glewDeleteBuffers);        break;
+    case GLTrace::RECORD_DeleteQueries:         prvt_delete_names('Q', __glewDeleteQueries);        break;
+    case GLTrace::RECORD_DeleteSamplers:        prvt_delete_names('M', __glewDeleteSamplers);       break;
+    case GLTrace::RECORD_DeleteTextures:        prvt_delete_names('T', objectgl_glDeleteTextures);  break;
+    case GLTrace::RECORD_DeleteVertexArrays:    prvt_delete_names('A', __glewDeleteVertexArrays);   break;
+    case GLTrace::RECORD_DeleteProgram:         prvt_delete_name('P', __glewDeleteProgram);         break;
+    case GLTrace::RECORD_DeleteShader:          prvt_delete_name('S', __glewDeleteShader);          break;
+
+    case GLTrace::RECORD_CreateTextures: {
+        const GLenum target = prvt_read<GLenum>();
+        const GLuint* captured = prvt_read_array<GLuint>(0, count);
+        GLuint* created = get_names_storage(prvt_scratches[1], count);
+        OBJECTGL_GL_REPLAY_CUSTOM(CreateTextures, target, GLsizei(count), created);
+        for (uint32_t i = 0; i < count && !prvt_corrupt && __glewCreateTextures != NULL; ++i)
+            prvt_names[get_names_kind('T')][captured[i]] = created[i];
+        break;
+    }
+
+    case GLTrace::RECORD_CreateProgram: {
+        const GLuint captured = prvt_read<GLuint>();
+        if (!prvt_corrupt)
+            prvt_names[get_names_kind('P')][captured] = glCreateProgram();
+        break;
+    }
+
+    case GLTrace::RECORD_CreateShader: {
+        const GLenum type = prvt_read<GLenum>();
+        const GLuint captured = prvt_read<GLuint>();
+        if (!prvt_corrupt)
+            prvt_names[get_names_kind('S')][captured] = glCreateShader(type);
+        break;
+    }
+
+    case GLTrace::RECORD_FenceSync: {
+        const GLenum condition = prvt_read<GLenum>();
+        const GLbitfield flags = prvt_read<GLbitfield>();
+        const uint64_t captured = prvt_read<uint64_t>();
+        if (!prvt_corrupt)
+            prvt_syncs[captured] = glFenceSync(condition, flags);
+        break;
+    }
+
+    case GLTrace::RECORD_DeleteSync: {
+        const auto found = prvt_syncs.find(prvt_read<uint64_t>());
+        if (found != prvt_syncs.end()) {
+            glDeleteSync(found->second);
+            prvt_syncs.erase(found);
+        }
+        break;
+    }
+
+    // multiple bindings
+    case GLTrace::RECORD_BindBuffersRange: {
+        const GLenum target = prvt_read<GLenum>();
+        const GLuint first = prvt_read<GLuint>();
+        const GLsizei bindings_count = prvt_read<GLsizei>();
+        const GLuint* buffers = prvt_read_names('B', 0, count);
+        const GLintptr* offsets = prvt_read_array<GLintptr>(1, count);
+        const GLsizeiptr* sizes = prvt_read_array<GLsizeiptr>(2, count);
+        OBJECTGL_GL_REPLAY_CUSTOM(BindBuffersRange, target, first, bindings_count, buffers, offsets, sizes);
+        break;
+    }
+
+    case GLTrace::RECORD_BindSamplers: {
+        const GLuint first = prvt_read<GLuint>();
+        const GLsizei bindings_count = prvt_read<GLsizei>();
+        const GLuint* samplers = prvt_read_names('M', 0, count);
+        OBJECTGL_GL_REPLAY_CUSTOM(BindSamplers, first, bindings_count, samplers);
+        break;
+    }
+
+    case GLTrace::RECORD_BindTextures: {
+        const GLuint first = prvt_read<GLuint>();
+        const GLsizei bindings_count = prvt_read<GLsizei>();
+        const GLuint* textures = prvt_read_names('T', 0, count);
+        OBJECTGL_GL_REPLAY_CUSTOM(BindTextures, first, bindings_count, textures);
+        break;
+    }
+
+    case GLTrace::RECORD_BindVertexBuffers: {
+        const GLuint first = prvt_read<GLuint>();
+        const GLsizei bindings_count = prvt_read<GLsizei>();
+        const GLuint* buffers = prvt_read_names('B', 0, count);
+        const GLintptr* offsets = prvt_read_array<GLintptr>(1, count);
+        const GLsizei* strides = prvt_read_array<GLsizei>(2, count);
+        OBJECTGL_GL_REPLAY_CUSTOM(BindVertexBuffers, first, bindings_count, buffers, offsets, strides);
+        break;
+    }
+
+    case GLTrace::RECORD_VertexArrayVertexBuffers: {
+        const GLuint vertex_array = prvt_remap('A', prvt_read<GLuint>());
+        const GLuint first = prvt_read<GLuint>();
+        const GLsizei bindings_count = prvt_read<GLsizei>();
+        const GLuint* buffers = prvt_read_names('B', 0, count);
+        const GLintptr* offsets = prvt_read_array<GLintptr>(1, count);
+        const GLsizei* strides = prvt_read_array<GLsizei>(2, count);
+        OBJECTGL_GL_REPLAY_CUSTOM(VertexArrayVertexBuffers, vertex_array, first, bindings_count, buffers, offsets, strides);
+        break;
+    }
+
+    // buffers contents, with dynamic storage so that mapped writes can always be replayed
+    case GLTrace::RECORD_BufferStorage: {
+        const GLenum target = prvt_read<GLenum>();
+        const GLsizeiptr size = prvt_read<GLsizeiptr>();
+        const unsigned char* data = prvt_read_bytes(count);
+        const GLbitfield flags = prvt_read<GLbitfield>();
+        OBJECTGL_GL_REPLAY_CUSTOM(BufferStorage, target, size, data, flags | GL_DYNAMIC_STORAGE_BIT);
+        break;
+    }
+
+    case GLTrace::RECORD_NamedBufferStorage: {
+        const GLuint buffer = prvt_remap('B', prvt_read<GLuint>());
+        const GLsizeiptr size = prvt_read<GLsizeiptr>();
+        const unsigned char* data = prvt_read_bytes(count);
+        const GLbitfield flags = prvt_read<GLbitfield>();
+        OBJECTGL_GL_REPLAY_CUSTOM(NamedBufferStorage, buffer, size, data, flags | GL_DYNAMIC_STORAGE_BIT);
+        break;
+    }
+
+    case GLTrace::RECORD_BufferSubData: {
+        const GLenum target = prvt_read<GLenum>();
+        const GLintptr offset = prvt_read<GLintptr>();
+        const unsigned char* data = prvt_read_bytes(count);
+        OBJECTGL_GL_REPLAY_CUSTOM(BufferSubData, target, offset, GLsizeiptr(count), data);
+        break;
+    }
+
+    case GLTrace::RECORD_NamedBufferSubData: {
+        const GLuint buffer = prvt_remap('B', prvt_read<GLuint>());
+        const GLintptr offset = prvt_read<GLintptr>();
+        const unsigned char* data = prvt_read_bytes(count);
+        OBJECTGL_GL_REPLAY_CUSTOM(NamedBufferSubData, buffer, offset, GLsizeiptr(count), data);
+        break;
+    }
+
+    // mappings, by buffer names of the capture
+    case GLTrace::RECORD_MapBufferRange: {
+        const GLenum target = prvt_read<GLenum>();
+        const GLintptr offset = prvt_read<GLintptr>();
+        const GLsizeiptr length = prvt_read<GLsizeiptr>();
+        const GLbitfield access = prvt_read<GLbitfield>();
+        const GLuint captured = prvt_read<GLuint>();
+        if (prvt_corrupt)
+            break;
+        void* data = glMapBufferRange(target, offset, length, access);
+        if (data != NULL)
+            prvt_mappings[captured] = Mapping{ static_cast<unsigned char*>(data), offset, length };
+        break;
+    }
+
+    case GLTrace::RECORD_MapNamedBufferRange: {
+        const GLuint captured = prvt_read<GLuint>();
+        const GLintptr offset = prvt_read<GLintptr>();
+        const GLsizeiptr length = prvt_read<GLsizeiptr>();
+        const GLbitfield access = prvt_read<GLbitfield>();
+        if (prvt_corrupt || __glewMapNamedBufferRange == NULL)
+            break;
+        void* data = glMapNamedBufferRange(prvt_remap('B', captured), offset, length, access);
+        if (data != NULL)
+            prvt_mappings[captured] = Mapping{ static_cast<unsigned char*>(data), offset, length };
+        break;
+    }
+
+    case GLTrace::RECORD_FlushMappedBufferRange: {
+        const GLenum target = prvt_read<GLenum>();
+        const GLintptr offset = prvt_read<GLintptr>();
+        const GLsizeiptr length = prvt_read<GLsizeiptr>();
+        OBJECTGL_GL_REPLAY_CUSTOM(FlushMappedBufferRange, target, offset, length);
+        break;
+    }
+
+    case GLTrace::RECORD_FlushMappedNamedBufferRange: {
+        const GLuint buffer = prvt_remap('B', prvt_read<GLuint>());
+        const GLintptr offset = prvt_read<GLintptr>();
+        const GLsizeiptr length = prvt_read<GLsizeiptr>();
+        OBJECTGL_GL_REPLAY_CUSTOM(FlushMappedNamedBufferRange, buffer, offset, length);
+        break;
+    }
+
+    case GLTrace::RECORD_UnmapBuffer: {
+        const GLenum target = prvt_read<GLenum>();
+        const GLuint captured = prvt_read<GLuint>();
+        if (prvt_corrupt)
+            break;
+        if (prvt_mappings.erase(captured) != 0)
+            glUnmapBuffer(target);
+        break;
+    }
+
+    case GLTrace::RECORD_UnmapNamedBuffer: {
+        const GLuint captured = prvt_read<GLuint>();
+        if (prvt_corrupt)
+            break;
+        if (prvt_mappings.erase(captured) != 0)
+            glUnmapNamedBuffer(prvt_remap('B', captured));
+        break;
+    }
+
+    case GLTrace::RECORD_MAPPED_WRITE:
+        prvt_replay_mapped_write();
+        break;
+
+    // shaders and programs
+    case GLTrace::RECORD_ShaderSource: {
+        const GLuint shader = prvt_remap('S', prvt_read<GLuint>());
+        const GLsizei strings_count = prvt_read<GLsizei>();
+        vector<const GLchar*> strings;
+        vector<GLint> lengths;
+        for (GLsizei i = 0; i < strings_count && !prvt_corrupt; ++i) {
+            strings.push_back(reinterpret_cast<const GLchar*>(prvt_read_bytes(count)));
+            lengths.push_back(GLint(count));
+        }
+        if (!prvt_corrupt)
+            glShaderSource(shader, GLsizei(strings.size()), strings.data(), lengths.data());
+        break;
+    }
+
+    case GLTrace::RECORD_ShaderBinary: {
+        const GLuint* shaders = prvt_read_names('S', 0, count);
+        const GLsizei shaders_count = GLsizei(count);
+        const GLenum format = prvt_read<GLenum>();
+        const unsigned char* binary = prvt_read_bytes(count);
+        OBJECTGL_GL_REPLAY_CUSTOM(ShaderBinary, shaders_count, shaders, format, binary, GLsizei(count));
+        break;
+    }
+
+    case GLTrace::RECORD_SpecializeShader:
+    case GLTrace::RECORD_SpecializeShaderARB: {
+        const GLuint shader = prvt_remap('S', prvt_read<GLuint>());
+        const unsigned char* chars = prvt_read_bytes(count);
+        const string entry_point = chars != NULL ? string(reinterpret_cast<const char*>(chars), count) : string("main");
+        const GLuint* indices = prvt_read_array<GLuint>(0, count);
+        const GLuint* values = prvt_read_array<GLuint>(1, count);
+        if (record == GLTrace::RECORD_SpecializeShader)
+            OBJECTGL_GL_REPLAY_CUSTOM(SpecializeShader, shader, entry_point.c_str(), count, indices, values);
+        else
+            OBJECTGL_GL_REPLAY_CUSTOM(SpecializeShaderARB, shader, entry_point.c_str(), count, indices, values);
+        break;
+    }
+
+    case GLTrace::RECORD_ProgramBinary: {
+        const GLuint program = prvt_remap('P', prvt_read<GLuint>());
+        const GLenum format = prvt_read<GLenum>();
+        const unsigned char* binary = prvt_read_bytes(count);
+        OBJECTGL_GL_REPLAY_CUSTOM(ProgramBinary, program, format, binary, GLsizei(count));
+        break;
+    }
+
+    case GLTrace::RECORD_UniformSubroutinesuiv: {
+        const GLenum shader_type = prvt_read<GLenum>();
+        const GLuint* indices = prvt_read_array<GLuint>(0, count);
+        OBJECTGL_GL_REPLAY_CUSTOM(UniformSubroutinesuiv, shader_type, GLsizei(count), indices);
+        break;
+    }
+
+    default:
+        prvt_corrupt = true;
+        break;
+    }
+}
+
+
+void GLTraceReplayer::prvt_create_names(const char kind, void (GLAPIENTRY* function)(GLsizei, GLuint*))
+{
+    uint32_t count = 0;
+    const GLuint* captured = prvt_read_array<GLuint>(0, count);
+    if (prvt_corrupt)
+        return;
+    if (function == NULL) {
+        ++prvt_skipped_calls;
+        return;
+    }
+
+    GLuint* created = get_names_storage(prvt_scratches[1], count);
+    function(GLsizei(count), created);
+    unordered_map<GLuint, GLuint>& names = prvt_names[get_names_kind(kind)];
+    for (uint32_t i = 0; i < count; ++i)
+        names[captured[i]] = created[i];
+}
+
+
+void GLTraceReplayer::prvt_delete_names(const char kind, void (GLAPIENTRY* function)(GLsizei, const GLuint*))
+{
+    uint32_t count = 0;
+    const GLuint* captured = prvt_read_array<GLuint>(0, count);
+    if (prvt_corrupt)
+        return;
+    if (function == NULL) {
+        ++prvt_skipped_calls;
+        return;
+    }
+
+    // names unknown to the replay map to 0, which is silently ignored
+    GLuint* deleted = get_names_storage(prvt_scratches[1], count);
+    unordered_map<GLuint, GLuint>& names = prvt_names[get_names_kind(kind)];
+    for (uint32_t i = 0; i < count; ++i) {
+        deleted[i] = prvt_remap(kind, captured[i]);
+        names.erase(captured[i]);
+    }
+    function(GLsizei(count), deleted);
+}
+
+
+void GLTraceReplayer::prvt_delete_name(const char kind, void (GLAPIENTRY* function)(GLuint))
+{
+    const GLuint captured = prvt_read<GLuint>();
+    if (prvt_corrupt)
+        return;
+    if (function == NULL) {
+        ++prvt_skipped_calls;
+        return;
+    }
+
+    function(prvt_remap(kind, captured));
+    prvt_names[get_names_kind(kind)].erase(captured);
+}
+
+
+void GLTraceReplayer::prvt_replay_mapped_write()
+{
+    const GLuint captured = prvt_read<GLuint>();
+    const int64_t offset = prvt_read<int64_t>();
+    uint32_t count = 0;
+    const unsigned char* data = prvt_read_bytes(count);
+    if (prvt_corrupt || count == 0)
+        return;
+
+    // writes into memory mapped by the replay too, else uploads
+    const auto found = prvt_mappings.find(captured);
+    if (found != prvt_mappings.end()) {
+        const Mapping& mapping = found->second;
+        if (offset >= mapping.offset && offset + int64_t(count) <= mapping.offset + mapping.length) {
+            memcpy(mapping.data + (offset - mapping.offset), data, count);
+            return;
+        }
+    }
+    OBJECTGL_GL_REPLAY_CUSTOM(NamedBufferSubData, prvt_remap('B', captured), GLintptr(offset), GLsizeiptr(count), data);
+}
+
+
+GLuint GLTraceReplayer::prvt_remap(const char kind, const GLuint name) const
+{
+    const size_t names_kind = get_names_kind(kind);
+    if (name == 0 || names_kind >= NAMES_KINDS_COUNT)
+        return name;
+
+    const unordered_map<GLuint, GLuint>& names = prvt_names[names_kind];
+    const auto found = names.find(name);
+    return found != names.end() ? found->second : 0;
+}
@@ -0,0 +1,145 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include "utils/mapped_file.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+static const char EMPTY_CONTENT[1] = { '\0' };  // the content of empty mapped files.
+
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const char* filepath)
+    : prvt_data(nullptr), prvt_size(0), prvt_file_handle(INVALID_HANDLE_VALUE), prvt_mapping_handle(NULL)
+{
+    prvt_file_handle = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (prvt_file_handle == INVALID_HANDLE_VALUE)
+        return;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(prvt_file_handle, &file_size))
+        return;
+
+    if (file_size.QuadPart == 0) {
+        prvt_data = EMPTY_CONTENT;
+        return;
+    }
+
+    prvt_mapping_handle = CreateFileMappingA(prvt_file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (prvt_mapping_handle == NULL)
+        return;
+
+    prvt_data = static_cast<const char*>(MapViewOfFile(prvt_mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if (prvt_data != nullptr)
+        prvt_size = size_t(file_size.QuadPart);
+}
+
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : prvt_data(other.prvt_data), prvt_size(other.prvt_size),
+      prvt_file_handle(other.prvt_file_handle), prvt_mapping_handle(other.prvt_mapping_handle)
+{
+    other.prvt_data = nullptr;
+    other.prvt_size = 0;
+    other.prvt_file_handle = INVALID_HANDLE_VALUE;
+    other.prvt_mapping_handle = NULL;
+}
+
+
+void MappedFile::prvt_unmap()
+{
+    if (prvt_data != nullptr && prvt_data != EMPTY_CONTENT)
+        UnmapViewOfFile(prvt_data);
+    if (prvt_mapping_handle != NULL)
+        CloseHandle(prvt_mapping_handle);
+    if (prvt_file_handle != INVALID_HANDLE_VALUE)
+        CloseHandle(prvt_file_handle);
+}
+
+#else
+
+MappedFile::MappedFile(const char* filepath)
+    : prvt_data(nullptr), prvt_size(0), prvt_fd(-1)
+{
+    prvt_fd = open(filepath, O_RDONLY | O_CLOEXEC);
+    if (prvt_fd < 0)
+        return;
+
+    struct stat file_stat;
+    if (fstat(prvt_fd, &file_stat) != 0)
+        return;
+
+    if (file_stat.st_size == 0) {
+        prvt_data = EMPTY_CONTENT;
+        return;
+    }
+
+    void* mapped = mmap(NULL, size_t(file_stat.st_size), PROT_READ, MAP_PRIVATE, prvt_fd, 0);
+    if (mapped == MAP_FAILED)
+        return;
+
+    // the whole content will be read sequentially by the driver
+    madvise(mapped, size_t(file_stat.st_size), MADV_SEQUENTIAL);
+    prvt_data = static_cast<const char*>(mapped);
+    prvt_size = size_t(file_stat.st_size);
+}
+
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : prvt_data(other.prvt_data), prvt_size(other.prvt_size), prvt_fd(other.prvt_fd)
+{
+    other.prvt_data = nullptr;
+    other.prvt_size = 0;
+    other.prvt_fd = -1;
+}
+
+
+void MappedFile::prvt_unmap()
+{
+    if (prvt_data != nullptr && prvt_data != EMPTY_CONTENT)
+        munmap(const_cast<char*>(prvt_data), prvt_size);
+    if (prvt_fd >= 0)
+        close(prvt_fd);
+}
+
+#endif
+
+
+MappedFile::~MappedFile()
+{
+    prvt_unmap();
+}
@@ -0,0 +1,200 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include "vertex_arrays/vertex_array.h"
+
+using namespace std;
+
+
+VertexArray::VertexArray()
+    : Object()
+{
+    if (Buffer::is_dsa_supported())
+        glCreateVertexArrays(1, &name);
+    else {
+        glGenVertexArrays(1, &name);
+        GLStateCache::get_current().bind_vertex_array(name);
+        GLStateCache::get_current().bind_vertex_array(0);
+    }
+}
+
+
+VertexArray::VertexArray(VertexArray&& other)
+    : Object(other.name),
+      prvt_strides(std::move(other.prvt_strides))
+{
+    other.name = 0;
+}
+
+
+VertexArray::~VertexArray()
+{
+    prvt_release();
+}
+
+
+VertexArray& VertexArray::operator= (VertexArray&& other)
+{
+    if (this != &other) {
+        prvt_release();
+        name = other.name;
+        prvt_strides = std::move(other.prvt_strides);
+        other.name = 0;
+    }
+    return *this;
+}
+
+
+void VertexArray::set_binding_divisor(const GLuint binding, const GLuint divisor)
+{
+    if (Buffer::is_dsa_supported())
+        glVertexArrayBindingDivisor(name, binding, divisor);
+    else {
+        GLStateCache::get_current().bind_vertex_array(name);
+        glVertexBindingDivisor(binding, divisor);
+        GLStateCache::get_current().bind_vertex_array(0);
+    }
+}
+
+
+void VertexArray::set_index_buffer(const IndexBuffer& buffer)
+{
+    if (Buffer::is_dsa_supported())
+        glVertexArrayElementBuffer(name, buffer.name);
+    else {
+        GLStateCache::get_current().bind_vertex_array(name);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer.name);
+        GLStateCache::get_current().bind_vertex_array(0);
+    }
+}
+
+
+bool VertexArray::set_layout(const VertexAttribute* attributes, const size_t count, const ShadersProgram& program)
+{
+    const ProgramReflection& reflection = program.get_reflection();
+    const bool dsa = Buffer::is_dsa_supported();
+    if (!dsa)
+        GLStateCache::get_current().bind_vertex_array(name);
+
+    size_t fed_inputs_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const VertexAttribute& attribute = attributes[i];
+        const GLint location = reflection.get_input_location(attribute.name);
+        if (location < 0)
+            continue;  // not active in this program
+        ++fed_inputs_count;
+
+        if (attribute.binding >= prvt_strides.size())
+            prvt_strides.resize(attribute.binding + 1, 0);
+        prvt_strides[attribute.binding] = attribute.stride;
+
+        if (dsa) {
+            glEnableVertexArrayAttrib(name, location);
+            switch (attribute.kind) {
+            case VertexAttribute::INTEGER:
+                glVertexArrayAttribIFormat(name, location, attribute.components, attribute.type, attribute.relative_offset);
+                break;
+            case VertexAttribute::DOUBLE:
+                glVertexArrayAttribLFormat(name, location, attribute.components, attribute.type, attribute.relative_offset);
+                break;
+            default:
+                glVertexArrayAttribFormat(name, location, attribute.components, attribute.type, attribute.normalized, attribute.relative_offset);
+                break;
+            }
+            glVertexArrayAttribBinding(name, location, attribute.binding);
+        }
+        else {
+            glEnableVertexAttribArray(location);
+            switch (attribute.kind) {
+            case VertexAttribute::INTEGER:
+                glVertexAttribIFormat(location, attribute.components, attribute.type, attribute.relative_offset);
+                break;
+            case VertexAttribute::DOUBLE:
+                glVertexAttribLFormat(location, attribute.components, attribute.type, attribute.relative_offset);
+                break;
+            default:
+                glVertexAttribFormat(location, attribute.components, attribute.type, attribute.normalized, attribute.relative_offset);
+                break;
+            }
+            glVertexAttribBinding(location, attribute.binding);
+        }
+    }
+
+    if (!dsa)
+        GLStateCache::get_current().bind_vertex_array(0);
+
+    // built-in inputs (e.g. gl_VertexID) are reported with location -1
+    size_t inputs_count = 0;
+    for (const ProgramReflection::Resource& input : reflection.get_resources(ProgramReflection::INPUTS))
+        if (input.location >= 0)
+            ++inputs_count;
+
+    if (fed_inputs_count < inputs_count) {
+        cerr << "!!! vertex layout feeds " << fed_inputs_count << " of the " << inputs_count << " inputs of program " << program.name << endl;
+        return false;
+    }
+    return true;
+}
+
+
+void VertexArray::set_vertex_buffer(const GLuint binding, const Buffer& buffer, const GLintptr offset)
+{
+    if (Buffer::is_dsa_supported())
+        glVertexArrayVertexBuffer(name, binding, buffer.name, offset, get_stride(binding));
+    else {
+        GLStateCache::get_current().bind_vertex_array(name);
+        glBindVertexBuffer(binding, buffer.name, offset, get_stride(binding));
+        GLStateCache::get_current().bind_vertex_array(0);
+    }
+}
+
+
+void VertexArray::set_vertex_buffers(const GLuint first_binding, const GLsizei count, const GLuint* buffers, const GLintptr* offsets)
+{
+    vector<GLsizei> strides(count);
+    for (GLsizei i = 0; i < count; ++i)
+        strides[i] = get_stride(first_binding + i);
+
+    if (Buffer::is_dsa_supported())
+        glVertexArrayVertexBuffers(name, first_binding, count, buffers, offsets, strides.data());
+    else {
+        GLStateCache::get_current().bind_vertex_array(name);
+        glBindVertexBuffers(first_binding, count, buffers, offsets, strides.data());
+        GLStateCache::get_current().bind_vertex_array(0);
+    }
+}
+
+
+void VertexArray::prvt_release()
+{
+    if (is_ok()) {
+        GLStateCache::get_current().on_vertex_array_deleted(name);
+        glDeleteVertexArrays(1, &name);
+        name = 0;
+    }
+}
@@ -0,0 +1,164 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "GL/glew.h"
+
+#include "commands/command_buffer.h"
+#include "commands/command_thread.h"
+#include "context/gl_backend.h"
+#include "context/memory_barriers.h"
+#include "objectgl_tests.h"
+#include "shaders/fragment_shader.h"
+#include "shaders/shaders_program.h"
+#include "shaders/uniforms_shadow.h"
+#include "shaders/vertex_shader.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+bool test_command_buffer()
+{
+    bool ok = true;
+    GLBackend::set_mock_uniforms(GL_FLOAT_VEC4, 1, 4);
+
+    VertexShader vertex_shader;
+    vertex_shader.set_source_code("#version 450 core\nvoid main() { gl_Position = vec4(0.0); }\n");
+    FragmentShader fragment_shader;
+    fragment_shader.set_source_code("#version 450 core\nuniform vec4 value0[4];\nout vec4 color;\nvoid main() { color = value0[0]; }\n");
+    ShadersList shaders{ &vertex_shader, &fragment_shader };
+    ShadersProgram program(shaders);
+
+    UniformsShadow& shadow = program.get_uniforms_shadow();
+    const GLint slot = shadow.find(program.get_reflection(), "value0");
+    OBJECTGL_CHECK(slot >= 0);
+    if (slot < 0)
+        return false;
+
+    GLfloat values[4][4] = {};
+    values[3][0] = 1.0f;
+
+    CommandBuffer commands;
+    commands.set_uniform(program, slot, 0, 4, values, sizeof(values));
+    OBJECTGL_CHECK(commands.get_commands_count() == 1);
+    const size_t size = commands.get_size();
+
+    // sizes which do not match the reflected type, and unknown slots, get rejected
+    commands.set_uniform(program, slot, 0, 4, values, sizeof(values) - 4);
+    commands.set_uniform(program, slot, 0, 1, values, sizeof(values));
+    commands.set_uniform(program, slot, 1.0f);
+    commands.set_uniform(program, slot + 1, 0, 1, values, sizeof(values[0]));
+    commands.set_uniform(program, -1, 0, 1, values, sizeof(values[0]));
+    OBJECTGL_CHECK(commands.get_commands_count() == 1);
+    OBJECTGL_CHECK(commands.get_size() == size);
+
+    // barriers required at replay time get issued before the draws
+    MemoryBarriers barriers;
+    MemoryBarriers::set_current(&barriers);
+    barriers.on_buffer_written(5);
+    commands.call([](void* user_data) {
+        static_cast<MemoryBarriers*>(user_data)->require_buffer(5, GL_COMMAND_BARRIER_BIT);
+    }, &barriers);
+    commands.draw_arrays(GL_TRIANGLES, 0, 3, 1, 0);
+
+    commands.execute();
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glMemoryBarrier") == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glDrawArraysInstancedBaseInstance") == 1);
+    MemoryBarriers::set_current(NULL);
+    OBJECTGL_CHECK(shadow.get_stats().modified == 4);
+    program.flush_uniforms();
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glProgramUniform4fv") == 1);
+    return ok;
+}
+
+
+//---------------------------------------------------------------------------
+static void count_replayed_call(void* user_data)
+{
+    ++*static_cast<atomic<size_t>*>(user_data);
+}
+
+
+bool test_command_thread()
+{
+    bool ok = true;
+    const size_t PRODUCERS_COUNT = 4;
+    const size_t BUFFERS_COUNT = 100;
+    const size_t CALLS_COUNT = 3;
+
+    atomic<size_t> calls(0);
+    vector<shared_ptr<CommandArena>> arenas(2 * PRODUCERS_COUNT);
+    auto produce = [&](CommandThread& command_thread, const size_t index) {
+        // keeps the arena alive after the producer exited, so that it tells whether command buffers still use it
+        arenas[index] = CommandArena::get_local();
+        for (size_t i = 0; i < BUFFERS_COUNT; ++i) {
+            CommandBuffer* commands = new CommandBuffer();
+            for (size_t c = 0; c < CALLS_COUNT; ++c)
+                commands->call(&count_replayed_call, &calls);
+            command_thread.submit(commands);
+        }
+    };
+
+    CommandThread command_thread;
+    OBJECTGL_CHECK(command_thread.start());
+
+    // several producers record and submit concurrently
+    vector<thread> producers;
+    for (size_t p = 0; p < PRODUCERS_COUNT; ++p)
+        producers.emplace_back(produce, ref(command_thread), p);
+    for (thread& producer : producers)
+        producer.join();
+    producers.clear();
+
+    command_thread.wait_idle();
+    CommandThread::Stats stats = command_thread.get_stats();
+    OBJECTGL_CHECK(stats.submitted == PRODUCERS_COUNT * BUFFERS_COUNT);
+    OBJECTGL_CHECK(stats.replayed == stats.submitted);
+    OBJECTGL_CHECK(stats.commands == PRODUCERS_COUNT * BUFFERS_COUNT * CALLS_COUNT);
+    OBJECTGL_CHECK(calls.load() == stats.commands);
+
+    // the command thread gets stopped while producers are submitting
+    for (size_t p = PRODUCERS_COUNT; p < 2 * PRODUCERS_COUNT; ++p)
+        producers.emplace_back(produce, ref(command_thread), p);
+    command_thread.stop();
+    for (thread& producer : producers)
+        producer.join();
+
+    stats = command_thread.get_stats();
+    OBJECTGL_CHECK(!command_thread.is_running());
+    OBJECTGL_CHECK(stats.replayed <= stats.submitted);
+    OBJECTGL_CHECK(stats.commands == stats.replayed * CALLS_COUNT);
+    OBJECTGL_CHECK(calls.load() == stats.commands);
+
+    // all command buffers, replayed or not, have been freed and have given back their chunks
+    for (const shared_ptr<CommandArena>& arena : arenas)
+        OBJECTGL_CHECK(arena.use_count() == 1);
+    return ok;
+}
@@ -0,0 +1,185 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include "GL/glew.h"
+
+#include "context/gl_backend.h"
+#include "context/gl_state.h"
+#include "objectgl_tests.h"
+#include "pipeline/pipeline_state.h"
+#include "shaders/compute_program.h"
+#include "shaders/compute_shader.h"
+#include "shaders/fragment_shader.h"
+#include "shaders/shaders_program.h"
+#include "shaders/vertex_shader.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+bool test_gl_state_cache()
+{
+    bool ok = true;
+    GLStateCache cache;
+
+    // unknown states are set, known ones are elided
+    OBJECTGL_CHECK(cache.enable(GL_DEPTH_TEST));
+    OBJECTGL_CHECK(!cache.enable(GL_DEPTH_TEST));
+    OBJECTGL_CHECK(cache.disable(GL_DEPTH_TEST));
+    OBJECTGL_CHECK(cache.use_program(5));
+    OBJECTGL_CHECK(!cache.use_program(5));
+    OBJECTGL_CHECK(cache.use_program(6));
+    OBJECTGL_CHECK(cache.viewport(0, 0, 640, 480));
+    OBJECTGL_CHECK(!cache.viewport(0, 0, 640, 480));
+    OBJECTGL_CHECK(cache.bind_texture(0, 7));
+    OBJECTGL_CHECK(!cache.bind_texture(0, 7));
+    OBJECTGL_CHECK(cache.bind_texture(1, 7));
+
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glEnable") == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glDisable") == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glUseProgram") == 2);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glViewport") == 1);
+    OBJECTGL_CHECK(cache.get_frame_stats().issued == 7);
+    OBJECTGL_CHECK(cache.get_frame_stats().elided == 4);
+
+    // ranges of textures bindings are elided element-wise
+    const GLuint textures[3] = { 7, 7, 8 };
+    OBJECTGL_CHECK(cache.bind_textures(0, 3, textures));
+    OBJECTGL_CHECK(!cache.bind_textures(0, 3, textures));
+
+    // deleted objects and invalidation make states unknown again
+    cache.on_texture_deleted(7);
+    OBJECTGL_CHECK(cache.bind_texture(0, 7));
+    cache.invalidate();
+    OBJECTGL_CHECK(cache.enable(GL_DEPTH_TEST));
+    OBJECTGL_CHECK(cache.use_program(6));
+
+    // frames statistics
+    cache.end_frame();
+    OBJECTGL_CHECK(cache.get_frame_stats().issued == 0 && cache.get_frame_stats().elided == 0);
+    OBJECTGL_CHECK(cache.get_last_frame_stats().issued == cache.get_total_stats().issued);
+    return ok;
+}
+
+
+//---------------------------------------------------------------------------
+bool test_pipeline_state_cache()
+{
+    bool ok = true;
+    GLStateCache cache;
+    GLStateCache::set_current(&cache);
+    PipelineStateCache pipelines;
+
+    PipelineDesc opaque_desc;
+    opaque_desc.depth_stencil.depth_test = true;
+    opaque_desc.viewport.viewport[2] = 640;
+    opaque_desc.viewport.viewport[3] = 480;
+
+    PipelineDesc blended_desc = opaque_desc;
+    blended_desc.blend.enabled = true;
+    blended_desc.blend.src_rgb = blended_desc.blend.src_alpha = GL_SRC_ALPHA;
+    blended_desc.blend.dst_rgb = blended_desc.blend.dst_alpha = GL_ONE_MINUS_SRC_ALPHA;
+
+    // equal descriptions share the same pipeline state
+    const PipelineState* opaque = pipelines.acquire(opaque_desc);
+    const PipelineState* blended = pipelines.acquire(blended_desc);
+    OBJECTGL_CHECK(pipelines.acquire(opaque_desc) == opaque);
+    OBJECTGL_CHECK(opaque != blended);
+    OBJECTGL_CHECK(pipelines.size() == 2);
+    OBJECTGL_CHECK(opaque->get_id() == 0 && blended->get_id() == 1);
+
+    // the whole state is applied first, then transitions apply differences only
+    pipelines.apply(opaque);
+    const uint64_t first_calls = GLBackend::get_calls_count();
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glDepthFunc") == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glViewport") == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glBlendFuncSeparate") == 0);
+
+    pipelines.apply(opaque);
+    OBJECTGL_CHECK(GLBackend::get_calls_count() == first_calls);
+
+    pipelines.apply(blended);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glBlendFuncSeparate") == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glDepthFunc") == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glViewport") == 1);
+    OBJECTGL_CHECK(pipelines.get_last_applied() == blended);
+
+    // back to the opaque state, blending gets disabled while its functions are kept
+    const uint64_t disables = GLBackend::get_calls_count("glDisable");
+    pipelines.apply(opaque);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glDisable") == disables + 1);
+    pipelines.apply(blended);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glBlendFuncSeparate") == 1);
+
+    pipelines.clear();
+    OBJECTGL_CHECK(pipelines.size() == 0 && pipelines.get_last_applied() == NULL);
+
+    GLStateCache::set_current(NULL);
+    return ok;
+}
+
+
+//---------------------------------------------------------------------------
+bool test_pipeline_state_dispatch()
+{
+    bool ok = true;
+    GLStateCache cache;
+    GLStateCache::set_current(&cache);
+    PipelineStateCache pipelines;
+
+    VertexShader vertex_shader;
+    vertex_shader.set_source_code("#version 450 core\nvoid main() { gl_Position = vec4(0.0); }\n");
+    FragmentShader fragment_shader;
+    fragment_shader.set_source_code("#version 450 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n");
+    ShadersList shaders{ &vertex_shader, &fragment_shader };
+    ShadersProgram program(shaders);
+
+    ComputeShader compute_shader;
+    compute_shader.set_source_code("#version 450 core\nlayout(local_size_x = 64) in;\nvoid main() {}\n");
+    ComputeProgram compute(compute_shader);
+    OBJECTGL_CHECK(program.linked && compute.linked);
+
+    PipelineDesc desc;
+    desc.program = &program;
+    const PipelineState* state = pipelines.acquire(desc);
+
+    // the program used by a dispatch in between gets replaced by the one of the pipeline state
+    pipelines.apply(state);
+    const uint64_t uses = GLBackend::get_calls_count("glUseProgram");
+    compute.dispatch(1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glDispatchCompute") == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glUseProgram") == uses + 1);
+    pipelines.apply(state);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glUseProgram") == uses + 2);
+    OBJECTGL_CHECK(!cache.use_program(program.name));
+
+    // with no dispatch in between, nothing gets issued
+    const uint64_t calls = GLBackend::get_calls_count();
+    pipelines.apply(state);
+    OBJECTGL_CHECK(GLBackend::get_calls_count() == calls);
+
+    GLStateCache::set_current(NULL);
+    return ok;
+}
@@ -0,0 +1,105 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+/* objectgl_tests: runs the behavior tests of ObjectGL against the MOCK
+* backend of GLBackend.
+*
+* Usage:
+*   objectgl_tests [<test name> ...]
+*     Runs the named tests, or all of them when none is named.  The
+*     exit code is 0 when all the run tests passed.
+*/
+
+
+//===========================================================================
+#include <cstdio>
+#include <cstring>
+
+#include "GL/glew.h"
+
+#include "context/gl_backend.h"
+#include "objectgl_tests.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+struct TestEntry {
+    const char* name;
+    bool (*run)();
+};
+
+static const TestEntry  tests[] = {
+    { "command_buffer",         &test_command_buffer },
+    { "command_thread",         &test_command_thread },
+    { "gl_state_cache",         &test_gl_state_cache },
+    { "pipeline_state_cache",   &test_pipeline_state_cache },
+    { "pipeline_state_dispatch", &test_pipeline_state_dispatch },
+    { "program_binary_cache",   &test_program_binary_cache },
+    { "render_queue",           &test_render_queue },
+    { "uniforms_shadow",        &test_uniforms_shadow }
+};
+static const size_t     TESTS_COUNT = sizeof(tests) / sizeof(tests[0]);
+
+
+//---------------------------------------------------------------------------
+// Runs one test with fresh mock settings and counters.
+static bool run(const TestEntry& test)
+{
+    GLBackend::set_mock_subroutines(GL_NONE, 0, 0);
+    GLBackend::set_mock_uniforms(GL_NONE, 0);
+    GLBackend::reset_counts();
+
+    const bool ok = test.run();
+    printf("%-30s %s\n", test.name, ok ? "passed" : "FAILED");
+    return ok;
+}
+
+
+//===========================================================================
+int main(int argc, char* argv[])
+{
+    GLBackend::set(GLBackend::MOCK);
+
+    bool ok = true;
+    if (argc == 1)
+        for (const TestEntry& test : tests)
+            ok = run(test) && ok;
+    else
+        for (int i = 1; i < argc; ++i) {
+            size_t t = 0;
+            while (t < TESTS_COUNT && strcmp(tests[t].name, argv[i]) != 0)
+                ++t;
+            if (t == TESTS_COUNT) {
+                fprintf(stderr, "!!! unknown test '%s'\n", argv[i]);
+                ok = false;
+            }
+            else
+                ok = run(tests[t]) && ok;
+        }
+
+    GLBackend::set(GLBackend::REAL);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#pragma once
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstdio>
+
+using namespace std;
+
+
+//===========================================================================
+/* objectgl_tests: the behavior tests of ObjectGL, run against the MOCK
+* backend of GLBackend, so that no OpenGL context is needed.
+*
+* Each test is a function which returns true when all its checks
+* passed.  Failed checks are reported on error console with their
+* location.
+*/
+
+
+//---------------------------------------------------------------------------
+/** \brief Checks a condition within a test function, reporting it on failure.
+*
+* The test keeps running after a failed check, so that all failures
+* get reported at once.
+*/
+#define OBJECTGL_CHECK(condition)                                           \
+    objectgl_check((condition), #condition, __FILE__, __LINE__, ok)
+
+
+inline void objectgl_check(const bool passed, const char* condition, const char* file, const int line, bool& ok)
+{
+    if (!passed) {
+        fprintf(stderr, "!!! %s:%d: check failed: %s\n", file, line, condition);
+        ok = false;
+    }
+}
+
+
+//---------------------------------------------------------------------------
+// the tests, which return true when all their checks passed.
+bool test_command_buffer();
+bool test_command_thread();
+bool test_gl_state_cache();
+bool test_pipeline_state_cache();
+bool test_pipeline_state_dispatch();
+bool test_program_binary_cache();
+bool test_render_queue();
+bool test_uniforms_shadow();
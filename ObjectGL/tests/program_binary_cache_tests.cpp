@@ -0,0 +1,118 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#include "GL/glew.h"
+
+#include "context/gl_backend.h"
+#include "objectgl_tests.h"
+#include "shaders/fragment_shader.h"
+#include "shaders/program_binary_cache.h"
+#include "shaders/shaders_program.h"
+#include "shaders/vertex_shader.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+bool test_program_binary_cache()
+{
+    bool ok = true;
+    const filesystem::path directory = filesystem::temp_directory_path() / "objectgl_tests_program_binaries";
+    error_code err;
+    filesystem::remove_all(directory, err);
+
+    ProgramBinaryCache cache(directory.string());
+    OBJECTGL_CHECK(cache.is_supported());
+
+    VertexShader vertex_shader;
+    vertex_shader.set_source_code("#version 450 core\nvoid main() { gl_Position = vec4(0.0); }\n");
+    FragmentShader fragment_shader;
+    fragment_shader.set_source_code("#version 450 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n");
+    ShadersList shaders{ &vertex_shader, &fragment_shader };
+
+    // first linking misses, then stores the binary
+    {
+        ShadersProgram program(shaders, cache);
+        OBJECTGL_CHECK(program.linked);
+    }
+    OBJECTGL_CHECK(cache.get_stats().misses == 1 && cache.get_stats().hits == 0);
+    OBJECTGL_CHECK(cache.get_stats().stores == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glLinkProgram") == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glGetProgramBinary") == 1);
+
+    // same shaders: the binary is loaded, with no compilation nor linking
+    {
+        ShadersProgram program(shaders, cache);
+        OBJECTGL_CHECK(program.linked);
+    }
+    OBJECTGL_CHECK(cache.get_stats().hits == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glProgramBinary") == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glLinkProgram") == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glCompileShader") == 2);
+
+    // modified sources change the key
+    fragment_shader.set_source_code("#version 450 core\nout vec4 color;\nvoid main() { color = vec4(0.5); }\n");
+    {
+        ShadersProgram program(shaders, cache);
+    }
+    OBJECTGL_CHECK(cache.get_stats().misses == 2 && cache.get_stats().stores == 2);
+
+    // cleared cache misses again
+    cache.clear();
+    {
+        ShadersProgram program(shaders, cache);
+    }
+    OBJECTGL_CHECK(cache.get_stats().misses == 3 && cache.get_stats().hits == 1);
+    OBJECTGL_CHECK(cache.get_stats().invalidations == 0);
+
+    // binary lengths which do not match the file size invalidate the entry, which then gets linked and stored again
+    const int64_t length_errors[] = { 0xfffffff0, -1 };
+    for (const int64_t length_error : length_errors) {
+        for (const filesystem::directory_entry& entry : filesystem::directory_iterator(directory, err)) {
+            fstream file(entry.path(), ios::binary | ios::in | ios::out);
+            uint32_t length = 0;
+            file.seekg(20);  // the offset of the binary length in the file header
+            file.read(reinterpret_cast<char*>(&length), sizeof(length));
+            length = uint32_t(length + length_error);
+            file.seekp(20);
+            file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        }
+        {
+            ShadersProgram program(shaders, cache);
+            OBJECTGL_CHECK(program.linked);
+        }
+    }
+    OBJECTGL_CHECK(cache.get_stats().invalidations == 2);
+    OBJECTGL_CHECK(cache.get_stats().hits == 1 && cache.get_stats().stores == 5);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glProgramBinary") == 1);
+
+    filesystem::remove_all(directory, err);
+    return ok;
+}
@@ -0,0 +1,105 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstdint>
+
+#include "GL/glew.h"
+
+#include "context/gl_backend.h"
+#include "context/gl_state.h"
+#include "context/memory_barriers.h"
+#include "objectgl_tests.h"
+#include "pipeline/pipeline_state.h"
+#include "render/render_queue.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+bool test_render_queue()
+{
+    bool ok = true;
+
+    // layers first, then opaque draws front to back, then translucent ones back to front
+    OBJECTGL_CHECK(RenderQueue::make_key(0, true, 9, 9, 9, 1.0f) < RenderQueue::make_key(1, false, 0, 0, 0, 0.0f));
+    OBJECTGL_CHECK(RenderQueue::make_key(0, false, 9, 9, 9, 100.0f) < RenderQueue::make_key(0, true, 0, 0, 0, 1.0f));
+    OBJECTGL_CHECK(RenderQueue::make_key(0, false, 3, 3, 3, 1.0f) < RenderQueue::make_key(0, false, 3, 3, 3, 2.0f));
+    OBJECTGL_CHECK(RenderQueue::make_key(0, true, 3, 3, 3, 2.0f) < RenderQueue::make_key(0, true, 3, 3, 3, 1.0f));
+
+    // opaque draws are grouped by program, then by pipeline state, then by material, before depth
+    OBJECTGL_CHECK(RenderQueue::make_key(0, false, 0, 9, 9, 100.0f) < RenderQueue::make_key(0, false, 1, 0, 0, 1.0f));
+    OBJECTGL_CHECK(RenderQueue::make_key(0, false, 1, 0, 9, 100.0f) < RenderQueue::make_key(0, false, 1, 1, 0, 1.0f));
+    OBJECTGL_CHECK(RenderQueue::make_key(0, false, 1, 1, 0, 100.0f) < RenderQueue::make_key(0, false, 1, 1, 1, 1.0f));
+    OBJECTGL_CHECK(RenderQueue::make_key(0, false, 1, 1, 1, -1.0f) == RenderQueue::make_key(0, false, 1, 1, 1, 0.0f));
+
+    // translucent draws with the same depth are grouped the same way
+    OBJECTGL_CHECK(RenderQueue::make_key(0, true, 0, 9, 9, 5.0f) < RenderQueue::make_key(0, true, 1, 0, 0, 5.0f));
+
+    // interleaved pushes are submitted grouped by pipeline state
+    GLStateCache cache;
+    GLStateCache::set_current(&cache);
+    PipelineStateCache pipelines;
+    PipelineDesc desc;
+    const PipelineState* first_state = pipelines.acquire(desc);
+    desc.depth_stencil.depth_test = true;
+    const PipelineState* second_state = pipelines.acquire(desc);
+
+    RenderQueue queue;
+    for (int i = 0; i < 8; ++i) {
+        const PipelineState* state = (i & 1) ? second_state : first_state;
+        DrawPacket packet{};
+        packet.key = RenderQueue::make_key(0, false, 0, state->get_id(), 0, float(8 - i));
+        packet.state = state;
+        packet.mode = GL_TRIANGLES;
+        packet.count = 3;
+        packet.instance_count = 1;
+        queue.push(packet);
+    }
+
+    // e.g. a vertex buffer written by a dispatch: its barrier gets issued before the draws
+    MemoryBarriers barriers;
+    MemoryBarriers::set_current(&barriers);
+    barriers.on_buffer_written(5);
+    barriers.require_buffer(5, GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+    queue.submit(pipelines);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glMemoryBarrier") == 1);
+    OBJECTGL_CHECK(barriers.get_pending() == 0);
+
+    OBJECTGL_CHECK(queue.get_stats().draws == 8);
+    OBJECTGL_CHECK(queue.get_stats().state_changes == 2);
+    OBJECTGL_CHECK(pipelines.get_last_applied() == second_state);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glDrawArraysInstancedBaseInstance") == 8);
+
+    // submitting again keeps the sorted order
+    queue.submit(pipelines);
+    OBJECTGL_CHECK(queue.get_stats().state_changes == 2);
+    OBJECTGL_CHECK(queue.size() == 8);
+    queue.clear();
+    OBJECTGL_CHECK(queue.size() == 0);
+
+    MemoryBarriers::set_current(NULL);
+    GLStateCache::set_current(NULL);
+    return ok;
+}
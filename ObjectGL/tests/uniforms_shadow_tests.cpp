@@ -0,0 +1,96 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+#include <cstdint>
+
+#include "GL/glew.h"
+
+#include "context/gl_backend.h"
+#include "objectgl_tests.h"
+#include "shaders/fragment_shader.h"
+#include "shaders/shaders_program.h"
+#include "shaders/uniforms_shadow.h"
+#include "shaders/vertex_shader.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+bool test_uniforms_shadow()
+{
+    bool ok = true;
+    GLBackend::set_mock_uniforms(GL_FLOAT_VEC4, 2, 8);
+
+    VertexShader vertex_shader;
+    vertex_shader.set_source_code("#version 450 core\nvoid main() { gl_Position = vec4(0.0); }\n");
+    FragmentShader fragment_shader;
+    fragment_shader.set_source_code("#version 450 core\nuniform vec4 value0[8];\nuniform vec4 value1[8];\nout vec4 color;\nvoid main() { color = value0[0] + value1[0]; }\n");
+    ShadersList shaders{ &vertex_shader, &fragment_shader };
+    ShadersProgram program(shaders);
+
+    UniformsShadow& shadow = program.get_uniforms_shadow();
+    const GLint slot = shadow.find(program.get_reflection(), "value1");
+    OBJECTGL_CHECK(slot >= 0);
+    OBJECTGL_CHECK(shadow.find(program.get_reflection(), "missing") == -1);
+    if (slot < 0)
+        return false;
+    OBJECTGL_CHECK(shadow.get_type(slot) == GL_FLOAT_VEC4);
+    OBJECTGL_CHECK(shadow.get_element_size(slot) == 16);
+
+    GLfloat values[8][4] = {};
+    for (int i = 0; i < 8; ++i)
+        values[i][0] = GLfloat(i);
+
+    // unknown values are always set, then uploaded at once
+    OBJECTGL_CHECK(shadow.set(slot, 0, 8, values));
+    OBJECTGL_CHECK(shadow.is_dirty());
+    program.flush_uniforms();
+    OBJECTGL_CHECK(!shadow.is_dirty());
+    OBJECTGL_CHECK(shadow.get_stats().modified == 8);
+    OBJECTGL_CHECK(shadow.get_stats().uploads == 1);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glProgramUniform4fv") == 1);
+
+    // resident values are skipped
+    OBJECTGL_CHECK(!shadow.set(slot, 0, 8, values));
+    OBJECTGL_CHECK(!shadow.is_dirty());
+    OBJECTGL_CHECK(shadow.get_stats().skipped == 8);
+    program.flush_uniforms();
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glProgramUniform4fv") == 1);
+
+    // consecutive modified elements are coalesced into one upload
+    shadow.reset_stats();
+    values[1][1] = values[2][1] = values[5][1] = 1.0f;
+    OBJECTGL_CHECK(shadow.set(slot, 0, 8, values));
+    OBJECTGL_CHECK(shadow.set(slot, 5, 1, values[5]) == false);
+    program.flush_uniforms();
+    OBJECTGL_CHECK(shadow.get_stats().modified == 3);
+    OBJECTGL_CHECK(shadow.get_stats().skipped == 6);
+    OBJECTGL_CHECK(shadow.get_stats().uploads == 2);
+    OBJECTGL_CHECK(GLBackend::get_calls_count("glProgramUniform4fv") == 3);
+
+    // out of range elements are rejected
+    OBJECTGL_CHECK(!shadow.set(slot, 8, 1, values));
+    return ok;
+}
@@ -0,0 +1,135 @@
+/**
+MIT License
+
+Copyright (c) 2022 Philippe Schmouker, ph.schmouker (at) gmail.com
+
+Permission is hereby granted,  free of charge,  to any person obtaining a copy
+of this software and associated documentation files (the "Software"),  to deal
+in the Software without restriction,  including without limitation the  rights
+to use,  copy,  modify,  merge,  publish,  distribute, sublicense, and/or sell
+copies of the Software,  and  to  permit  persons  to  whom  the  Software  is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS",  WITHOUT WARRANTY OF ANY  KIND,  EXPRESS  OR
+IMPLIED,  INCLUDING  BUT  NOT  LIMITED  TO  THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT  SHALL  THE
+AUTHORS  OR  COPYRIGHT  HOLDERS  BE  LIABLE  FOR  ANY CLAIM,  DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,  ARISING FROM,
+OUT  OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+//===========================================================================
+/* gl_trace_replay: replays an OpenGL trace captured by GLTrace, headless,
+* and reports the CPU cost of the submission path of each frame.
+*
+* Usage:
+*   gl_trace_replay <trace file> [--finish] [--quiet] [--warmup <count>]
+*     --finish : waits for the GPU at the end of each frame, out of the
+*                measured time, so that frames do not overlap.
+*     --quiet  : reports the summary only.
+*     --warmup : the count of first frames left out of the summary,
+*                e.g. the ones that compile shaders. Defaults to 0.
+*
+* The OpenGL 4.5 core context is created headless by GLContext, e.g.
+* with llvmpipe:
+*   LIBGL_ALWAYS_SOFTWARE=1 gl_trace_replay frames.trace
+*/
+
+
+//===========================================================================
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "context/gl_context.h"
+#include "trace/gl_trace_replayer.h"
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------
+static double get_percentile(const vector<double>& sorted, const double percentile)
+{
+    const size_t index = size_t(percentile * double(sorted.size() - 1) + 0.5);
+    return sorted[min(index, sorted.size() - 1)];
+}
+
+
+//===========================================================================
+int main(int argc, char* argv[])
+{
+    const char* filepath = NULL;
+    bool finish = false;
+    bool quiet = false;
+    size_t warmup = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--finish") == 0)
+            finish = true;
+        else if (strcmp(argv[i], "--quiet") == 0)
+            quiet = true;
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            warmup = size_t(strtoul(argv[++i], NULL, 10));
+        else if (filepath == NULL)
+            filepath = argv[i];
+    }
+    if (filepath == NULL) {
+        cerr << "usage: gl_trace_replay <trace file> [--finish] [--quiet] [--warmup <count>]" << endl;
+        return 2;
+    }
+
+    GLContext context;
+    if (!context.is_ok())
+        return 1;
+    cout << "renderer: " << glGetString(GL_RENDERER) << " (" << GLContext::get_platform_name(context.get_platform()) << ")" << endl;
+
+    vector<double> frames_ms;
+    uint64_t calls = 0;
+    bool ok = false;
+    {
+        GLTraceReplayer replayer(filepath);
+        if (!replayer.is_ok())
+            return 1;
+
+        GLTraceReplayer::FrameStats stats;
+        while (replayer.replay_frame(stats)) {
+            if (!quiet)
+                printf("frame %6llu: %9.3f ms, %7llu calls, %10llu bytes\n", (unsigned long long)(replayer.get_replayed_frames() - 1), stats.cpu_ms,
+                       (unsigned long long)stats.calls, (unsigned long long)stats.bytes);
+            if (replayer.get_replayed_frames() > warmup) {
+                frames_ms.push_back(stats.cpu_ms);
+                calls += stats.calls;
+            }
+            if (finish)
+                glFinish();
+        }
+        glFinish();
+
+        ok = replayer.is_ok();
+        if (replayer.get_skipped_calls() > 0)
+            cout << replayer.get_skipped_calls() << " calls skipped: entry points not available" << endl;
+    }
+
+    if (frames_ms.empty()) {
+        cout << "no frame measured" << endl;
+        return ok ? 0 : 1;
+    }
+
+    double total_ms = 0.0;
+    for (const double ms : frames_ms)
+        total_ms += ms;
+    vector<double> sorted = frames_ms;
+    sort(sorted.begin(), sorted.end());
+    printf("%zu frames, %llu calls: cpu min %.3f ms, avg %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+           sorted.size(), (unsigned long long)calls, sorted.front(), total_ms / double(sorted.size()),
+           get_percentile(sorted, 0.5), get_percentile(sorted, 0.99), sorted.back());
+    return ok ? 0 : 1;
+}